@@ -0,0 +1,414 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** batch.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** Apply the executable implementation of an operation to arrays of
+** packed inputs, spreading the work across a pool of threads.
+**
+** The work is split into chunks of a fixed number of elements.  Each
+** worker starts with a contiguous range of chunks and, when that runs
+** out, takes chunks from the other workers.  Chunks are a whole number
+** of cache lines of output so that workers never write to the same line.
+**
+*/
+
+#include <assert.h>
+#include <stddef.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "symfpu/applications/implementations.h"
+
+#ifndef SYMFPU_BATCH
+#define SYMFPU_BATCH
+
+namespace symfpu {
+  namespace batch {
+
+    static const size_t cacheLineSize = 64;
+
+
+    // A non-owning view of an array
+    template <class T>
+    class span {
+    protected :
+      T *start;
+      size_t length;
+
+    public :
+      span (T *s, size_t l) : start(s), length(l) {}
+      span (std::vector<T> &v) : start(v.data()), length(v.size()) {}
+
+      template <class S>
+      span (const span<S> &old) : start(old.data()), length(old.size()) {}
+
+      T * data (void) const { return start; }
+      size_t size (void) const { return length; }
+
+      T & operator[] (size_t i) const {
+	assert(i < length);
+	return start[i];
+      }
+    };
+
+
+    class threadPool {
+    public :
+      // Applied to [begin, end) by the worker with the given index
+      typedef std::function<void (size_t, size_t, size_t)> body;
+
+    protected :
+      // Each worker's remaining range, one per cache line
+      struct workQueue {
+	std::atomic<size_t> next;
+	size_t end;
+	char padding[cacheLineSize - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+	workQueue () : next(0), end(0) {}
+      };
+
+      std::vector<workQueue> queues;
+      std::vector<std::thread> threads;
+
+      std::mutex dispatchMutex;   // One parallelFor at a time
+
+      std::mutex mutex;           // Protects the following
+      std::condition_variable wake;
+      std::condition_variable done;
+      const body *current;
+      size_t grain;
+      size_t generation;
+      size_t active;
+      bool stopping;
+
+
+      void run (size_t worker) {
+	size_t workers = queues.size();
+
+	for (size_t i = 0; i < workers; ++i) {
+	  workQueue &q = queues[(worker + i) % workers];
+
+	  while (1) {
+	    size_t begin = q.next.fetch_add(grain, std::memory_order_relaxed);
+	    if (begin >= q.end)
+	      break;
+
+	    size_t end = (q.end - begin < grain) ? q.end : begin + grain;
+	    (*current)(begin, end, worker);
+	  }
+	}
+
+	return;
+      }
+
+      void workerLoop (size_t worker) {
+	size_t seen = 0;
+
+	while (1) {
+	  std::unique_lock<std::mutex> lock(mutex);
+	  while (!stopping && generation == seen) {
+	    wake.wait(lock);
+	  }
+	  if (stopping)
+	    return;
+	  seen = generation;
+	  lock.unlock();
+
+	  run(worker);
+
+	  lock.lock();
+	  --active;
+	  if (active == 0)
+	    done.notify_one();
+	}
+      }
+
+    public :
+      // The calling thread is used as worker 0, so threadCount - 1
+      // threads are created.  Zero means one per hardware thread.
+      threadPool (size_t threadCount = 0) :
+	current(NULL), grain(1), generation(0), active(0), stopping(false) {
+	if (threadCount == 0) {
+	  threadCount = std::thread::hardware_concurrency();
+	  if (threadCount == 0)
+	    threadCount = 1;
+	}
+
+	queues = std::vector<workQueue>(threadCount);
+	for (size_t i = 1; i < threadCount; ++i) {
+	  threads.push_back(std::thread(&threadPool::workerLoop, this, i));
+	}
+      }
+
+      ~threadPool () {
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  stopping = true;
+	}
+	wake.notify_all();
+
+	for (size_t i = 0; i < threads.size(); ++i) {
+	  threads[i].join();
+	}
+      }
+
+      size_t size (void) const {
+	return queues.size();
+      }
+
+      // Call b on disjoint sub-ranges covering [0, length), each a
+      // multiple of chunk elements long (apart from the last).
+      // Returns once all of them have completed.
+      void parallelFor (size_t length, size_t chunk, const body &b) {
+	if (length == 0)
+	  return;
+
+	std::lock_guard<std::mutex> dispatch(dispatchMutex);
+
+	size_t workers = queues.size();
+	size_t chunks = (length + chunk - 1) / chunk;
+	size_t perWorker = chunks / workers;
+	size_t extra = chunks % workers;
+	size_t position = 0;
+
+	for (size_t i = 0; i < workers; ++i) {
+	  size_t owned = (perWorker + ((i < extra) ? 1 : 0)) * chunk;
+	  queues[i].next.store(position, std::memory_order_relaxed);
+	  position = (length - position < owned) ? length : position + owned;
+	  queues[i].end = position;
+	}
+	assert(position == length);
+
+	{
+	  std::lock_guard<std::mutex> lock(mutex);
+	  current = &b;
+	  grain = chunk;
+	  active = workers - 1;
+	  ++generation;
+	}
+	wake.notify_all();
+
+	run(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while (active != 0) {
+	  done.wait(lock);
+	}
+	current = NULL;
+
+	return;
+      }
+    };
+
+
+    // Round the requested chunk size up to a whole number of cache lines of output
+    template <class T>
+    size_t chunkSize (size_t requested) {
+      size_t perLine = (sizeof(T) < cacheLineSize) ? cacheLineSize / sizeof(T) : 1;
+      if (requested < perLine)
+	return perLine;
+      return ((requested + perLine - 1) / perLine) * perLine;
+    }
+
+
+
+    template <class execBV, class traits>
+    class implementation {
+    public :
+      typedef typename traits::rm rm;
+      typedef typename traits::fpt fpt;
+      typedef sympfuKernels<execBV, traits> kernels;
+      typedef sympfuContext<traits> context;
+
+      static const size_t defaultChunk = 256;
+
+      // Each chunk works on its own copy of the context so that
+      // back-ends with heavier formats and rounding modes do not
+      // share them between threads.
+
+#define SYMFPU_BATCH_UNARY(F, OUT)					\
+      static void F (threadPool &pool, const context &c,		\
+		     span<const execBV> input, span<OUT> output,	\
+		     size_t chunk = defaultChunk) {			\
+	assert(input.size() == output.size());			\
+	pool.parallelFor(input.size(), chunkSize<OUT>(chunk),		\
+			 [&] (size_t begin, size_t end, size_t) {	\
+			   context local(c);				\
+			   for (size_t i = begin; i < end; ++i) {	\
+			     output.data()[i] = kernels::F(local.format, input.data()[i]); \
+			   }						\
+			 });						\
+      }
+
+#define SYMFPU_BATCH_UNARY_ROUNDED(F)					\
+      static void F (threadPool &pool, const context &c,		\
+		     span<const execBV> input, span<execBV> output,	\
+		     size_t chunk = defaultChunk) {			\
+	assert(input.size() == output.size());			\
+	pool.parallelFor(input.size(), chunkSize<execBV>(chunk),	\
+			 [&] (size_t begin, size_t end, size_t) {	\
+			   context local(c);				\
+			   for (size_t i = begin; i < end; ++i) {	\
+			     output.data()[i] = kernels::F(local.format, local.mode, input.data()[i]); \
+			   }						\
+			 });						\
+      }
+
+#define SYMFPU_BATCH_BINARY(F, OUT)					\
+      static void F (threadPool &pool, const context &c,		\
+		     span<const execBV> left, span<const execBV> right,	\
+		     span<OUT> output,					\
+		     size_t chunk = defaultChunk) {			\
+	assert(left.size() == output.size());			\
+	assert(right.size() == output.size());			\
+	pool.parallelFor(left.size(), chunkSize<OUT>(chunk),		\
+			 [&] (size_t begin, size_t end, size_t) {	\
+			   context local(c);				\
+			   for (size_t i = begin; i < end; ++i) {	\
+			     output.data()[i] = kernels::F(local.format, left.data()[i], right.data()[i]); \
+			   }						\
+			 });						\
+      }
+
+#define SYMFPU_BATCH_BINARY_ROUNDED(F)					\
+      static void F (threadPool &pool, const context &c,		\
+		     span<const execBV> left, span<const execBV> right,	\
+		     span<execBV> output,				\
+		     size_t chunk = defaultChunk) {			\
+	assert(left.size() == output.size());			\
+	assert(right.size() == output.size());			\
+	pool.parallelFor(left.size(), chunkSize<execBV>(chunk),		\
+			 [&] (size_t begin, size_t end, size_t) {	\
+			   context local(c);				\
+			   for (size_t i = begin; i < end; ++i) {	\
+			     output.data()[i] = kernels::F(local.format, local.mode, left.data()[i], right.data()[i]); \
+			   }						\
+			 });						\
+      }
+
+#define SYMFPU_BATCH_TERNARY_ROUNDED(F)					\
+      static void F (threadPool &pool, const context &c,		\
+		     span<const execBV> first, span<const execBV> second, \
+		     span<const execBV> third, span<execBV> output,	\
+		     size_t chunk = defaultChunk) {			\
+	assert(first.size() == output.size());			\
+	assert(second.size() == output.size());			\
+	assert(third.size() == output.size());			\
+	pool.parallelFor(first.size(), chunkSize<execBV>(chunk),	\
+			 [&] (size_t begin, size_t end, size_t) {	\
+			   context local(c);				\
+			   for (size_t i = begin; i < end; ++i) {	\
+			     output.data()[i] = kernels::F(local.format, local.mode, first.data()[i], second.data()[i], third.data()[i]); \
+			   }						\
+			 });						\
+      }
+
+#define SYMFPU_BATCH_BINARY_AUGMENTED(F)				\
+      static void F (threadPool &pool, const context &c,		\
+		     span<const execBV> left, span<const execBV> right,	\
+		     span<execBV> output, span<execBV> error,		\
+		     size_t chunk = defaultChunk) {			\
+	assert(left.size() == output.size());			\
+	assert(right.size() == output.size());			\
+	assert(error.size() == output.size());			\
+	pool.parallelFor(left.size(), chunkSize<execBV>(chunk),		\
+			 [&] (size_t begin, size_t end, size_t) {	\
+			   context local(c);				\
+			   for (size_t i = begin; i < end; ++i) {	\
+			     output.data()[i] = kernels::F(local.format, local.mode, left.data()[i], right.data()[i], error.data()[i]); \
+			   }						\
+			 });						\
+      }
+
+      SYMFPU_BATCH_UNARY(unpackPack, execBV)
+      SYMFPU_BATCH_UNARY(negate, execBV)
+      SYMFPU_BATCH_UNARY(absolute, execBV)
+      SYMFPU_BATCH_UNARY(nextUp, execBV)
+      SYMFPU_BATCH_UNARY(nextDown, execBV)
+      SYMFPU_BATCH_UNARY(logB, int)
+      SYMFPU_BATCH_UNARY_ROUNDED(sqrt)
+      SYMFPU_BATCH_UNARY_ROUNDED(rti)
+
+      SYMFPU_BATCH_UNARY(isNormal, bool)
+      SYMFPU_BATCH_UNARY(isSubnormal, bool)
+      SYMFPU_BATCH_UNARY(isZero, bool)
+      SYMFPU_BATCH_UNARY(isInfinite, bool)
+      SYMFPU_BATCH_UNARY(isNaN, bool)
+      SYMFPU_BATCH_UNARY(isPositive, bool)
+      SYMFPU_BATCH_UNARY(isNegative, bool)
+
+      SYMFPU_BATCH_BINARY(smtlibEqual, bool)
+      SYMFPU_BATCH_BINARY(ieee754Equal, bool)
+      SYMFPU_BATCH_BINARY(lessThan, bool)
+      SYMFPU_BATCH_BINARY(lessThanOrEqual, bool)
+
+      SYMFPU_BATCH_BINARY_ROUNDED(multiply)
+      SYMFPU_BATCH_BINARY_ROUNDED(add)
+      SYMFPU_BATCH_BINARY_ROUNDED(sub)
+      SYMFPU_BATCH_BINARY_ROUNDED(div)
+      SYMFPU_BATCH_BINARY(max, execBV)
+      SYMFPU_BATCH_BINARY(min, execBV)
+      SYMFPU_BATCH_BINARY(rem, execBV)
+
+      SYMFPU_BATCH_TERNARY_ROUNDED(fma)
+
+      // The third array is the random bits
+      SYMFPU_BATCH_TERNARY_ROUNDED(stochasticAdd)
+      SYMFPU_BATCH_TERNARY_ROUNDED(stochasticMultiply)
+
+      // The rounding errors go in the second output array
+      SYMFPU_BATCH_BINARY_AUGMENTED(augmentedAdd)
+      SYMFPU_BATCH_BINARY_AUGMENTED(augmentedMultiply)
+
+      // output[i] is input[i] * 2^scale[i]
+      static void scaleB (threadPool &pool, const context &c,
+			  span<const execBV> input, span<const int> scale, span<execBV> output,
+			  size_t chunk = defaultChunk) {
+	assert(input.size() == output.size());
+	assert(scale.size() == output.size());
+	pool.parallelFor(input.size(), chunkSize<execBV>(chunk),
+			 [&] (size_t begin, size_t end, size_t) {
+			   context local(c);
+			   for (size_t i = begin; i < end; ++i) {
+			     output.data()[i] = kernels::scaleB(local.format, local.mode, input.data()[i], scale.data()[i]);
+			   }
+			 });
+      }
+
+#undef SYMFPU_BATCH_UNARY
+#undef SYMFPU_BATCH_UNARY_ROUNDED
+#undef SYMFPU_BATCH_BINARY
+#undef SYMFPU_BATCH_BINARY_ROUNDED
+#undef SYMFPU_BATCH_TERNARY_ROUNDED
+#undef SYMFPU_BATCH_BINARY_AUGMENTED
+    };
+
+  }
+}
+
+#endif
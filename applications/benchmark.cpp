@@ -0,0 +1,138 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** benchmark.cpp
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** Times the truncating float to signed conversion (as used for C
+** casts) against the general conversion with RTZ, which goes through
+** the rounder.  Both include the unpack.  The results are compared as
+** well so a faster but wrong conversion is noticed.
+**
+**   ./benchmark [ number of inputs ]
+**
+*/
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "symfpu/baseTypes/simpleExecutable.h"
+#include "symfpu/baseTypes/simpleExecutableInstantiations.h"
+
+#include "symfpu/core/unpackedFloat.h"
+#include "symfpu/core/packing.h"
+#include "symfpu/core/convert.h"
+
+typedef symfpu::simpleExecutable::traits traits;
+typedef traits::fpt fpt;
+typedef traits::ubv ubv;
+typedef traits::sbv sbv;
+typedef symfpu::unpackedFloat<traits> uf;
+
+static double now (void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// xorshift64, so that the inputs are the same on every run
+static uint64_t nextRandom (uint64_t &state) {
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+static void usage (const char *name) {
+  fprintf(stderr, "Usage : %s [ number of inputs ]\n", name);
+  fprintf(stderr, "  The number of inputs must be a positive integer, 1000000 by default\n");
+}
+
+int main (int argc, char **argv) {
+  size_t n = 1000000;
+
+  if (argc > 2) {
+    usage(argv[0]);
+    return 1;
+  }
+  if (argc == 2) {
+    char *end = NULL;
+    errno = 0;
+    unsigned long long parsed = strtoull(argv[1], &end, 0);
+    if (!isdigit((unsigned char)argv[1][0]) || *end != '\0' || errno != 0 || parsed == 0 || parsed > SIZE_MAX / sizeof(int64_t)) {
+      usage(argv[0]);
+      return 1;
+    }
+    n = parsed;
+  }
+
+  fpt format(8,24);
+  const int widths[] = { 8, 16, 32 };
+
+  // Mostly values that convert, plus some that do not
+  uint32_t *inputs = new uint32_t[n];
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t r = nextRandom(state);
+    uint32_t exponent = 127 + (r % 40) - 4;
+    inputs[i] = (r & 0x80000000) | (exponent << 23) | ((r >> 32) & 0x007FFFFF);
+  }
+
+  fprintf(stdout, "width\tinputs\ttruncating (us)\trounder RTZ (us)\tmismatches\n");
+
+  for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w) {
+    int width = widths[w];
+    sbv undef(sbv::zero(width));
+    int64_t *truncated = new int64_t[n];
+    int64_t *rounded = new int64_t[n];
+
+    double start = now();
+    for (size_t i = 0; i < n; ++i) {
+      uf input(symfpu::unpack<traits>(format, ubv(32, inputs[i])));
+      truncated[i] = symfpu::convertFloatToSBVRTZ<traits>(format, input, width, undef).contents();
+    }
+    double middle = now();
+    for (size_t i = 0; i < n; ++i) {
+      uf input(symfpu::unpack<traits>(format, ubv(32, inputs[i])));
+      rounded[i] = symfpu::convertFloatToSBV<traits>(format, traits::RTZ(), input, width, undef).contents();
+    }
+    double end = now();
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < n; ++i) {
+      mismatches += (truncated[i] != rounded[i]) ? 1 : 0;
+    }
+
+    fprintf(stdout, "%d\t%lu\t%.3f\t%.3f\t%lu\n", width, (unsigned long)n,
+	    1e6 * (middle - start) / n, 1e6 * (end - middle) / n, (unsigned long)mismatches);
+
+    delete[] truncated;
+    delete[] rounded;
+  }
+
+  delete[] inputs;
+
+  return 0;
+}
@@ -0,0 +1,168 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** block.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** Encoding arrays of packed floating-point values into block
+** floating-point (see core/blockFloat.h), decoding them and taking dot
+** products of blocks, spread across a pool of threads.
+**
+** Consecutive runs of blockSize values form a block.  Block j has its
+** shared exponent in scales[j], its NaN flag in nan[j] and its elements
+** in elements[j * blockSize] to elements[(j + 1) * blockSize - 1].
+**
+*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "symfpu/applications/implementations.h"
+#include "symfpu/applications/batch.h"
+#include "symfpu/core/blockFloat.h"
+
+#ifndef SYMFPU_BLOCK
+#define SYMFPU_BLOCK
+
+namespace symfpu {
+  namespace block {
+
+    using batch::span;
+    using batch::threadPool;
+    using batch::chunkSize;
+
+
+    template <class S, class bwt>
+    struct blocks {
+      span<int64_t> scales;
+      span<bool> nan;
+      span<S> elements;
+      size_t blockSize;
+      bwt elementWidth;
+
+      blocks (span<int64_t> s, span<bool> n, span<S> e, size_t b, bwt w) :
+	scales(s), nan(n), elements(e), blockSize(b), elementWidth(w) {
+	assert(blockSize > 0);
+	assert(scales.size() == nan.size());
+	assert(scales.size() * blockSize == elements.size());
+      }
+
+      size_t size (void) const {
+	return scales.size();
+      }
+    };
+
+
+    template <class execBV, class traits>
+    class implementation {
+    public :
+      typedef typename traits::bwt bwt;
+      typedef typename traits::ubv ubv;
+      typedef typename traits::sbv sbv;
+      typedef symfpu::unpackedFloat<traits> uf;
+      typedef symfpu::blockFloat<traits> bf;
+      typedef sympfuContext<traits> context;
+
+      static const size_t defaultChunk = 16;   // In blocks
+
+    protected :
+      template <class S>
+      static bf get (const context &c, const blocks<S, bwt> &b, size_t j) {
+	std::vector<sbv> elements;
+	for (size_t i = 0; i < b.blockSize; ++i) {
+	  elements.push_back(sbv(b.elementWidth, b.elements.data()[j * b.blockSize + i]));
+	}
+	return bf(b.nan.data()[j], sbv(uf::exponentWidth(c.format), b.scales.data()[j]), elements);
+      }
+
+      static execBV packElement (const context &c, const uf &u) {
+	return symfpu::pack<traits>(c.format, u).contents();
+      }
+
+    public :
+      template <class S>
+      static void encode (threadPool &pool, const context &c, span<const execBV> input,
+			  const blocks<S, bwt> &output, size_t chunk = defaultChunk) {
+	assert(input.size() == output.elements.size());
+	pool.parallelFor(output.size(), chunkSize<int64_t>(chunk),
+			 [&] (size_t begin, size_t end, size_t) {
+			   context local(c);
+			   for (size_t j = begin; j < end; ++j) {
+			     std::vector<uf> values;
+			     for (size_t i = 0; i < output.blockSize; ++i) {
+			       values.push_back(symfpu::unpack<traits>(local.format,
+									ubv(local.format.packedWidth(),
+									    input.data()[j * output.blockSize + i])));
+			     }
+
+			     bf encoded(symfpu::blockEncode<traits>(local.format, local.mode, values, output.elementWidth));
+
+			     output.scales.data()[j] = encoded.scale.contents();
+			     output.nan.data()[j] = encoded.nan;
+			     for (size_t i = 0; i < output.blockSize; ++i) {
+			       output.elements.data()[j * output.blockSize + i] = (S)encoded.elements[i].contents();
+			     }
+			   }
+			 });
+      }
+
+      template <class S>
+      static void decode (threadPool &pool, const context &c, const blocks<S, bwt> &input,
+			  span<execBV> output, size_t chunk = defaultChunk) {
+	assert(input.elements.size() == output.size());
+	pool.parallelFor(input.size(), chunkSize<int64_t>(chunk),
+			 [&] (size_t begin, size_t end, size_t) {
+			   context local(c);
+			   for (size_t j = begin; j < end; ++j) {
+			     bf b(get(local, input, j));
+			     for (size_t i = 0; i < input.blockSize; ++i) {
+			       output.data()[j * input.blockSize + i] =
+				 packElement(local, symfpu::blockDecode<traits>(local.format, local.mode, b, i));
+			     }
+			   }
+			 });
+      }
+
+      // output[j] is the dot product of block j of left and right
+      template <class S>
+      static void dotProduct (threadPool &pool, const context &c, const blocks<S, bwt> &left,
+			      const blocks<S, bwt> &right, span<execBV> output, size_t chunk = defaultChunk) {
+	assert(left.size() == output.size());
+	assert(right.size() == output.size());
+	assert(left.blockSize == right.blockSize);
+	pool.parallelFor(output.size(), chunkSize<execBV>(chunk),
+			 [&] (size_t begin, size_t end, size_t) {
+			   context local(c);
+			   for (size_t j = begin; j < end; ++j) {
+			     output.data()[j] = packElement(local, symfpu::blockDotProduct<traits>(local.format, local.mode,
+												   get(local, left, j), get(local, right, j)));
+			   }
+			 });
+      }
+    };
+
+  }
+}
+
+#endif
@@ -0,0 +1,179 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** dispatch.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** Choosing the kernel for an operation at run-time.  All operations
+** have the same type so they can be held in one table and picked by
+** an operation read from, for example, an input file; the format and
+** rounding mode are read from the context.
+**
+** The operations for the simple executable back-end are compiled once
+** into symfpu.a so kernels for particular widths would run the same
+** out-of-line code; there is no per-format specialisation.
+**
+*/
+
+#include <assert.h>
+
+#include "symfpu/applications/implementations.h"
+
+#ifndef SYMFPU_DISPATCH
+#define SYMFPU_DISPATCH
+
+namespace symfpu {
+  namespace dispatch {
+
+    enum operation {
+      UNPACKPACK, NEGATE, ABSOLUTE, SQRT, RTI,
+      ISNORMAL, ISSUBNORMAL, ISZERO, ISINFINITE, ISNAN, ISPOSITIVE, ISNEGATIVE,
+      SMTLIBEQUAL, IEEE754EQUAL, LESSTHAN, LESSTHANOREQUAL,
+      MULTIPLY, ADD, SUB, DIV, MAX, MIN, FMA, REM,
+      NUMBER_OF_OPERATIONS
+    };
+
+
+    // All operations with the same type so they can go in one table.
+    // Unused arguments are ignored, predicates return 0 or 1.
+    template <class execBV, class traits>
+    class uniformKernels {
+    public :
+      typedef sympfuContext<traits> context;
+      typedef sympfuKernels<execBV, traits> kernels;
+      typedef execBV (*kernel) (const context &, execBV, execBV, execBV);
+
+#define SYMFPU_DISPATCH_UNARY(F)					\
+      static execBV F (const context &c, execBV a, execBV, execBV) {	\
+	return execBV(kernels::F(c.format, a));		\
+      }
+
+#define SYMFPU_DISPATCH_UNARY_ROUNDED(F)				\
+      static execBV F (const context &c, execBV a, execBV, execBV) {	\
+	return kernels::F(c.format, c.mode, a);		\
+      }
+
+#define SYMFPU_DISPATCH_BINARY(F)					\
+      static execBV F (const context &c, execBV a, execBV b, execBV) {	\
+	return execBV(kernels::F(c.format, a, b));		\
+      }
+
+#define SYMFPU_DISPATCH_BINARY_ROUNDED(F)				\
+      static execBV F (const context &c, execBV a, execBV b, execBV) {	\
+	return kernels::F(c.format, c.mode, a, b);		\
+      }
+
+      SYMFPU_DISPATCH_UNARY(unpackPack)
+      SYMFPU_DISPATCH_UNARY(negate)
+      SYMFPU_DISPATCH_UNARY(absolute)
+      SYMFPU_DISPATCH_UNARY_ROUNDED(sqrt)
+      SYMFPU_DISPATCH_UNARY_ROUNDED(rti)
+
+      SYMFPU_DISPATCH_UNARY(isNormal)
+      SYMFPU_DISPATCH_UNARY(isSubnormal)
+      SYMFPU_DISPATCH_UNARY(isZero)
+      SYMFPU_DISPATCH_UNARY(isInfinite)
+      SYMFPU_DISPATCH_UNARY(isNaN)
+      SYMFPU_DISPATCH_UNARY(isPositive)
+      SYMFPU_DISPATCH_UNARY(isNegative)
+
+      SYMFPU_DISPATCH_BINARY(smtlibEqual)
+      SYMFPU_DISPATCH_BINARY(ieee754Equal)
+      SYMFPU_DISPATCH_BINARY(lessThan)
+      SYMFPU_DISPATCH_BINARY(lessThanOrEqual)
+
+      SYMFPU_DISPATCH_BINARY_ROUNDED(multiply)
+      SYMFPU_DISPATCH_BINARY_ROUNDED(add)
+      SYMFPU_DISPATCH_BINARY_ROUNDED(sub)
+      SYMFPU_DISPATCH_BINARY_ROUNDED(div)
+      SYMFPU_DISPATCH_BINARY(max)
+      SYMFPU_DISPATCH_BINARY(min)
+      SYMFPU_DISPATCH_BINARY(rem)
+
+#undef SYMFPU_DISPATCH_UNARY
+#undef SYMFPU_DISPATCH_UNARY_ROUNDED
+#undef SYMFPU_DISPATCH_BINARY
+#undef SYMFPU_DISPATCH_BINARY_ROUNDED
+
+      static execBV fma (const context &c, execBV a, execBV b, execBV d) {
+	return kernels::fma(c.format, c.mode, a, b, d);
+      }
+
+      static void fill (kernel *table) {
+	table[UNPACKPACK] = &unpackPack;
+	table[NEGATE] = &negate;
+	table[ABSOLUTE] = &absolute;
+	table[SQRT] = &sqrt;
+	table[RTI] = &rti;
+	table[ISNORMAL] = &isNormal;
+	table[ISSUBNORMAL] = &isSubnormal;
+	table[ISZERO] = &isZero;
+	table[ISINFINITE] = &isInfinite;
+	table[ISNAN] = &isNaN;
+	table[ISPOSITIVE] = &isPositive;
+	table[ISNEGATIVE] = &isNegative;
+	table[SMTLIBEQUAL] = &smtlibEqual;
+	table[IEEE754EQUAL] = &ieee754Equal;
+	table[LESSTHAN] = &lessThan;
+	table[LESSTHANOREQUAL] = &lessThanOrEqual;
+	table[MULTIPLY] = &multiply;
+	table[ADD] = &add;
+	table[SUB] = &sub;
+	table[DIV] = &div;
+	table[MAX] = &max;
+	table[MIN] = &min;
+	table[FMA] = &fma;
+	table[REM] = &rem;
+	return;
+      }
+    };
+
+
+    // Lookups do not modify it so may be made from any number of
+    // threads.
+    template <class execBV, class traits>
+    class registry {
+    public :
+      typedef sympfuContext<traits> context;
+      typedef typename uniformKernels<execBV, traits>::kernel kernel;
+
+    protected :
+      kernel kernels[NUMBER_OF_OPERATIONS];
+
+    public :
+      registry () {
+	uniformKernels<execBV, traits>::fill(kernels);
+      }
+
+      kernel lookup (const operation op) const {
+	assert(op < NUMBER_OF_OPERATIONS);
+	return kernels[op];
+      }
+
+      execBV apply (const operation op, const context &c, execBV a, execBV b = 0, execBV d = 0) const {
+	return (*lookup(op))(c, a, b, d);
+      }
+    };
+
+  }
+}
+
+#endif
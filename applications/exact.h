@@ -0,0 +1,359 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** exact.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** Exact sums and dot products of arrays with a single rounding, for
+** executable back-ends.  The accumulator has the same layout and
+** semantics as core/accumulator.h but is held in an array of machine
+** words, as it is too wide for the back-end's bit-vectors.  Only the
+** final rounding goes through symfpu.
+**
+** As the accumulation is exact, the result does not depend on the order
+** in which terms are added, so each worker can have its own accumulator
+** and the threaded versions give the same results as the serial ones.
+**
+*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "symfpu/applications/implementations.h"
+#include "symfpu/applications/batch.h"
+#include "symfpu/core/accumulator.h"
+
+#ifndef SYMFPU_EXACT
+#define SYMFPU_EXACT
+
+namespace symfpu {
+  namespace exact {
+
+    using batch::span;
+    using batch::threadPool;
+
+
+    // Two's complement, least significant word first
+    class wideAccumulator {
+    public :
+      std::vector<uint64_t> words;
+      size_t fractionBits;
+      bool nan;
+      bool inf;
+      bool infSign;
+      bool allPositiveZero;
+      bool allNegativeZero;
+      size_t terms;
+
+      // An extra word of carries so there is no practical limit on terms
+      wideAccumulator (size_t width, size_t f) :
+	words(width / 64 + 2, 0), fractionBits(f), nan(false), inf(false), infSign(false),
+	allPositiveZero(true), allNegativeZero(true), terms(0) {}
+
+      void classify (bool termNaN, bool termInf, bool termZero, bool negative) {
+	nan = nan || termNaN || (inf && termInf && (infSign != negative));
+	infSign = inf ? infSign : negative;
+	inf = inf || termInf;
+	allPositiveZero = allPositiveZero && termZero && !negative;
+	allNegativeZero = allNegativeZero && termZero && negative;
+	++terms;
+	return;
+      }
+
+      // Adds (or subtracts) (high:low) * 2^position
+      void add (bool negative, uint64_t high, uint64_t low, size_t position) {
+	size_t index = position / 64;
+	size_t offset = position % 64;
+
+	uint64_t shifted[3];
+	shifted[0] = low << offset;
+	shifted[1] = (offset == 0) ? high : ((high << offset) | (low >> (64 - offset)));
+	shifted[2] = (offset == 0) ? 0 : (high >> (64 - offset));
+
+	uint64_t carry = 0;
+	for (size_t i = index; i < words.size(); ++i) {
+	  uint64_t operand = (i - index < 3) ? shifted[i - index] : 0;
+
+	  if (i - index >= 3 && carry == 0)
+	    break;
+
+	  uint64_t before = words[i];
+	  if (negative) {
+	    uint64_t difference = before - operand - carry;
+	    carry = (before < operand || (before == operand && carry)) ? 1 : 0;
+	    words[i] = difference;
+	  } else {
+	    uint64_t sum = before + operand + carry;
+	    carry = (sum < before || (sum == before && carry)) ? 1 : 0;
+	    words[i] = sum;
+	  }
+	}
+	return;
+      }
+
+      void merge (const wideAccumulator &other) {
+	assert(words.size() == other.words.size());
+	assert(fractionBits == other.fractionBits);
+
+	uint64_t carry = 0;
+	for (size_t i = 0; i < words.size(); ++i) {
+	  uint64_t before = words[i];
+	  uint64_t sum = before + other.words[i] + carry;
+	  carry = (sum < before || (sum == before && carry)) ? 1 : 0;
+	  words[i] = sum;
+	}
+
+	nan = nan || other.nan || (inf && other.inf && (infSign != other.infSign));
+	infSign = inf ? infSign : other.infSign;
+	inf = inf || other.inf;
+	allPositiveZero = allPositiveZero && other.allPositiveZero;
+	allNegativeZero = allNegativeZero && other.allNegativeZero;
+	terms += other.terms;
+	return;
+      }
+
+      bool isNegative (void) const {
+	return (words.back() >> 63) != 0;
+      }
+
+      bool isZero (void) const {
+	for (size_t i = 0; i < words.size(); ++i) {
+	  if (words[i] != 0)
+	    return false;
+	}
+	return true;
+      }
+
+      // Of the absolute value
+      std::vector<uint64_t> magnitude (void) const {
+	std::vector<uint64_t> result(words);
+	if (isNegative()) {
+	  uint64_t carry = 1;
+	  for (size_t i = 0; i < result.size(); ++i) {
+	    result[i] = ~result[i] + carry;
+	    carry = (carry && result[i] == 0) ? 1 : 0;
+	  }
+	}
+	return result;
+      }
+    };
+
+
+    // 64 x 64 -> 128 bit multiplication from 32 bit halves
+    inline void multiplyWide (uint64_t a, uint64_t b, uint64_t &high, uint64_t &low) {
+      uint64_t aLow = a & 0xFFFFFFFFULL, aHigh = a >> 32;
+      uint64_t bLow = b & 0xFFFFFFFFULL, bHigh = b >> 32;
+
+      uint64_t lowLow = aLow * bLow;
+      uint64_t lowHigh = aLow * bHigh;
+      uint64_t highLow = aHigh * bLow;
+      uint64_t highHigh = aHigh * bHigh;
+
+      uint64_t middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFFULL) + (highLow & 0xFFFFFFFFULL);
+
+      low = (lowLow & 0xFFFFFFFFULL) | (middle << 32);
+      high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+      return;
+    }
+
+
+    template <class execBV, class traits>
+    class implementation {
+    public :
+      typedef typename traits::bwt bwt;
+      typedef typename traits::ubv ubv;
+      typedef typename traits::sbv sbv;
+      typedef symfpu::unpackedFloat<traits> uf;
+      typedef symfpu::exactAccumulator<traits> layout;
+      typedef sympfuContext<traits> context;
+
+      static const size_t defaultChunk = 4096;
+
+      static wideAccumulator makeEmpty (const context &c, const bool products, const size_t capacity) {
+	return wideAccumulator(layout::widthFor(c.format, products, capacity),
+			       layout::fractionBitsFor(c.format, products));
+      }
+
+      static void accumulate (const context &c, wideAccumulator &acc, execBV value) {
+	assert(acc.fractionBits >= layout::fractionBitsFor(c.format, false));
+
+	uf u(symfpu::unpack<traits>(c.format, ubv(c.format.packedWidth(), value)));
+	acc.classify(u.getNaN(), u.getInf(), u.getZero(), u.getSign());
+
+	if (!(u.getNaN() || u.getInf() || u.getZero())) {
+	  int64_t significandWidth(uf::significandWidth(c.format));
+	  int64_t position(u.getExponent().contents() - (significandWidth - 1) + (int64_t)acc.fractionBits);
+	  assert(position >= 0);
+
+	  acc.add(u.getSign(), 0, u.getSignificand().contents(), position);
+	}
+	return;
+      }
+
+      static void accumulateProduct (const context &c, wideAccumulator &acc, execBV left, execBV right) {
+	assert(acc.fractionBits >= layout::fractionBitsFor(c.format, true));
+
+	uf l(symfpu::unpack<traits>(c.format, ubv(c.format.packedWidth(), left)));
+	uf r(symfpu::unpack<traits>(c.format, ubv(c.format.packedWidth(), right)));
+
+	bool nan = l.getNaN() || r.getNaN() || (l.getInf() && r.getZero()) || (l.getZero() && r.getInf());
+	bool inf = l.getInf() || r.getInf();
+	bool zero = l.getZero() || r.getZero();
+	bool negative = l.getSign() ^ r.getSign();
+	acc.classify(nan, inf, zero, negative);
+
+	if (!(nan || inf || zero)) {
+	  int64_t significandWidth(uf::significandWidth(c.format));
+	  int64_t position(l.getExponent().contents() + r.getExponent().contents() -
+			   2 * (significandWidth - 1) + (int64_t)acc.fractionBits);
+	  assert(position >= 0);
+
+	  uint64_t high, low;
+	  multiplyWide(l.getSignificand().contents(), r.getSignificand().contents(), high, low);
+	  acc.add(negative, high, low, position);
+	}
+	return;
+      }
+
+      // The only rounding
+      static execBV round (const context &c, const wideAccumulator &acc) {
+	if (acc.nan) {
+	  return symfpu::pack<traits>(c.format, uf::makeNaN(c.format)).contents();
+	}
+	if (acc.inf) {
+	  return symfpu::pack<traits>(c.format, uf::makeInf(c.format, acc.infSign)).contents();
+	}
+	if (acc.isZero()) {
+	  bool zeroSign = (c.mode == traits::RTN()) ? !acc.allPositiveZero : (acc.allNegativeZero && acc.terms > 0);
+	  return symfpu::pack<traits>(c.format, uf::makeZero(c.format, zeroSign)).contents();
+	}
+
+	std::vector<uint64_t> magnitude(acc.magnitude());
+
+	size_t top = magnitude.size() * 64 - 1;
+	while (((magnitude[top / 64] >> (top % 64)) & 1) == 0) {
+	  --top;
+	}
+
+	// The top significandWidth + 1 bits, then a sticky bit
+	bwt significandWidth(uf::significandWidth(c.format));
+	bwt workingWidth(significandWidth + 2);
+	assert(workingWidth <= 64);
+
+	uint64_t extracted = 0;
+	for (size_t i = 0; i < workingWidth - 1; ++i) {
+	  extracted <<= 1;
+	  if (top >= i) {
+	    size_t bit = top - i;
+	    extracted |= (magnitude[bit / 64] >> (bit % 64)) & 1;
+	  }
+	}
+
+	bool sticky = false;
+	if (top >= workingWidth - 1) {
+	  size_t remaining = top - (workingWidth - 1);   // Bits [remaining, 0]
+	  for (size_t i = 0; i < remaining / 64 && !sticky; ++i) {
+	    sticky = (magnitude[i] != 0);
+	  }
+	  uint64_t partial = magnitude[remaining / 64] & ((((uint64_t)1 << (remaining % 64)) << 1) - 1);
+	  sticky = sticky || (partial != 0);
+	}
+	extracted = (extracted << 1) | (sticky ? 1 : 0);
+
+	// The leading bit is 2^(top - fractionBits); use as few exponent
+	// bits as possible as the rounder needs fewer than the significand
+	bool belowOne = (top < acc.fractionBits);
+	size_t distance = belowOne ? acc.fractionBits - top : top - acc.fractionBits;
+	bwt exponentWidth(bitsToRepresent<bwt>(distance) + 1);
+	bwt targetExponentWidth(uf::exponentWidth(c.format));
+	exponentWidth = (exponentWidth > targetExponentWidth) ? exponentWidth : targetExponentWidth;
+
+	sbv exponent(sbv(exponentWidth, distance));
+	uf initial(acc.isNegative(),
+		   belowOne ? -exponent : exponent,
+		   ubv(workingWidth, extracted));
+
+	return symfpu::pack<traits>(c.format, symfpu::rounder<traits>(c.format, c.mode, initial)).contents();
+      }
+
+
+      static execBV sum (const context &c, span<const execBV> input) {
+	assert(input.size() > 0);
+	wideAccumulator acc(makeEmpty(c, false, input.size()));
+	for (size_t i = 0; i < input.size(); ++i) {
+	  accumulate(c, acc, input.data()[i]);
+	}
+	return round(c, acc);
+      }
+
+      static execBV sum (threadPool &pool, const context &c, span<const execBV> input,
+			 size_t chunk = defaultChunk) {
+	assert(input.size() > 0);
+	std::vector<wideAccumulator> partial(pool.size(), makeEmpty(c, false, input.size()));
+	pool.parallelFor(input.size(), chunk,
+			 [&] (size_t begin, size_t end, size_t worker) {
+			   context local(c);
+			   for (size_t i = begin; i < end; ++i) {
+			     accumulate(local, partial[worker], input.data()[i]);
+			   }
+			 });
+	for (size_t i = 1; i < partial.size(); ++i) {
+	  partial[0].merge(partial[i]);
+	}
+	return round(c, partial[0]);
+      }
+
+      static execBV dotProduct (const context &c, span<const execBV> left, span<const execBV> right) {
+	assert(left.size() > 0);
+	assert(left.size() == right.size());
+	wideAccumulator acc(makeEmpty(c, true, left.size()));
+	for (size_t i = 0; i < left.size(); ++i) {
+	  accumulateProduct(c, acc, left.data()[i], right.data()[i]);
+	}
+	return round(c, acc);
+      }
+
+      static execBV dotProduct (threadPool &pool, const context &c, span<const execBV> left,
+				span<const execBV> right, size_t chunk = defaultChunk) {
+	assert(left.size() > 0);
+	assert(left.size() == right.size());
+	std::vector<wideAccumulator> partial(pool.size(), makeEmpty(c, true, left.size()));
+	pool.parallelFor(left.size(), chunk,
+			 [&] (size_t begin, size_t end, size_t worker) {
+			   context local(c);
+			   for (size_t i = begin; i < end; ++i) {
+			     accumulateProduct(local, partial[worker], left.data()[i], right.data()[i]);
+			   }
+			 });
+	for (size_t i = 1; i < partial.size(); ++i) {
+	  partial[0].merge(partial[i]);
+	}
+	return round(c, partial[0]);
+      }
+    };
+
+  }
+}
+
+#endif
@@ -44,6 +44,7 @@
 #include "symfpu/core/sqrt.h"
 #include "symfpu/core/fma.h"
 #include "symfpu/core/remainder.h"
+#include "symfpu/core/exponent.h"
 
 #ifndef SYMFPU_IMPLEMENTATIONS
 #define SYMFPU_IMPLEMENTATIONS
@@ -278,10 +279,27 @@ template <class execBV, class execFloat>
 class native {
  public :
 
+  // The floating-point environment, and thus the rounding mode,
+  // has thread storage duration so each thread sets its own.
   static void setRoundingMode (const int roundingMode) {
     fesetround(roundingMode);
   }
 
+  // Uses a rounding mode for the lifetime of the object
+  class scope {
+  protected :
+    int previous;
+
+  public :
+    scope (const int roundingMode) : previous(fegetround()) {
+      fesetround(roundingMode);
+    }
+
+    ~scope () {
+      fesetround(previous);
+    }
+  };
+
   static execBV unpackPack (execBV bv) {
     return bv;
   }
@@ -467,18 +485,56 @@ class native {
 
 
 
+template <class traits>
+class sympfuContext {
+ public :
+  // Everything an operation needs other than its arguments.
+  // Immutable so one context can be shared between threads.
+
+  typedef typename traits::rm rm;
+  typedef typename traits::fpt fpt;
+
+  const fpt format;
+  const rm mode;
+
+  sympfuContext (const fpt &f, const rm &m) : format(f), mode(m) {}
+  sympfuContext (const fpt &f, const int roundingMode) : format(f), mode(nativeRoundingMode(roundingMode)) {}
+
+  static rm nativeRoundingMode (const int roundingMode) {
+    switch (roundingMode) {
+    case FE_TONEAREST :  return traits::RNE(); break;
+    case FE_UPWARD :     return traits::RTP(); break;
+    case FE_DOWNWARD :   return traits::RTN(); break;
+    case FE_TOWARDZERO : return traits::RTZ(); break;
+      /* // Disabled until a suitable reference implementation is available
+    case ??? :           return traits::RNA(); break;
+      */
+    default :
+      assert(0);
+      break;
+    }
+    return traits::RNE();
+  }
+};
+
+
+
 template <class execBV, class traits>
-class sympfuImplementation {
+class sympfuKernels {
 
  public :
-  // Wrapped in a struct to make type scoping easier
-  // and to save on typenames.
-  // Object is stateless.
-  
+  // The per-element operations with the format and rounding mode
+  // given explicitly.  These share no state so they can be called
+  // from any number of threads (see batch.h).
+  // Packed values are in the low bits of execBV, which can be wider
+  // than the format so that one type can carry several formats
+  // (see dispatch.h).
+
   typedef typename traits::rm rm;
   typedef typename traits::bwt bwt;
   typedef typename traits::fpt fpt;
   typedef typename traits::ubv ubv;
+  typedef typename traits::sbv sbv;
   typedef typename traits::prop prop;
   typedef symfpu::unpackedFloat<traits> uf;
   
@@ -486,282 +542,289 @@ class sympfuImplementation {
     return sizeof(execBV) * CHAR_BIT;
   }
 
- protected :
-  static rm * mode;
-  static fpt * format;
+  static execBV unpackPack (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
     
- public :
-  
-  static void setRoundingMode (const int roundingMode) {
-    if (mode != NULL) {
-      delete mode;
-    }
-
-    switch (roundingMode) {
-    case FE_TONEAREST :
-      mode = new rm(traits::RNE());
-      break;
-    case FE_UPWARD :
-      mode = new rm(traits::RTP());
-      break;
-    case FE_DOWNWARD :
-      mode = new rm(traits::RTN());
-      break;
-    case FE_TOWARDZERO :
-      mode = new rm(traits::RTZ());
-      break;
-      /* // Disabled until a suitable reference implementation is available
-    case ??? :
-      mode = new traits::rm(traits::RNA());
-      break;
-      */
-    default :
-      assert(0);
-      break;
-    }
+    uf unpacked(symfpu::unpack<traits>(format, packed));
+    
+    ubv repacked(symfpu::pack<traits>(format, unpacked));
+    
+    return repacked.contents();
   }
 
-  static void setFormat (const fpt &newFormat) {
-    if (format != NULL) {
-      delete format;
-    }
-    format = new fpt(newFormat);
-    return;
+  static execBV negate (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
+    
+    uf unpacked(symfpu::unpack<traits>(format, packed));
+    
+    uf negated(symfpu::negate<traits>(format, unpacked));
+    
+    ubv repacked(symfpu::pack<traits>(format, negated));
+    
+    return repacked.contents();
   }
 
-  static void destroyFormat() {
-    delete format;
-    return;
-  }
-  
-  static execBV unpackPack (const execBV bv) {
-    ubv packed(bitsInExecBV(),bv);
+  static execBV absolute (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
+ 
+    uf unpacked(symfpu::unpack<traits>(format, packed));
     
-    uf unpacked(symfpu::unpack<traits>(*format, packed));
+    uf abs(symfpu::absolute<traits>(format, unpacked));
     
-    ubv repacked(symfpu::pack<traits>(*format, unpacked));
+    ubv repacked(symfpu::pack<traits>(format, abs));
     
     return repacked.contents();
   }
 
-  static execBV negate (execBV bv) {
-    ubv packed(bitsInExecBV(),bv);
+  static execBV sqrt (const fpt &format, const rm &mode, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
+ 
+    uf unpacked(symfpu::unpack<traits>(format, packed));
+    
+    uf sqrt(symfpu::sqrt<traits>(format, mode, unpacked));
     
-    uf unpacked(symfpu::unpack<traits>(*format, packed));
+    ubv repacked(symfpu::pack<traits>(format, sqrt));
+    
+    return repacked.contents();
+  }
+
+  static execBV rti (const fpt &format, const rm &mode, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
+ 
+    uf unpacked(symfpu::unpack<traits>(format, packed));
     
-    uf negated(symfpu::negate<traits>(*format, unpacked));
+    uf rti(symfpu::roundToIntegral<traits>(format, mode, unpacked));
     
-    ubv repacked(symfpu::pack<traits>(*format, negated));
+    ubv repacked(symfpu::pack<traits>(format, rti));
     
     return repacked.contents();
   }
 
-  static execBV absolute (execBV bv) {
-    ubv packed(bitsInExecBV(),bv);
+  static execBV nextUp (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
  
-    uf unpacked(symfpu::unpack<traits>(*format, packed));
+    uf unpacked(symfpu::unpack<traits>(format, packed));
     
-    uf abs(symfpu::absolute<traits>(*format, unpacked));
+    uf next(symfpu::nextUp<traits>(format, unpacked));
     
-    ubv repacked(symfpu::pack<traits>(*format, abs));
+    ubv repacked(symfpu::pack<traits>(format, next));
     
     return repacked.contents();
   }
-  
-  static execBV sqrt (execBV bv) {
-    ubv packed(bitsInExecBV(),bv);
+
+  static execBV nextDown (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
  
-    uf unpacked(symfpu::unpack<traits>(*format, packed));
+    uf unpacked(symfpu::unpack<traits>(format, packed));
     
-    uf sqrt(symfpu::sqrt<traits>(*format, *mode, unpacked));
+    uf next(symfpu::nextDown<traits>(format, unpacked));
     
-    ubv repacked(symfpu::pack<traits>(*format, sqrt));
+    ubv repacked(symfpu::pack<traits>(format, next));
     
     return repacked.contents();
   }
 
-  static execBV rti (execBV bv) {
-    ubv packed(bitsInExecBV(),bv);
+  static execBV scaleB (const fpt &format, const rm &mode, execBV bv, int scale) {
+    ubv packed(format.packedWidth(), bv);
  
-    uf unpacked(symfpu::unpack<traits>(*format, packed));
+    uf unpacked(symfpu::unpack<traits>(format, packed));
     
-    uf rti(symfpu::roundToIntegral<traits>(*format, *mode, unpacked));
+    uf scaled(symfpu::scaleB<traits>(format, mode, unpacked, sbv(sizeof(int) * CHAR_BIT, scale)));
     
-    ubv repacked(symfpu::pack<traits>(*format, rti));
+    ubv repacked(symfpu::pack<traits>(format, scaled));
     
     return repacked.contents();
   }
 
-  static bool isNormal (execBV bv) {
-    ubv packed(bitsInExecBV(),bv);
+  // As ilogb
+  static int logB (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
+ 
+    uf unpacked(symfpu::unpack<traits>(format, packed));
+    
+    sbv exponent(symfpu::logB<traits>(format, unpacked, sbv::zero(uf::exponentWidth(format))));
+    
+    if (unpacked.getNaN()) {
+      return FP_ILOGBNAN;
+    } else if (unpacked.getInf()) {
+      return INT_MAX;
+    } else if (unpacked.getZero()) {
+      return FP_ILOGB0;
+    } else {
+      return (int)exponent.contents();
+    }
+  }
+
+  static bool isNormal (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
     
-    uf unpacked(symfpu::unpack<traits>(*format, packed));
+    uf unpacked(symfpu::unpack<traits>(format, packed));
     
-    prop result(symfpu::isNormal<traits>(*format, unpacked));
+    prop result(symfpu::isNormal<traits>(format, unpacked));
     
     return result;  
   }
 
-  static bool isSubnormal (execBV bv) {
-    ubv packed(bitsInExecBV(),bv);
+  static bool isSubnormal (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
     
-    uf unpacked(symfpu::unpack<traits>(*format, packed));
+    uf unpacked(symfpu::unpack<traits>(format, packed));
     
-    prop result(symfpu::isSubnormal<traits>(*format, unpacked));
+    prop result(symfpu::isSubnormal<traits>(format, unpacked));
     
     return result;
   }
 
-  static bool isZero (execBV bv) {
-    ubv packed(bitsInExecBV(),bv);
+  static bool isZero (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
     
-    uf unpacked(symfpu::unpack<traits>(*format, packed));
+    uf unpacked(symfpu::unpack<traits>(format, packed));
     
-    prop result(symfpu::isZero<traits>(*format, unpacked));
+    prop result(symfpu::isZero<traits>(format, unpacked));
     
     return result;
   }
 
-  static bool isInfinite (execBV bv) {
-    ubv packed(bitsInExecBV(),bv);
+  static bool isInfinite (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
     
-    uf unpacked(symfpu::unpack<traits>(*format, packed));
+    uf unpacked(symfpu::unpack<traits>(format, packed));
     
-    prop result(symfpu::isInfinite<traits>(*format, unpacked));
+    prop result(symfpu::isInfinite<traits>(format, unpacked));
     
     return result;
   }
 
-  static bool isNaN (execBV bv) {
-    ubv packed(bitsInExecBV(),bv);
+  static bool isNaN (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
     
-    uf unpacked(symfpu::unpack<traits>(*format, packed));
+    uf unpacked(symfpu::unpack<traits>(format, packed));
     
-    prop result(symfpu::isNaN<traits>(*format, unpacked));
+    prop result(symfpu::isNaN<traits>(format, unpacked));
     
     return result;
   }
 
-  static bool isPositive (execBV bv) {
-    ubv packed(bitsInExecBV(),bv);
+  static bool isPositive (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
     
-    uf unpacked(symfpu::unpack<traits>(*format, packed));
+    uf unpacked(symfpu::unpack<traits>(format, packed));
     
-    prop result(symfpu::isPositive<traits>(*format, unpacked));
+    prop result(symfpu::isPositive<traits>(format, unpacked));
     
     return result;
   }
 
-  static bool isNegative (execBV bv) {
-    ubv packed(bitsInExecBV(),bv);
+  static bool isNegative (const fpt &format, execBV bv) {
+    ubv packed(format.packedWidth(), bv);
     
-    uf unpacked(symfpu::unpack<traits>(*format, packed));
+    uf unpacked(symfpu::unpack<traits>(format, packed));
     
-    prop result(symfpu::isNegative<traits>(*format, unpacked));
+    prop result(symfpu::isNegative<traits>(format, unpacked));
     
     return result;
   }
 
-  static bool smtlibEqual (execBV bv1, execBV bv2) {
-    ubv packed1(bitsInExecBV(),bv1);
-    ubv packed2(bitsInExecBV(),bv2);
+  static bool smtlibEqual (const fpt &format, execBV bv1, execBV bv2) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
     
-    uf unpacked1(symfpu::unpack<traits>(*format, packed1));
-    uf unpacked2(symfpu::unpack<traits>(*format, packed2));
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
     
-    prop result(symfpu::smtlibEqual<traits>(*format, unpacked1, unpacked2));
+    prop result(symfpu::smtlibEqual<traits>(format, unpacked1, unpacked2));
     
     return result;
   }
 
-  static bool ieee754Equal (execBV bv1, execBV bv2) {
-    ubv packed1(bitsInExecBV(),bv1);
-    ubv packed2(bitsInExecBV(),bv2);
+  static bool ieee754Equal (const fpt &format, execBV bv1, execBV bv2) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
     
-    uf unpacked1(symfpu::unpack<traits>(*format, packed1));
-    uf unpacked2(symfpu::unpack<traits>(*format, packed2));
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
     
-    prop result(symfpu::ieee754Equal<traits>(*format, unpacked1, unpacked2));
+    prop result(symfpu::ieee754Equal<traits>(format, unpacked1, unpacked2));
     
     return result;
   }
 
-  static bool lessThan (execBV bv1, execBV bv2) {
-    ubv packed1(bitsInExecBV(),bv1);
-    ubv packed2(bitsInExecBV(),bv2);
+  static bool lessThan (const fpt &format, execBV bv1, execBV bv2) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
     
-    uf unpacked1(symfpu::unpack<traits>(*format, packed1));
-    uf unpacked2(symfpu::unpack<traits>(*format, packed2));
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
     
-    prop result(symfpu::lessThan<traits>(*format, unpacked1, unpacked2));
+    prop result(symfpu::lessThan<traits>(format, unpacked1, unpacked2));
     
     return result;
   }
 
-  static bool lessThanOrEqual  (execBV bv1, execBV bv2) {
-    ubv packed1(bitsInExecBV(),bv1);
-    ubv packed2(bitsInExecBV(),bv2);
+  static bool lessThanOrEqual (const fpt &format, execBV bv1, execBV bv2) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
     
-    uf unpacked1(symfpu::unpack<traits>(*format, packed1));
-    uf unpacked2(symfpu::unpack<traits>(*format, packed2));
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
     
-    prop result(symfpu::lessThanOrEqual<traits>(*format, unpacked1, unpacked2));
+    prop result(symfpu::lessThanOrEqual<traits>(format, unpacked1, unpacked2));
     
     return result;
   }
 
-  static execBV multiply (execBV bv1, execBV bv2) {
-    ubv packed1(bitsInExecBV(),bv1);
-    ubv packed2(bitsInExecBV(),bv2);
+  static execBV multiply (const fpt &format, const rm &mode, execBV bv1, execBV bv2) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
     
-    uf unpacked1(symfpu::unpack<traits>(*format, packed1));
-    uf unpacked2(symfpu::unpack<traits>(*format, packed2));
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
     
-    uf multiplied(symfpu::multiply<traits>(*format, *mode, unpacked1, unpacked2));
+    uf multiplied(symfpu::multiply<traits>(format, mode, unpacked1, unpacked2));
     
-    ubv repacked(symfpu::pack<traits>(*format, multiplied));
+    ubv repacked(symfpu::pack<traits>(format, multiplied));
     
     return repacked.contents();
   }
 
-  static execBV add (execBV bv1, execBV bv2) {
-    ubv packed1(bitsInExecBV(),bv1);
-    ubv packed2(bitsInExecBV(),bv2);
+  static execBV add (const fpt &format, const rm &mode, execBV bv1, execBV bv2) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
     
-    uf unpacked1(symfpu::unpack<traits>(*format, packed1));
-    uf unpacked2(symfpu::unpack<traits>(*format, packed2));
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
     
-    uf added(symfpu::add<traits>(*format, *mode, unpacked1, unpacked2, prop(true)));
+    uf added(symfpu::add<traits>(format, mode, unpacked1, unpacked2, prop(true)));
     
-    ubv repacked(symfpu::pack<traits>(*format, added));
+    ubv repacked(symfpu::pack<traits>(format, added));
     
     return repacked.contents();
   }
 
-  static execBV sub (execBV bv1, execBV bv2) {
-    ubv packed1(bitsInExecBV(),bv1);
-    ubv packed2(bitsInExecBV(),bv2);
+  static execBV sub (const fpt &format, const rm &mode, execBV bv1, execBV bv2) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
     
-    uf unpacked1(symfpu::unpack<traits>(*format, packed1));
-    uf unpacked2(symfpu::unpack<traits>(*format, packed2));
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
     
-    uf added(symfpu::add<traits>(*format, *mode, unpacked1, unpacked2, prop(false)));
+    uf added(symfpu::add<traits>(format, mode, unpacked1, unpacked2, prop(false)));
     
-    ubv repacked(symfpu::pack<traits>(*format, added));
+    ubv repacked(symfpu::pack<traits>(format, added));
     
     return repacked.contents();
   }
 
-  static execBV div (execBV bv1, execBV bv2) {
-    ubv packed1(bitsInExecBV(),bv1);
-    ubv packed2(bitsInExecBV(),bv2);
+  static execBV div (const fpt &format, const rm &mode, execBV bv1, execBV bv2) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
     
-    uf unpacked1(symfpu::unpack<traits>(*format, packed1));
-    uf unpacked2(symfpu::unpack<traits>(*format, packed2));
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
     
-    uf added(symfpu::divide<traits>(*format, *mode, unpacked1, unpacked2));
+    uf added(symfpu::divide<traits>(format, mode, unpacked1, unpacked2));
     
-    ubv repacked(symfpu::pack<traits>(*format, added));
+    ubv repacked(symfpu::pack<traits>(format, added));
     
     return repacked.contents();
   }
@@ -769,64 +832,361 @@ class sympfuImplementation {
   #define INTELSSEMAXSTYLE true
   #define INTELSSEMINSTYLE false
   
-  static execBV max (execBV bv1, execBV bv2) {
-    ubv packed1(bitsInExecBV(),bv1);
-    ubv packed2(bitsInExecBV(),bv2);
+  static execBV max (const fpt &format, execBV bv1, execBV bv2) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
     
-    uf unpacked1(symfpu::unpack<traits>(*format, packed1));
-    uf unpacked2(symfpu::unpack<traits>(*format, packed2));
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
     
-    uf max(symfpu::max<traits>(*format, unpacked1, unpacked2, INTELSSEMAXSTYLE));
+    uf max(symfpu::max<traits>(format, unpacked1, unpacked2, INTELSSEMAXSTYLE));
     
-    ubv repacked(symfpu::pack<traits>(*format, max));
+    ubv repacked(symfpu::pack<traits>(format, max));
     
     return repacked.contents();
   }
 
-  static execBV min (execBV bv1, execBV bv2) {
-    ubv packed1(bitsInExecBV(),bv1);
-    ubv packed2(bitsInExecBV(),bv2);
+  static execBV min (const fpt &format, execBV bv1, execBV bv2) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
     
-    uf unpacked1(symfpu::unpack<traits>(*format, packed1));
-    uf unpacked2(symfpu::unpack<traits>(*format, packed2));
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
     
-    uf min(symfpu::min<traits>(*format, unpacked1, unpacked2, INTELSSEMINSTYLE));
+    uf min(symfpu::min<traits>(format, unpacked1, unpacked2, INTELSSEMINSTYLE));
     
-    ubv repacked(symfpu::pack<traits>(*format, min));
+    ubv repacked(symfpu::pack<traits>(format, min));
     
     return repacked.contents();
   }
 
-  static execBV fma (execBV bv1, execBV bv2, execBV bv3) {
-    ubv packed1(bitsInExecBV(),bv1);
-    ubv packed2(bitsInExecBV(),bv2);
-    ubv packed3(bitsInExecBV(),bv3);
+  static execBV fma (const fpt &format, const rm &mode, execBV bv1, execBV bv2, execBV bv3) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
+    ubv packed3(format.packedWidth(), bv3);
     
-    uf unpacked1(symfpu::unpack<traits>(*format, packed1));
-    uf unpacked2(symfpu::unpack<traits>(*format, packed2));
-    uf unpacked3(symfpu::unpack<traits>(*format, packed3));
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
+    uf unpacked3(symfpu::unpack<traits>(format, packed3));
     
-    uf fma(symfpu::fma<traits>(*format, *mode, unpacked1, unpacked2, unpacked3));
+    uf fma(symfpu::fma<traits>(format, mode, unpacked1, unpacked2, unpacked3));
     
-    ubv repacked(symfpu::pack<traits>(*format, fma));
+    ubv repacked(symfpu::pack<traits>(format, fma));
     
     return repacked.contents();
   }
 
-  static execBV rem (execBV bv1, execBV bv2) {
-    ubv packed1(bitsInExecBV(),bv1);
-    ubv packed2(bitsInExecBV(),bv2);
+  // Mixed format operations read sourceFormat and round once to targetFormat
+  static execBV sqrt (const fpt &sourceFormat, const fpt &targetFormat, const rm &mode, execBV bv) {
+    ubv packed(sourceFormat.packedWidth(), bv);
+ 
+    uf unpacked(symfpu::unpack<traits>(sourceFormat, packed));
+    
+    uf sqrt(symfpu::sqrt<traits>(sourceFormat, targetFormat, mode, unpacked));
+    
+    ubv repacked(symfpu::pack<traits>(targetFormat, sqrt));
+    
+    return repacked.contents();
+  }
+
+  static execBV multiply (const fpt &sourceFormat, const fpt &targetFormat, const rm &mode, execBV bv1, execBV bv2) {
+    ubv packed1(sourceFormat.packedWidth(), bv1);
+    ubv packed2(sourceFormat.packedWidth(), bv2);
+    
+    uf unpacked1(symfpu::unpack<traits>(sourceFormat, packed1));
+    uf unpacked2(symfpu::unpack<traits>(sourceFormat, packed2));
+    
+    uf result(symfpu::multiply<traits>(sourceFormat, targetFormat, mode, unpacked1, unpacked2));
+    
+    ubv repacked(symfpu::pack<traits>(targetFormat, result));
+    
+    return repacked.contents();
+  }
+
+  static execBV add (const fpt &sourceFormat, const fpt &targetFormat, const rm &mode, execBV bv1, execBV bv2) {
+    ubv packed1(sourceFormat.packedWidth(), bv1);
+    ubv packed2(sourceFormat.packedWidth(), bv2);
+    
+    uf unpacked1(symfpu::unpack<traits>(sourceFormat, packed1));
+    uf unpacked2(symfpu::unpack<traits>(sourceFormat, packed2));
+    
+    uf result(symfpu::add<traits>(sourceFormat, targetFormat, mode, unpacked1, unpacked2, prop(true)));
+    
+    ubv repacked(symfpu::pack<traits>(targetFormat, result));
+    
+    return repacked.contents();
+  }
+
+  static execBV sub (const fpt &sourceFormat, const fpt &targetFormat, const rm &mode, execBV bv1, execBV bv2) {
+    ubv packed1(sourceFormat.packedWidth(), bv1);
+    ubv packed2(sourceFormat.packedWidth(), bv2);
+    
+    uf unpacked1(symfpu::unpack<traits>(sourceFormat, packed1));
+    uf unpacked2(symfpu::unpack<traits>(sourceFormat, packed2));
+    
+    uf result(symfpu::add<traits>(sourceFormat, targetFormat, mode, unpacked1, unpacked2, prop(false)));
+    
+    ubv repacked(symfpu::pack<traits>(targetFormat, result));
+    
+    return repacked.contents();
+  }
+
+  static execBV div (const fpt &sourceFormat, const fpt &targetFormat, const rm &mode, execBV bv1, execBV bv2) {
+    ubv packed1(sourceFormat.packedWidth(), bv1);
+    ubv packed2(sourceFormat.packedWidth(), bv2);
+    
+    uf unpacked1(symfpu::unpack<traits>(sourceFormat, packed1));
+    uf unpacked2(symfpu::unpack<traits>(sourceFormat, packed2));
+    
+    uf result(symfpu::divide<traits>(sourceFormat, targetFormat, mode, unpacked1, unpacked2));
+    
+    ubv repacked(symfpu::pack<traits>(targetFormat, result));
+    
+    return repacked.contents();
+  }
+
+  static execBV fma (const fpt &sourceFormat, const fpt &targetFormat, const rm &mode, execBV bv1, execBV bv2, execBV bv3) {
+    ubv packed1(sourceFormat.packedWidth(), bv1);
+    ubv packed2(sourceFormat.packedWidth(), bv2);
+    ubv packed3(sourceFormat.packedWidth(), bv3);
+    
+    uf unpacked1(symfpu::unpack<traits>(sourceFormat, packed1));
+    uf unpacked2(symfpu::unpack<traits>(sourceFormat, packed2));
+    uf unpacked3(symfpu::unpack<traits>(sourceFormat, packed3));
+    
+    uf fma(symfpu::fma<traits>(sourceFormat, targetFormat, mode, unpacked1, unpacked2, unpacked3));
+    
+    ubv repacked(symfpu::pack<traits>(targetFormat, fma));
+    
+    return repacked.contents();
+  }
+
+  // Stochastically rounded, using the packed width of the format as
+  // the number of random bits.  mode gives overflow and underflow.
+  static execBV stochasticAdd (const fpt &format, const rm &mode, execBV bv1, execBV bv2, execBV random) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
+    ubv randomBits(format.packedWidth(), random);
+    
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
+    
+    uf added(symfpu::stochasticAdd<traits>(format, mode, unpacked1, unpacked2, prop(true), randomBits));
+    
+    ubv repacked(symfpu::pack<traits>(format, added));
+    
+    return repacked.contents();
+  }
+
+  static execBV stochasticMultiply (const fpt &format, const rm &mode, execBV bv1, execBV bv2, execBV random) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
+    ubv randomBits(format.packedWidth(), random);
+    
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
+    
+    uf multiplied(symfpu::stochasticMultiply<traits>(format, mode, unpacked1, unpacked2, randomBits));
+    
+    ubv repacked(symfpu::pack<traits>(format, multiplied));
+    
+    return repacked.contents();
+  }
+
+  // The rounded result is returned and the rounding error put in error
+  static execBV augmentedAdd (const fpt &format, const rm &mode, execBV bv1, execBV bv2, execBV &error) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
+    
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
+    
+    symfpu::augmentedResult<traits> added(symfpu::augmentedAdd<traits>(format, mode, unpacked1, unpacked2, prop(true)));
     
-    uf unpacked1(symfpu::unpack<traits>(*format, packed1));
-    uf unpacked2(symfpu::unpack<traits>(*format, packed2));
+    error = symfpu::pack<traits>(format, added.error).contents();
     
-    uf min(symfpu::remainder<traits>(*format, unpacked1, unpacked2));
+    ubv repacked(symfpu::pack<traits>(format, added.value));
     
-    ubv repacked(symfpu::pack<traits>(*format, min));
+    return repacked.contents();
+  }
+
+  static execBV augmentedMultiply (const fpt &format, const rm &mode, execBV bv1, execBV bv2, execBV &error) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
+    
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
+    
+    symfpu::augmentedResult<traits> multiplied(symfpu::augmentedMultiply<traits>(format, mode, unpacked1, unpacked2));
+    
+    error = symfpu::pack<traits>(format, multiplied.error).contents();
+    
+    ubv repacked(symfpu::pack<traits>(format, multiplied.value));
     
     return repacked.contents();
   }
 
+  static execBV rem (const fpt &format, execBV bv1, execBV bv2) {
+    ubv packed1(format.packedWidth(), bv1);
+    ubv packed2(format.packedWidth(), bv2);
+    
+    uf unpacked1(symfpu::unpack<traits>(format, packed1));
+    uf unpacked2(symfpu::unpack<traits>(format, packed2));
+    
+    uf min(symfpu::remainder<traits>(format, unpacked1, unpacked2));
+    
+    ubv repacked(symfpu::pack<traits>(format, min));
+    
+    return repacked.contents();
+  }
+
+};
+
+
+
+template <class execBV, class traits>
+class sympfuImplementation {
+
+ public :
+  // Wrapped in a struct to make type scoping easier
+  // and to save on typenames.
+  // The only state is a per-thread pointer to the context.
+  
+  typedef typename traits::rm rm;
+  typedef typename traits::bwt bwt;
+  typedef typename traits::fpt fpt;
+  typedef typename traits::ubv ubv;
+  typedef typename traits::prop prop;
+  typedef symfpu::unpackedFloat<traits> uf;
+  typedef sympfuKernels<execBV, traits> kernels;
+  typedef sympfuContext<traits> context;
+  
+  static bwt bitsInExecBV () {
+    return kernels::bitsInExecBV();
+  }
+
+ protected :
+  // The context used by the current thread, owned by a scope object
+  static thread_local const context *current;
+    
+ public :
+
+  // Makes c the current thread's context for the lifetime of the object
+  class scope {
+  protected :
+    const context *previous;
+
+  public :
+    scope (const context &c) : previous(current) {
+      current = &c;
+    }
+
+    ~scope () {
+      current = previous;
+    }
+  };
+
+  static const context & getContext (void) {
+    assert(current != NULL);
+    return *current;
+  }
+  
+  static execBV unpackPack (execBV bv) {
+    return kernels::unpackPack(getContext().format, bv);
+  }
+
+  static execBV negate (execBV bv) {
+    return kernels::negate(getContext().format, bv);
+  }
+
+  static execBV absolute (execBV bv) {
+    return kernels::absolute(getContext().format, bv);
+  }
+
+  static execBV sqrt (execBV bv) {
+    return kernels::sqrt(getContext().format, getContext().mode, bv);
+  }
+
+  static execBV rti (execBV bv) {
+    return kernels::rti(getContext().format, getContext().mode, bv);
+  }
+
+  static bool isNormal (execBV bv) {
+    return kernels::isNormal(getContext().format, bv);
+  }
+
+  static bool isSubnormal (execBV bv) {
+    return kernels::isSubnormal(getContext().format, bv);
+  }
+
+  static bool isZero (execBV bv) {
+    return kernels::isZero(getContext().format, bv);
+  }
+
+  static bool isInfinite (execBV bv) {
+    return kernels::isInfinite(getContext().format, bv);
+  }
+
+  static bool isNaN (execBV bv) {
+    return kernels::isNaN(getContext().format, bv);
+  }
+
+  static bool isPositive (execBV bv) {
+    return kernels::isPositive(getContext().format, bv);
+  }
+
+  static bool isNegative (execBV bv) {
+    return kernels::isNegative(getContext().format, bv);
+  }
+
+  static bool smtlibEqual (execBV bv1, execBV bv2) {
+    return kernels::smtlibEqual(getContext().format, bv1, bv2);
+  }
+
+  static bool ieee754Equal (execBV bv1, execBV bv2) {
+    return kernels::ieee754Equal(getContext().format, bv1, bv2);
+  }
+
+  static bool lessThan (execBV bv1, execBV bv2) {
+    return kernels::lessThan(getContext().format, bv1, bv2);
+  }
+
+  static bool lessThanOrEqual (execBV bv1, execBV bv2) {
+    return kernels::lessThanOrEqual(getContext().format, bv1, bv2);
+  }
+
+  static execBV multiply (execBV bv1, execBV bv2) {
+    return kernels::multiply(getContext().format, getContext().mode, bv1, bv2);
+  }
+
+  static execBV add (execBV bv1, execBV bv2) {
+    return kernels::add(getContext().format, getContext().mode, bv1, bv2);
+  }
+
+  static execBV sub (execBV bv1, execBV bv2) {
+    return kernels::sub(getContext().format, getContext().mode, bv1, bv2);
+  }
+
+  static execBV div (execBV bv1, execBV bv2) {
+    return kernels::div(getContext().format, getContext().mode, bv1, bv2);
+  }
+
+  static execBV max (execBV bv1, execBV bv2) {
+    return kernels::max(getContext().format, bv1, bv2);
+  }
+
+  static execBV min (execBV bv1, execBV bv2) {
+    return kernels::min(getContext().format, bv1, bv2);
+  }
+
+  static execBV fma (execBV bv1, execBV bv2, execBV bv3) {
+    return kernels::fma(getContext().format, getContext().mode, bv1, bv2, bv3);
+  }
+
+  static execBV rem (execBV bv1, execBV bv2) {
+    return kernels::rem(getContext().format, bv1, bv2);
+  }
+
   
   // The SMT-LIB notion of equality
   //bool compareFloat (execBV bv1, execBV bv2);
@@ -834,10 +1194,7 @@ class sympfuImplementation {
 };
 
 template <class execBV, class traits>
-typename sympfuImplementation<execBV, traits>::rm * sympfuImplementation<execBV, traits>::mode = NULL;
-
-template <class execBV, class traits>
-typename sympfuImplementation<execBV, traits>::fpt * sympfuImplementation<execBV, traits>::format = NULL;
+thread_local const typename sympfuImplementation<execBV, traits>::context * sympfuImplementation<execBV, traits>::current = NULL;
 
 
 #endif
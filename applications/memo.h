@@ -0,0 +1,249 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** memo.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** A cache in front of the executable operations for when the same
+** operation is applied to the same constants many times, for example
+** when a solver folds literals.  Results are keyed by the operation,
+** format, rounding mode and packed inputs.
+**
+** The cache is split into shards, each with its own lock, so that
+** threads working on different keys rarely contend.  The capacity is
+** split between the shards so that together they hold at most that
+** many results; each evicts its oldest entries first.
+**
+** The lock is not held while the operation is computed, so two threads
+** that miss on the same key will both compute it; only the first
+** result to be inserted is kept.
+**
+*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "symfpu/applications/dispatch.h"
+
+#ifndef SYMFPU_MEMO
+#define SYMFPU_MEMO
+
+namespace symfpu {
+  namespace memo {
+
+    struct statistics {
+      uint64_t hits;
+      uint64_t misses;
+      uint64_t evictions;
+      size_t entries;
+
+      statistics () : hits(0), misses(0), evictions(0), entries(0) {}
+
+      double hitRate (void) const {
+	uint64_t lookups = hits + misses;
+	return (lookups == 0) ? 0.0 : ((double)hits) / ((double)lookups);
+      }
+    };
+
+
+    // Rounding modes are only comparable so are numbered for the key
+    template <class traits>
+    unsigned int roundingModeIndex (const typename traits::rm &mode) {
+      if (mode == traits::RNE()) return 0;
+      if (mode == traits::RNA()) return 1;
+      if (mode == traits::RTP()) return 2;
+      if (mode == traits::RTN()) return 3;
+      if (mode == traits::RTZ()) return 4;
+      if (isRoundToOdd<traits>(mode)) return 5;
+      assert(0);
+      return 0;
+    }
+
+
+    template <class execBV, class traits>
+    class cache {
+    public :
+      typedef typename traits::bwt bwt;
+      typedef typename traits::fpt fpt;
+      typedef sympfuContext<traits> context;
+      typedef dispatch::registry<execBV, traits> registry;
+
+    protected :
+      struct key {
+	bwt exponentWidth;
+	bwt significandWidth;
+	unsigned int op;
+	unsigned int modeAndFlags;
+	execBV a;
+	execBV b;
+	execBV d;
+
+	bool operator == (const key &k) const {
+	  return exponentWidth == k.exponentWidth &&
+	    significandWidth == k.significandWidth &&
+	    op == k.op &&
+	    modeAndFlags == k.modeAndFlags &&
+	    a == k.a && b == k.b && d == k.d;
+	}
+      };
+
+      // splitmix64 finaliser
+      static uint64_t mix (uint64_t x) {
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+      }
+
+      static uint64_t hash (const key &k) {
+	uint64_t h = mix((((uint64_t)k.exponentWidth) << 48) ^
+			 (((uint64_t)k.significandWidth) << 32) ^
+			 (((uint64_t)k.op) << 8) ^
+			 ((uint64_t)k.modeAndFlags));
+	h = mix(h ^ (uint64_t)k.a);
+	h = mix(h ^ (uint64_t)k.b);
+	h = mix(h ^ (uint64_t)k.d);
+	return h;
+      }
+
+      struct hasher {
+	size_t operator() (const key &k) const {
+	  return (size_t)hash(k);
+	}
+      };
+
+      struct shard {
+	std::mutex mutex;   // Protects the rest
+	std::unordered_map<key, execBV, hasher> entries;
+	std::deque<key> order;   // Oldest first
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	size_t capacity;
+
+	shard () : hits(0), misses(0), evictions(0), capacity(0) {}
+      };
+
+      const registry &kernels;
+      std::vector<shard> shards;
+
+      key makeKey (const dispatch::operation op, const context &c, execBV a, execBV b, execBV d) const {
+	key k;
+	k.exponentWidth = c.format.exponentWidth();
+	k.significandWidth = c.format.significandWidth();
+	k.op = op;
+	k.modeAndFlags = (roundingModeIndex<traits>(c.mode) << 2) |
+	  (flushToZero<traits>(c.format) ? 0x2 : 0x0) |
+	  (denormalsAreZero<traits>(c.format) ? 0x1 : 0x0);
+	k.a = a;
+	k.b = b;
+	k.d = d;
+	return k;
+      }
+
+      shard & shardFor (const key &k) {
+	// The low bits choose the bucket so use the high ones here
+	return shards[(hash(k) >> 32) % shards.size()];
+      }
+
+    public :
+      // capacity is the total number of results kept, split as evenly
+      // as possible between the shards.  There are never more shards
+      // than results so that every shard can hold something.
+      cache (const registry &r, size_t capacity, size_t numberOfShards = 16) :
+	kernels(r), shards((numberOfShards < capacity) ? numberOfShards : capacity) {
+	assert(numberOfShards > 0);
+	assert(capacity > 0);
+
+	for (size_t i = 0; i < shards.size(); ++i) {
+	  shards[i].capacity = (capacity / shards.size()) + ((i < capacity % shards.size()) ? 1 : 0);
+	}
+      }
+
+      execBV apply (const dispatch::operation op, const context &c, execBV a, execBV b = 0, execBV d = 0) {
+	key k(makeKey(op, c, a, b, d));
+	shard &s = shardFor(k);
+
+	{
+	  std::lock_guard<std::mutex> lock(s.mutex);
+	  typename std::unordered_map<key, execBV, hasher>::const_iterator it(s.entries.find(k));
+	  if (it != s.entries.end()) {
+	    ++s.hits;
+	    return it->second;
+	  }
+	  ++s.misses;
+	}
+
+	execBV result = kernels.apply(op, c, a, b, d);
+
+	{
+	  std::lock_guard<std::mutex> lock(s.mutex);
+	  if (s.entries.insert(std::make_pair(k, result)).second) {
+	    s.order.push_back(k);
+
+	    while (s.order.size() > s.capacity) {
+	      s.entries.erase(s.order.front());
+	      s.order.pop_front();
+	      ++s.evictions;
+	    }
+	  }
+	}
+
+	return result;
+      }
+
+      statistics stats (void) {
+	statistics total;
+	for (size_t i = 0; i < shards.size(); ++i) {
+	  std::lock_guard<std::mutex> lock(shards[i].mutex);
+	  total.hits += shards[i].hits;
+	  total.misses += shards[i].misses;
+	  total.evictions += shards[i].evictions;
+	  total.entries += shards[i].entries.size();
+	}
+	return total;
+      }
+
+      void clear (void) {
+	for (size_t i = 0; i < shards.size(); ++i) {
+	  std::lock_guard<std::mutex> lock(shards[i].mutex);
+	  shards[i].entries.clear();
+	  shards[i].order.clear();
+	  shards[i].hits = 0;
+	  shards[i].misses = 0;
+	  shards[i].evictions = 0;
+	}
+	return;
+      }
+    };
+
+  }
+}
+
+#endif
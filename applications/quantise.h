@@ -0,0 +1,460 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** quantise.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** Converting arrays of packed floating-point values to and from
+** fixed-point integers.  The fixed-point values have fractionBits
+** bits after the binary point, so they are the real value multiplied
+** by 2^fractionBits, and are held in the low targetWidth /
+** sourceWidth bits of an integer type.
+**
+** The results are those of convertFloatToSBV / convertFloatToUBV and
+** convertSBVToFloat / convertUBVToFloat (or their saturating
+** versions) with decimalPointPosition set to fractionBits.  Where a
+** back-end and format have a vectorised version it is used for as
+** much of the array as possible.
+**
+*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#endif
+
+#include "symfpu/applications/implementations.h"
+#include "symfpu/applications/batch.h"
+#include "symfpu/baseTypes/simpleExecutable.h"
+
+#ifndef SYMFPU_QUANTISE
+#define SYMFPU_QUANTISE
+
+namespace symfpu {
+  namespace quantise {
+
+    using batch::span;
+    using batch::threadPool;
+    using batch::chunkSize;
+
+
+    // Vectorised conversions for particular back-ends and formats.
+    // Each returns how many elements, from the start of the array, it
+    // has converted, which is zero if it can not handle the case.
+    template <class execBV, class traits>
+    struct vectorised {
+      typedef typename traits::bwt bwt;
+      typedef sympfuContext<traits> context;
+
+      template <class S>
+      static size_t floatToFixed (const context &, span<const execBV>, span<S>,
+				  bool, bwt, bwt, bool, S) {
+	return 0;
+      }
+
+      template <class S>
+      static size_t fixedToFloat (const context &, span<const S>, span<execBV>,
+				  bool, bwt, bwt) {
+	return 0;
+      }
+    };
+
+
+#if defined(__SSE2__)
+    // binary32 with SSE2.  The value is scaled by 2^fractionBits, which
+    // is exact, and then converted with the rounding mode set in the
+    // MXCSR.  Out of range and NaN are then detected and patched.
+    // RNA and RTO have no SSE rounding mode so are left to symfpu, as
+    // are formats that flush subnormals as the MXCSR flags are not set.
+    template <>
+    struct vectorised<uint32_t, symfpu::simpleExecutable::traits> {
+      typedef symfpu::simpleExecutable::traits traits;
+      typedef traits::bwt bwt;
+      typedef sympfuContext<traits> context;
+
+    protected :
+      static bool handled (const context &c, bool isSigned, bwt width, bwt fractionBits) {
+	return c.format.exponentWidth() == 8 &&
+	  c.format.significandWidth() == 24 &&
+	  !flushToZero<traits>(c.format) &&
+	  !denormalsAreZero<traits>(c.format) &&
+	  !(c.mode == traits::RNA()) &&
+	  !(c.mode == traits::RTO()) &&
+	  width <= (isSigned ? 32U : 31U) &&
+	  width >= (isSigned ? 2U : 1U) &&
+	  fractionBits < width;
+      }
+
+      static unsigned int mxcsrRoundingMode (const traits::rm &mode) {
+	if (mode == traits::RNE()) return _MM_ROUND_NEAREST;
+	if (mode == traits::RTP()) return _MM_ROUND_UP;
+	if (mode == traits::RTN()) return _MM_ROUND_DOWN;
+	return _MM_ROUND_TOWARD_ZERO;
+      }
+
+      // 2^exponent for -126 <= exponent <= 127
+      static float powerOfTwo (int exponent) {
+	union { uint32_t bits; float value; } u;
+	u.bits = ((uint32_t)(exponent + 127)) << 23;
+	return u.value;
+      }
+
+      class mxcsrScope {
+	unsigned int saved;
+      public :
+	mxcsrScope (unsigned int mode) : saved(_MM_GET_ROUNDING_MODE()) {
+	  _MM_SET_ROUNDING_MODE(mode);
+	}
+	~mxcsrScope () {
+	  _MM_SET_ROUNDING_MODE(saved);
+	}
+      };
+
+    public :
+      template <class S>
+      static size_t floatToFixed (const context &c, span<const uint32_t> input, span<S> output,
+				  bool isSigned, bwt targetWidth, bwt fractionBits,
+				  bool saturate, S undefValue) {
+	if (!handled(c, isSigned, targetWidth, fractionBits))
+	  return 0;
+
+	size_t length = input.size() & ~((size_t)3);
+	mxcsrScope rounding(mxcsrRoundingMode(c.mode));
+
+	const __m128 scale = _mm_set1_ps(powerOfTwo(fractionBits));
+	const __m128 upper = _mm_set1_ps(2147483648.0f);    //  2^31
+	const __m128 lower = _mm_set1_ps(-2147483648.0f);   // -2^31
+	const __m128 zero = _mm_setzero_ps();
+	// In 64 bits as targetWidth may be 32
+	const int32_t minimum = isSigned ? (int32_t)(-(((int64_t)1) << (targetWidth - 1))) : 0;
+	const int32_t maximum = (int32_t)((((int64_t)1) << (isSigned ? targetWidth - 1 : targetWidth)) - 1);
+	const __m128i minimumV = _mm_set1_epi32(minimum);
+	const __m128i maximumV = _mm_set1_epi32(maximum);
+
+	for (size_t i = 0; i < length; i += 4) {
+	  __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_loadu_si128((const __m128i *)(input.data() + i))), scale);
+	  __m128i converted = _mm_cvtps_epi32(scaled);
+
+	  // NaN fails both comparisons
+	  __m128i inRange = _mm_castps_si128(_mm_and_ps(_mm_cmpge_ps(scaled, lower), _mm_cmplt_ps(scaled, upper)));
+	  __m128i tooSmall = _mm_cmpgt_epi32(minimumV, converted);
+	  __m128i tooLarge = _mm_cmpgt_epi32(converted, maximumV);
+	  __m128i valid = _mm_andnot_si128(_mm_or_si128(tooSmall, tooLarge), inRange);
+
+	  __m128i saturated;
+	  if (isSigned) {
+	    __m128i negative = _mm_castps_si128(_mm_cmplt_ps(scaled, zero));
+	    __m128i nan = _mm_castps_si128(_mm_cmpunord_ps(scaled, scaled));
+	    saturated = _mm_andnot_si128(nan, _mm_or_si128(_mm_and_si128(negative, minimumV),
+							   _mm_andnot_si128(negative, maximumV)));
+	  } else {
+	    saturated = _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(scaled, zero)), maximumV);
+	  }
+
+	  int32_t result[4];
+	  int32_t isValid[4];
+	  _mm_storeu_si128((__m128i *)result, _mm_or_si128(_mm_and_si128(valid, converted),
+							   _mm_andnot_si128(valid, saturated)));
+	  _mm_storeu_si128((__m128i *)isValid, valid);
+
+	  for (size_t j = 0; j < 4; ++j) {
+	    output.data()[i + j] = (isValid[j] || saturate) ? (S)result[j] : undefValue;
+	  }
+	}
+
+	return length;
+      }
+
+      // Converting to float rounds (in the MXCSR mode) integers above
+      // 2^24, but scaling by 2^-fractionBits is then exact as it can not
+      // reach the subnormals, so there is only one rounding.
+      template <class S>
+      static size_t fixedToFloat (const context &c, span<const S> input, span<uint32_t> output,
+				  bool isSigned, bwt sourceWidth, bwt fractionBits) {
+	if (!handled(c, isSigned, sourceWidth, fractionBits))
+	  return 0;
+
+	size_t length = input.size() & ~((size_t)3);
+	mxcsrScope rounding(mxcsrRoundingMode(c.mode));
+
+	const __m128 scale = _mm_set1_ps(powerOfTwo(-((int)fractionBits)));
+
+	for (size_t i = 0; i < length; i += 4) {
+	  int32_t lanes[4];
+	  for (size_t j = 0; j < 4; ++j) {
+	    lanes[j] = (int32_t)input.data()[i + j];
+	  }
+
+	  __m128 converted = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)lanes));
+	  _mm_storeu_si128((__m128i *)(output.data() + i), _mm_castps_si128(_mm_mul_ps(converted, scale)));
+	}
+
+	return length;
+      }
+    };
+#endif
+
+
+    // Any format held in a uint64_t.  When every input is exactly
+    // representable the packed result is built directly from the
+    // leading zero count, whatever the rounding mode.
+    template <>
+    struct vectorised<uint64_t, symfpu::simpleExecutable::traits> {
+      typedef symfpu::simpleExecutable::traits traits;
+      typedef traits::bwt bwt;
+      typedef sympfuContext<traits> context;
+
+      template <class S>
+      static size_t floatToFixed (const context &, span<const uint64_t>, span<S>,
+				  bool, bwt, bwt, bool, S) {
+	return 0;
+      }
+
+      template <class S>
+      static size_t fixedToFloat (const context &c, span<const S> input, span<uint64_t> output,
+				  bool isSigned, bwt sourceWidth, bwt fractionBits) {
+	if (!symfpu::integerConversionIsExact<traits>(c.format, isSigned ? sourceWidth - 1 : sourceWidth,
+						      sourceWidth - 1, fractionBits))
+	  return 0;
+
+	const bwt fractionWidth = c.format.significandWidth() - 1;
+	const uint64_t bias = (((uint64_t)1) << (c.format.exponentWidth() - 1)) - 1;
+	const uint64_t signBit = ((uint64_t)1) << (c.format.packedWidth() - 1);
+	const uint64_t sourceMask = ((uint64_t)-1) >> (64 - sourceWidth);
+	const uint64_t fractionMask = (((uint64_t)1) << fractionWidth) - 1;
+
+	for (size_t i = 0; i < input.size(); ++i) {
+	  uint64_t raw = ((uint64_t)input.data()[i]) & sourceMask;
+	  bool negative = isSigned && ((raw >> (sourceWidth - 1)) & 0x1);
+	  uint64_t magnitude = negative ? ((-raw) & sourceMask) : raw;   // The most negative is still right
+
+	  if (magnitude == 0) {
+	    output.data()[i] = 0;
+	    continue;
+	  }
+
+	  bwt top = 63 - __builtin_clzll(magnitude);
+	  uint64_t fraction = ((top <= fractionWidth) ?
+			       (magnitude << (fractionWidth - top)) :
+			       (magnitude >> (top - fractionWidth))) & fractionMask;
+	  uint64_t exponent = (top + bias) - fractionBits;
+
+	  output.data()[i] = (negative ? signBit : 0) | (exponent << fractionWidth) | fraction;
+	}
+
+	return input.size();
+      }
+    };
+
+
+
+    template <class execBV, class traits>
+    class implementation {
+    public :
+      typedef typename traits::bwt bwt;
+      typedef typename traits::fpt fpt;
+      typedef typename traits::ubv ubv;
+      typedef typename traits::sbv sbv;
+      typedef symfpu::unpackedFloat<traits> uf;
+      typedef sympfuContext<traits> context;
+      typedef vectorised<execBV, traits> fast;
+
+      static const size_t defaultChunk = 1024;
+
+    protected :
+      static uf unpackElement (const context &c, execBV bv) {
+	return symfpu::unpack<traits>(c.format, ubv(c.format.packedWidth(), bv));
+      }
+
+      static execBV packElement (const context &c, const uf &u) {
+	return symfpu::pack<traits>(c.format, u).contents();
+      }
+
+      template <class IN, class OUT, class F>
+      static void parallel (threadPool &pool, span<IN> input, span<OUT> output, size_t chunk, const F &f) {
+	assert(input.size() == output.size());
+	pool.parallelFor(input.size(), chunkSize<OUT>(chunk),
+			 [&] (size_t begin, size_t end, size_t) {
+			   f(span<IN>(input.data() + begin, end - begin),
+			     span<OUT>(output.data() + begin, end - begin));
+			 });
+	return;
+      }
+
+    public :
+
+      // Float to fixed-point, undefValue is used for NaN and out of range values.
+      // Signed targets need at least two bits.
+      template <class S>
+      static void floatToSigned (const context &c, span<const execBV> input, span<S> output,
+				 bwt targetWidth, bwt fractionBits, S undefValue) {
+	assert(targetWidth >= 2);
+	assert(input.size() == output.size());
+	context local(c);
+	size_t i = fast::floatToFixed(local, input, output, true, targetWidth, fractionBits, false, undefValue);
+	sbv undef(targetWidth, undefValue);
+
+	for (; i < input.size(); ++i) {
+	  output.data()[i] = (S)symfpu::convertFloatToSBV<traits>(local.format, local.mode, unpackElement(local, input.data()[i]),
+								  targetWidth, undef, fractionBits).contents();
+	}
+	return;
+      }
+
+      template <class S>
+      static void floatToUnsigned (const context &c, span<const execBV> input, span<S> output,
+				   bwt targetWidth, bwt fractionBits, S undefValue) {
+	assert(input.size() == output.size());
+	context local(c);
+	size_t i = fast::floatToFixed(local, input, output, false, targetWidth, fractionBits, false, undefValue);
+	ubv undef(targetWidth, undefValue);
+
+	for (; i < input.size(); ++i) {
+	  output.data()[i] = (S)symfpu::convertFloatToUBV<traits>(local.format, local.mode, unpackElement(local, input.data()[i]),
+								  targetWidth, undef, fractionBits).contents();
+	}
+	return;
+      }
+
+      // Float to fixed-point, out of range values go to the nearest
+      // representable value and NaN goes to zero
+      template <class S>
+      static void floatToSignedSaturating (const context &c, span<const execBV> input, span<S> output,
+					   bwt targetWidth, bwt fractionBits) {
+	assert(targetWidth >= 2);
+	assert(input.size() == output.size());
+	context local(c);
+	size_t i = fast::floatToFixed(local, input, output, true, targetWidth, fractionBits, true, S(0));
+
+	for (; i < input.size(); ++i) {
+	  output.data()[i] = (S)symfpu::convertFloatToSBVSaturating<traits>(local.format, local.mode, unpackElement(local, input.data()[i]),
+									    targetWidth, fractionBits).contents();
+	}
+	return;
+      }
+
+      template <class S>
+      static void floatToUnsignedSaturating (const context &c, span<const execBV> input, span<S> output,
+					     bwt targetWidth, bwt fractionBits) {
+	assert(input.size() == output.size());
+	context local(c);
+	size_t i = fast::floatToFixed(local, input, output, false, targetWidth, fractionBits, true, S(0));
+
+	for (; i < input.size(); ++i) {
+	  output.data()[i] = (S)symfpu::convertFloatToUBVSaturating<traits>(local.format, local.mode, unpackElement(local, input.data()[i]),
+									    targetWidth, fractionBits).contents();
+	}
+	return;
+      }
+
+      // Fixed-point to float, the inputs must fit in sourceWidth bits.
+      // Sources that need rounding and are much wider than the target
+      // significand hit the core limitation on the significand being
+      // narrower than the exponent.
+      template <class S>
+      static void signedToFloat (const context &c, span<const S> input, span<execBV> output,
+				 bwt sourceWidth, bwt fractionBits) {
+	assert(input.size() == output.size());
+	context local(c);
+	size_t i = fast::fixedToFloat(local, input, output, true, sourceWidth, fractionBits);
+
+	for (; i < input.size(); ++i) {
+	  output.data()[i] = packElement(local, symfpu::convertSBVToFloat<traits>(local.format, local.mode,
+										  sbv(sourceWidth, input.data()[i]),
+										  fractionBits));
+	}
+	return;
+      }
+
+      template <class S>
+      static void unsignedToFloat (const context &c, span<const S> input, span<execBV> output,
+				   bwt sourceWidth, bwt fractionBits) {
+	assert(input.size() == output.size());
+	context local(c);
+	size_t i = fast::fixedToFloat(local, input, output, false, sourceWidth, fractionBits);
+
+	for (; i < input.size(); ++i) {
+	  output.data()[i] = packElement(local, symfpu::convertUBVToFloat<traits>(local.format, local.mode,
+										  ubv(sourceWidth, input.data()[i]),
+										  fractionBits));
+	}
+	return;
+      }
+
+
+      // The same spread across a pool of threads
+      template <class S>
+      static void floatToSigned (threadPool &pool, const context &c, span<const execBV> input, span<S> output,
+				 bwt targetWidth, bwt fractionBits, S undefValue, size_t chunk = defaultChunk) {
+	parallel(pool, input, output, chunk, [&] (span<const execBV> in, span<S> out) {
+	    floatToSigned(c, in, out, targetWidth, fractionBits, undefValue);
+	  });
+      }
+
+      template <class S>
+      static void floatToUnsigned (threadPool &pool, const context &c, span<const execBV> input, span<S> output,
+				   bwt targetWidth, bwt fractionBits, S undefValue, size_t chunk = defaultChunk) {
+	parallel(pool, input, output, chunk, [&] (span<const execBV> in, span<S> out) {
+	    floatToUnsigned(c, in, out, targetWidth, fractionBits, undefValue);
+	  });
+      }
+
+      template <class S>
+      static void floatToSignedSaturating (threadPool &pool, const context &c, span<const execBV> input, span<S> output,
+					   bwt targetWidth, bwt fractionBits, size_t chunk = defaultChunk) {
+	parallel(pool, input, output, chunk, [&] (span<const execBV> in, span<S> out) {
+	    floatToSignedSaturating(c, in, out, targetWidth, fractionBits);
+	  });
+      }
+
+      template <class S>
+      static void floatToUnsignedSaturating (threadPool &pool, const context &c, span<const execBV> input, span<S> output,
+					     bwt targetWidth, bwt fractionBits, size_t chunk = defaultChunk) {
+	parallel(pool, input, output, chunk, [&] (span<const execBV> in, span<S> out) {
+	    floatToUnsignedSaturating(c, in, out, targetWidth, fractionBits);
+	  });
+      }
+
+      template <class S>
+      static void signedToFloat (threadPool &pool, const context &c, span<const S> input, span<execBV> output,
+				 bwt sourceWidth, bwt fractionBits, size_t chunk = defaultChunk) {
+	parallel(pool, input, output, chunk, [&] (span<const S> in, span<execBV> out) {
+	    signedToFloat(c, in, out, sourceWidth, fractionBits);
+	  });
+      }
+
+      template <class S>
+      static void unsignedToFloat (threadPool &pool, const context &c, span<const S> input, span<execBV> output,
+				   bwt sourceWidth, bwt fractionBits, size_t chunk = defaultChunk) {
+	parallel(pool, input, output, chunk, [&] (span<const S> in, span<execBV> out) {
+	    unsignedToFloat(c, in, out, sourceWidth, fractionBits);
+	  });
+      }
+    };
+
+  }
+}
+
+#endif
@@ -0,0 +1,283 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** termMemo.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** A cache in front of the symbolic operations so that when the same
+** operation is applied to the same terms it is only encoded once.
+** Results are keyed by the operation, format, rounding mode term and
+** the terms of the inputs, with the inputs of commutative operations
+** put in a fixed order so that x + y and y + x are the same.
+**
+** The back-end must give the identity of its values with
+**   appendTermIdentity(std::vector<uint64_t> &key, const T &value)
+** for the prop, rm, sbv and ubv types, found by argument dependent
+** lookup.  Identities are only meaningful within one graph / DAG /
+** circuit, so a cache should only be used with one of them.
+**
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "symfpu/core/unpackedFloat.h"
+#include "symfpu/core/add.h"
+#include "symfpu/core/multiply.h"
+#include "symfpu/core/divide.h"
+#include "symfpu/core/fma.h"
+#include "symfpu/core/sqrt.h"
+#include "symfpu/core/remainder.h"
+#include "symfpu/core/convert.h"
+
+#ifndef SYMFPU_TERM_MEMO
+#define SYMFPU_TERM_MEMO
+
+namespace symfpu {
+  namespace termMemo {
+
+    struct statistics {
+      uint64_t hits;
+      uint64_t misses;
+      size_t entries;
+
+      statistics () : hits(0), misses(0), entries(0) {}
+
+      double hitRate (void) const {
+	uint64_t lookups = hits + misses;
+	return (lookups == 0) ? 0.0 : ((double)hits) / ((double)lookups);
+      }
+    };
+
+    enum operation {
+      ADD,
+      MULTIPLY,
+      DIVIDE,
+      FMA,
+      SQRT,
+      REMAINDER,
+      ROUND_TO_INTEGRAL
+    };
+
+
+    template <class t>
+    class cache {
+    public :
+      typedef typename t::fpt fpt;
+      typedef typename t::rm rm;
+      typedef typename t::prop prop;
+      typedef unpackedFloat<t> uf;
+
+    protected :
+      typedef std::vector<uint64_t> key;
+
+      // splitmix64 finaliser
+      static uint64_t mix (uint64_t x) {
+	x ^= x >> 30;
+	x *= 0xbf58476d1ce4e5b9ULL;
+	x ^= x >> 27;
+	x *= 0x94d049bb133111ebULL;
+	x ^= x >> 31;
+	return x;
+      }
+
+      struct hasher {
+	size_t operator() (const key &k) const {
+	  uint64_t h = k.size();
+	  for (key::const_iterator it = k.begin(); it != k.end(); ++it) {
+	    h = mix(h ^ *it);
+	  }
+	  return (size_t)h;
+	}
+      };
+
+      std::unordered_map<key, uf, hasher> entries;
+      uint64_t hits;
+      uint64_t misses;
+
+      static key makeKey (const operation op, const fpt &format) {
+	key k;
+	k.push_back(op);
+	k.push_back(format.exponentWidth());
+	k.push_back(format.significandWidth());
+	k.push_back((flushToZero<t>(format) ? 0x2 : 0x0) |
+		    (denormalsAreZero<t>(format) ? 0x1 : 0x0));
+	return k;
+      }
+
+      static key identity (const uf &f) {
+	key k;
+	appendTermIdentity(k, f.getNaN());
+	appendTermIdentity(k, f.getInf());
+	appendTermIdentity(k, f.getZero());
+	appendTermIdentity(k, f.getSign());
+	appendTermIdentity(k, f.getExponent());
+	appendTermIdentity(k, f.getSignificand());
+	return k;
+      }
+
+      static void append (key &k, const key &operand) {
+	k.insert(k.end(), operand.begin(), operand.end());
+	return;
+      }
+
+      // For commutative operations
+      static void appendInOrder (key &k, const key &l, const key &r) {
+	if (r < l) {
+	  append(k, r);
+	  append(k, l);
+	} else {
+	  append(k, l);
+	  append(k, r);
+	}
+	return;
+      }
+
+      // NULL if not known
+      const uf * lookup (const key &k) {
+	typename std::unordered_map<key, uf, hasher>::const_iterator it(entries.find(k));
+	if (it == entries.end()) {
+	  ++misses;
+	  return NULL;
+	}
+	++hits;
+	return &(it->second);
+      }
+
+      const uf & insert (const key &k, const uf &result) {
+	return entries.insert(std::make_pair(k, result)).first->second;
+      }
+
+    public :
+      cache () : hits(0), misses(0) {}
+
+
+      // Addition is commutative, subtraction is not
+      uf add (const fpt &format, const rm &roundingMode, const uf &left, const uf &right, const prop &isAdd) {
+	key k(makeKey(ADD, format));
+	appendTermIdentity(k, roundingMode);
+	appendTermIdentity(k, isAdd);
+
+	key trueIdentity;
+	appendTermIdentity(trueIdentity, prop(true));
+	key isAddIdentity;
+	appendTermIdentity(isAddIdentity, isAdd);
+
+	if (isAddIdentity == trueIdentity) {
+	  appendInOrder(k, identity(left), identity(right));
+	} else {
+	  append(k, identity(left));
+	  append(k, identity(right));
+	}
+
+	const uf *cached = this->lookup(k);
+	if (cached != NULL) return *cached;
+	return this->insert(k, symfpu::add<t>(format, roundingMode, left, right, isAdd));
+      }
+
+      uf multiply (const fpt &format, const rm &roundingMode, const uf &left, const uf &right) {
+	key k(makeKey(MULTIPLY, format));
+	appendTermIdentity(k, roundingMode);
+	appendInOrder(k, identity(left), identity(right));
+
+	const uf *cached = this->lookup(k);
+	if (cached != NULL) return *cached;
+	return this->insert(k, symfpu::multiply<t>(format, roundingMode, left, right));
+      }
+
+      uf divide (const fpt &format, const rm &roundingMode, const uf &left, const uf &right) {
+	key k(makeKey(DIVIDE, format));
+	appendTermIdentity(k, roundingMode);
+	append(k, identity(left));
+	append(k, identity(right));
+
+	const uf *cached = this->lookup(k);
+	if (cached != NULL) return *cached;
+	return this->insert(k, symfpu::divide<t>(format, roundingMode, left, right));
+      }
+
+      // The multiplication is commutative
+      uf fma (const fpt &format, const rm &roundingMode, const uf &leftMultiply, const uf &rightMultiply, const uf &addArgument) {
+	key k(makeKey(FMA, format));
+	appendTermIdentity(k, roundingMode);
+	appendInOrder(k, identity(leftMultiply), identity(rightMultiply));
+	append(k, identity(addArgument));
+
+	const uf *cached = this->lookup(k);
+	if (cached != NULL) return *cached;
+	return this->insert(k, symfpu::fma<t>(format, roundingMode, leftMultiply, rightMultiply, addArgument));
+      }
+
+      uf sqrt (const fpt &format, const rm &roundingMode, const uf &input) {
+	key k(makeKey(SQRT, format));
+	appendTermIdentity(k, roundingMode);
+	append(k, identity(input));
+
+	const uf *cached = this->lookup(k);
+	if (cached != NULL) return *cached;
+	return this->insert(k, symfpu::sqrt<t>(format, roundingMode, input));
+      }
+
+      uf remainder (const fpt &format, const uf &left, const uf &right) {
+	key k(makeKey(REMAINDER, format));
+	append(k, identity(left));
+	append(k, identity(right));
+
+	const uf *cached = this->lookup(k);
+	if (cached != NULL) return *cached;
+	return this->insert(k, symfpu::remainder<t>(format, left, right));
+      }
+
+      uf roundToIntegral (const fpt &format, const rm &roundingMode, const uf &input) {
+	key k(makeKey(ROUND_TO_INTEGRAL, format));
+	appendTermIdentity(k, roundingMode);
+	append(k, identity(input));
+
+	const uf *cached = this->lookup(k);
+	if (cached != NULL) return *cached;
+	return this->insert(k, symfpu::roundToIntegral<t>(format, roundingMode, input));
+      }
+
+
+      statistics stats (void) const {
+	statistics total;
+	total.hits = hits;
+	total.misses = misses;
+	total.entries = entries.size();
+	return total;
+      }
+
+      void clear (void) {
+	entries.clear();
+	hits = 0;
+	misses = 0;
+	return;
+      }
+    };
+
+  }
+}
+
+#endif
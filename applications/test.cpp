@@ -26,6 +26,7 @@
 **
 */
 
+#include <float.h>
 #include <math.h>
 #include <ieee754.h>
 #include <fenv.h>
@@ -33,10 +34,38 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <getopt.h>
+#include <xmmintrin.h>
+#include <pmmintrin.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include "symfpu/baseTypes/simpleExecutable.h"
+#include "symfpu/baseTypes/simpleExecutableInstantiations.h"
+#include "symfpu/baseTypes/aig.h"
+#include "symfpu/baseTypes/aigInstantiations.h"
+#include "symfpu/baseTypes/smtlib.h"
+#include "symfpu/baseTypes/smtlibInstantiations.h"
+#include "symfpu/baseTypes/cost.h"
+#include "symfpu/baseTypes/costInstantiations.h"
+#include "symfpu/baseTypes/cnf.h"
+#include "symfpu/baseTypes/cnfInstantiations.h"
+#include "symfpu/baseTypes/knownBits.h"
+#include "symfpu/baseTypes/knownBitsInstantiations.h"
+#include "symfpu/baseTypes/simplifying.h"
+#include "symfpu/baseTypes/collecting.h"
 
 #include "symfpu/applications/implementations.h"
+#include "symfpu/applications/batch.h"
+#include "symfpu/applications/block.h"
+#include "symfpu/applications/dispatch.h"
+#include "symfpu/applications/exact.h"
+#include "symfpu/applications/memo.h"
+#include "symfpu/applications/quantise.h"
+#include "symfpu/applications/termMemo.h"
+
+#include "symfpu/core/convert.h"
 
 
 /*** Test Vector Generation ***/
@@ -186,6 +215,7 @@ traits::fpt singlePrecisionFormatObject(8,24);
 
 // Thus we are using the functions in ...
 typedef sympfuImplementation<uint32_t, traits> singlePrecisionExecutableSymfpu;
+typedef singlePrecisionExecutableSymfpu::context singlePrecisionContext;
 
 // Which we then compare against
 typedef native<uint32_t, float> singlePrecisionHardware;
@@ -1138,265 +1168,2557 @@ void ternaryRoundedFunctionPrintSMT (const int /*verbose*/, const uint64_t start
 
 
 
-typedef void (*testFunction) (const int, const uint64_t, const uint64_t);
-typedef void (*printFunction) (const int, const uint64_t, const uint64_t, const char *, const char *, const char *);
+/*** Batch Execution ***/
 
-struct testStruct {
-  int enable;
-  const int usesRounding;
-  const char *name;
-  const testFunction run;
-  const printFunction printC;
-  const printFunction printSMT;
-  const char *cPrintString;
-  const char *SMTPrintString;
-};
+// The same vectors, run through the batch engine a block at a time
+#define BATCHBLOCK 0x10000
 
-struct roundingModeTestStruct {
-  int enable;
-  const char *name;
-  const int value;
-  const char *cPrintString;
-};
+typedef symfpu::batch::implementation<uint32_t, traits> singlePrecisionBatchSymfpu;
+typedef symfpu::batch::threadPool threadPool;
+typedef symfpu::batch::span<const uint32_t> inputSpan;
+typedef symfpu::batch::span<uint32_t> outputSpan;
+typedef symfpu::batch::span<bool> predicateSpan;
 
+threadPool *batchPool = NULL;
 
+uint32_t getTestBits (uint64_t index) {
+  float f = getTestValue(index);
+  return *((uint32_t *)(&f));
+}
 
+uint64_t batchLength (const uint64_t block, const uint64_t end) {
+  return (end - block < BATCHBLOCK) ? end - block : BATCHBLOCK;
+}
 
 
-/*** Application ***/
+typedef void (*unaryFunctionBFP) (threadPool &, const singlePrecisionContext &, inputSpan, outputSpan, size_t);
 
+template <unaryFunctionBFP test, unaryFunctionTFP ref>
+void unaryFunctionBatch (const int verbose, const uint64_t start, const uint64_t end) {
+  static uint32_t input[BATCHBLOCK];
+  static uint32_t computed[BATCHBLOCK];
 
+  for (uint64_t block = start; block < end; block += BATCHBLOCK) {
+    uint64_t length = batchLength(block, end);
 
-#define INCREMENT 0xFFFFFF
+    for (uint64_t k = 0; k < length; ++k) {
+      input[k] = getTestBits(block + k);
+    }
 
-#define TEST 0
-#define PRINTC 1
-#define PRINTSMT 2
+    test(*batchPool, singlePrecisionExecutableSymfpu::getContext(), inputSpan(input, length), outputSpan(computed, length), singlePrecisionBatchSymfpu::defaultChunk);
 
-// Save on typing!
-#define INST(T,F) T##Test<singlePrecisionExecutableSymfpu::F, singlePrecisionHardware::F>, T##PrintC<singlePrecisionHardware::F>, T##PrintSMT<singlePrecisionHardware::F>
+    for (uint64_t k = 0; k < length; ++k) {
+      uint32_t reference = ref(input[k]);
 
-int main (int argc, char **argv) {
-  struct testStruct tests[] = {
-    {0,0,         "unpackPack", INST( unaryFunction, unpackPack),      "f",        "f"},
-    {0,0,             "negate", INST( unaryFunction, negate),          "-f",       "(fp.neg f)"},
-    {0,0,           "absolute", INST( unaryFunction, absolute),        "fabsf(f)", "(fp.abs f)"},
-    {0,0,           "isNormal", INST(unaryPredicate, isNormal),        "isnormal(f)", "(fp.isNormal f)"},
-    {0,0,        "isSubnormal", INST(unaryPredicate, isSubnormal),     "fpclassify(f) == FP_SUBNORMAL", "(fp.isSubnormal f)"},
-    {0,0,             "isZero", INST(unaryPredicate, isZero),          "(f) == 0.0f", "(fp.isZero f)"},
-    {0,0,         "isInfinite", INST(unaryPredicate, isInfinite),      "isinf(f)", "(fp.isInfinite f)"},
-    {0,0,              "isNaN", INST(unaryPredicate, isNaN),           "isnan(f)", "(fp.isNaN f)"},
-    {0,0,         "isPositive", INST(unaryPredicate, isPositive),      "!isnan(f) && signbit(f) == 0", "(fp.isPositive f)"},
-    {0,0,         "isNegative", INST(unaryPredicate, isNegative),      "!isnan(f) && signbit(f) != 0", "(fp.isNegative f)"},
-    {0,0,      "SMT-LIB_equal", INST(binaryPredicate, smtlibEqual),    "compare(f,g)", "(= f g)"},
-    {0,0,       "IEE754_equal", INST(binaryPredicate, ieee754Equal),    "f == g",  "(fp.eq f g)"},
-    {0,0,          "less_than", INST(binaryPredicate, lessThan),         "f < g",  "(fp.lt f g)"},
-    {0,0, "less_than_or_equal", INST(binaryPredicate, lessThanOrEqual), "f <= g",  "(fp.leq f g)"},
-    {0,1,           "multiply", INST(binaryRoundedFunction, multiply),  "f * g",  "(fp.mul rm f g)"},
-    {0,1,                "add", INST(binaryRoundedFunction, add),       "f + g",  "(fp.add rm f g)"},
-    {0,1,           "subtract", INST(binaryRoundedFunction, sub),       "f - g",  "(fp.sub rm f g)"},
-    {0,1,             "divide", INST(binaryRoundedFunction, div),       "f / g",  "(fp.div rm f g)"},
-    {0,0,                "max", INST(binaryFunction, max),              "fmaxf(f,g)",  "(fp.max f g)"},
-    {0,0,                "min", INST(binaryFunction, min),              "fminf(f,g)",  "(fp.min f g)"},
-    {0,1,               "sqrt", INST(unaryRoundedFunction, sqrt),       "sqrtf(f)",  "(fp.sqrt rm f)"},
-    {0,1,  "round_to_integral", INST(unaryRoundedFunction, rti),        "(fegetround()==FE_TONEAREST) ? rintf(f) : (fegetround()==FE_UPWARD) ? ceilf(f) : (fegetround()==FE_DOWNWARD) ? floorf(f) : truncf(f)",  "(fp.roundToIntegral rm f)"},
-    {0,1,                "fma", INST(ternaryRoundedFunction, fma),      "fmaf(f,g)",  "(fp.fma rm f g h)"},
-    {0,0,          "remainder", INST(binaryFunction, rem),              "remainderf(f,g)",  "(fp.remainder f g)"},
-    {0,0,                 NULL, NULL, NULL, NULL,                           NULL,  NULL}
-  };
+      if (verbose || !singlePrecisionHardware::smtlibEqual(computed[k], reference)) {
+	fprintf(stdout,"vector[%d] ", (uint32_t)(block + k));
+	fprintf(stdout,"input = 0x%x, computed = 0x%x, real = 0x%x\n", input[k], computed[k], reference);
+	fflush(stdout);
+      }
+    }
 
-  struct roundingModeTestStruct roundingModeTests[] = {
-    {0, "RNE",  FE_TONEAREST, "FE_TONEAREST"},
-    {0, "RTP",     FE_UPWARD, "FE_UPWARD"},
-    {0, "RTN",   FE_DOWNWARD, "FE_DOWNWARD"},
-    {0, "RTZ", FE_TOWARDZERO, "FE_TOWARDZERO"},
-  //{0, "RNA",        FE_???, "FE_???"},   // Disabled until a suitable reference is available
-    {0,  NULL,             0, NULL}
-  };
+    fprintf(stdout,".");
+    fflush(stdout);
+  }
 
-  uint64_t start = 0;
-  uint64_t end = INCREMENT;
-  int verbose = 0;
-  int help = 0;
-  int enableAllTests = 0;
-  int enableAllRoundingModes = 0;
-  int continuous = 0;
-  int action = TEST;
+  return;
+}
 
-  struct option options[] = {
-    {         "verbose",        no_argument,                          &verbose,  1 },
-    {            "help",        no_argument,                             &help,  1 },
+typedef void (*unaryRoundedFunctionBFP) (threadPool &, const singlePrecisionContext &, inputSpan, outputSpan, size_t);
 
-    {           "start",  required_argument,                              NULL, 's'},
-    {             "end",  required_argument,                              NULL, 'e'},
-    {   "specialValues",        no_argument,                              NULL, 't'},
-    {      "continuous",        no_argument,                       &continuous,  1 },
+template <unaryRoundedFunctionBFP test, unaryRoundedFunctionTFP ref>
+void unaryRoundedFunctionBatch (const int verbose, const uint64_t start, const uint64_t end) {
+  static uint32_t input[BATCHBLOCK];
+  static uint32_t computed[BATCHBLOCK];
 
-    {        "allTests",        no_argument,                   &enableAllTests,  1 },
-    {"allRoundingModes",        no_argument,           &enableAllRoundingModes,  1 },
+  for (uint64_t block = start; block < end; block += BATCHBLOCK) {
+    uint64_t length = batchLength(block, end);
 
-    {          "printC",        no_argument,                           &action,  PRINTC },
-    {        "printSMT",        no_argument,                           &action,  PRINTSMT },
+    for (uint64_t k = 0; k < length; ++k) {
+      input[k] = getTestBits(block + k);
+    }
 
-    {      "unpackPack",        no_argument,                &(tests[0].enable),  1 },
-    {          "negate",        no_argument,                &(tests[1].enable),  1 },
-    {        "absolute",        no_argument,                &(tests[2].enable),  1 },
-    {        "isNormal",        no_argument,                &(tests[3].enable),  1 },
-    {     "isSubnormal",        no_argument,                &(tests[4].enable),  1 },
-    {          "isZero",        no_argument,                &(tests[5].enable),  1 },
-    {      "isInfinite",        no_argument,                &(tests[6].enable),  1 },
-    {           "isNaN",        no_argument,                &(tests[7].enable),  1 },
-    {      "isPositive",        no_argument,                &(tests[8].enable),  1 },
-    {      "isNegative",        no_argument,                &(tests[9].enable),  1 },
-    {     "smtlibEqual",        no_argument,               &(tests[10].enable),  1 },
-    {    "ieee754Equal",        no_argument,               &(tests[11].enable),  1 },
-    {        "lessThan",        no_argument,               &(tests[12].enable),  1 },
-    { "lessThanOrEqual",        no_argument,               &(tests[13].enable),  1 },
-    {        "multiply",        no_argument,               &(tests[14].enable),  1 },
-    {             "add",        no_argument,               &(tests[15].enable),  1 },
-    {        "subtract",        no_argument,               &(tests[16].enable),  1 },
-    {          "divide",        no_argument,               &(tests[17].enable),  1 },
-    {             "max",        no_argument,               &(tests[18].enable),  1 },
-    {             "min",        no_argument,               &(tests[19].enable),  1 },
-    {            "sqrt",        no_argument,               &(tests[20].enable),  1 },
-    {             "rti",        no_argument,               &(tests[21].enable),  1 },
-    {             "fma",        no_argument,               &(tests[22].enable),  1 },
-    {       "remainder",        no_argument,               &(tests[23].enable),  1 },
-    {             "rne",        no_argument,    &(roundingModeTests[0].enable),  1 },
-    {             "rtp",        no_argument,    &(roundingModeTests[1].enable),  1 },
-    {             "rtn",        no_argument,    &(roundingModeTests[2].enable),  1 },
-    {             "rtz",        no_argument,    &(roundingModeTests[3].enable),  1 },
-  //{             "rna",        no_argument,    &(roundingModeTests[4].enable),  1 },
-    {             "RNE",        no_argument,    &(roundingModeTests[0].enable),  1 },
-    {             "RTP",        no_argument,    &(roundingModeTests[1].enable),  1 },
-    {             "RTN",        no_argument,    &(roundingModeTests[2].enable),  1 },
-    {             "RTZ",        no_argument,    &(roundingModeTests[3].enable),  1 },
-  //{             "RNA",        no_argument,    &(roundingModeTests[4].enable),  1 },
-    {              NULL,                  0,                              NULL,  0 }
+    test(*batchPool, singlePrecisionExecutableSymfpu::getContext(), inputSpan(input, length), outputSpan(computed, length), singlePrecisionBatchSymfpu::defaultChunk);
 
+    for (uint64_t k = 0; k < length; ++k) {
+      uint32_t reference = ref(input[k]);
 
-  }; 
+      if (verbose || !singlePrecisionHardware::smtlibEqual(computed[k], reference)) {
+	fprintf(stdout,"vector[%d] ", (uint32_t)(block + k));
+	fprintf(stdout,"input = 0x%x, computed = 0x%x, real = 0x%x\n", input[k], computed[k], reference);
+	fflush(stdout);
+      }
+    }
 
-  bool parseOptions = true;
-  while (parseOptions) {
-    int currentOption = 0;
-    int response = getopt_long(argc, argv, "vs:e:t", options, &currentOption);
+    fprintf(stdout,".");
+    fflush(stdout);
+  }
 
-    switch(response) {
-    case 'v' :
-      verbose = 1;
-      break;
+  return;
+}
 
-    case 's' :
-      start = strtoull(optarg,NULL,0);
-      break;
+typedef void (*unaryPredicateBFP) (threadPool &, const singlePrecisionContext &, inputSpan, predicateSpan, size_t);
 
-    case 'e' :
-      end = strtoull(optarg,NULL,0);
-      break;
+template <unaryPredicateBFP test, unaryPredicateTFP ref>
+void unaryPredicateBatch (const int verbose, const uint64_t start, const uint64_t end) {
+  static uint32_t input[BATCHBLOCK];
+  static bool computed[BATCHBLOCK];
 
-    case 't' :
-      end = NUMBER_OF_FLOAT_TESTS  * NUMBER_OF_FLOAT_TESTS; // TODO : split doesn't work like this so this isn't quite right
-      break;
+  for (uint64_t block = start; block < end; block += BATCHBLOCK) {
+    uint64_t length = batchLength(block, end);
 
-    case 0 :    /* Flag set */
-      break;
+    for (uint64_t k = 0; k < length; ++k) {
+      input[k] = getTestBits(block + k);
+    }
 
-    case -1 :   /* End of options */
-      parseOptions = false;
-      break;
+    test(*batchPool, singlePrecisionExecutableSymfpu::getContext(), inputSpan(input, length), predicateSpan(computed, length), singlePrecisionBatchSymfpu::defaultChunk);
 
-    case '?' :  /* Unknown option */
-      fprintf(stderr,"Unknown option : \"%s\"\n", optarg);
-      return 1;
-      break;
+    for (uint64_t k = 0; k < length; ++k) {
+      bool reference = ref(input[k]);
 
-    default :   /* Unrecognised getopt response */
-      fprintf(stderr,"Unrecognised getopt response \'%d\' from \"%s\"\n",response, optarg);
-      return 1;
-      break;
+      if (verbose || !(computed[k] == reference)) {
+	fprintf(stdout,"vector[%d] ", (uint32_t)(block + k));
+	fprintf(stdout,"input = 0x%x, computed = %d, real = %d\n", input[k], computed[k], reference);
+	fflush(stdout);
+      }
     }
+
+    fprintf(stdout,".");
+    fflush(stdout);
   }
 
-  /* Help text */
-  if (help) {
-    fprintf(stderr, "TODO: Super helpful message here!\n");
+  return;
+}
 
-    fprintf(stderr, "Options : \n");
-    struct option *opt = &(options[0]);
-    while (opt->name != NULL) {
-      switch (opt->has_arg) {
-      case no_argument : fprintf(stderr, "\t--%s\n", opt->name); break;
-      case required_argument : fprintf(stderr, "\t--%s\t  argument\n", opt->name); break;
-      case optional_argument : fprintf(stderr, "\t--%s\t[ argument ]\n", opt->name); break;
-      default :	fprintf(stderr, "\t--%s\t???\n", opt->name); break;
-      }
+typedef void (*binaryPredicateBFP) (threadPool &, const singlePrecisionContext &, inputSpan, inputSpan, predicateSpan, size_t);
 
-      ++opt;
+template <binaryPredicateBFP test, binaryPredicateTFP ref>
+void binaryPredicateBatch (const int verbose, const uint64_t start, const uint64_t end) {
+  static uint32_t input1[BATCHBLOCK];
+  static uint32_t input2[BATCHBLOCK];
+  static bool computed[BATCHBLOCK];
+
+  for (uint64_t block = start; block < end; block += BATCHBLOCK) {
+    uint64_t length = batchLength(block, end);
+
+    for (uint64_t k = 0; k < length; ++k) {
+      input1[k] = getTestBits(splitRight(block + k));
+      input2[k] = getTestBits(splitLeft(block + k));
     }
 
-    return 0;
-  }
+    test(*batchPool, singlePrecisionExecutableSymfpu::getContext(), inputSpan(input1, length), inputSpan(input2, length), predicateSpan(computed, length), singlePrecisionBatchSymfpu::defaultChunk);
 
-  int roundingModeSet = 0;
-  uint64_t j = 0;
-  while (roundingModeTests[j].name != NULL) {
-    roundingModeSet |= roundingModeTests[j].enable;
-    ++j;
+    for (uint64_t k = 0; k < length; ++k) {
+      bool reference = ref(input1[k], input2[k]);
+
+      if (verbose || !(computed[k] == reference)) {
+	fprintf(stdout,"vector[%d] ", (uint32_t)(block + k));
+	fprintf(stdout,"input1 = 0x%x, input2 = 0x%x, computed = %d, real = %d\n", input1[k], input2[k], computed[k], reference);
+	fflush(stdout);
+      }
+    }
+
+    fprintf(stdout,".");
+    fflush(stdout);
   }
-  if (!roundingModeSet && !enableAllRoundingModes) {
-    // Set default rounding mode of RNE
-    roundingModeTests[0].enable = 1;
+
+  return;
+}
+
+typedef void (*binaryFunctionBFP) (threadPool &, const singlePrecisionContext &, inputSpan, inputSpan, outputSpan, size_t);
+
+template <binaryFunctionBFP test, binaryFunctionTFP ref>
+void binaryFunctionBatch (const int verbose, const uint64_t start, const uint64_t end) {
+  static uint32_t input1[BATCHBLOCK];
+  static uint32_t input2[BATCHBLOCK];
+  static uint32_t computed[BATCHBLOCK];
+
+  for (uint64_t block = start; block < end; block += BATCHBLOCK) {
+    uint64_t length = batchLength(block, end);
+
+    for (uint64_t k = 0; k < length; ++k) {
+      input1[k] = getTestBits(splitRight(block + k));
+      input2[k] = getTestBits(splitLeft(block + k));
+    }
+
+    test(*batchPool, singlePrecisionExecutableSymfpu::getContext(), inputSpan(input1, length), inputSpan(input2, length), outputSpan(computed, length), singlePrecisionBatchSymfpu::defaultChunk);
+
+    for (uint64_t k = 0; k < length; ++k) {
+      uint32_t reference = ref(input1[k], input2[k]);
+
+      if (verbose || !singlePrecisionHardware::smtlibEqual(computed[k], reference)) {
+	fprintf(stdout,"vector[%d] ", (uint32_t)(block + k));
+	fprintf(stdout,"input1 = 0x%x, input2 = 0x%x, computed = 0x%x, real = 0x%x\n", input1[k], input2[k], computed[k], reference);
+	fflush(stdout);
+      }
+    }
+
+    fprintf(stdout,".");
+    fflush(stdout);
   }
 
+  return;
+}
 
-  singlePrecisionExecutableSymfpu::setFormat(singlePrecisionFormatObject);
-  
- top :
+typedef void (*binaryRoundedFunctionBFP) (threadPool &, const singlePrecisionContext &, inputSpan, inputSpan, outputSpan, size_t);
 
-  /* Run the tests */
-  int i = 0;
-  while (tests[i].name != NULL) {
-    if (enableAllTests || tests[i].enable) {
-      if (tests[i].usesRounding) {
-	
-	int j = 0;
-	while (roundingModeTests[j].name != NULL) {
-	  if (enableAllRoundingModes || roundingModeTests[j].enable) {
-	    fprintf(stdout, "Running test for %s %s : ", tests[i].name, roundingModeTests[j].name);
-	    fflush(stdout);
+template <binaryRoundedFunctionBFP test, binaryRoundedFunctionTFP ref>
+void binaryRoundedFunctionBatch (const int verbose, const uint64_t start, const uint64_t end) {
+  static uint32_t input1[BATCHBLOCK];
+  static uint32_t input2[BATCHBLOCK];
+  static uint32_t computed[BATCHBLOCK];
 
-	    singlePrecisionExecutableSymfpu::setRoundingMode(roundingModeTests[j].value);
-	    singlePrecisionHardware::setRoundingMode(roundingModeTests[j].value);
-	    
-	    switch (action) {
-	    case TEST :
-	      tests[i].run(verbose, start, end);
-	      break;
-	      
-	    case PRINTC :
-	      tests[i].printC(verbose, start, end, tests[i].name, tests[i].cPrintString, roundingModeTests[j].cPrintString);
-	      break;
-	      
-	    case PRINTSMT :
-	      tests[i].printSMT(verbose, start, end, tests[i].name, tests[i].SMTPrintString, roundingModeTests[j].name);
-	      break;
-	      
-	    default :
-	      assert(0);
-	      break;
-	    }
+  for (uint64_t block = start; block < end; block += BATCHBLOCK) {
+    uint64_t length = batchLength(block, end);
 
-	    fprintf(stdout, "\n");
-	    fflush(stdout);
-	  }
-	  ++j;
-	}
+    for (uint64_t k = 0; k < length; ++k) {
+      input1[k] = getTestBits(splitRight(block + k));
+      input2[k] = getTestBits(splitLeft(block + k));
+    }
 
+    test(*batchPool, singlePrecisionExecutableSymfpu::getContext(), inputSpan(input1, length), inputSpan(input2, length), outputSpan(computed, length), singlePrecisionBatchSymfpu::defaultChunk);
 
-      } else {
-	fprintf(stdout, "Running test for %s : ", tests[i].name);
+    for (uint64_t k = 0; k < length; ++k) {
+      uint32_t reference = ref(input1[k], input2[k]);
+
+      if (verbose || !singlePrecisionHardware::smtlibEqual(computed[k], reference)) {
+	fprintf(stdout,"vector[%d] ", (uint32_t)(block + k));
+	fprintf(stdout,"input1 = 0x%x, input2 = 0x%x, computed = 0x%x, real = 0x%x\n", input1[k], input2[k], computed[k], reference);
 	fflush(stdout);
+      }
+    }
+
+    fprintf(stdout,".");
+    fflush(stdout);
+  }
+
+  return;
+}
+
+typedef void (*ternaryRoundedFunctionBFP) (threadPool &, const singlePrecisionContext &, inputSpan, inputSpan, inputSpan, outputSpan, size_t);
+
+template <ternaryRoundedFunctionBFP test, ternaryRoundedFunctionTFP ref>
+void ternaryRoundedFunctionBatch (const int verbose, const uint64_t start, const uint64_t end) {
+  static uint32_t input1[BATCHBLOCK];
+  static uint32_t input2[BATCHBLOCK];
+  static uint32_t input3[BATCHBLOCK];
+  static uint32_t computed[BATCHBLOCK];
+
+  for (uint64_t block = start; block < end; block += BATCHBLOCK) {
+    uint64_t length = batchLength(block, end);
+
+    for (uint64_t k = 0; k < length; ++k) {
+      input1[k] = getTestBits(splitOneOfThree(block + k));
+      input2[k] = getTestBits(splitTwoOfThree(block + k));
+      input3[k] = getTestBits(splitThreeOfThree(block + k));
+    }
+
+    test(*batchPool, singlePrecisionExecutableSymfpu::getContext(), inputSpan(input1, length), inputSpan(input2, length), inputSpan(input3, length), outputSpan(computed, length), singlePrecisionBatchSymfpu::defaultChunk);
+
+    for (uint64_t k = 0; k < length; ++k) {
+      uint32_t reference = ref(input1[k], input2[k], input3[k]);
+
+      if (verbose || !singlePrecisionHardware::smtlibEqual(computed[k], reference)) {
+	fprintf(stdout,"vector[%d] ", (uint32_t)(block + k));
+	fprintf(stdout,"input1 = 0x%x, input2 = 0x%x, input3 = 0x%x, computed = 0x%x, real = 0x%x\n", input1[k], input2[k], input3[k], computed[k], reference);
+	fflush(stdout);
+      }
+    }
+
+    fprintf(stdout,".");
+    fflush(stdout);
+  }
+
+  return;
+}
+
+
+
+/*** Dispatched Execution ***/
+
+// The same operations, looked up at run-time from the current format
+typedef symfpu::dispatch::registry<uint32_t, traits> singlePrecisionRegistry;
+singlePrecisionRegistry dispatchRegistry;
+
+class singlePrecisionDispatched {
+ public :
+
+#define DISPATCHFUNCTION(F, OP)						\
+  static uint32_t F (uint32_t a) {					\
+    return dispatchRegistry.apply(symfpu::dispatch::OP, singlePrecisionExecutableSymfpu::getContext(), a); \
+  }
+
+#define DISPATCHPREDICATE(F, OP)					\
+  static bool F (uint32_t a) {						\
+    return dispatchRegistry.apply(symfpu::dispatch::OP, singlePrecisionExecutableSymfpu::getContext(), a); \
+  }
+
+#define DISPATCHBINARYFUNCTION(F, OP)					\
+  static uint32_t F (uint32_t a, uint32_t b) {				\
+    return dispatchRegistry.apply(symfpu::dispatch::OP, singlePrecisionExecutableSymfpu::getContext(), a, b); \
+  }
+
+#define DISPATCHBINARYPREDICATE(F, OP)					\
+  static bool F (uint32_t a, uint32_t b) {				\
+    return dispatchRegistry.apply(symfpu::dispatch::OP, singlePrecisionExecutableSymfpu::getContext(), a, b); \
+  }
+
+  DISPATCHFUNCTION(unpackPack, UNPACKPACK)
+  DISPATCHFUNCTION(negate, NEGATE)
+  DISPATCHFUNCTION(absolute, ABSOLUTE)
+  DISPATCHFUNCTION(sqrt, SQRT)
+  DISPATCHFUNCTION(rti, RTI)
+  DISPATCHPREDICATE(isNormal, ISNORMAL)
+  DISPATCHPREDICATE(isSubnormal, ISSUBNORMAL)
+  DISPATCHPREDICATE(isZero, ISZERO)
+  DISPATCHPREDICATE(isInfinite, ISINFINITE)
+  DISPATCHPREDICATE(isNaN, ISNAN)
+  DISPATCHPREDICATE(isPositive, ISPOSITIVE)
+  DISPATCHPREDICATE(isNegative, ISNEGATIVE)
+  DISPATCHBINARYPREDICATE(smtlibEqual, SMTLIBEQUAL)
+  DISPATCHBINARYPREDICATE(ieee754Equal, IEEE754EQUAL)
+  DISPATCHBINARYPREDICATE(lessThan, LESSTHAN)
+  DISPATCHBINARYPREDICATE(lessThanOrEqual, LESSTHANOREQUAL)
+  DISPATCHBINARYFUNCTION(multiply, MULTIPLY)
+  DISPATCHBINARYFUNCTION(add, ADD)
+  DISPATCHBINARYFUNCTION(sub, SUB)
+  DISPATCHBINARYFUNCTION(div, DIV)
+  DISPATCHBINARYFUNCTION(max, MAX)
+  DISPATCHBINARYFUNCTION(min, MIN)
+  DISPATCHBINARYFUNCTION(rem, REM)
+
+  static uint32_t fma (uint32_t a, uint32_t b, uint32_t c) {
+    return dispatchRegistry.apply(symfpu::dispatch::FMA, singlePrecisionExecutableSymfpu::getContext(), a, b, c);
+  }
+};
+
+
+
+/*** Focused Checks ***/
+
+// Fixed cases for things that the tests above do not reach, such as
+// other formats and conversions.  Failures are reported as vectors.
+
+void checkResult (const int verbose, const uint64_t index, const char *name, const uint64_t computed, const uint64_t reference) {
+  if (verbose || computed != reference) {
+    fprintf(stdout,"vector[%d] ", (uint32_t)index);
+    fprintf(stdout,"%s : computed = 0x%lx, real = 0x%lx\n", name, computed, reference);
+    fflush(stdout);
+  }
+  return;
+}
+
+uint32_t floatToBits (float f) {
+  return *((uint32_t *)(&f));
+}
+
+struct convertToSignedCase {
+  float input;
+  int width;
+  int64_t rne;        // Also saturating
+  int64_t rtz;
+};
+
+// The most negative value at each width is the one that needs care.
+// Rounding to 64 bits needs wider bit-vectors than simpleExecutable has.
+static const convertToSignedCase convertToSignedCases[] = {
+  {                 -128.0f,  8,                  -128LL,                  -128LL},
+  {                 -127.5f,  8,                  -128LL,                  -127LL},
+  {                 -128.5f,  8,                  -128LL,                  -128LL},
+  {                  127.0f,  8,                   127LL,                   127LL},
+  {                   -1.0f,  8,                    -1LL,                    -1LL},
+  {               -32768.0f, 16,                -32768LL,                -32768LL},
+  {               -32767.5f, 16,                -32768LL,                -32767LL},
+  {               -32768.5f, 16,                -32768LL,                -32768LL},
+  {          -2147483648.0f, 32,           -2147483648LL,           -2147483648LL},
+  {          -2147483520.0f, 32,           -2147483520LL,           -2147483520LL}
+};
+
+void checkConvertToSigned (const int verbose) {
+  typedef traits::sbv sbv;
+  typedef traits::ubv ubv;
+  typedef symfpu::unpackedFloat<traits> uf;
+
+  const uint64_t cases = sizeof(convertToSignedCases) / sizeof(convertToSignedCase);
+  for (uint64_t i = 0; i < cases; ++i) {
+    const convertToSignedCase &c = convertToSignedCases[i];
+    uf input(symfpu::unpack<traits>(singlePrecisionFormatObject, ubv(32, floatToBits(c.input))));
+    sbv undef(sbv::zero(c.width));
+
+    sbv rne(symfpu::convertFloatToSBV<traits>(singlePrecisionFormatObject, traits::RNE(), input, c.width, undef));
+    checkResult(verbose, i, "convertFloatToSBV RNE", rne.contents(), c.rne);
+
+    sbv saturated(symfpu::convertFloatToSBVSaturating<traits>(singlePrecisionFormatObject, traits::RNE(), input, c.width));
+    checkResult(verbose, i, "convertFloatToSBVSaturating RNE", saturated.contents(), c.rne);
+
+    sbv rtz(symfpu::convertFloatToSBV<traits>(singlePrecisionFormatObject, traits::RTZ(), input, c.width, undef));
+    checkResult(verbose, i, "convertFloatToSBV RTZ", rtz.contents(), c.rtz);
+
+    sbv truncated(symfpu::convertFloatToSBVRTZ<traits>(singlePrecisionFormatObject, input, c.width, undef));
+    checkResult(verbose, i, "convertFloatToSBVRTZ", truncated.contents(), c.rtz);
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// Against SSE with the MXCSR flush-to-zero and denormals-are-zero bits
+static const float flushValues[] = {
+   0x0p+0f,        -0x0p+0f,
+   0x1p-149f,      -0x1p-149f,
+   0x1.fffffcp-127f, -0x1.fffffcp-127f,
+   0x1p-126f,      -0x1p-126f,
+   0x1.000002p-126f, -0x1.8p-126f,
+   0x1p-125f,      -0x1.000002p-125f,
+   0x1p-1f,        -0x1p+0f,
+   0x1.8p+0f,       INFINITY
+};
+
+static const struct { int fenvMode; unsigned int mxcsrMode; } flushRoundingModes[] = {
+  {  FE_TONEAREST,     _MM_ROUND_NEAREST },
+  {    FE_UPWARD,          _MM_ROUND_UP },
+  {  FE_DOWNWARD,        _MM_ROUND_DOWN },
+  {FE_TOWARDZERO, _MM_ROUND_TOWARD_ZERO }
+};
+
+uint32_t sseFlushed (const unsigned int mxcsrMode, const bool ftz, const bool daz, const int operation, const float f, const float g) {
+  unsigned int saved = _mm_getcsr();
+  _mm_setcsr((saved & ~(_MM_ROUND_MASK | _MM_FLUSH_ZERO_MASK | _MM_DENORMALS_ZERO_MASK)) |
+	     mxcsrMode |
+	     (ftz ? _MM_FLUSH_ZERO_ON : _MM_FLUSH_ZERO_OFF) |
+	     (daz ? _MM_DENORMALS_ZERO_ON : _MM_DENORMALS_ZERO_OFF));
+
+  volatile float left = f;
+  volatile float right = g;
+  volatile float result;
+  switch (operation) {
+  case 0 : result = left + right; break;
+  case 1 : result = left - right; break;
+  case 2 : result = left * right; break;
+  default : result = left / right; break;
+  }
+
+  _mm_setcsr(saved);
+  return floatToBits(result);
+}
+
+void checkFlushToZero (const int verbose) {
+  typedef sympfuKernels<uint32_t, traits> kernels;
+  static const char * names[] = { "add", "sub", "multiply", "divide" };
+
+  const uint64_t values = sizeof(flushValues) / sizeof(float);
+  const uint64_t modes = sizeof(flushRoundingModes) / sizeof(flushRoundingModes[0]);
+  uint64_t index = 0;
+
+  for (int flags = 1; flags <= 3; ++flags) {
+    bool ftz = flags & 0x2;
+    bool daz = flags & 0x1;
+    fpt format(8, 24, ftz, daz);
+
+    for (uint64_t m = 0; m < modes; ++m) {
+      traits::rm mode(singlePrecisionContext::nativeRoundingMode(flushRoundingModes[m].fenvMode));
+
+      for (int operation = 0; operation < 4; ++operation) {
+	for (uint64_t i = 0; i < values; ++i) {
+	  for (uint64_t j = 0; j < values; ++j) {
+	    uint32_t f = floatToBits(flushValues[i]);
+	    uint32_t g = floatToBits(flushValues[j]);
+	    uint32_t computed;
+	    switch (operation) {
+	    case 0 : computed = kernels::add(format, mode, f, g); break;
+	    case 1 : computed = kernels::sub(format, mode, f, g); break;
+	    case 2 : computed = kernels::multiply(format, mode, f, g); break;
+	    default : computed = kernels::div(format, mode, f, g); break;
+	    }
+	    uint32_t reference = sseFlushed(flushRoundingModes[m].mxcsrMode, ftz, daz, operation,
+					    flushValues[i], flushValues[j]);
+
+	    checkResult(verbose, index, names[operation], computed,
+			singlePrecisionHardware::smtlibEqual(computed, reference) ? computed : reference);
+	    ++index;
+	  }
+	}
+      }
+    }
+  }
+
+  // The quantise kernels must not use the hardware's subnormal handling
+  // so the whole array, which is vectorised, gives the same as each
+  // element on its own, which is not
+  typedef symfpu::quantise::implementation<uint32_t, traits> quantiser;
+  typedef symfpu::batch::span<int32_t> fixedSpan;
+  std::vector<uint32_t> input;
+  for (int repeat = 0; repeat < 4; ++repeat) {
+    for (uint64_t i = 0; i < values; ++i) {
+      input.push_back(floatToBits(flushValues[i]));
+    }
+  }
+
+  for (int flags = 1; flags <= 3; ++flags) {
+    fpt format(8, 24, flags & 0x2, flags & 0x1);
+
+    for (uint64_t m = 0; m < modes; ++m) {
+      singlePrecisionContext context(format, flushRoundingModes[m].fenvMode);
+
+      for (traits::bwt fraction = 0; fraction <= 20; fraction += 20) {
+	std::vector<int32_t> fixed(input.size());
+	quantiser::floatToSignedSaturating<int32_t>(context, inputSpan(input.data(), input.size()), fixedSpan(fixed), 32, fraction);
+
+	for (size_t i = 0; i < input.size(); ++i) {
+	  int32_t single = 0;
+	  quantiser::floatToSignedSaturating<int32_t>(context, inputSpan(input.data() + i, 1), fixedSpan(&single, 1), 32, fraction);
+	  checkResult(verbose, index, "quantise floatToSignedSaturating", (uint32_t)fixed[i], (uint32_t)single);
+	  ++index;
+	}
+      }
+    }
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// Dispatched operations must use the flags of the format in the context
+void checkDispatchFlags (const int verbose) {
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  singlePrecisionRegistry r;
+
+  const uint64_t values = sizeof(flushValues) / sizeof(float);
+  uint64_t index = 0;
+
+  for (int flags = 0; flags <= 3; ++flags) {
+    fpt format(8, 24, flags & 0x2, flags & 0x1);
+    singlePrecisionContext context(format, FE_TONEAREST);
+
+    for (uint64_t i = 0; i < values; ++i) {
+      for (uint64_t j = 0; j < values; ++j) {
+	uint32_t f = floatToBits(flushValues[i]);
+	uint32_t g = floatToBits(flushValues[j]);
+
+	checkResult(verbose, index, "dispatched multiply",
+		    r.apply(symfpu::dispatch::MULTIPLY, context, f, g),
+		    kernels::multiply(format, context.mode, f, g));
+	checkResult(verbose, index, "dispatched add",
+		    r.apply(symfpu::dispatch::ADD, context, f, g),
+		    kernels::add(format, context.mode, f, g));
+	++index;
+      }
+    }
+  }
+
+  // Half of the smallest normal is flushed
+  fpt ftz(8, 24, true, false);
+  singlePrecisionContext context(ftz, FE_TONEAREST);
+  checkResult(verbose, index, "dispatched multiply FTZ",
+	      r.apply(symfpu::dispatch::MULTIPLY, context, floatToBits(0x1p-126f), floatToBits(0x1p-1f)),
+	      0x0);
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// The capacity is a limit on the whole cache, not each shard
+void checkMemo (const int verbose) {
+  typedef symfpu::memo::cache<uint32_t, traits> memoCache;
+
+  singlePrecisionRegistry r;
+  singlePrecisionContext context(singlePrecisionFormatObject, FE_TONEAREST);
+  const size_t capacities[] = { 1, 10, 100 };
+  uint64_t index = 0;
+
+  for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); ++c) {
+    memoCache memo(r, capacities[c]);
+
+    for (uint64_t i = 0; i < NUMBER_OF_FLOAT_TESTS; ++i) {
+      uint32_t f = floatToBits(getTestValue(i));
+      uint32_t g = floatToBits(getTestValue(NUMBER_OF_FLOAT_TESTS - 1 - i));
+
+      checkResult(verbose, index, "memo add",
+		  memo.apply(symfpu::dispatch::ADD, context, f, g),
+		  r.apply(symfpu::dispatch::ADD, context, f, g));
+      checkResult(verbose, index, "memo add again",
+		  memo.apply(symfpu::dispatch::ADD, context, f, g),
+		  r.apply(symfpu::dispatch::ADD, context, f, g));
+      ++index;
+    }
+
+    symfpu::memo::statistics stats(memo.stats());
+    checkResult(verbose, index, "memo entries", stats.entries > capacities[c], 0);
+    checkResult(verbose, index, "memo hits", stats.hits < NUMBER_OF_FLOAT_TESTS, 0);  // Each repeat hits
+    ++index;
+  }
+
+  // The flags are part of the key
+  memoCache memo(r, 16);
+  uint32_t f = floatToBits(0x1p-126f);
+  uint32_t g = floatToBits(0x1p-1f);
+  singlePrecisionContext ftz(fpt(8, 24, true, false), FE_TONEAREST);
+  checkResult(verbose, index, "memo multiply",
+	      memo.apply(symfpu::dispatch::MULTIPLY, context, f, g), 0x00400000);
+  checkResult(verbose, index, "memo multiply FTZ",
+	      memo.apply(symfpu::dispatch::MULTIPLY, ftz, f, g), 0x0);
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// With RNE the error is exactly what TwoSum computes.  Binary64 is
+// included as its packed width is the most simpleExecutable allows.
+template <class execFloat>
+execFloat twoSumError (const execFloat f, const execFloat g, const execFloat scale) {
+  volatile execFloat sum = f * scale + g * scale;
+  volatile execFloat virtualG = sum - f * scale;
+  volatile execFloat virtualF = sum - virtualG;
+  return ((f * scale - virtualF) + (g * scale - virtualG)) / scale;
+}
+
+template <class execFloat, class execBV>
+void checkTwoSum (const int verbose, const uint64_t index, const char *name, const fpt &format, const execFloat f, const execFloat g) {
+  typedef sympfuKernels<execBV, traits> kernels;
+
+  volatile execFloat sum = f + g;
+  execFloat error = sum;
+  if (sum - sum == 0) {
+    error = twoSumError(f, g, (execFloat)1.0);
+    if (error - error != 0) {
+      // Near the largest number sum - f can overflow, halving is exact there
+      error = twoSumError(f, g, (execFloat)0.5);
+    }
+  }
+
+  execBV computedError;
+  execBV computed = kernels::augmentedAdd(format, traits::RNE(), *((execBV *)&f), *((execBV *)&g), computedError);
+
+  // Zeros of either sign and NaNs of any payload are the same here
+  execFloat s = sum;
+  execFloat c = *((execFloat *)&computed);
+  execFloat e = *((execFloat *)&computedError);
+  checkResult(verbose, index, name, computed,
+	      (c == s || (c != c && s != s)) ? computed : *((execBV *)&s));
+  checkResult(verbose, index, name, computedError,
+	      (e == error || (e != e && error != error)) ? computedError : *((execBV *)&error));
+  return;
+}
+
+// The directed rounding modes, against a reference from double.  exact
+// is the exact result, which a double holds for the products of
+// binary32 values and the sums that are checked.  If rounding exact
+// with an unbounded exponent passes the largest finite value the
+// error is the rounded result, otherwise it is the exact difference
+// rounded in the same mode.
+float augmentedReference (const double exact, const int fenvMode, float &error) {
+  fesetround(fenvMode);
+  volatile float rounded = (float)exact;
+  volatile float scaled = (float)(exact * 0x1p-64);
+  bool overflow = (fabs(exact) > 0x1p100) && (fabs((double)scaled * 0x1p64) > FLT_MAX);
+  volatile double difference = exact - (double)rounded;
+  error = overflow ? rounded : (float)difference;
+  fesetround(FE_TONEAREST);
+  return rounded;
+}
+
+template <class execFloat, class execBV>
+void checkAugmentedResult (const int verbose, const uint64_t index, const char *name,
+			   const execBV computed, const execBV computedError,
+			   const execFloat reference, const execFloat referenceError) {
+  // Zeros of either sign and NaNs of any payload are the same here
+  execFloat c = *((execFloat *)&computed);
+  execFloat e = *((execFloat *)&computedError);
+  checkResult(verbose, index, name, computed,
+	      (c == reference || (c != c && reference != reference)) ? computed : *((execBV *)&reference));
+  checkResult(verbose, index, name, computedError,
+	      (e == referenceError || (e != e && referenceError != referenceError)) ? computedError : *((execBV *)&referenceError));
+  return;
+}
+
+static const struct { int fenvMode; const char *add; const char *multiply; } augmentedDirectedModes[] = {
+  {    FE_UPWARD,   "augmentedAdd RTP",   "augmentedMultiply RTP" },
+  {  FE_DOWNWARD,   "augmentedAdd RTN",   "augmentedMultiply RTN" },
+  {FE_TOWARDZERO,   "augmentedAdd RTZ",   "augmentedMultiply RTZ" }
+};
+
+// Pairs that overflow to the largest finite value in some of the
+// directed modes, or only just do not
+static const float augmentedOverflowValues[][2] = {
+  {    FLT_MAX,    FLT_MAX },
+  {   -FLT_MAX,   -FLT_MAX },
+  {    FLT_MAX,  0x1p+103f },
+  {    FLT_MAX,  0x1p+104f },
+  {   -FLT_MAX, -0x1p+104f },
+  {  0x1p+127f,      2.0f },
+  {  0x1p+127f,     -2.0f },
+  {  0x1.fffffep+63f, 0x1.fffffep+64f },
+  { -0x1.fffffep+63f, 0x1.000002p+64f }
+};
+
+void checkAugmentedAdd (const int verbose) {
+  int savedMode = fegetround();
+  fesetround(FE_TONEAREST);
+
+  uint64_t index = 0;
+  for (uint64_t i = 0; i < NUMBER_OF_FLOAT_TESTS; ++i) {
+    for (uint64_t j = 0; j < NUMBER_OF_FLOAT_TESTS; ++j) {
+      float f = getTestValue(i);
+      float g = getTestValue(j);
+      checkTwoSum<float, uint32_t>(verbose, index, "augmentedAdd binary32", singlePrecisionFormatObject, f, g);
+
+      // Not the sum of floats so that the error is not always zero
+      double d = f;
+      double e = g / 3.0;
+      checkTwoSum<double, uint64_t>(verbose, index, "augmentedAdd binary64", fpt(11, 53), d, e);
+      ++index;
+    }
+  }
+
+  // The directed modes where the sum is exact in double
+  const uint64_t overflowCases = sizeof(augmentedOverflowValues) / sizeof(augmentedOverflowValues[0]);
+  for (uint64_t m = 0; m < sizeof(augmentedDirectedModes) / sizeof(augmentedDirectedModes[0]); ++m) {
+    traits::rm mode(singlePrecisionContext::nativeRoundingMode(augmentedDirectedModes[m].fenvMode));
+
+    for (uint64_t i = 0; i < NUMBER_OF_FLOAT_TESTS + overflowCases; ++i) {
+      for (uint64_t j = 0; j < ((i < NUMBER_OF_FLOAT_TESTS) ? NUMBER_OF_FLOAT_TESTS : 1); ++j) {
+	float f = (i < NUMBER_OF_FLOAT_TESTS) ? getTestValue(i) : augmentedOverflowValues[i - NUMBER_OF_FLOAT_TESTS][0];
+	float g = (i < NUMBER_OF_FLOAT_TESTS) ? getTestValue(j) : augmentedOverflowValues[i - NUMBER_OF_FLOAT_TESTS][1];
+
+	volatile double sum = (double)f + (double)g;
+	if (sum - sum == 0 && twoSumError<double>(f, g, 1.0) != 0.0) continue;
+
+	float error;
+	float reference = augmentedReference(sum, augmentedDirectedModes[m].fenvMode, error);
+
+	uint32_t computedError;
+	uint32_t computed = sympfuKernels<uint32_t, traits>::augmentedAdd(singlePrecisionFormatObject, mode,
+									  floatToBits(f), floatToBits(g), computedError);
+	checkAugmentedResult<float, uint32_t>(verbose, index, augmentedDirectedModes[m].add,
+					      computed, computedError, reference, error);
+	++index;
+      }
+    }
+  }
+
+  fesetround(savedMode);
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+// With RNE the error is exactly what TwoProduct, fma(a, b, -p),
+// computes; the directed modes are checked against double, which holds
+// the product of two binary32 values exactly.  Binary64 products are
+// wider than simpleExecutable allows.
+void checkAugmentedMultiply (const int verbose) {
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  int savedMode = fegetround();
+  fesetround(FE_TONEAREST);
+
+  const uint64_t overflowCases = sizeof(augmentedOverflowValues) / sizeof(augmentedOverflowValues[0]);
+  uint64_t index = 0;
+
+  for (uint64_t i = 0; i < NUMBER_OF_FLOAT_TESTS + overflowCases; ++i) {
+    for (uint64_t j = 0; j < ((i < NUMBER_OF_FLOAT_TESTS) ? NUMBER_OF_FLOAT_TESTS : 1); ++j) {
+      float f = (i < NUMBER_OF_FLOAT_TESTS) ? getTestValue(i) : augmentedOverflowValues[i - NUMBER_OF_FLOAT_TESTS][0];
+      float g = (i < NUMBER_OF_FLOAT_TESTS) ? getTestValue(j) : augmentedOverflowValues[i - NUMBER_OF_FLOAT_TESTS][1];
+
+      // Overflow and NaN give the product as the error
+      volatile float product = f * g;
+      float error = (product - product == 0) ? fmaf(f, g, -product) : product;
+
+      uint32_t computedError;
+      uint32_t computed = kernels::augmentedMultiply(singlePrecisionFormatObject, traits::RNE(),
+						     floatToBits(f), floatToBits(g), computedError);
+      checkAugmentedResult<float, uint32_t>(verbose, index, "augmentedMultiply RNE",
+					    computed, computedError, product, error);
+
+      for (uint64_t m = 0; m < sizeof(augmentedDirectedModes) / sizeof(augmentedDirectedModes[0]); ++m) {
+	float directedError;
+	float reference = augmentedReference((double)f * (double)g, augmentedDirectedModes[m].fenvMode, directedError);
+
+	computed = kernels::augmentedMultiply(singlePrecisionFormatObject,
+					      singlePrecisionContext::nativeRoundingMode(augmentedDirectedModes[m].fenvMode),
+					      floatToBits(f), floatToBits(g), computedError);
+	checkAugmentedResult<float, uint32_t>(verbose, index, augmentedDirectedModes[m].multiply,
+					      computed, computedError, reference, directedError);
+      }
+      ++index;
+    }
+  }
+
+  fesetround(savedMode);
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// With random bits of zero stochastic rounding never rounds up, so is
+// RTZ.  With all ones it rounds up whenever the discarded bits it looks
+// at are not all zero, which is rounding away from zero unless they
+// are all below the random bits.  For addition that is only known not
+// to happen if the exponents are close.
+void checkStochasticRounding (const int verbose) {
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  uint64_t index = 0;
+  for (uint64_t i = 0; i < NUMBER_OF_FLOAT_TESTS; ++i) {
+    for (uint64_t j = 0; j < NUMBER_OF_FLOAT_TESTS; ++j) {
+      uint32_t f = floatToBits(getTestValue(i));
+      uint32_t g = floatToBits(getTestValue(j));
+      traits::rm away((((f ^ g) & 0x80000000) == 0) ? traits::RTP() : traits::RTN());
+      traits::rm awayAdd(((getTestValue(i) + getTestValue(j)) < 0) ? traits::RTN() : traits::RTP());
+      int exponentDifference = (int)((f >> 23) & 0xFF) - (int)((g >> 23) & 0xFF);
+
+      checkResult(verbose, index, "stochasticAdd zero",
+		  kernels::stochasticAdd(singlePrecisionFormatObject, traits::RTZ(), f, g, 0x0),
+		  kernels::add(singlePrecisionFormatObject, traits::RTZ(), f, g));
+      checkResult(verbose, index, "stochasticMultiply zero",
+		  kernels::stochasticMultiply(singlePrecisionFormatObject, traits::RTZ(), f, g, 0x0),
+		  kernels::multiply(singlePrecisionFormatObject, traits::RTZ(), f, g));
+      if (abs(exponentDifference) <= 8) {
+	checkResult(verbose, index, "stochasticAdd ones",
+		    kernels::stochasticAdd(singlePrecisionFormatObject, awayAdd, f, g, 0xFFFFFFFF),
+		    kernels::add(singlePrecisionFormatObject, awayAdd, f, g));
+      }
+      checkResult(verbose, index, "stochasticMultiply ones",
+		  kernels::stochasticMultiply(singlePrecisionFormatObject, away, f, g, 0xFFFFFFFF),
+		  kernels::multiply(singlePrecisionFormatObject, away, f, g));
+      ++index;
+    }
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// Round-to-odd is truncation with the last bit set if it was inexact,
+// which includes overflow and underflow to zero.  NaNs are excluded as
+// the last bit is part of the payload.
+uint32_t hardwareRoundToOdd (const int operation, const float f, const float g) {
+  int savedMode = fegetround();
+  fesetround(FE_TOWARDZERO);
+  feclearexcept(FE_INEXACT);
+
+  volatile float left = f;
+  volatile float right = g;
+  volatile float result = (operation == 0) ? left + right : left * right;
+  bool inexact = fetestexcept(FE_INEXACT);
+
+  fesetround(savedMode);
+
+  uint32_t truncated = floatToBits(result);
+  return (inexact && !isnan(result)) ? (truncated | 0x1) : truncated;
+}
+
+void checkRoundToOdd (const int verbose) {
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  uint64_t index = 0;
+  for (uint64_t i = 0; i < NUMBER_OF_FLOAT_TESTS; ++i) {
+    for (uint64_t j = 0; j < NUMBER_OF_FLOAT_TESTS; ++j) {
+      float f = getTestValue(i);
+      float g = getTestValue(j);
+
+      uint32_t added = kernels::add(singlePrecisionFormatObject, traits::RTO(), floatToBits(f), floatToBits(g));
+      uint32_t addReference = hardwareRoundToOdd(0, f, g);
+      checkResult(verbose, index, "add RTO", added,
+		  singlePrecisionHardware::smtlibEqual(added, addReference) ? added : addReference);
+
+      uint32_t multiplied = kernels::multiply(singlePrecisionFormatObject, traits::RTO(), floatToBits(f), floatToBits(g));
+      uint32_t multiplyReference = hardwareRoundToOdd(1, f, g);
+      checkResult(verbose, index, "multiply RTO", multiplied,
+		  singlePrecisionHardware::smtlibEqual(multiplied, multiplyReference) ? multiplied : multiplyReference);
+      ++index;
+    }
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// The vectorised conversions must give the same as the core ones
+void checkQuantise (const int verbose) {
+  typedef symfpu::quantise::implementation<uint32_t, traits> quantiser;
+  typedef symfpu::batch::span<int32_t> fixedSpan;
+  typedef symfpu::batch::span<const int32_t> fixedInputSpan;
+  typedef traits::ubv ubv;
+  typedef traits::sbv sbv;
+  typedef symfpu::unpackedFloat<traits> uf;
+
+  const size_t n = NUMBER_OF_FLOAT_TESTS + 4096;
+  std::vector<uint32_t> input(n);
+  for (size_t i = 0; i < n; ++i) {
+    input[i] = floatToBits(getTestValue(i));
+  }
+
+  const int fenvModes[] = { FE_TONEAREST, FE_UPWARD, FE_DOWNWARD, FE_TOWARDZERO };
+  const traits::bwt widths[] = { 2, 8, 16, 31, 32 };
+  const traits::bwt fractionBits[] = { 0, 5 };
+  uint64_t index = 0;
+
+  for (size_t m = 0; m < sizeof(fenvModes) / sizeof(int); ++m) {
+    singlePrecisionContext context(singlePrecisionFormatObject, fenvModes[m]);
+
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w) {
+      for (size_t f = 0; f < sizeof(fractionBits) / sizeof(fractionBits[0]); ++f) {
+	traits::bwt width = widths[w];
+	traits::bwt fraction = fractionBits[f];
+	if (fraction >= width) continue;
+
+	std::vector<int32_t> fixed(n);
+	std::vector<int32_t> saturated(n);
+	std::vector<uint32_t> floats(n);
+
+	quantiser::floatToSigned<int32_t>(context, inputSpan(input.data(), n), fixedSpan(fixed), width, fraction, 0);
+	quantiser::floatToSignedSaturating<int32_t>(context, inputSpan(input.data(), n), fixedSpan(saturated), width, fraction);
+	quantiser::signedToFloat<int32_t>(context, fixedInputSpan(saturated.data(), n), outputSpan(floats), width, fraction);
+
+	for (size_t i = 0; i < n; ++i) {
+	  uf unpacked(symfpu::unpack<traits>(singlePrecisionFormatObject, ubv(32, input[i])));
+	  checkResult(verbose, index, "floatToSigned", (uint32_t)fixed[i],
+		      (uint32_t)symfpu::convertFloatToSBV<traits>(singlePrecisionFormatObject, context.mode, unpacked,
+								  width, sbv::zero(width), fraction).contents());
+	  checkResult(verbose, index, "floatToSignedSaturating", (uint32_t)saturated[i],
+		      (uint32_t)symfpu::convertFloatToSBVSaturating<traits>(singlePrecisionFormatObject, context.mode, unpacked,
+									    width, fraction).contents());
+	  checkResult(verbose, index, "signedToFloat", floats[i],
+		      symfpu::pack<traits>(singlePrecisionFormatObject,
+					   symfpu::convertSBVToFloat<traits>(singlePrecisionFormatObject, context.mode,
+									     sbv(width, saturated[i]), fraction)).contents());
+	  ++index;
+	}
+      }
+    }
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// With one rounding, a sum of two is add, a dot product of one is
+// multiply and of two, with one of the terms being 1, is fma
+void checkExact (const int verbose) {
+  typedef symfpu::exact::implementation<uint32_t, traits> exactSymfpu;
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  const int fenvModes[] = { FE_TONEAREST, FE_UPWARD, FE_DOWNWARD, FE_TOWARDZERO };
+  const uint32_t one = floatToBits(1.0f);
+  uint64_t index = 0;
+
+  for (size_t m = 0; m < sizeof(fenvModes) / sizeof(int); ++m) {
+    singlePrecisionContext context(singlePrecisionFormatObject, fenvModes[m]);
+
+    for (uint64_t i = 0; i < NUMBER_OF_FLOAT_TESTS; ++i) {
+      for (uint64_t j = 0; j < NUMBER_OF_FLOAT_TESTS; ++j) {
+	uint32_t f = floatToBits(getTestValue(i));
+	uint32_t g = floatToBits(getTestValue(j));
+	uint32_t h = floatToBits(getTestValue((i + j) % NUMBER_OF_FLOAT_TESTS));
+
+	uint32_t pair[2] = { f, g };
+	uint32_t left[2] = { f, h };
+	uint32_t right[2] = { g, one };
+
+	uint32_t summed = exactSymfpu::sum(context, inputSpan(pair, 2));
+	uint32_t added = kernels::add(context.format, context.mode, f, g);
+	checkResult(verbose, index, "exact sum", summed,
+		    singlePrecisionHardware::smtlibEqual(summed, added) ? summed : added);
+
+	uint32_t product = exactSymfpu::dotProduct(context, inputSpan(&f, 1), inputSpan(&g, 1));
+	uint32_t multiplied = kernels::multiply(context.format, context.mode, f, g);
+	checkResult(verbose, index, "exact dotProduct of one", product,
+		    singlePrecisionHardware::smtlibEqual(product, multiplied) ? product : multiplied);
+
+	uint32_t dot = exactSymfpu::dotProduct(context, inputSpan(left, 2), inputSpan(right, 2));
+	uint32_t fused = kernels::fma(context.format, context.mode, f, g, h);
+	checkResult(verbose, index, "exact dotProduct of two", dot,
+		    singlePrecisionHardware::smtlibEqual(dot, fused) ? dot : fused);
+	++index;
+      }
+    }
+
+    // The order of the terms does not change the result.  The test
+    // values come in pairs of opposite sign, so the signs are changed
+    // to stop the sum being zero, and scaling keeps it finite.
+    const size_t n = 1 << 14;
+    std::vector<uint32_t> values(n);
+    for (size_t i = 0; i < n; ++i) {
+      float v = fabsf(getTestValue(NUMBER_OF_FLOAT_TESTS + i));
+      values[i] = floatToBits(isfinite(v) ? ((i % 3 == 0) ? -v : v) * 0x1p-100f : 0.0f);
+    }
+    threadPool pool(4);
+    checkResult(verbose, index, "threaded exact sum",
+		exactSymfpu::sum(pool, context, inputSpan(values.data(), n), 1000),
+		exactSymfpu::sum(context, inputSpan(values.data(), n)));
+    checkResult(verbose, index, "threaded exact dotProduct",
+		exactSymfpu::dotProduct(pool, context, inputSpan(values.data(), n), inputSpan(values.data(), n), 1000),
+		exactSymfpu::dotProduct(context, inputSpan(values.data(), n), inputSpan(values.data(), n)));
+    ++index;
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// Against the C library's nextafterf, ilogbf and scalbnf, which
+// rounds in the current mode
+void checkExponentOperations (const int verbose) {
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  const int fenvModes[] = { FE_TONEAREST, FE_UPWARD, FE_DOWNWARD, FE_TOWARDZERO };
+  const int scales[] = { -300, -150, -127, -24, -1, 0, 1, 24, 127, 150, 300 };
+  int savedMode = fegetround();
+  uint64_t index = 0;
+
+  for (uint64_t i = 0; i < NUMBER_OF_FLOAT_TESTS + 4096; ++i) {
+    float f = getTestValue(i);
+    uint32_t bits = floatToBits(f);
+
+    uint32_t up = kernels::nextUp(singlePrecisionFormatObject, bits);
+    uint32_t upReference = floatToBits(nextafterf(f, INFINITY));
+    checkResult(verbose, index, "nextUp", up,
+		singlePrecisionHardware::smtlibEqual(up, upReference) ? up : upReference);
+
+    uint32_t down = kernels::nextDown(singlePrecisionFormatObject, bits);
+    uint32_t downReference = floatToBits(nextafterf(f, -INFINITY));
+    checkResult(verbose, index, "nextDown", down,
+		singlePrecisionHardware::smtlibEqual(down, downReference) ? down : downReference);
+
+    checkResult(verbose, index, "logB", (uint32_t)kernels::logB(singlePrecisionFormatObject, bits), (uint32_t)ilogbf(f));
+
+    for (size_t m = 0; m < sizeof(fenvModes) / sizeof(int); ++m) {
+      traits::rm mode(singlePrecisionContext::nativeRoundingMode(fenvModes[m]));
+      for (size_t k = 0; k < sizeof(scales) / sizeof(int); ++k) {
+	fesetround(fenvModes[m]);
+	uint32_t reference = floatToBits(scalbnf(f, scales[k]));
+	fesetround(savedMode);
+
+	uint32_t scaled = kernels::scaleB(singlePrecisionFormatObject, mode, bits, scales[k]);
+	checkResult(verbose, index, "scaleB", scaled,
+		    singlePrecisionHardware::smtlibEqual(scaled, reference) ? scaled : reference);
+      }
+    }
+    ++index;
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+float halfToFloat (const uint32_t h) {
+  int exponent = (h >> 10) & 0x1F;
+  int significand = h & 0x3FF;
+  float magnitude = (exponent == 0x1F) ? ((significand == 0) ? INFINITY : NAN) :
+                    (exponent == 0) ? ldexpf(significand, -24) :
+                    ldexpf(significand | 0x400, exponent - 25);
+  return (h & 0x8000) ? -magnitude : magnitude;
+}
+
+// Widening from binary16 to binary32 is exact, so reading narrow inputs
+// is the same as the binary32 operation on the widened ones.  Products
+// of binary16 values are exact in binary32, so narrowing the product
+// of widened ones to binary16 is the same as converting it.
+void checkMixedFormats (const int verbose) {
+  typedef sympfuKernels<uint32_t, traits> kernels;
+  typedef traits::ubv ubv;
+  typedef symfpu::unpackedFloat<traits> uf;
+
+  const fpt halfFormat(5, 11);
+  const int fenvModes[] = { FE_TONEAREST, FE_UPWARD, FE_DOWNWARD, FE_TOWARDZERO };
+  const uint64_t n = 64;
+  int savedMode = fegetround();
+  uint64_t index = 0;
+
+  for (size_t m = 0; m < sizeof(fenvModes) / sizeof(int); ++m) {
+    traits::rm mode(singlePrecisionContext::nativeRoundingMode(fenvModes[m]));
+
+    for (uint64_t i = 0; i < n; ++i) {
+      for (uint64_t j = 0; j < n; ++j) {
+	// Spread over all of the binary16 values
+	uint32_t a = (i * 0x9E37 + 0x11) & 0xFFFF;
+	uint32_t b = (j * 0x7F4B + 0x3C00) & 0xFFFF;
+	float f = halfToFloat(a);
+	float g = halfToFloat(b);
+	float h = halfToFloat((a ^ b) & 0xFFFF);
+
+	fesetround(fenvModes[m]);
+	volatile float left = f;
+	volatile float right = g;
+	uint32_t added = floatToBits(left + right);
+	uint32_t subtracted = floatToBits(left - right);
+	uint32_t multiplied = floatToBits(left * right);
+	uint32_t divided = floatToBits(left / right);
+	uint32_t fused = floatToBits(fmaf(f, g, h));
+	fesetround(savedMode);
+
+	uint32_t computed[5] = {
+	  kernels::add(halfFormat, singlePrecisionFormatObject, mode, a, b),
+	  kernels::sub(halfFormat, singlePrecisionFormatObject, mode, a, b),
+	  kernels::multiply(halfFormat, singlePrecisionFormatObject, mode, a, b),
+	  kernels::div(halfFormat, singlePrecisionFormatObject, mode, a, b),
+	  kernels::fma(halfFormat, singlePrecisionFormatObject, mode, a, b, (a ^ b) & 0xFFFF)
+	};
+	uint32_t reference[5] = { added, subtracted, multiplied, divided, fused };
+	static const char * names[5] = { "widening add", "widening sub", "widening multiply",
+					 "widening div", "widening fma" };
+	for (int k = 0; k < 5; ++k) {
+	  checkResult(verbose, index, names[k], computed[k],
+		      singlePrecisionHardware::smtlibEqual(computed[k], reference[k]) ? computed[k] : reference[k]);
+	}
+
+	uf exact(symfpu::unpack<traits>(singlePrecisionFormatObject, ubv(32, multiplied)));
+	uint32_t narrowed = kernels::multiply(singlePrecisionFormatObject, halfFormat, mode,
+					      floatToBits(f), floatToBits(g));
+	uint32_t narrowReference = symfpu::pack<traits>(halfFormat,
+							symfpu::convertFloatToFloat<traits>(singlePrecisionFormatObject, halfFormat,
+											    mode, exact)).contents();
+	checkResult(verbose, index, "narrowing multiply", narrowed, narrowReference);
+	++index;
+      }
+    }
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// The remainder test above is only binary32.  The remainder is exact so
+// binary16 can use remainderf on the widened values.  NaNs may differ
+// in their payload, zeros must have the same sign.
+void checkRemainder (const int verbose) {
+  typedef sympfuKernels<uint32_t, traits> kernels;
+  typedef sympfuKernels<uint64_t, traits> doubleKernels;
+
+  const fpt halfFormat(5, 11);
+  const fpt doubleFormat(11, 53);
+  uint64_t index = 0;
+
+  for (uint64_t i = 0; i < 256; ++i) {
+    for (uint64_t j = 0; j < 256; ++j) {
+      uint32_t a = (i * 0x9E37 + 0x11) & 0xFFFF;
+      uint32_t b = (j * 0x7F4B + 0x3C00) & 0xFFFF;
+      float r = remainderf(halfToFloat(a), halfToFloat(b));
+      float c = halfToFloat(kernels::rem(halfFormat, a, b));
+      checkResult(verbose, index, "binary16 remainder", floatToBits(c),
+		  (c != c && r != r) ? floatToBits(c) : floatToBits(r));
+      ++index;
+    }
+  }
+
+  for (uint64_t i = 0; i < NUMBER_OF_FLOAT_TESTS; ++i) {
+    for (uint64_t j = 0; j < NUMBER_OF_FLOAT_TESTS; ++j) {
+      // Not just widened floats so all of the significand is used
+      double f = getTestValue(i) * (1.0 + 0x1p-40);
+      double g = getTestValue(j) / 3.0;
+      double r = remainder(f, g);
+      uint64_t computed = doubleKernels::rem(doubleFormat, *((uint64_t *)&f), *((uint64_t *)&g));
+      double c = *((double *)&computed);
+      checkResult(verbose, index, "binary64 remainder", computed,
+		  (c != c && r != r) ? computed : *((uint64_t *)&r));
+      ++index;
+    }
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// Integers to binary32 against the hardware conversions, which round
+// in the current mode, and the packing path for exact conversions
+// against ldexp
+void checkIntegerToFloat (const int verbose) {
+  typedef traits::ubv ubv;
+  typedef traits::sbv sbv;
+  typedef symfpu::quantise::implementation<uint64_t, traits> doubleQuantiser;
+
+  const int fenvModes[] = { FE_TONEAREST, FE_UPWARD, FE_DOWNWARD, FE_TOWARDZERO };
+  const traits::bwt widths[] = { 2, 8, 16, 31, 32 };
+  const uint64_t n = 4096;
+  int savedMode = fegetround();
+  uint64_t index = 0;
+
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  std::vector<uint32_t> raw(n);
+  for (uint64_t i = 0; i < n; ++i) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    // Small, large and everything in between
+    raw[i] = ((uint32_t)state) >> (i % 32);
+  }
+
+  for (size_t m = 0; m < sizeof(fenvModes) / sizeof(int); ++m) {
+    traits::rm mode(singlePrecisionContext::nativeRoundingMode(fenvModes[m]));
+
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w) {
+      traits::bwt width = widths[w];
+      for (uint64_t i = 0; i < n; ++i) {
+	uint32_t u = raw[i] & (0xFFFFFFFFU >> (32 - width));
+	int32_t s = (int32_t)(u << (32 - width)) >> (32 - width);
+
+	fesetround(fenvModes[m]);
+	volatile uint32_t vu = u;
+	volatile int32_t vs = s;
+	float unsignedReference = (float)vu;
+	float signedReference = (float)vs;
+	fesetround(savedMode);
+
+	checkResult(verbose, index, "convertUBVToFloat",
+		    symfpu::pack<traits>(singlePrecisionFormatObject,
+					 symfpu::convertUBVToFloat<traits>(singlePrecisionFormatObject, mode, ubv(width, u))).contents(),
+		    floatToBits(unsignedReference));
+	checkResult(verbose, index, "convertSBVToFloat",
+		    symfpu::pack<traits>(singlePrecisionFormatObject,
+					 symfpu::convertSBVToFloat<traits>(singlePrecisionFormatObject, mode, sbv(width, s))).contents(),
+		    floatToBits(signedReference));
+	++index;
+      }
+    }
+  }
+
+  // int32 to binary64 is always exact
+  singlePrecisionContext context(fpt(11, 53), FE_TONEAREST);
+  std::vector<int32_t> fixed(n);
+  std::vector<uint64_t> converted(n);
+  for (uint64_t i = 0; i < n; ++i) {
+    fixed[i] = (int32_t)raw[i] * ((i & 0x1) ? -1 : 1);
+  }
+  doubleQuantiser::signedToFloat<int32_t>(context, symfpu::batch::span<const int32_t>(fixed.data(), n),
+					  symfpu::batch::span<uint64_t>(converted), 32, 7);
+  for (uint64_t i = 0; i < n; ++i) {
+    double reference = ldexp((double)fixed[i], -7);
+    checkResult(verbose, index, "signedToFloat binary64", converted[i], *((uint64_t *)&reference));
+    ++index;
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// In the order that the symbolic back-ends number them
+traits::rm roundingModeFromIndex (const unsigned int index) {
+  switch (index) {
+  case 1 : return traits::RNA();
+  case 2 : return traits::RTP();
+  case 3 : return traits::RTN();
+  case 4 : return traits::RTZ();
+  case 5 : return traits::RTO();
+  default : return traits::RNE();
+  }
+}
+
+// binary16 operations built as and-inverter graphs and simulated, 64
+// inputs at a time, against the executable back-end
+void checkAIG (const int verbose) {
+  typedef symfpu::aig::traits aigTraits;
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  const fpt halfFormat(5, 11);
+  const aigTraits::fpt aigHalfFormat(5, 11);
+  static const char * names[] = { "aig add", "aig multiply", "aig div" };
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  uint64_t index = 0;
+
+  for (int operation = 0; operation < 3; ++operation) {
+    symfpu::aig::graph g;
+    symfpu::aig::scope s(g);
+
+    aigTraits::ubv a(aigTraits::ubv::input(16, "a"));
+    aigTraits::ubv b(aigTraits::ubv::input(16, "b"));
+    aigTraits::rm mode(aigTraits::rm::input("rm"));
+    symfpu::unpackedFloat<aigTraits> ua(symfpu::unpack<aigTraits>(aigHalfFormat, a));
+    symfpu::unpackedFloat<aigTraits> ub(symfpu::unpack<aigTraits>(aigHalfFormat, b));
+
+    aigTraits::ubv result(symfpu::pack<aigTraits>(aigHalfFormat,
+						  (operation == 0) ? symfpu::add<aigTraits>(aigHalfFormat, mode, ua, ub, aigTraits::prop(true)) :
+						  (operation == 1) ? symfpu::multiply<aigTraits>(aigHalfFormat, mode, ua, ub) :
+						  symfpu::divide<aigTraits>(aigHalfFormat, mode, ua, ub)));
+
+    for (int round = 0; round < 32; ++round) {
+      // a, b then the rounding mode, least significant bit first
+      std::vector<uint64_t> inputs(g.numberOfInputs());
+      for (size_t i = 0; i < inputs.size(); ++i) {
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	inputs[i] = state;
+      }
+      std::vector<uint64_t> outputs(g.simulate(inputs, result.getBits()));
+
+      for (unsigned int lane = 0; lane < 64; ++lane) {
+	uint32_t av = 0, bv = 0, computed = 0;
+	unsigned int modeIndex = 0;
+	for (unsigned int i = 0; i < 16; ++i) {
+	  av |= ((inputs[i] >> lane) & 0x1) << i;
+	  bv |= ((inputs[16 + i] >> lane) & 0x1) << i;
+	  computed |= ((outputs[i] >> lane) & 0x1) << i;
+	}
+	for (unsigned int i = 0; i < 3; ++i) {
+	  modeIndex |= ((inputs[32 + i] >> lane) & 0x1) << i;
+	}
+
+	traits::rm m(roundingModeFromIndex(modeIndex));
+	uint32_t reference = (operation == 0) ? kernels::add(halfFormat, m, av, bv) :
+	                     (operation == 1) ? kernels::multiply(halfFormat, m, av, bv) :
+	                     kernels::div(halfFormat, m, av, bv);
+	checkResult(verbose, index, names[operation], computed, reference);
+	++index;
+      }
+    }
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// The DAG folds constants with the SMT-LIB semantics, so binary16
+// operations on constants give a constant, which must be what the
+// executable back-end computes
+void checkSMTLIB (const int verbose) {
+  typedef symfpu::smtlib::traits smtTraits;
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  const fpt halfFormat(5, 11);
+  const smtTraits::fpt smtHalfFormat(5, 11);
+  static const char * names[] = { "smtlib add", "smtlib multiply", "smtlib div" };
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  uint64_t index = 0;
+
+  for (int operation = 0; operation < 3; ++operation) {
+    symfpu::smtlib::dag d;
+    symfpu::smtlib::scope s(d);
+
+    for (uint64_t i = 0; i < 1024; ++i) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      uint32_t av = state & 0xFFFF;
+      uint32_t bv = (state >> 16) & 0xFFFF;
+      unsigned int modeIndex = (state >> 32) % 6;
+
+      smtTraits::rm mode(modeIndex);
+      symfpu::unpackedFloat<smtTraits> ua(symfpu::unpack<smtTraits>(smtHalfFormat, smtTraits::ubv(16, av)));
+      symfpu::unpackedFloat<smtTraits> ub(symfpu::unpack<smtTraits>(smtHalfFormat, smtTraits::ubv(16, bv)));
+      smtTraits::ubv result(symfpu::pack<smtTraits>(smtHalfFormat,
+						    (operation == 0) ? symfpu::add<smtTraits>(smtHalfFormat, mode, ua, ub, smtTraits::prop(true)) :
+						    (operation == 1) ? symfpu::multiply<smtTraits>(smtHalfFormat, mode, ua, ub) :
+						    symfpu::divide<smtTraits>(smtHalfFormat, mode, ua, ub)));
+
+      traits::rm m(roundingModeFromIndex(modeIndex));
+      uint32_t reference = (operation == 0) ? kernels::add(halfFormat, m, av, bv) :
+	                   (operation == 1) ? kernels::multiply(halfFormat, m, av, bv) :
+	                   kernels::div(halfFormat, m, av, bv);
+      checkResult(verbose, index, names[operation],
+		  result.isConstant() ? d.constantValue(result.getTerm()) : ~0ULL, reference);
+      ++index;
+    }
+  }
+
+  // With inputs the variables are declared and the result is defined
+  symfpu::smtlib::dag d;
+  symfpu::smtlib::scope s(d);
+  symfpu::unpackedFloat<smtTraits> ua(symfpu::unpack<smtTraits>(smtHalfFormat, smtTraits::ubv::input(16, "a")));
+  symfpu::unpackedFloat<smtTraits> ub(symfpu::unpack<smtTraits>(smtHalfFormat, smtTraits::ubv::input(16, "b")));
+  smtTraits::ubv sum(symfpu::pack<smtTraits>(smtHalfFormat, symfpu::add<smtTraits>(smtHalfFormat, smtTraits::RNE(), ua, ub, smtTraits::prop(true))));
+
+  std::ostringstream out;
+  d.writeSMTLIB(out, std::vector<symfpu::smtlib::term>(1, sum.getTerm()), std::vector<std::string>(1, "sum"));
+  checkResult(verbose, index, "smtlib declarations", out.str().find("(declare-fun a () (_ BitVec 16))") == std::string::npos, 0);
+  checkResult(verbose, index, "smtlib definition", out.str().find("sum") == std::string::npos, 0);
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// Unit propagation over DIMACS clauses.  The outputs are encoded in
+// both polarities so, once the inputs are fixed, propagation alone must
+// give them a value.
+class unitPropagator {
+protected :
+  std::vector<std::vector<int> > clauses;
+  std::vector<std::vector<size_t> > occurrences;   // By the literal's negation, i.e. where it can be false
+  std::vector<int> value;                         // 1, -1 or 0 if not known
+  std::vector<int> trail;
+
+  size_t slot (const int literal) const { return (literal > 0) ? 2 * literal : -2 * literal + 1; }
+  int valueOf (const int literal) const { return (literal > 0) ? value[literal] : -value[-literal]; }
+
+  bool assign (const int literal) {
+    if (valueOf(literal) != 0) return valueOf(literal) == 1;
+    value[abs(literal)] = (literal > 0) ? 1 : -1;
+    trail.push_back(literal);
+    return true;
+  }
+
+public :
+  std::vector<int> inputs;
+  std::vector<int> outputs;
+
+  unitPropagator (std::istream &in) {
+    std::string line;
+    while (std::getline(in, line)) {
+      std::istringstream words(line);
+      std::string first;
+      words >> first;
+      if (first == "c") {
+	std::string kind;
+	size_t index;
+	int literal;
+	words >> kind >> index >> literal;
+	((kind == "input") ? inputs : outputs).push_back(literal);
+      } else if (first == "p") {
+	std::string format;
+	size_t variables;
+	words >> format >> variables;
+	value.assign(variables + 1, 0);
+	occurrences.resize(2 * variables + 2);
+      } else if (!first.empty()) {
+	std::vector<int> clause;
+	for (int literal = atoi(first.c_str()); literal != 0; words >> literal) {
+	  occurrences[slot(-literal)].push_back(clauses.size());
+	  clause.push_back(literal);
+	}
+	clauses.push_back(clause);
+      }
+    }
+  }
+
+  // False if the clauses are contradicted
+  bool propagate (const std::vector<int> &assumptions) {
+    for (size_t i = 0; i < trail.size(); ++i) {
+      value[abs(trail[i])] = 0;
+    }
+    trail.clear();
+
+    for (size_t i = 0; i < clauses.size(); ++i) {
+      if (clauses[i].size() == 1 && !assign(clauses[i][0])) return false;
+    }
+    for (size_t i = 0; i < assumptions.size(); ++i) {
+      if (!assign(assumptions[i])) return false;
+    }
+
+    for (size_t next = 0; next < trail.size(); ++next) {
+      const std::vector<size_t> &watched(occurrences[slot(trail[next])]);
+      for (size_t i = 0; i < watched.size(); ++i) {
+	const std::vector<int> &clause(clauses[watched[i]]);
+	int unassigned = 0;
+	size_t count = 0;
+	bool satisfied = false;
+	for (size_t j = 0; j < clause.size() && !satisfied; ++j) {
+	  int v = valueOf(clause[j]);
+	  satisfied = (v == 1);
+	  if (v == 0) {
+	    unassigned = clause[j];
+	    ++count;
+	  }
+	}
+	if (satisfied) continue;
+	if (count == 0) return false;
+	if (count == 1 && !assign(unassigned)) return false;
+      }
+    }
+    return true;
+  }
+
+  int get (const int literal) const { return valueOf(literal); }
+};
+
+// binary16 operations written as CNF and evaluated by unit propagation
+// against the executable back-end, with and without the polarity-aware
+// encoding
+void checkCNF (const int verbose) {
+  typedef symfpu::cnf::traits cnfTraits;
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  const fpt halfFormat(5, 11);
+  const cnfTraits::fpt cnfHalfFormat(5, 11);
+  static const char * names[] = { "cnf add", "cnf multiply" };
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  uint64_t index = 0;
+
+  for (int operation = 0; operation < 2; ++operation) {
+    symfpu::cnf::circuit c;
+    symfpu::cnf::scope s(c);
+
+    cnfTraits::ubv a(cnfTraits::ubv::input(16, "a"));
+    cnfTraits::ubv b(cnfTraits::ubv::input(16, "b"));
+    cnfTraits::rm mode(cnfTraits::rm::input("rm"));
+    symfpu::unpackedFloat<cnfTraits> ua(symfpu::unpack<cnfTraits>(cnfHalfFormat, a));
+    symfpu::unpackedFloat<cnfTraits> ub(symfpu::unpack<cnfTraits>(cnfHalfFormat, b));
+    cnfTraits::ubv result(symfpu::pack<cnfTraits>(cnfHalfFormat,
+						  (operation == 0) ? symfpu::add<cnfTraits>(cnfHalfFormat, mode, ua, ub, cnfTraits::prop(true)) :
+						  symfpu::multiply<cnfTraits>(cnfHalfFormat, mode, ua, ub)));
+
+    for (int polarityAware = 0; polarityAware <= 1; ++polarityAware) {
+      std::stringstream dimacs;
+      c.writeDIMACS(dimacs, std::vector<symfpu::cnf::literal>(), result.getBits(), polarityAware);
+      unitPropagator propagator(dimacs);
+
+      for (int round = 0; round < 256; ++round) {
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+
+	// a, b then the rounding mode, least significant bit first
+	std::vector<int> assumptions;
+	for (size_t i = 0; i < propagator.inputs.size(); ++i) {
+	  assumptions.push_back(((state >> i) & 0x1) ? propagator.inputs[i] : -propagator.inputs[i]);
+	}
+	bool consistent = propagator.propagate(assumptions);
+
+	uint32_t computed = 0;
+	for (size_t i = 0; i < propagator.outputs.size(); ++i) {
+	  int v = propagator.get(propagator.outputs[i]);
+	  computed |= ((v == 1) ? 0x1 : 0x0) << i;
+	  consistent = consistent && (v != 0);
+	}
+
+	uint32_t av = state & 0xFFFF;
+	uint32_t bv = (state >> 16) & 0xFFFF;
+	traits::rm m(roundingModeFromIndex((state >> 32) & 0x7));
+	uint32_t reference = (operation == 0) ? kernels::add(halfFormat, m, av, bv) :
+	                     kernels::multiply(halfFormat, m, av, bv);
+	checkResult(verbose, index, names[operation], consistent ? computed : ~0U, reference);
+	++index;
+      }
+    }
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// binary16 operations on partially known inputs.  Every known bit of
+// the result must agree with the executable back-end on any input that
+// matches the known bits, and fully known inputs must give the result.
+void checkKnownBits (const int verbose) {
+  typedef symfpu::knownBits::traits kbTraits;
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  const fpt halfFormat(5, 11);
+  const kbTraits::fpt kbHalfFormat(5, 11);
+  static const char * names[] = { "knownBits add", "knownBits multiply", "knownBits divide" };
+  static const kbTraits::rm modes[] = { kbTraits::RNE(), kbTraits::RNA(), kbTraits::RTP(),
+					kbTraits::RTN(), kbTraits::RTZ(), kbTraits::RTO() };
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  uint64_t index = 0;
+
+  for (int operation = 0; operation < 3; ++operation) {
+    for (int round = 0; round < 256; ++round) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+
+      // Round 0 mod 4 is fully known, otherwise random known masks
+      // biased so that the sign and exponent are often known
+      uint32_t av = state & 0xFFFF;
+      uint32_t bv = (state >> 16) & 0xFFFF;
+      uint32_t aKnown = (round % 4 == 0) ? 0xFFFF : (((state >> 32) & 0xFFFF) | ((round % 2) ? 0xFC00 : 0x0));
+      uint32_t bKnown = (round % 4 == 0) ? 0xFFFF : (((state >> 48) & 0xFFFF) | ((round % 2) ? 0xFC00 : 0x0));
+      unsigned int modeIndex = round % 7;   // 6 is an unknown rounding mode
+
+      std::string as(16, 'X');
+      std::string bs(16, 'X');
+      for (int i = 0; i < 16; ++i) {
+	if ((aKnown >> i) & 0x1) as[15 - i] = ((av >> i) & 0x1) ? '1' : '0';
+	if ((bKnown >> i) & 0x1) bs[15 - i] = ((bv >> i) & 0x1) ? '1' : '0';
+      }
+
+      kbTraits::rm mode((modeIndex < 6) ? modes[modeIndex] : kbTraits::rm::unknown());
+      symfpu::unpackedFloat<kbTraits> ua(symfpu::unpack<kbTraits>(kbHalfFormat, kbTraits::ubv::fromString(as)));
+      symfpu::unpackedFloat<kbTraits> ub(symfpu::unpack<kbTraits>(kbHalfFormat, kbTraits::ubv::fromString(bs)));
+      kbTraits::ubv result(symfpu::pack<kbTraits>(kbHalfFormat,
+						  (operation == 0) ? symfpu::add<kbTraits>(kbHalfFormat, mode, ua, ub, kbTraits::prop(true)) :
+						  (operation == 1) ? symfpu::multiply<kbTraits>(kbHalfFormat, mode, ua, ub) :
+						  symfpu::divide<kbTraits>(kbHalfFormat, mode, ua, ub)));
+
+      std::string rs(result.toString());
+      uint32_t resultKnown = 0;
+      uint32_t resultOnes = 0;
+      for (int i = 0; i < 16; ++i) {
+	resultKnown |= (rs[15 - i] != 'X') ? (0x1 << i) : 0x0;
+	resultOnes |= (rs[15 - i] == '1') ? (0x1 << i) : 0x0;
+      }
+
+      for (int sample = 0; sample < 32; ++sample) {
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+
+	uint32_t a = (av & aKnown) | (state & ~aKnown & 0xFFFF);
+	uint32_t b = (bv & bKnown) | ((state >> 16) & ~bKnown & 0xFFFF);
+	traits::rm m(roundingModeFromIndex((modeIndex < 6) ? modeIndex : (state >> 32) % 6));
+	uint32_t reference = (operation == 0) ? kernels::add(halfFormat, m, a, b) :
+	                     (operation == 1) ? kernels::multiply(halfFormat, m, a, b) :
+	                     kernels::div(halfFormat, m, a, b);
+
+	// A fully known query must give a fully known result
+	uint32_t expectedKnown = (aKnown == 0xFFFF && bKnown == 0xFFFF && modeIndex < 6) ? 0xFFFF : resultKnown;
+	checkResult(verbose, index, names[operation], (resultKnown << 16) | resultOnes,
+		    (expectedKnown << 16) | (reference & expectedKnown));
+	++index;
+      }
+    }
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// binary16 operations through the simplifying traits over the
+// executable back-end.  Constant inputs must be folded to the kernel's
+// result; opaque ones (the inner value without the simplifier knowing
+// it) must reach the same result through the inner back-end.
+void checkSimplifying (const int verbose) {
+  typedef symfpu::simplifying::traits<traits> simpTraits;
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  const fpt halfFormat(5, 11);
+  const simpTraits::fpt simpHalfFormat(5, 11);
+  static const char * names[] = { "simplifying add", "simplifying multiply", "simplifying divide",
+				  "simplifying add (opaque)", "simplifying multiply (opaque)", "simplifying divide (opaque)" };
+  static const simpTraits::rm modes[] = { simpTraits::RNE(), simpTraits::RNA(), simpTraits::RTP(),
+					  simpTraits::RTN(), simpTraits::RTZ(), simpTraits::RTO() };
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  uint64_t index = 0;
+
+  for (int operation = 0; operation < 3; ++operation) {
+    for (int opaque = 0; opaque <= 1; ++opaque) {
+      for (int round = 0; round < 1024; ++round) {
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+
+	uint32_t av = state & 0xFFFF;
+	uint32_t bv = (state >> 16) & 0xFFFF;
+	unsigned int modeIndex = (state >> 32) % 6;
+	traits::rm m(roundingModeFromIndex(modeIndex));
+
+	simpTraits::ubv a(opaque ? simpTraits::ubv(traits::ubv(16, av)) : simpTraits::ubv(16, av));
+	simpTraits::rm mode(opaque ? simpTraits::rm(m) : modes[modeIndex]);
+	symfpu::unpackedFloat<simpTraits> ua(symfpu::unpack<simpTraits>(simpHalfFormat, a));
+	symfpu::unpackedFloat<simpTraits> ub(symfpu::unpack<simpTraits>(simpHalfFormat, simpTraits::ubv(16, bv)));
+	simpTraits::ubv result(symfpu::pack<simpTraits>(simpHalfFormat,
+							(operation == 0) ? symfpu::add<simpTraits>(simpHalfFormat, mode, ua, ub, simpTraits::prop(true)) :
+							(operation == 1) ? symfpu::multiply<simpTraits>(simpHalfFormat, mode, ua, ub) :
+							symfpu::divide<simpTraits>(simpHalfFormat, mode, ua, ub)));
+
+	uint32_t reference = (operation == 0) ? kernels::add(halfFormat, m, av, bv) :
+	                     (operation == 1) ? kernels::multiply(halfFormat, m, av, bv) :
+	                     kernels::div(halfFormat, m, av, bv);
+
+	// Constant inputs that did not fold give an impossible result
+	uint32_t computed = opaque ? result.getInner().contents() :
+	                    (result.isConstant() ? result.constantValue() : ~0U);
+	checkResult(verbose, index, names[operation + 3 * opaque], computed, reference);
+	++index;
+      }
+    }
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// Cost estimate of a binary16 / binary32 operation; a rounding mode
+// index of 6 is an input
+template <class t>
+typename t::ubv costedOperation (const int operation, const typename t::fpt &format, const unsigned int modeIndex,
+				 const typename t::ubv &a, const typename t::ubv &b) {
+  static const typename t::rm modes[] = { t::RNE(), t::RNA(), t::RTP(), t::RTN(), t::RTZ(), t::RTO() };
+  typename t::rm mode((modeIndex < 6) ? modes[modeIndex] : t::rm::input("rm"));
+  symfpu::unpackedFloat<t> ua(symfpu::unpack<t>(format, a));
+  symfpu::unpackedFloat<t> ub(symfpu::unpack<t>(format, b));
+  return symfpu::pack<t>(format,
+			 (operation == 0) ? symfpu::add<t>(format, mode, ua, ub, typename t::prop(true)) :
+			 (operation == 1) ? symfpu::multiply<t>(format, mode, ua, ub) :
+			 symfpu::divide<t>(format, mode, ua, ub));
+}
+
+// The cost back-end has no values to compare so it is checked against
+// the and-inverter graph it estimates : the estimate must be an upper
+// bound on the graph built, constants must cost nothing, and a
+// constant rounding mode, narrower format or simpler operation must
+// not cost more
+void checkCost (const int verbose) {
+  typedef symfpu::cost::traits costTraits;
+  typedef symfpu::aig::traits aigTraits;
+
+  static const char * names[] = { "cost add", "cost multiply", "cost divide" };
+  const costTraits::fpt costFormats[] = { costTraits::fpt(5, 11), costTraits::fpt(8, 24) };
+  const aigTraits::fpt aigHalfFormat(5, 11);
+  uint64_t index = 0;
+
+  symfpu::cost::tally symbolic[3][2];
+  for (int operation = 0; operation < 3; ++operation) {
+    for (int f = 0; f < 2; ++f) {
+      costTraits::bwt width = costFormats[f].packedWidth();
+      symfpu::cost::ledger l;
+      {
+	symfpu::cost::scope s(l);
+	costedOperation<costTraits>(operation, costFormats[f], 6,
+				    costTraits::ubv::input(width, "a"), costTraits::ubv::input(width, "b"));
+      }
+      symbolic[operation][f] = l.total();
+      checkResult(verbose, index++, names[operation], symbolic[operation][f].count > 0, true);
+      checkResult(verbose, index++, names[operation],
+		  symbolic[operation][f].clauses >= symbolic[operation][f].gates, true);
+
+      for (unsigned int modeIndex = 0; modeIndex < 6; ++modeIndex) {
+	symfpu::cost::ledger constantMode;
+	{
+	  symfpu::cost::scope s(constantMode);
+	  costedOperation<costTraits>(operation, costFormats[f], modeIndex,
+				      costTraits::ubv::input(width, "a"), costTraits::ubv::input(width, "b"));
+	}
+	checkResult(verbose, index++, names[operation],
+		    constantMode.total().gates <= symbolic[operation][f].gates, true);
+
+	symfpu::cost::ledger constants;
+	{
+	  symfpu::cost::scope s(constants);
+	  costedOperation<costTraits>(operation, costFormats[f], modeIndex,
+				      costTraits::ubv(width, 0x3C00), costTraits::ubv(width, 0x4248));
+	}
+	checkResult(verbose, index++, names[operation], constants.total().count, 0);
+      }
+    }
+
+    checkResult(verbose, index++, names[operation], symbolic[operation][0].gates <= symbolic[operation][1].gates, true);
+
+    symfpu::aig::graph g;
+    symfpu::aig::scope s(g);
+    aigTraits::ubv result(costedOperation<aigTraits>(operation, aigHalfFormat, 6,
+						     aigTraits::ubv::input(16, "a"), aigTraits::ubv::input(16, "b")));
+    checkResult(verbose, index++, names[operation], g.coneSize(result.getBits()) <= symbolic[operation][0].gates, true);
+  }
+
+  checkResult(verbose, index++, "cost divide", symbolic[1][1].gates <= symbolic[2][1].gates, true);
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// binary16 operations built as and-inverter graphs with the properties
+// collected.  Under simulation the result must match the executable
+// back-end and every collected lemma must hold.  Run 3 is multiply
+// with preconditions and multiply.h disabled, which must remove them.
+void checkCollecting (const int verbose) {
+  typedef symfpu::aig::traits aigTraits;
+  typedef symfpu::collecting::traits<aigTraits> collectingTraits;
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  const fpt halfFormat(5, 11);
+  const collectingTraits::fpt collectingHalfFormat(5, 11);
+  static const char * names[] = { "collecting add", "collecting multiply", "collecting div", "collecting disabled" };
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  uint64_t index = 0;
+
+  for (int run = 0; run < 4; ++run) {
+    int operation = (run == 3) ? 1 : run;
+    symfpu::aig::graph g;
+    symfpu::aig::scope s(g);
+    symfpu::collecting::collector<aigTraits> c;
+    symfpu::collecting::scope<aigTraits> cs(c);
+
+    if (run == 3) {
+      c.disable(symfpu::collecting::PRECONDITION_PROPERTY);
+      c.disable("multiply.h");
+    }
+
+    collectingTraits::ubv a(collectingTraits::ubv::input(16, "a"));
+    collectingTraits::ubv b(collectingTraits::ubv::input(16, "b"));
+    collectingTraits::rm mode(collectingTraits::rm::input("rm"));
+    symfpu::unpackedFloat<collectingTraits> ua(symfpu::unpack<collectingTraits>(collectingHalfFormat, a));
+    symfpu::unpackedFloat<collectingTraits> ub(symfpu::unpack<collectingTraits>(collectingHalfFormat, b));
+
+    collectingTraits::ubv result(symfpu::pack<collectingTraits>(collectingHalfFormat,
+								(operation == 0) ? symfpu::add<collectingTraits>(collectingHalfFormat, mode, ua, ub, collectingTraits::prop(true)) :
+								(operation == 1) ? symfpu::multiply<collectingTraits>(collectingHalfFormat, mode, ua, ub) :
+								symfpu::divide<collectingTraits>(collectingHalfFormat, mode, ua, ub)));
+
+    // The result bits then the lemmas
+    std::vector<symfpu::aig::literal> outputs(result.getBits());
+    const std::vector<symfpu::collecting::collector<aigTraits>::lemma> &lemmas(c.getLemmas());
+    checkResult(verbose, index++, names[run], lemmas.size() > 0, true);
+    for (size_t i = 0; i < lemmas.size(); ++i) {
+      outputs.push_back(lemmas[i].condition.getLiteral());
+
+      bool excluded = (lemmas[i].kind == symfpu::collecting::PRECONDITION_PROPERTY) ||
+	(std::string(lemmas[i].site.file).find("multiply.h") != std::string::npos);
+      checkResult(verbose, index++, names[run], (run == 3) && excluded, false);
+    }
+
+    for (int round = 0; round < 32; ++round) {
+      // a, b then the rounding mode, least significant bit first
+      std::vector<uint64_t> inputs(g.numberOfInputs());
+      for (size_t i = 0; i < inputs.size(); ++i) {
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	inputs[i] = state;
+      }
+      std::vector<uint64_t> values(g.simulate(inputs, outputs));
+
+      for (size_t i = 0; i < lemmas.size(); ++i) {
+	checkResult(verbose, index++, names[run], values[16 + i], ~0ULL);
+      }
+
+      for (unsigned int lane = 0; lane < 64; ++lane) {
+	uint32_t av = 0, bv = 0, computed = 0;
+	unsigned int modeIndex = 0;
+	for (unsigned int i = 0; i < 16; ++i) {
+	  av |= ((inputs[i] >> lane) & 0x1) << i;
+	  bv |= ((inputs[16 + i] >> lane) & 0x1) << i;
+	  computed |= ((values[i] >> lane) & 0x1) << i;
+	}
+	for (unsigned int i = 0; i < 3; ++i) {
+	  modeIndex |= ((inputs[32 + i] >> lane) & 0x1) << i;
+	}
+
+	traits::rm m(roundingModeFromIndex(modeIndex));
+	uint32_t reference = (operation == 0) ? kernels::add(halfFormat, m, av, bv) :
+	                     (operation == 1) ? kernels::multiply(halfFormat, m, av, bv) :
+	                     kernels::div(halfFormat, m, av, bv);
+	checkResult(verbose, index++, names[run], computed, reference);
+      }
+    }
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// The term cache over and-inverter graphs.  x + y then y + x must be
+// one hit giving the same graph, as must x * y then y * x, but x - y
+// and y - x are different.  The cached results are simulated against
+// the executable back-end on binary16.
+void checkTermMemo (const int verbose) {
+  typedef symfpu::aig::traits aigTraits;
+  typedef symfpu::unpackedFloat<aigTraits> aigFloat;
+  typedef sympfuKernels<uint32_t, traits> kernels;
+
+  const fpt halfFormat(5, 11);
+  const aigTraits::fpt aigHalfFormat(5, 11);
+  static const char * names[] = { "termMemo add", "termMemo sub", "termMemo reverse sub", "termMemo multiply" };
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  uint64_t index = 0;
+
+  symfpu::aig::graph g;
+  symfpu::aig::scope s(g);
+  symfpu::termMemo::cache<aigTraits> c;
+
+  aigTraits::rm mode(aigTraits::rm::input("rm"));
+  aigFloat x(symfpu::unpack<aigTraits>(aigHalfFormat, aigTraits::ubv::input(16, "x")));
+  aigFloat y(symfpu::unpack<aigTraits>(aigHalfFormat, aigTraits::ubv::input(16, "y")));
+  aigTraits::prop isAdd(true);
+
+  aigTraits::ubv sum(symfpu::pack<aigTraits>(aigHalfFormat, c.add(aigHalfFormat, mode, x, y, isAdd)));
+  aigTraits::ubv commutedSum(symfpu::pack<aigTraits>(aigHalfFormat, c.add(aigHalfFormat, mode, y, x, isAdd)));
+  checkResult(verbose, index++, names[0], c.stats().hits, 1);
+  checkResult(verbose, index++, names[0], sum.getBits() == commutedSum.getBits(), true);
+
+  aigTraits::ubv difference(symfpu::pack<aigTraits>(aigHalfFormat, c.add(aigHalfFormat, mode, x, y, !isAdd)));
+  aigTraits::ubv reverseDifference(symfpu::pack<aigTraits>(aigHalfFormat, c.add(aigHalfFormat, mode, y, x, !isAdd)));
+  checkResult(verbose, index++, names[1], c.stats().hits, 1);
+  checkResult(verbose, index++, names[1], difference.getBits() == reverseDifference.getBits(), false);
+
+  aigTraits::ubv product(symfpu::pack<aigTraits>(aigHalfFormat, c.multiply(aigHalfFormat, mode, x, y)));
+  aigTraits::ubv commutedProduct(symfpu::pack<aigTraits>(aigHalfFormat, c.multiply(aigHalfFormat, mode, y, x)));
+  checkResult(verbose, index++, names[3], c.stats().hits, 2);
+  checkResult(verbose, index++, names[3], c.stats().misses, 4);
+  checkResult(verbose, index++, names[3], c.stats().entries, 4);
+  checkResult(verbose, index++, names[3], product.getBits() == commutedProduct.getBits(), true);
+
+  std::vector<symfpu::aig::literal> outputs;
+  const aigTraits::ubv *results[] = { &commutedSum, &difference, &reverseDifference, &commutedProduct };
+  for (int i = 0; i < 4; ++i) {
+    outputs.insert(outputs.end(), results[i]->getBits().begin(), results[i]->getBits().end());
+  }
+
+  for (int round = 0; round < 32; ++round) {
+    // The rounding mode, x then y, least significant bit first
+    std::vector<uint64_t> inputs(g.numberOfInputs());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      inputs[i] = state;
+    }
+    std::vector<uint64_t> values(g.simulate(inputs, outputs));
+
+    for (unsigned int lane = 0; lane < 64; ++lane) {
+      uint32_t xv = 0, yv = 0;
+      unsigned int modeIndex = 0;
+      for (unsigned int i = 0; i < 3; ++i) {
+	modeIndex |= ((inputs[i] >> lane) & 0x1) << i;
+      }
+      for (unsigned int i = 0; i < 16; ++i) {
+	xv |= ((inputs[3 + i] >> lane) & 0x1) << i;
+	yv |= ((inputs[19 + i] >> lane) & 0x1) << i;
+      }
+
+      traits::rm m(roundingModeFromIndex(modeIndex));
+      uint32_t references[] = { kernels::add(halfFormat, m, xv, yv),
+				kernels::sub(halfFormat, m, xv, yv),
+				kernels::sub(halfFormat, m, yv, xv),
+				kernels::multiply(halfFormat, m, xv, yv) };
+
+      for (int r = 0; r < 4; ++r) {
+	uint32_t computed = 0;
+	for (unsigned int i = 0; i < 16; ++i) {
+	  computed |= ((values[16 * r + i] >> lane) & 0x1) << i;
+	}
+	checkResult(verbose, index++, names[r], computed, references[r]);
+      }
+    }
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+// Round to an integer in the mode of the fenv index, in double as the
+// values in the block checks are exact in it
+double roundToIntegerInMode (const double value, const int fenvMode) {
+  switch (fenvMode) {
+  case FE_UPWARD : return ceil(value);
+  case FE_DOWNWARD : return floor(value);
+  case FE_TOWARDZERO : return trunc(value);
+  default : {
+    double lower = floor(value);
+    double difference = value - lower;
+    return (difference > 0.5 || (difference == 0.5 && fmod(lower, 2.0) != 0.0)) ? lower + 1.0 : lower;
+  }
+  }
+}
+
+// One rounding from double to float in the mode of the fenv index
+uint32_t doubleToFloatInMode (const double value, const int fenvMode) {
+  fesetround(fenvMode);
+  volatile float rounded = (float)value;
+  fesetround(FE_TONEAREST);
+  return floatToBits(rounded);
+}
+
+// Block floating-point.  A block of one normal value is that value
+// rounded to elementWidth - 1 bits of significand (i.e.
+// convertFloatToFloat to a narrower format) unless that rounds up a
+// binade, when the element saturates.  Larger blocks are checked against double,
+// where every element and the dot products are exact before the final
+// rounding.  Blocks with NaN or infinity are NaN and the packed form
+// must unpack to the same block.
+void checkBlockFloat (const int verbose) {
+  typedef symfpu::block::implementation<uint32_t, traits> blockSymfpu;
+  typedef symfpu::block::blocks<int32_t, traits::bwt> blocks;
+  typedef symfpu::blockFloat<traits> bf;
+  typedef symfpu::unpackedFloat<traits> uf;
+  typedef traits::ubv ubv;
+
+  union { uint32_t bits; float value; } u;
+  const int fenvModes[] = { FE_TONEAREST, FE_UPWARD, FE_DOWNWARD, FE_TOWARDZERO };
+  const size_t numberOfModes = sizeof(fenvModes) / sizeof(int);
+  const fpt &format(singlePrecisionFormatObject);
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  uint64_t index = 0;
+
+  // Blocks of one against convertFloatToFloat
+  const traits::bwt singleWidths[] = { 12, 16 };
+  for (size_t m = 0; m < numberOfModes; ++m) {
+    traits::rm mode(singlePrecisionContext::nativeRoundingMode(fenvModes[m]));
+
+    for (size_t w = 0; w < sizeof(singleWidths) / sizeof(singleWidths[0]); ++w) {
+      traits::bwt elementWidth = singleWidths[w];
+      fpt narrow(8, elementWidth - 1);
+
+      for (uint64_t i = 0; i < NUMBER_OF_FLOAT_TESTS; ++i) {
+	float f = getTestValue(i);
+	if (!isnormal(f) && f != 0.0f) continue;
+
+	uf input(symfpu::unpack<traits>(format, ubv(32, floatToBits(f))));
+	uf rounded(symfpu::convertFloatToFloat<traits>(format, narrow, mode, input));
+	uint32_t reference = symfpu::pack<traits>(format, symfpu::convertFloatToFloat<traits>(narrow, format, traits::RNE(), rounded)).contents();
+	if (input.getZero()) {
+	  reference = 0x0;   // Elements are integers so have no -0
+	} else if (rounded.getInf() || input.getExponent() < rounded.getExponent()) {
+	  double saturated = ldexp((double)((1 << (elementWidth - 1)) - 1), ilogbf(f) - (elementWidth - 2));
+	  reference = floatToBits((float)(signbit(f) ? -saturated : saturated));
+	}
+
+	bf encoded(symfpu::blockEncode<traits>(format, mode, std::vector<uf>(1, input), elementWidth));
+	checkResult(verbose, index, "blockFloat single",
+		    symfpu::pack<traits>(format, symfpu::blockDecode<traits>(format, mode, encoded, 0)).contents(),
+		    reference);
+	++index;
+      }
+    }
+  }
+
+  // Larger blocks against double, through the threaded interface
+  const size_t blockSize = 16;
+  const size_t numberOfBlocks = 64;
+  const size_t n = blockSize * numberOfBlocks;
+  const traits::bwt widths[] = { 8, 16 };
+  threadPool pool(4);
+
+  std::vector<uint32_t> input[2];
+  for (int side = 0; side < 2; ++side) {
+    for (size_t i = 0; i < n; ++i) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      uint32_t exponent = 127 + (state % 41) - 20;
+      input[side].push_back((state % 8 == 0) ? 0 : ((state >> 32) & 0x80000000) | (exponent << 23) | ((state >> 8) & 0x007FFFFF));
+    }
+  }
+
+  for (size_t m = 0; m < numberOfModes; ++m) {
+    singlePrecisionContext context(format, fenvModes[m]);
+
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w) {
+      traits::bwt elementWidth = widths[w];
+      double largest = (double)((1 << (elementWidth - 1)) - 1);
+
+      std::vector<int64_t> scales[2] = { std::vector<int64_t>(numberOfBlocks), std::vector<int64_t>(numberOfBlocks) };
+      bool nan[2][numberOfBlocks];
+      std::vector<int32_t> elements[2] = { std::vector<int32_t>(n), std::vector<int32_t>(n) };
+      std::vector<uint32_t> decoded(n);
+      std::vector<uint32_t> dot(numberOfBlocks);
+
+      blocks b[2] = { blocks(symfpu::batch::span<int64_t>(scales[0]), symfpu::batch::span<bool>(nan[0], numberOfBlocks),
+			     symfpu::batch::span<int32_t>(elements[0]), blockSize, elementWidth),
+		      blocks(symfpu::batch::span<int64_t>(scales[1]), symfpu::batch::span<bool>(nan[1], numberOfBlocks),
+			     symfpu::batch::span<int32_t>(elements[1]), blockSize, elementWidth) };
+
+      for (int side = 0; side < 2; ++side) {
+	blockSymfpu::encode<int32_t>(pool, context, inputSpan(input[side].data(), n), b[side]);
+      }
+      blockSymfpu::decode<int32_t>(pool, context, b[0], outputSpan(decoded));
+      blockSymfpu::dotProduct<int32_t>(pool, context, b[0], b[1], outputSpan(dot));
+
+      for (size_t j = 0; j < numberOfBlocks; ++j) {
+	double sum = 0.0;
+
+	for (int side = 0; side < 2; ++side) {
+	  int scale = -126 - 23;   // As minSubnormalExponent if all zero
+	  for (size_t i = 0; i < blockSize; ++i) {
+	    u.bits = input[side][j * blockSize + i];
+	    if (u.value != 0.0f && ilogbf(u.value) > scale) scale = ilogbf(u.value);
+	  }
+	  checkResult(verbose, index, "blockFloat scale", scales[side][j], scale);
+	  checkResult(verbose, index, "blockFloat nan", nan[side][j], false);
+
+	  for (size_t i = 0; i < blockSize; ++i) {
+	    u.bits = input[side][j * blockSize + i];
+	    double element = roundToIntegerInMode(ldexp((double)u.value, (elementWidth - 2) - scale), fenvModes[m]);
+	    element = (element > largest) ? largest : ((element < -largest) ? -largest : ((element == 0.0) ? 0.0 : element));
+	    checkResult(verbose, index, "blockFloat encode", (uint32_t)elements[side][j * blockSize + i], (uint32_t)(int32_t)element);
+
+	    if (side == 0) {
+	      checkResult(verbose, index, "blockFloat decode", decoded[j * blockSize + i],
+			  floatToBits((float)ldexp(element, scale - (elementWidth - 2))));
+	    }
+	  }
+	}
+
+	for (size_t i = 0; i < blockSize; ++i) {
+	  sum += ldexp((double)elements[0][j * blockSize + i], scales[0][j] - (elementWidth - 2)) *
+	         ldexp((double)elements[1][j * blockSize + i], scales[1][j] - (elementWidth - 2));
+	}
+	uint32_t reference = (sum == 0.0) ? ((fenvModes[m] == FE_DOWNWARD) ? 0x80000000 : 0x0) :
+	                     doubleToFloatInMode(sum, fenvModes[m]);
+	checkResult(verbose, index, "blockFloat dotProduct", dot[j], reference);
+	++index;
+      }
+    }
+  }
+
+  // Saturation when the largest value rounds up a binade
+  {
+    uint32_t nearlyTwo[2] = { floatToBits(0x1.fffffep+0f), floatToBits(-0x1p-3f) };
+    int64_t scale = 0;
+    bool nan = true;
+    int32_t saturated[2] = { 0, 0 };
+    blocks b(symfpu::batch::span<int64_t>(&scale, 1), symfpu::batch::span<bool>(&nan, 1),
+	     symfpu::batch::span<int32_t>(saturated, 2), 2, 8);
+    blockSymfpu::encode<int32_t>(pool, singlePrecisionContext(format, FE_UPWARD), inputSpan(nearlyTwo, 2), b);
+    checkResult(verbose, index, "blockFloat saturation", scale, 0);
+    checkResult(verbose, index, "blockFloat saturation", saturated[0], 127);
+    checkResult(verbose, index, "blockFloat saturation", (uint32_t)saturated[1], (uint32_t)-8);
+    ++index;
+  }
+
+  // NaN and infinity make the whole block NaN
+  {
+    const uint32_t specials[] = { 0x7FC00000, 0x7F800000, 0xFF800000 };
+    for (size_t k = 0; k < sizeof(specials) / sizeof(uint32_t); ++k) {
+      std::vector<uf> values;
+      for (size_t i = 0; i < 4; ++i) {
+	values.push_back(symfpu::unpack<traits>(format, ubv(32, (i == 2) ? specials[k] : floatToBits(1.5f * i))));
+      }
+      bf encoded(symfpu::blockEncode<traits>(format, traits::RNE(), values, 8));
+      bf finite(symfpu::blockEncode<traits>(format, traits::RNE(), std::vector<uf>(4, values[1]), 8));
+
+      checkResult(verbose, index, "blockFloat special nan", encoded.nan, true);
+      for (size_t i = 0; i < 4; ++i) {
+	checkResult(verbose, index, "blockFloat special decode",
+		    symfpu::blockDecode<traits>(format, traits::RNE(), encoded, i).getNaN(), true);
+      }
+      checkResult(verbose, index, "blockFloat special dotProduct",
+		  symfpu::blockDotProduct<traits>(format, traits::RNE(), finite, encoded).getNaN(), true);
+      ++index;
+    }
+  }
+
+  // Packing round trip, which must fit in 64 bits
+  for (size_t k = 0; k < 64; ++k) {
+    std::vector<uf> values;
+    for (size_t i = 0; i < 4; ++i) {
+      u.bits = input[0][4 * k + i];
+      values.push_back(symfpu::unpack<traits>(format, ubv(32, (k % 16 == 0 && i == 1) ? 0x7FC00000 : u.bits)));
+    }
+    traits::bwt elementWidth = (k % 2) ? 12 : 8;
+    bf encoded(symfpu::blockEncode<traits>(format, traits::RNE(), values, elementWidth));
+    bf unpacked(symfpu::blockUnpack<traits>(format, symfpu::blockPack<traits>(encoded), 4, elementWidth));
+
+    checkResult(verbose, index, "blockFloat pack nan", unpacked.nan, encoded.nan);
+    checkResult(verbose, index, "blockFloat pack scale", unpacked.scale.contents(), encoded.scale.contents());
+    for (size_t i = 0; i < 4; ++i) {
+      checkResult(verbose, index, "blockFloat pack element", unpacked.elements[i].contents(), encoded.elements[i].contents());
+    }
+    ++index;
+  }
+
+  fprintf(stdout,".");
+  fflush(stdout);
+  return;
+}
+
+
+
+typedef void (*testFunction) (const int, const uint64_t, const uint64_t);
+typedef void (*printFunction) (const int, const uint64_t, const uint64_t, const char *, const char *, const char *);
+
+struct testStruct {
+  int enable;
+  const int usesRounding;
+  const char *name;
+  const testFunction run;
+  const printFunction printC;
+  const printFunction printSMT;
+  const testFunction batch;
+  const testFunction dispatch;
+  const char *cPrintString;
+  const char *SMTPrintString;
+};
+
+typedef void (*checkFunction) (const int);
+
+struct checkStruct {
+  int enable;
+  const char *name;
+  const checkFunction run;
+};
+
+struct roundingModeTestStruct {
+  int enable;
+  const char *name;
+  const int value;
+  const char *cPrintString;
+};
+
+
+
+
+
+/*** Application ***/
+
+
+
+#define INCREMENT 0xFFFFFF
+
+#define TEST 0
+#define PRINTC 1
+#define PRINTSMT 2
+#define BATCH 3
+#define DISPATCH 4
+
+// Save on typing!
+#define INST(T,F) T##Test<singlePrecisionExecutableSymfpu::F, singlePrecisionHardware::F>, T##PrintC<singlePrecisionHardware::F>, T##PrintSMT<singlePrecisionHardware::F>, T##Batch<singlePrecisionBatchSymfpu::F, singlePrecisionHardware::F>, T##Test<singlePrecisionDispatched::F, singlePrecisionHardware::F>
+
+int main (int argc, char **argv) {
+  struct testStruct tests[] = {
+    {0,0,         "unpackPack", INST( unaryFunction, unpackPack),      "f",        "f"},
+    {0,0,             "negate", INST( unaryFunction, negate),          "-f",       "(fp.neg f)"},
+    {0,0,           "absolute", INST( unaryFunction, absolute),        "fabsf(f)", "(fp.abs f)"},
+    {0,0,           "isNormal", INST(unaryPredicate, isNormal),        "isnormal(f)", "(fp.isNormal f)"},
+    {0,0,        "isSubnormal", INST(unaryPredicate, isSubnormal),     "fpclassify(f) == FP_SUBNORMAL", "(fp.isSubnormal f)"},
+    {0,0,             "isZero", INST(unaryPredicate, isZero),          "(f) == 0.0f", "(fp.isZero f)"},
+    {0,0,         "isInfinite", INST(unaryPredicate, isInfinite),      "isinf(f)", "(fp.isInfinite f)"},
+    {0,0,              "isNaN", INST(unaryPredicate, isNaN),           "isnan(f)", "(fp.isNaN f)"},
+    {0,0,         "isPositive", INST(unaryPredicate, isPositive),      "!isnan(f) && signbit(f) == 0", "(fp.isPositive f)"},
+    {0,0,         "isNegative", INST(unaryPredicate, isNegative),      "!isnan(f) && signbit(f) != 0", "(fp.isNegative f)"},
+    {0,0,      "SMT-LIB_equal", INST(binaryPredicate, smtlibEqual),    "compare(f,g)", "(= f g)"},
+    {0,0,       "IEE754_equal", INST(binaryPredicate, ieee754Equal),    "f == g",  "(fp.eq f g)"},
+    {0,0,          "less_than", INST(binaryPredicate, lessThan),         "f < g",  "(fp.lt f g)"},
+    {0,0, "less_than_or_equal", INST(binaryPredicate, lessThanOrEqual), "f <= g",  "(fp.leq f g)"},
+    {0,1,           "multiply", INST(binaryRoundedFunction, multiply),  "f * g",  "(fp.mul rm f g)"},
+    {0,1,                "add", INST(binaryRoundedFunction, add),       "f + g",  "(fp.add rm f g)"},
+    {0,1,           "subtract", INST(binaryRoundedFunction, sub),       "f - g",  "(fp.sub rm f g)"},
+    {0,1,             "divide", INST(binaryRoundedFunction, div),       "f / g",  "(fp.div rm f g)"},
+    {0,0,                "max", INST(binaryFunction, max),              "fmaxf(f,g)",  "(fp.max f g)"},
+    {0,0,                "min", INST(binaryFunction, min),              "fminf(f,g)",  "(fp.min f g)"},
+    {0,1,               "sqrt", INST(unaryRoundedFunction, sqrt),       "sqrtf(f)",  "(fp.sqrt rm f)"},
+    {0,1,  "round_to_integral", INST(unaryRoundedFunction, rti),        "(fegetround()==FE_TONEAREST) ? rintf(f) : (fegetround()==FE_UPWARD) ? ceilf(f) : (fegetround()==FE_DOWNWARD) ? floorf(f) : truncf(f)",  "(fp.roundToIntegral rm f)"},
+    {0,1,                "fma", INST(ternaryRoundedFunction, fma),      "fmaf(f,g)",  "(fp.fma rm f g h)"},
+    {0,0,          "remainder", INST(binaryFunction, rem),              "remainderf(f,g)",  "(fp.remainder f g)"},
+    {0,0,                 NULL, NULL, NULL, NULL, NULL, NULL,               NULL,  NULL}
+  };
+
+  struct checkStruct checks[] = {
+    {0, "convertToSigned", checkConvertToSigned},
+    {0,     "flushToZero", checkFlushToZero},
+    {0,   "dispatchFlags", checkDispatchFlags},
+    {0,            "memo", checkMemo},
+    {0,    "augmentedAdd", checkAugmentedAdd},
+    {0,      "stochastic", checkStochasticRounding},
+    {0,      "roundToOdd", checkRoundToOdd},
+    {0,        "quantise", checkQuantise},
+    {0,           "exact", checkExact},
+    {0,        "exponent", checkExponentOperations},
+    {0,    "mixedFormats", checkMixedFormats},
+    {0,  "remainderSteps", checkRemainder},
+    {0,  "integerToFloat", checkIntegerToFloat},
+    {0,             "aig", checkAIG},
+    {0,          "smtlib", checkSMTLIB},
+    {0,             "cnf", checkCNF},
+    {0,       "knownBits", checkKnownBits},
+    {0,     "simplifying", checkSimplifying},
+    {0,            "cost", checkCost},
+    {0,      "collecting", checkCollecting},
+    {0,        "termMemo", checkTermMemo},
+    {0,      "blockFloat", checkBlockFloat},
+    {0, "augmentedMultiply", checkAugmentedMultiply},
+    {0,              NULL, NULL}
+  };
+
+  struct roundingModeTestStruct roundingModeTests[] = {
+    {0, "RNE",  FE_TONEAREST, "FE_TONEAREST"},
+    {0, "RTP",     FE_UPWARD, "FE_UPWARD"},
+    {0, "RTN",   FE_DOWNWARD, "FE_DOWNWARD"},
+    {0, "RTZ", FE_TOWARDZERO, "FE_TOWARDZERO"},
+  //{0, "RNA",        FE_???, "FE_???"},   // Disabled until a suitable reference is available
+    {0,  NULL,             0, NULL}
+  };
+
+  uint64_t start = 0;
+  uint64_t end = INCREMENT;
+  int verbose = 0;
+  int help = 0;
+  int enableAllTests = 0;
+  int enableAllRoundingModes = 0;
+  int continuous = 0;
+  int action = TEST;
+  int threads = 0;
+
+  struct option options[] = {
+    {         "verbose",        no_argument,                          &verbose,  1 },
+    {            "help",        no_argument,                             &help,  1 },
+
+    {           "start",  required_argument,                              NULL, 's'},
+    {             "end",  required_argument,                              NULL, 'e'},
+    {   "specialValues",        no_argument,                              NULL, 't'},
+    {      "continuous",        no_argument,                       &continuous,  1 },
+
+    {        "allTests",        no_argument,                   &enableAllTests,  1 },
+    {"allRoundingModes",        no_argument,           &enableAllRoundingModes,  1 },
+
+    {          "printC",        no_argument,                           &action,  PRINTC },
+    {        "printSMT",        no_argument,                           &action,  PRINTSMT },
+    {           "batch",        no_argument,                           &action,  BATCH },
+    {        "dispatch",        no_argument,                           &action,  DISPATCH },
+    {         "threads",  required_argument,                              NULL, 'j'},
+
+    {      "unpackPack",        no_argument,                &(tests[0].enable),  1 },
+    {          "negate",        no_argument,                &(tests[1].enable),  1 },
+    {        "absolute",        no_argument,                &(tests[2].enable),  1 },
+    {        "isNormal",        no_argument,                &(tests[3].enable),  1 },
+    {     "isSubnormal",        no_argument,                &(tests[4].enable),  1 },
+    {          "isZero",        no_argument,                &(tests[5].enable),  1 },
+    {      "isInfinite",        no_argument,                &(tests[6].enable),  1 },
+    {           "isNaN",        no_argument,                &(tests[7].enable),  1 },
+    {      "isPositive",        no_argument,                &(tests[8].enable),  1 },
+    {      "isNegative",        no_argument,                &(tests[9].enable),  1 },
+    {     "smtlibEqual",        no_argument,               &(tests[10].enable),  1 },
+    {    "ieee754Equal",        no_argument,               &(tests[11].enable),  1 },
+    {        "lessThan",        no_argument,               &(tests[12].enable),  1 },
+    { "lessThanOrEqual",        no_argument,               &(tests[13].enable),  1 },
+    {        "multiply",        no_argument,               &(tests[14].enable),  1 },
+    {             "add",        no_argument,               &(tests[15].enable),  1 },
+    {        "subtract",        no_argument,               &(tests[16].enable),  1 },
+    {          "divide",        no_argument,               &(tests[17].enable),  1 },
+    {             "max",        no_argument,               &(tests[18].enable),  1 },
+    {             "min",        no_argument,               &(tests[19].enable),  1 },
+    {            "sqrt",        no_argument,               &(tests[20].enable),  1 },
+    {             "rti",        no_argument,               &(tests[21].enable),  1 },
+    {             "fma",        no_argument,               &(tests[22].enable),  1 },
+    {       "remainder",        no_argument,               &(tests[23].enable),  1 },
+    { "convertToSigned",        no_argument,              &(checks[0].enable),  1 },
+    {     "flushToZero",        no_argument,              &(checks[1].enable),  1 },
+    {   "dispatchFlags",        no_argument,              &(checks[2].enable),  1 },
+    {            "memo",        no_argument,              &(checks[3].enable),  1 },
+    {    "augmentedAdd",        no_argument,              &(checks[4].enable),  1 },
+    {      "stochastic",        no_argument,              &(checks[5].enable),  1 },
+    {      "roundToOdd",        no_argument,              &(checks[6].enable),  1 },
+    {        "quantise",        no_argument,              &(checks[7].enable),  1 },
+    {           "exact",        no_argument,              &(checks[8].enable),  1 },
+    {        "exponent",        no_argument,              &(checks[9].enable),  1 },
+    {    "mixedFormats",        no_argument,             &(checks[10].enable),  1 },
+    {  "remainderSteps",        no_argument,             &(checks[11].enable),  1 },
+    {  "integerToFloat",        no_argument,             &(checks[12].enable),  1 },
+    {             "aig",        no_argument,             &(checks[13].enable),  1 },
+    {          "smtlib",        no_argument,             &(checks[14].enable),  1 },
+    {             "cnf",        no_argument,             &(checks[15].enable),  1 },
+    {       "knownBits",        no_argument,             &(checks[16].enable),  1 },
+    {     "simplifying",        no_argument,             &(checks[17].enable),  1 },
+    {            "cost",        no_argument,             &(checks[18].enable),  1 },
+    {      "collecting",        no_argument,             &(checks[19].enable),  1 },
+    {        "termMemo",        no_argument,             &(checks[20].enable),  1 },
+    {      "blockFloat",        no_argument,             &(checks[21].enable),  1 },
+    {"augmentedMultiply",       no_argument,             &(checks[22].enable),  1 },
+    {             "rne",        no_argument,    &(roundingModeTests[0].enable),  1 },
+    {             "rtp",        no_argument,    &(roundingModeTests[1].enable),  1 },
+    {             "rtn",        no_argument,    &(roundingModeTests[2].enable),  1 },
+    {             "rtz",        no_argument,    &(roundingModeTests[3].enable),  1 },
+  //{             "rna",        no_argument,    &(roundingModeTests[4].enable),  1 },
+    {             "RNE",        no_argument,    &(roundingModeTests[0].enable),  1 },
+    {             "RTP",        no_argument,    &(roundingModeTests[1].enable),  1 },
+    {             "RTN",        no_argument,    &(roundingModeTests[2].enable),  1 },
+    {             "RTZ",        no_argument,    &(roundingModeTests[3].enable),  1 },
+  //{             "RNA",        no_argument,    &(roundingModeTests[4].enable),  1 },
+    {              NULL,                  0,                              NULL,  0 }
+
+
+  }; 
+
+  bool parseOptions = true;
+  while (parseOptions) {
+    int currentOption = 0;
+    int response = getopt_long(argc, argv, "vs:e:tj:", options, &currentOption);
+
+    switch(response) {
+    case 'v' :
+      verbose = 1;
+      break;
+
+    case 's' :
+      start = strtoull(optarg,NULL,0);
+      break;
+
+    case 'e' :
+      end = strtoull(optarg,NULL,0);
+      break;
+
+    case 'j' :
+      threads = atoi(optarg);
+      break;
+
+    case 't' :
+      end = NUMBER_OF_FLOAT_TESTS  * NUMBER_OF_FLOAT_TESTS; // TODO : split doesn't work like this so this isn't quite right
+      break;
+
+    case 0 :    /* Flag set */
+      break;
+
+    case -1 :   /* End of options */
+      parseOptions = false;
+      break;
+
+    case '?' :  /* Unknown option */
+      fprintf(stderr,"Unknown option : \"%s\"\n", optarg);
+      return 1;
+      break;
+
+    default :   /* Unrecognised getopt response */
+      fprintf(stderr,"Unrecognised getopt response \'%d\' from \"%s\"\n",response, optarg);
+      return 1;
+      break;
+    }
+  }
+
+  /* Help text */
+  if (help) {
+    fprintf(stderr, "TODO: Super helpful message here!\n");
+
+    fprintf(stderr, "Options : \n");
+    struct option *opt = &(options[0]);
+    while (opt->name != NULL) {
+      switch (opt->has_arg) {
+      case no_argument : fprintf(stderr, "\t--%s\n", opt->name); break;
+      case required_argument : fprintf(stderr, "\t--%s\t  argument\n", opt->name); break;
+      case optional_argument : fprintf(stderr, "\t--%s\t[ argument ]\n", opt->name); break;
+      default :	fprintf(stderr, "\t--%s\t???\n", opt->name); break;
+      }
+
+      ++opt;
+    }
+
+    return 0;
+  }
+
+  int roundingModeSet = 0;
+  uint64_t j = 0;
+  while (roundingModeTests[j].name != NULL) {
+    roundingModeSet |= roundingModeTests[j].enable;
+    ++j;
+  }
+  if (!roundingModeSet && !enableAllRoundingModes) {
+    // Set default rounding mode of RNE
+    roundingModeTests[0].enable = 1;
+  }
+
+
+  if (action == BATCH) {
+    batchPool = new threadPool(threads);
+  }
+
+  /* Run the checks, once as they do not depend on the range */
+  if (action == TEST) {
+    int k = 0;
+    while (checks[k].name != NULL) {
+      if (enableAllTests || checks[k].enable) {
+	fprintf(stdout, "Running check for %s : ", checks[k].name);
+	fflush(stdout);
+
+	checks[k].run(verbose);
+
+	fprintf(stdout, "\n");
+	fflush(stdout);
+      }
+      ++k;
+    }
+  }
+  
+ top :
+
+  /* Run the tests */
+  int i = 0;
+  while (tests[i].name != NULL) {
+    if (enableAllTests || tests[i].enable) {
+      if (tests[i].usesRounding) {
+	
+	int j = 0;
+	while (roundingModeTests[j].name != NULL) {
+	  if (enableAllRoundingModes || roundingModeTests[j].enable) {
+	    fprintf(stdout, "Running test for %s %s : ", tests[i].name, roundingModeTests[j].name);
+	    fflush(stdout);
+
+	    singlePrecisionContext context(singlePrecisionFormatObject, roundingModeTests[j].value);
+	    singlePrecisionExecutableSymfpu::scope symfpuScope(context);
+	    singlePrecisionHardware::scope hardwareScope(roundingModeTests[j].value);
+	    
+	    switch (action) {
+	    case TEST :
+	      tests[i].run(verbose, start, end);
+	      break;
+	      
+	    case PRINTC :
+	      tests[i].printC(verbose, start, end, tests[i].name, tests[i].cPrintString, roundingModeTests[j].cPrintString);
+	      break;
+	      
+	    case PRINTSMT :
+	      tests[i].printSMT(verbose, start, end, tests[i].name, tests[i].SMTPrintString, roundingModeTests[j].name);
+	      break;
+
+	    case BATCH :
+	      tests[i].batch(verbose, start, end);
+	      break;
+
+	    case DISPATCH :
+	      tests[i].dispatch(verbose, start, end);
+	      break;
+	      
+	    default :
+	      assert(0);
+	      break;
+	    }
+
+	    fprintf(stdout, "\n");
+	    fflush(stdout);
+	  }
+	  ++j;
+	}
+
+
+      } else {
+	fprintf(stdout, "Running test for %s : ", tests[i].name);
+	fflush(stdout);
+
+	// Rounding mode is not used but the format is
+	singlePrecisionContext context(singlePrecisionFormatObject, FE_TONEAREST);
+	singlePrecisionExecutableSymfpu::scope symfpuScope(context);
 
 	switch (action) {
 	case TEST :
@@ -1410,6 +3732,14 @@ int main (int argc, char **argv) {
 	case PRINTSMT :
 	  tests[i].printSMT(verbose, start, end, tests[i].name, tests[i].SMTPrintString, NULL);
 	  break;
+
+	case BATCH :
+	  tests[i].batch(verbose, start, end);
+	  break;
+
+	case DISPATCH :
+	  tests[i].dispatch(verbose, start, end);
+	  break;
 	  
 	default :
 	  assert(0);
@@ -1433,7 +3763,7 @@ int main (int argc, char **argv) {
     goto top;
   }
 
-  singlePrecisionExecutableSymfpu::destroyFormat();
+  delete batchPool;
 
   return 1;
 }
@@ -0,0 +1,657 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** aig.cpp
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** The graph and the bit-level circuits for the AIG back-end.
+**
+*/
+
+#include "symfpu/baseTypes/aig.h"
+
+#include <algorithm>
+
+namespace symfpu {
+  namespace aig {
+
+    /*** The graph ***/
+
+    graph::graph () : rewrites(0) {
+      node constant = { noFanin, noFanin };
+      nodes.push_back(constant);
+    }
+
+    literal graph::input (const std::string &name) {
+      uint32_t index = nodes.size();
+      assert(index < (1U << 31));
+
+      node n = { noFanin, noFanin };
+      nodes.push_back(n);
+      inputNodes.push_back(index);
+      inputNames.push_back(name);
+
+      return index << 1;
+    }
+
+    literal graph::makeAnd (const literal a, const literal b) {
+      uint64_t key = (((uint64_t)a) << 32) | b;
+
+      std::unordered_map<uint64_t, uint32_t>::const_iterator it(structuralHash.find(key));
+      if (it != structuralHash.end()) {
+	return it->second << 1;
+      }
+
+      uint32_t index = nodes.size();
+      assert(index < (1U << 31));
+
+      node n = { a, b };
+      nodes.push_back(n);
+      structuralHash.insert(std::make_pair(key, index));
+
+      return index << 1;
+    }
+
+    // The local rewrites of Brummayer and Biere, where a and b are
+    // distinct and not constant.  Returns noFanin if none apply.
+    literal graph::rewrite (const literal a, const literal b) {
+      bool aIsAnd = isAnd(a);
+      bool bIsAnd = isAnd(b);
+
+      // One level, with the and gate as a
+      for (int swap = 0; swap < 2; ++swap) {
+	literal x = (swap == 0) ? a : b;
+	literal y = (swap == 0) ? b : a;
+
+	if ((swap == 0) ? !aIsAnd : !bIsAnd) continue;
+
+	const node &n = fanins(x);
+
+	if (!isNegated(x)) {
+	  // Contradiction : (x0 & x1) & !x0 = false
+	  if (y == negate(n.left) || y == negate(n.right)) { ++rewrites; return falseLiteral; }
+
+	  // Idempotence : (x0 & x1) & x0 = x0 & x1
+	  if (y == n.left || y == n.right) { ++rewrites; return x; }
+
+	} else {
+	  // Subsumption : !(x0 & x1) & !x0 = !x0
+	  if (y == negate(n.left) || y == negate(n.right)) { ++rewrites; return y; }
+
+	  // Substitution : !(x0 & x1) & x0 = !x1 & x0
+	  if (y == n.left) { ++rewrites; return andGate(negate(n.right), y); }
+	  if (y == n.right) { ++rewrites; return andGate(negate(n.left), y); }
+	}
+      }
+
+      // Two level
+      if (aIsAnd && bIsAnd) {
+	const node &na = fanins(a);
+	const node &nb = fanins(b);
+
+	literal af[2] = { na.left, na.right };
+	literal bf[2] = { nb.left, nb.right };
+
+	if (!isNegated(a) && !isNegated(b)) {
+	  for (int i = 0; i < 2; ++i) {
+	    for (int j = 0; j < 2; ++j) {
+	      // Contradiction : (a0 & a1) & (!a0 & b1) = false
+	      if (af[i] == negate(bf[j])) { ++rewrites; return falseLiteral; }
+	    }
+	  }
+
+	} else if (isNegated(a) != isNegated(b)) {
+	  // Make the negated one x
+	  const literal *xf = isNegated(a) ? af : bf;
+	  const literal *yf = isNegated(a) ? bf : af;
+	  literal y = isNegated(a) ? b : a;
+
+	  for (int i = 0; i < 2; ++i) {
+	    for (int j = 0; j < 2; ++j) {
+	      // Subsumption : !(x0 & x1) & (!x0 & y1) = (!x0 & y1)
+	      if (xf[i] == negate(yf[j])) { ++rewrites; return y; }
+	    }
+	  }
+
+	  for (int i = 0; i < 2; ++i) {
+	    for (int j = 0; j < 2; ++j) {
+	      // Substitution : !(x0 & x1) & (x0 & y1) = !x1 & (x0 & y1)
+	      if (xf[i] == yf[j]) { ++rewrites; return andGate(negate(xf[1 - i]), y); }
+	    }
+	  }
+
+	} else {
+	  for (int i = 0; i < 2; ++i) {
+	    for (int j = 0; j < 2; ++j) {
+	      // Resolution : !(s & x) & !(s & !x) = !s
+	      if (af[i] == bf[j] && af[1 - i] == negate(bf[1 - j])) {
+		++rewrites;
+		return negate(af[i]);
+	      }
+	    }
+	  }
+	}
+      }
+
+      return noFanin;
+    }
+
+    literal graph::andGate (const literal x, const literal y) {
+      // Order the fanins so that the hash is independent of the order
+      literal a = std::max(x, y);
+      literal b = std::min(x, y);
+
+      // Constants are the smallest literals so will be b
+      if (b == falseLiteral) return falseLiteral;
+      if (b == trueLiteral) return a;
+      if (a == b) return a;
+      if (a == negate(b)) return falseLiteral;
+
+      literal rewritten = rewrite(a, b);
+      if (rewritten != noFanin) {
+	return rewritten;
+      }
+
+      return makeAnd(a, b);
+    }
+
+    literal graph::xorGate (const literal a, const literal b) {
+      if (isConstant(a)) return (a == falseLiteral) ? b : negate(b);
+      if (isConstant(b)) return (b == falseLiteral) ? a : negate(a);
+      if (a == b) return falseLiteral;
+      if (a == negate(b)) return trueLiteral;
+
+      return orGate(andGate(a, negate(b)), andGate(negate(a), b));
+    }
+
+    literal graph::iteGate (const literal c, const literal t, const literal e) {
+      if (c == trueLiteral) return t;
+      if (c == falseLiteral) return e;
+      if (t == e) return t;
+
+      return orGate(andGate(c, t), andGate(negate(c), e));
+    }
+
+
+    // Marks the and gates needed by the outputs.  As fanins are always
+    // made before the gates that use them, going down the indices
+    // visits every gate after all of its users.
+    std::vector<bool> graph::cone (const std::vector<literal> &outputs) const {
+      std::vector<bool> needed(nodes.size(), false);
+
+      for (size_t i = 0; i < outputs.size(); ++i) {
+	needed[nodeIndex(outputs[i])] = true;
+      }
+
+      for (size_t i = nodes.size() - 1; i > 0; --i) {
+	if (needed[i] && nodes[i].left != noFanin) {
+	  needed[nodeIndex(nodes[i].left)] = true;
+	  needed[nodeIndex(nodes[i].right)] = true;
+	}
+      }
+
+      return needed;
+    }
+
+    size_t graph::coneSize (const std::vector<literal> &outputs) const {
+      std::vector<bool> needed(cone(outputs));
+
+      size_t count = 0;
+      for (size_t i = 1; i < nodes.size(); ++i) {
+	count += (needed[i] && nodes[i].left != noFanin);
+      }
+      return count;
+    }
+
+    std::vector<uint64_t> graph::simulate (const std::vector<uint64_t> &inputValues,
+					   const std::vector<literal> &literals) const {
+      assert(inputValues.size() == inputNodes.size());
+
+      std::vector<uint64_t> value(nodes.size(), 0);
+
+      for (size_t i = 0; i < inputNodes.size(); ++i) {
+	value[inputNodes[i]] = inputValues[i];
+      }
+
+      #define LITERALVALUE(L) (value[nodeIndex(L)] ^ (isNegated(L) ? ~0ULL : 0ULL))
+
+      for (size_t i = 1; i < nodes.size(); ++i) {
+	if (nodes[i].left != noFanin) {
+	  value[i] = LITERALVALUE(nodes[i].left) & LITERALVALUE(nodes[i].right);
+	}
+      }
+
+      std::vector<uint64_t> result(literals.size());
+      for (size_t i = 0; i < literals.size(); ++i) {
+	result[i] = LITERALVALUE(literals[i]);
+      }
+
+      #undef LITERALVALUE
+
+      return result;
+    }
+
+    static void writeDelta (std::ostream &out, uint32_t delta) {
+      while (delta & ~0x7FU) {
+	out.put((char)((delta & 0x7F) | 0x80));
+	delta >>= 7;
+      }
+      out.put((char)delta);
+    }
+
+    void graph::writeAIGER (std::ostream &out,
+			    const std::vector<literal> &outputs,
+			    const std::vector<std::string> &outputNames,
+			    bool binary) const {
+      assert(outputNames.empty() || outputNames.size() == outputs.size());
+
+      std::vector<bool> needed(cone(outputs));
+
+      // Inputs are variables 1 to I then the and gates in index order,
+      // which is topological
+      std::vector<uint32_t> variable(nodes.size(), 0);
+      uint32_t next = 1;
+
+      for (size_t i = 0; i < inputNodes.size(); ++i) {
+	variable[inputNodes[i]] = next++;
+      }
+
+      std::vector<uint32_t> ands;
+      for (size_t i = 1; i < nodes.size(); ++i) {
+	if (needed[i] && nodes[i].left != noFanin) {
+	  variable[i] = next++;
+	  ands.push_back(i);
+	}
+      }
+
+      #define MAPLITERAL(L) ((variable[nodeIndex(L)] << 1) | (L & 0x1))
+
+      out << (binary ? "aig " : "aag ") << (next - 1) << " "
+	  << inputNodes.size() << " 0 "
+	  << outputs.size() << " "
+	  << ands.size() << "\n";
+
+      if (!binary) {
+	for (size_t i = 0; i < inputNodes.size(); ++i) {
+	  out << (variable[inputNodes[i]] << 1) << "\n";
+	}
+      }
+
+      for (size_t i = 0; i < outputs.size(); ++i) {
+	out << MAPLITERAL(outputs[i]) << "\n";
+      }
+
+      for (size_t i = 0; i < ands.size(); ++i) {
+	const node &n = nodes[ands[i]];
+	uint32_t lhs = variable[ands[i]] << 1;
+	uint32_t rhs0 = MAPLITERAL(n.left);
+	uint32_t rhs1 = MAPLITERAL(n.right);
+	if (rhs0 < rhs1) std::swap(rhs0, rhs1);
+
+	if (binary) {
+	  assert(lhs > rhs0);
+	  writeDelta(out, lhs - rhs0);
+	  writeDelta(out, rhs0 - rhs1);
+	} else {
+	  out << lhs << " " << rhs0 << " " << rhs1 << "\n";
+	}
+      }
+
+      #undef MAPLITERAL
+
+      // Symbol table
+      for (size_t i = 0; i < inputNames.size(); ++i) {
+	if (!inputNames[i].empty()) {
+	  out << "i" << i << " " << inputNames[i] << "\n";
+	}
+      }
+      for (size_t i = 0; i < outputNames.size(); ++i) {
+	if (!outputNames[i].empty()) {
+	  out << "o" << i << " " << outputNames[i] << "\n";
+	}
+      }
+
+      return;
+    }
+
+
+
+    /*** The current graph ***/
+
+    static thread_local graph *current = NULL;
+
+    graph & currentGraph (void) {
+      assert(current != NULL);
+      return *current;
+    }
+
+    scope::scope (graph &g) : previous(current) {
+      current = &g;
+    }
+
+    scope::~scope () {
+      current = previous;
+    }
+
+
+
+    /*** Traits ***/
+
+    roundingMode traits::RNE (void) { return roundingMode(0); }
+    roundingMode traits::RNA (void) { return roundingMode(1); }
+    roundingMode traits::RTP (void) { return roundingMode(2); }
+    roundingMode traits::RTN (void) { return roundingMode(3); }
+    roundingMode traits::RTZ (void) { return roundingMode(4); }
+    roundingMode traits::RTO (void) { return roundingMode(5); }
+
+    void traits::precondition (const prop &p) { assert(!p.isFalse()); return; }
+    void traits::postcondition (const prop &p) { assert(!p.isFalse()); return; }
+    void traits::invariant (const prop &p) { assert(!p.isFalse()); return; }
+
+
+
+    /*** Rounding modes ***/
+
+    roundingMode::roundingMode (const unsigned int mode) {
+      PRECONDITION(mode < numberOfModes);
+      for (unsigned int i = 0; i < numberOfModes; ++i) {
+	modes[i] = (i == mode) ? trueLiteral : falseLiteral;
+      }
+    }
+
+    roundingMode::roundingMode (const roundingMode &old) {
+      std::copy(old.modes, old.modes + numberOfModes, modes);
+    }
+
+    roundingMode & roundingMode::operator = (const roundingMode &op) {
+      std::copy(op.modes, op.modes + numberOfModes, modes);
+      return *this;
+    }
+
+    roundingMode roundingMode::input (const std::string &name) {
+      bitVector<false> encoding(bitVector<false>::input(3, name));
+
+      roundingMode result(0);
+      literal other = falseLiteral;
+      for (unsigned int i = 1; i < numberOfModes; ++i) {
+	result.modes[i] = (encoding == bitVector<false>(3, i)).getLiteral();
+	other = currentGraph().orGate(other, result.modes[i]);
+      }
+      result.modes[0] = negate(other);
+
+      return result;
+    }
+
+    proposition roundingMode::valid (void) const {
+      graph &g = currentGraph();
+
+      literal some = falseLiteral;
+      literal two = falseLiteral;
+      for (unsigned int i = 0; i < numberOfModes; ++i) {
+	two = g.orGate(two, g.andGate(some, modes[i]));
+	some = g.orGate(some, modes[i]);
+      }
+
+      return proposition::fromLiteral(g.andGate(some, negate(two)));
+    }
+
+    proposition roundingMode::operator == (const roundingMode &op) const {
+      graph &g = currentGraph();
+
+      literal result = falseLiteral;
+      for (unsigned int i = 0; i < numberOfModes; ++i) {
+	result = g.orGate(result, g.andGate(modes[i], op.modes[i]));
+      }
+
+      return proposition::fromLiteral(result);
+    }
+
+
+
+    /*** Bit-vector circuits ***/
+
+    namespace operations {
+
+      bits constant (const bitWidthType w, const uint64_t v, const bool isSigned) {
+	bits b(w);
+	for (bitWidthType i = 0; i < w; ++i) {
+	  bitWidthType j = (i < 64) ? i : 63;
+	  bool bit = (i < 64 || isSigned) && ((v >> j) & 0x1);
+	  b[i] = bit ? trueLiteral : falseLiteral;
+	}
+	return b;
+      }
+
+      bits mux (const literal c, const bits &l, const bits &r) {
+	assert(l.size() == r.size());
+	graph &g = currentGraph();
+
+	if (c == trueLiteral) return l;
+	if (c == falseLiteral) return r;
+
+	bits result(l.size());
+	for (size_t i = 0; i < l.size(); ++i) {
+	  result[i] = g.iteGate(c, l[i], r[i]);
+	}
+	return result;
+      }
+
+      bits bitwiseAnd (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+	graph &g = currentGraph();
+
+	bits result(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result[i] = g.andGate(a[i], b[i]);
+	}
+	return result;
+      }
+
+      bits bitwiseOr (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+	graph &g = currentGraph();
+
+	bits result(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result[i] = g.orGate(a[i], b[i]);
+	}
+	return result;
+      }
+
+      bits bitwiseNot (const bits &a) {
+	bits result(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result[i] = aig::negate(a[i]);
+	}
+	return result;
+      }
+
+      // Ripple carry
+      bits add (const bits &a, const bits &b, const literal carryIn) {
+	assert(a.size() == b.size());
+	graph &g = currentGraph();
+
+	bits result(a.size());
+	literal carry = carryIn;
+	for (size_t i = 0; i < a.size(); ++i) {
+	  literal halfSum = g.xorGate(a[i], b[i]);
+	  result[i] = g.xorGate(halfSum, carry);
+	  carry = g.orGate(g.andGate(a[i], b[i]), g.andGate(halfSum, carry));
+	}
+	return result;
+      }
+
+      bits negate (const bits &a) {
+	return add(bitwiseNot(a), constant(a.size(), 0, false), trueLiteral);
+      }
+
+      // Shift and add, only the low bits are needed
+      bits multiply (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+	graph &g = currentGraph();
+	size_t w = a.size();
+
+	bits result(constant(w, 0, false));
+	for (size_t i = 0; i < w; ++i) {
+	  if (b[i] == falseLiteral) continue;
+
+	  bits partial(w, falseLiteral);
+	  for (size_t j = i; j < w; ++j) {
+	    partial[j] = g.andGate(a[j - i], b[i]);
+	  }
+	  result = add(result, partial, falseLiteral);
+	}
+	return result;
+      }
+
+      // Restoring division.  Division by zero gives all ones and a
+      // remainder of the dividend, as in SMT-LIB.
+      static void unsignedDivide (const bits &a, const bits &b, bits &quotient, bits &remainder) {
+	assert(a.size() == b.size());
+	size_t w = a.size();
+
+	bits divisor(b);
+	divisor.push_back(falseLiteral);
+
+	bits partial(constant(w + 1, 0, false));
+	quotient.resize(w);
+
+	for (size_t i = w; i > 0; --i) {
+	  partial.pop_back();
+	  partial.insert(partial.begin(), a[i - 1]);
+
+	  literal fits = aig::negate(lessThan(partial, divisor, false, false));
+	  partial = mux(fits, add(partial, bitwiseNot(divisor), trueLiteral), partial);
+	  quotient[i - 1] = fits;
+	}
+
+	partial.pop_back();
+	remainder = partial;
+	return;
+      }
+
+      // Signed division rounds towards zero and the remainder has the
+      // sign of the dividend
+      void divide (const bits &a, const bits &b, const bool isSigned, bits &quotient, bits &remainder) {
+	if (!isSigned) {
+	  unsignedDivide(a, b, quotient, remainder);
+	  return;
+	}
+
+	literal aNegative = a.back();
+	literal bNegative = b.back();
+
+	bits q, r;
+	unsignedDivide(mux(aNegative, negate(a), a),
+		       mux(bNegative, negate(b), b),
+		       q, r);
+
+	quotient = mux(currentGraph().xorGate(aNegative, bNegative), negate(q), q);
+	remainder = mux(aNegative, negate(r), r);
+	return;
+      }
+
+      // Barrel shifter, amounts of the width or more shift everything out
+      static bits shift (const bits &a, const bits &amount, const bool left, const literal fill) {
+	assert(a.size() == amount.size());
+	graph &g = currentGraph();
+	size_t w = a.size();
+
+	bits result(a);
+	literal tooFar = falseLiteral;
+
+	for (size_t j = 0; j < amount.size(); ++j) {
+	  if (j >= 32 || (1ULL << j) >= w) {
+	    tooFar = g.orGate(tooFar, amount[j]);
+	    continue;
+	  }
+
+	  size_t distance = 1ULL << j;
+	  bits shifted(w);
+	  for (size_t i = 0; i < w; ++i) {
+	    if (left) {
+	      shifted[i] = (i >= distance) ? result[i - distance] : falseLiteral;
+	    } else {
+	      shifted[i] = (i + distance < w) ? result[i + distance] : fill;
+	    }
+	  }
+	  result = mux(amount[j], shifted, result);
+	}
+
+	return mux(tooFar, bits(w, left ? falseLiteral : fill), result);
+      }
+
+      bits leftShift (const bits &a, const bits &amount) {
+	return shift(a, amount, true, falseLiteral);
+      }
+
+      bits rightShift (const bits &a, const bits &amount, const bool arithmetic) {
+	return shift(a, amount, false, arithmetic ? a.back() : falseLiteral);
+      }
+
+      literal equal (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+	graph &g = currentGraph();
+
+	literal result = trueLiteral;
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result = g.andGate(result, g.equalGate(a[i], b[i]));
+	}
+	return result;
+      }
+
+      // From the least significant bit up, signed comparison is
+      // unsigned comparison with the top bits inverted
+      literal lessThan (const bits &a, const bits &b, const bool isSigned, const bool orEqual) {
+	assert(a.size() == b.size());
+	graph &g = currentGraph();
+	size_t w = a.size();
+
+	literal result = orEqual ? trueLiteral : falseLiteral;
+	for (size_t i = 0; i < w; ++i) {
+	  bool flip = isSigned && (i == w - 1);
+	  literal ai = flip ? aig::negate(a[i]) : a[i];
+	  literal bi = flip ? aig::negate(b[i]) : b[i];
+
+	  result = g.orGate(g.andGate(aig::negate(ai), bi),
+			    g.andGate(g.equalGate(ai, bi), result));
+	}
+	return result;
+      }
+
+      literal allOnes (const bits &a) {
+	graph &g = currentGraph();
+
+	literal result = trueLiteral;
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result = g.andGate(result, a[i]);
+	}
+	return result;
+      }
+
+      literal allZeros (const bits &a) {
+	return allOnes(bitwiseNot(a));
+      }
+
+    }
+
+  }
+}
@@ -0,0 +1,689 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** cnf.cpp
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** The circuit, clause generation and bit-level operations for the CNF
+** back-end.
+**
+*/
+
+#include "symfpu/baseTypes/cnf.h"
+
+#include <algorithm>
+
+namespace symfpu {
+  namespace cnf {
+
+    /*** The circuit ***/
+
+    circuit::circuit () {
+      gate constant = { INPUT, { 0, 0, 0 } };
+      gates.push_back(constant);
+    }
+
+    literal circuit::input (const std::string &name) {
+      uint32_t index = gates.size();
+      assert(index < (1U << 31));
+
+      gate g = { INPUT, { 0, 0, 0 } };
+      gates.push_back(g);
+      inputGates.push_back(index);
+      inputNames.push_back(name);
+
+      return index << 1;
+    }
+
+    literal circuit::makeGate (const gateType type, const literal a, const literal b, const literal c) {
+      gate g = { type, { a, b, c } };
+
+      std::unordered_map<gate, uint32_t, hasher>::const_iterator it(structuralHash.find(g));
+      if (it != structuralHash.end()) {
+	return it->second << 1;
+      }
+
+      uint32_t index = gates.size();
+      assert(index < (1U << 31));
+
+      gates.push_back(g);
+      structuralHash.insert(std::make_pair(g, index));
+
+      return index << 1;
+    }
+
+    literal circuit::andGate (const literal x, const literal y) {
+      literal a = std::max(x, y);
+      literal b = std::min(x, y);
+
+      // Constants are the smallest literals so will be b
+      if (b == falseLiteral) return falseLiteral;
+      if (b == trueLiteral) return a;
+      if (a == b) return a;
+      if (a == negate(b)) return falseLiteral;
+
+      return makeGate(AND, a, b, 0);
+    }
+
+    // Negations are taken out of the fanins of xor gates
+    literal circuit::xorGate (const literal x, const literal y) {
+      if (isConstant(x)) return x ^ y;
+      if (isConstant(y)) return x ^ y;
+
+      bool negated = isNegated(x) != isNegated(y);
+      literal a = std::max(x, y) & ~0x1U;
+      literal b = std::min(x, y) & ~0x1U;
+
+      literal result = (a == b) ? falseLiteral : makeGate(XOR, a, b, 0);
+      return negated ? negate(result) : result;
+    }
+
+    literal circuit::xor3Gate (const literal x, const literal y, const literal z) {
+      if (isConstant(x)) return x ^ xorGate(y, z);
+      if (isConstant(y)) return y ^ xorGate(x, z);
+      if (isConstant(z)) return z ^ xorGate(x, y);
+
+      bool negated = isNegated(x) ^ isNegated(y) ^ isNegated(z);
+      literal f[3] = { x & ~0x1U, y & ~0x1U, z & ~0x1U };
+      std::sort(f, f + 3);
+
+      literal result;
+      if (f[0] == f[1]) {
+	result = f[2];
+      } else if (f[1] == f[2]) {
+	result = f[0];
+      } else {
+	result = makeGate(XOR3, f[2], f[1], f[0]);
+      }
+      return negated ? negate(result) : result;
+    }
+
+    literal circuit::majorityGate (const literal x, const literal y, const literal z) {
+      literal f[3] = { x, y, z };
+      std::sort(f, f + 3);
+
+      // Constants are the smallest literals so will be first
+      if (f[0] == falseLiteral) return andGate(f[1], f[2]);
+      if (f[0] == trueLiteral) return orGate(f[1], f[2]);
+
+      for (int i = 0; i < 3; ++i) {
+	literal p = f[i];
+	literal q = f[(i + 1) % 3];
+	literal r = f[(i + 2) % 3];
+	if (p == q) return p;
+	if (p == negate(q)) return r;
+      }
+
+      // So that at most one fanin is negated
+      int negatedFanins = isNegated(x) + isNegated(y) + isNegated(z);
+      if (negatedFanins >= 2) {
+	return negate(majorityGate(negate(x), negate(y), negate(z)));
+      }
+
+      return makeGate(MAJORITY, f[2], f[1], f[0]);
+    }
+
+    literal circuit::iteGate (const literal c, const literal t, const literal e) {
+      if (c == trueLiteral) return t;
+      if (c == falseLiteral) return e;
+      if (t == e) return t;
+      if (t == negate(e)) return negate(xorGate(c, t));
+
+      if (t == trueLiteral || t == c) return orGate(c, e);
+      if (t == falseLiteral || t == negate(c)) return andGate(negate(c), e);
+      if (e == trueLiteral || e == negate(c)) return orGate(negate(c), t);
+      if (e == falseLiteral || e == c) return andGate(c, t);
+
+      // The condition and the then branch are not negated
+      if (isNegated(c)) return iteGate(negate(c), e, t);
+      if (isNegated(t)) return negate(iteGate(c, negate(t), negate(e)));
+
+      return makeGate(ITE, c, t, e);
+    }
+
+
+
+    /*** Clause generation ***/
+
+    // The polarities a gate is needed in
+    static const uint8_t positive = 0x1;
+    static const uint8_t negative = 0x2;
+    static const uint8_t both = positive | negative;
+
+    static inline uint8_t polarityOf (const literal l, const uint8_t p) {
+      return isNegated(l) ? (uint8_t)(((p & positive) << 1) | ((p & negative) >> 1)) : p;
+    }
+
+    template <class emitter>
+    uint32_t circuit::generate (const std::vector<literal> &assertions,
+				const std::vector<literal> &outputs,
+				const bool polarityAware,
+				std::vector<uint32_t> &variable,
+				emitter &emit) const {
+      std::vector<uint8_t> polarity(gates.size(), 0);
+
+      for (size_t i = 0; i < assertions.size(); ++i) {
+	polarity[gateIndex(assertions[i])] |= polarityOf(assertions[i], positive);
+      }
+      for (size_t i = 0; i < outputs.size(); ++i) {
+	polarity[gateIndex(outputs[i])] |= both;
+      }
+
+      // Fanins are always made before the gates that use them so going
+      // down the indices reaches every gate after all of its users
+      for (size_t i = gates.size() - 1; i > 0; --i) {
+	const gate &g = gates[i];
+	uint8_t p = polarityAware ? polarity[i] : (polarity[i] ? both : 0);
+	polarity[i] = p;
+	if (p == 0) continue;
+
+	switch (g.type) {
+	case INPUT :
+	  break;
+
+	case AND :
+	case MAJORITY :
+	  for (int j = 0; j < ((g.type == AND) ? 2 : 3); ++j) {
+	    polarity[gateIndex(g.fanin[j])] |= polarityOf(g.fanin[j], p);
+	  }
+	  break;
+
+	case ITE :
+	  polarity[gateIndex(g.fanin[0])] |= both;
+	  polarity[gateIndex(g.fanin[1])] |= polarityOf(g.fanin[1], p);
+	  polarity[gateIndex(g.fanin[2])] |= polarityOf(g.fanin[2], p);
+	  break;
+
+	case XOR :
+	case XOR3 :
+	  for (int j = 0; j < ((g.type == XOR) ? 2 : 3); ++j) {
+	    polarity[gateIndex(g.fanin[j])] |= both;
+	  }
+	  break;
+	}
+      }
+
+
+      // Inputs are variables 1 to I, then the gates in index order and
+      // the constant last if it is used
+      variable.assign(gates.size(), 0);
+      uint32_t next = 1;
+
+      for (size_t i = 0; i < inputGates.size(); ++i) {
+	variable[inputGates[i]] = next++;
+      }
+      for (size_t i = 1; i < gates.size(); ++i) {
+	if (polarity[i] != 0 && gates[i].type != INPUT) {
+	  variable[i] = next++;
+	}
+      }
+      if (polarity[0] != 0) {
+	variable[0] = next++;
+	int unit[1] = { -(int)variable[0] };   // As gate 0 is false
+	emit(unit, 1);
+      }
+
+      #define DIMACS(L) ((isNegated(L) ? -1 : 1) * (int)variable[gateIndex(L)])
+      #define CLAUSE(...) do { int clause[] = { __VA_ARGS__ }; emit(clause, sizeof(clause) / sizeof(int)); } while (0)
+
+      for (size_t i = 1; i < gates.size(); ++i) {
+	const gate &g = gates[i];
+	uint8_t p = polarity[i];
+	if (p == 0 || g.type == INPUT) continue;
+
+	int o = (int)variable[i];
+	int a = DIMACS(g.fanin[0]);
+	int b = DIMACS(g.fanin[1]);
+	int c = (g.type == AND || g.type == XOR) ? 0 : DIMACS(g.fanin[2]);
+
+	switch (g.type) {
+	case AND :
+	  if (p & positive) { CLAUSE(-o, a); CLAUSE(-o, b); }
+	  if (p & negative) { CLAUSE(o, -a, -b); }
+	  break;
+
+	case XOR :
+	  if (p & positive) { CLAUSE(-o, a, b); CLAUSE(-o, -a, -b); }
+	  if (p & negative) { CLAUSE(o, -a, b); CLAUSE(o, a, -b); }
+	  break;
+
+	case XOR3 :
+	  if (p & positive) { CLAUSE(-o, a, b, c); CLAUSE(-o, a, -b, -c); CLAUSE(-o, -a, b, -c); CLAUSE(-o, -a, -b, c); }
+	  if (p & negative) { CLAUSE(o, -a, b, c); CLAUSE(o, a, -b, c); CLAUSE(o, a, b, -c); CLAUSE(o, -a, -b, -c); }
+	  break;
+
+	case MAJORITY :
+	  if (p & positive) { CLAUSE(-o, a, b); CLAUSE(-o, a, c); CLAUSE(-o, b, c); }
+	  if (p & negative) { CLAUSE(o, -a, -b); CLAUSE(o, -a, -c); CLAUSE(o, -b, -c); }
+	  break;
+
+	case ITE :
+	  // The third clause of each is implied but helps propagation
+	  if (p & positive) { CLAUSE(-o, -a, b); CLAUSE(-o, a, c); CLAUSE(-o, b, c); }
+	  if (p & negative) { CLAUSE(o, -a, -b); CLAUSE(o, a, -c); CLAUSE(o, -b, -c); }
+	  break;
+
+	case INPUT :
+	  break;
+	}
+      }
+
+      for (size_t i = 0; i < assertions.size(); ++i) {
+	CLAUSE(DIMACS(assertions[i]));
+      }
+
+      #undef CLAUSE
+      #undef DIMACS
+
+      return next - 1;
+    }
+
+    struct counter {
+      uint64_t clauses;
+      uint64_t literals;
+
+      counter () : clauses(0), literals(0) {}
+
+      void operator() (const int *, const size_t n) {
+	++clauses;
+	literals += n;
+      }
+    };
+
+    struct writer {
+      std::ostream &out;
+
+      writer (std::ostream &o) : out(o) {}
+
+      void operator() (const int *c, const size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+	  out << c[i] << ' ';
+	}
+	out << "0\n";
+      }
+    };
+
+    circuit::statistics circuit::size (const std::vector<literal> &assertions,
+				       const std::vector<literal> &outputs,
+				       const bool polarityAware) const {
+      std::vector<uint32_t> variable;
+      counter count;
+
+      statistics s;
+      s.variables = generate(assertions, outputs, polarityAware, variable, count);
+      s.clauses = count.clauses;
+      s.literals = count.literals;
+
+      return s;
+    }
+
+    void circuit::writeDIMACS (std::ostream &out,
+			       const std::vector<literal> &assertions,
+			       const std::vector<literal> &outputs,
+			       const bool polarityAware) const {
+      // The header needs the number of clauses so they are generated
+      // twice rather than stored
+      std::vector<uint32_t> variable;
+      counter count;
+      uint32_t variables = generate(assertions, outputs, polarityAware, variable, count);
+
+      for (size_t i = 0; i < inputGates.size(); ++i) {
+	out << "c input " << i << " " << variable[inputGates[i]];
+	if (!inputNames[i].empty()) {
+	  out << " " << inputNames[i];
+	}
+	out << "\n";
+      }
+      for (size_t i = 0; i < outputs.size(); ++i) {
+	out << "c output " << i << " "
+	    << ((isNegated(outputs[i]) ? -1 : 1) * (int)variable[gateIndex(outputs[i])]) << "\n";
+      }
+
+      out << "p cnf " << variables << " " << count.clauses << "\n";
+
+      writer write(out);
+      generate(assertions, outputs, polarityAware, variable, write);
+
+      return;
+    }
+
+
+
+    /*** The current circuit ***/
+
+    static thread_local circuit *current = NULL;
+
+    circuit & currentCircuit (void) {
+      assert(current != NULL);
+      return *current;
+    }
+
+    scope::scope (circuit &c) : previous(current) {
+      current = &c;
+    }
+
+    scope::~scope () {
+      current = previous;
+    }
+
+
+
+    /*** Traits ***/
+
+    roundingMode traits::RNE (void) { return roundingMode(0); }
+    roundingMode traits::RNA (void) { return roundingMode(1); }
+    roundingMode traits::RTP (void) { return roundingMode(2); }
+    roundingMode traits::RTN (void) { return roundingMode(3); }
+    roundingMode traits::RTZ (void) { return roundingMode(4); }
+    roundingMode traits::RTO (void) { return roundingMode(5); }
+
+    void traits::precondition (const prop &p) { assert(!p.isFalse()); return; }
+    void traits::postcondition (const prop &p) { assert(!p.isFalse()); return; }
+    void traits::invariant (const prop &p) { assert(!p.isFalse()); return; }
+
+
+
+    /*** Rounding modes ***/
+
+    roundingMode::roundingMode (const unsigned int mode) {
+      PRECONDITION(mode < numberOfModes);
+      for (unsigned int i = 0; i < numberOfModes; ++i) {
+	modes[i] = (i == mode) ? trueLiteral : falseLiteral;
+      }
+    }
+
+    roundingMode::roundingMode (const roundingMode &old) {
+      std::copy(old.modes, old.modes + numberOfModes, modes);
+    }
+
+    roundingMode & roundingMode::operator = (const roundingMode &op) {
+      std::copy(op.modes, op.modes + numberOfModes, modes);
+      return *this;
+    }
+
+    roundingMode roundingMode::input (const std::string &name) {
+      bitVector<false> encoding(bitVector<false>::input(3, name));
+
+      roundingMode result(0);
+      literal other = falseLiteral;
+      for (unsigned int i = 1; i < numberOfModes; ++i) {
+	result.modes[i] = (encoding == bitVector<false>(3, i)).getLiteral();
+	other = currentCircuit().orGate(other, result.modes[i]);
+      }
+      result.modes[0] = negate(other);
+
+      return result;
+    }
+
+    proposition roundingMode::valid (void) const {
+      circuit &g = currentCircuit();
+
+      literal some = falseLiteral;
+      literal two = falseLiteral;
+      for (unsigned int i = 0; i < numberOfModes; ++i) {
+	two = g.orGate(two, g.andGate(some, modes[i]));
+	some = g.orGate(some, modes[i]);
+      }
+
+      return proposition::fromLiteral(g.andGate(some, negate(two)));
+    }
+
+    proposition roundingMode::operator == (const roundingMode &op) const {
+      circuit &g = currentCircuit();
+
+      literal result = falseLiteral;
+      for (unsigned int i = 0; i < numberOfModes; ++i) {
+	result = g.orGate(result, g.andGate(modes[i], op.modes[i]));
+      }
+
+      return proposition::fromLiteral(result);
+    }
+
+
+
+    /*** Bit-vector circuits ***/
+
+    namespace operations {
+
+      bits constant (const bitWidthType w, const uint64_t v, const bool isSigned) {
+	bits b(w);
+	for (bitWidthType i = 0; i < w; ++i) {
+	  bitWidthType j = (i < 64) ? i : 63;
+	  bool bit = (i < 64 || isSigned) && ((v >> j) & 0x1);
+	  b[i] = bit ? trueLiteral : falseLiteral;
+	}
+	return b;
+      }
+
+      bits mux (const literal c, const bits &l, const bits &r) {
+	assert(l.size() == r.size());
+	circuit &g = currentCircuit();
+
+	if (c == trueLiteral) return l;
+	if (c == falseLiteral) return r;
+
+	bits result(l.size());
+	for (size_t i = 0; i < l.size(); ++i) {
+	  result[i] = g.iteGate(c, l[i], r[i]);
+	}
+	return result;
+      }
+
+      bits bitwiseAnd (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+	circuit &g = currentCircuit();
+
+	bits result(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result[i] = g.andGate(a[i], b[i]);
+	}
+	return result;
+      }
+
+      bits bitwiseOr (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+	circuit &g = currentCircuit();
+
+	bits result(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result[i] = g.orGate(a[i], b[i]);
+	}
+	return result;
+      }
+
+      bits bitwiseNot (const bits &a) {
+	bits result(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result[i] = cnf::negate(a[i]);
+	}
+	return result;
+      }
+
+      // Ripple carry of full adders
+      bits add (const bits &a, const bits &b, const literal carryIn) {
+	assert(a.size() == b.size());
+	circuit &g = currentCircuit();
+
+	bits result(a.size());
+	literal carry = carryIn;
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result[i] = g.xor3Gate(a[i], b[i], carry);
+	  carry = g.majorityGate(a[i], b[i], carry);
+	}
+	return result;
+      }
+
+      bits negate (const bits &a) {
+	return add(bitwiseNot(a), constant(a.size(), 0, false), trueLiteral);
+      }
+
+      // Shift and add, only the low bits are needed
+      bits multiply (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+	circuit &g = currentCircuit();
+	size_t w = a.size();
+
+	bits result(constant(w, 0, false));
+	for (size_t i = 0; i < w; ++i) {
+	  if (b[i] == falseLiteral) continue;
+
+	  bits partial(w, falseLiteral);
+	  for (size_t j = i; j < w; ++j) {
+	    partial[j] = g.andGate(a[j - i], b[i]);
+	  }
+	  result = add(result, partial, falseLiteral);
+	}
+	return result;
+      }
+
+      // Restoring division.  Division by zero gives all ones and a
+      // remainder of the dividend, as in SMT-LIB.
+      static void unsignedDivide (const bits &a, const bits &b, bits &quotient, bits &remainder) {
+	assert(a.size() == b.size());
+	size_t w = a.size();
+
+	bits divisor(b);
+	divisor.push_back(falseLiteral);
+
+	bits partial(constant(w + 1, 0, false));
+	quotient.resize(w);
+
+	for (size_t i = w; i > 0; --i) {
+	  partial.pop_back();
+	  partial.insert(partial.begin(), a[i - 1]);
+
+	  literal fits = cnf::negate(lessThan(partial, divisor, false, false));
+	  partial = mux(fits, add(partial, bitwiseNot(divisor), trueLiteral), partial);
+	  quotient[i - 1] = fits;
+	}
+
+	partial.pop_back();
+	remainder = partial;
+	return;
+      }
+
+      // Signed division rounds towards zero and the remainder has the
+      // sign of the dividend
+      void divide (const bits &a, const bits &b, const bool isSigned, bits &quotient, bits &remainder) {
+	if (!isSigned) {
+	  unsignedDivide(a, b, quotient, remainder);
+	  return;
+	}
+
+	literal aNegative = a.back();
+	literal bNegative = b.back();
+
+	bits q, r;
+	unsignedDivide(mux(aNegative, negate(a), a),
+		       mux(bNegative, negate(b), b),
+		       q, r);
+
+	quotient = mux(currentCircuit().xorGate(aNegative, bNegative), negate(q), q);
+	remainder = mux(aNegative, negate(r), r);
+	return;
+      }
+
+      // Barrel shifter, amounts of the width or more shift everything out
+      static bits shift (const bits &a, const bits &amount, const bool left, const literal fill) {
+	assert(a.size() == amount.size());
+	circuit &g = currentCircuit();
+	size_t w = a.size();
+
+	bits result(a);
+	literal tooFar = falseLiteral;
+
+	for (size_t j = 0; j < amount.size(); ++j) {
+	  if (j >= 32 || (1ULL << j) >= w) {
+	    tooFar = g.orGate(tooFar, amount[j]);
+	    continue;
+	  }
+
+	  size_t distance = 1ULL << j;
+	  bits shifted(w);
+	  for (size_t i = 0; i < w; ++i) {
+	    if (left) {
+	      shifted[i] = (i >= distance) ? result[i - distance] : falseLiteral;
+	    } else {
+	      shifted[i] = (i + distance < w) ? result[i + distance] : fill;
+	    }
+	  }
+	  result = mux(amount[j], shifted, result);
+	}
+
+	return mux(tooFar, bits(w, left ? falseLiteral : fill), result);
+      }
+
+      bits leftShift (const bits &a, const bits &amount) {
+	return shift(a, amount, true, falseLiteral);
+      }
+
+      bits rightShift (const bits &a, const bits &amount, const bool arithmetic) {
+	return shift(a, amount, false, arithmetic ? a.back() : falseLiteral);
+      }
+
+      literal equal (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+	circuit &g = currentCircuit();
+
+	literal result = trueLiteral;
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result = g.andGate(result, g.equalGate(a[i], b[i]));
+	}
+	return result;
+      }
+
+      // From the least significant bit up, signed comparison is
+      // unsigned comparison with the top bits inverted
+      literal lessThan (const bits &a, const bits &b, const bool isSigned, const bool orEqual) {
+	assert(a.size() == b.size());
+	circuit &g = currentCircuit();
+	size_t w = a.size();
+
+	literal result = orEqual ? trueLiteral : falseLiteral;
+	for (size_t i = 0; i < w; ++i) {
+	  bool flip = isSigned && (i == w - 1);
+	  literal ai = flip ? cnf::negate(a[i]) : a[i];
+	  literal bi = flip ? cnf::negate(b[i]) : b[i];
+
+	  result = g.orGate(g.andGate(cnf::negate(ai), bi),
+			    g.andGate(g.equalGate(ai, bi), result));
+	}
+	return result;
+      }
+
+      literal allOnes (const bits &a) {
+	circuit &g = currentCircuit();
+
+	literal result = trueLiteral;
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result = g.andGate(result, a[i]);
+	}
+	return result;
+      }
+
+      literal allZeros (const bits &a) {
+	return allOnes(bitwiseNot(a));
+      }
+
+    }
+
+  }
+}
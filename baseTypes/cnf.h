@@ -0,0 +1,614 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** cnf.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** A bit-level back-end that gives CNF for a SAT solver directly,
+** without an external library.  Gates (and, xor, multiplexers and the
+** sum and carry of full adders) are hash-consed and constants are
+** propagated as they are made.  Clauses are only generated when the
+** DIMACS file is written, so that the polarity each gate is used in
+** is known and only the clauses for those polarities are needed
+** (Plaisted-Greenbaum).  Full adders and multiplexers have their own
+** clauses rather than being broken into and gates.
+**
+** Operations add to the circuit given by the innermost cnf::scope.
+**
+*/
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Symfpu headers
+#include "symfpu/utils/properties.h"
+#include "symfpu/core/ite.h"
+#include "symfpu/baseTypes/shared.h"
+
+#ifndef SYMFPU_CNF
+#define SYMFPU_CNF
+
+namespace symfpu {
+  namespace cnf {
+
+    typedef symfpu::shared::bitWidthType bitWidthType;
+    typedef symfpu::shared::floatingPointTypeInfo floatingPointTypeInfo;
+
+    // 2 * gate index + 1 if negated.  Gate 0 is the constant false.
+    typedef uint32_t literal;
+
+    const literal falseLiteral = 0;
+    const literal trueLiteral = 1;
+
+    inline literal negate (const literal l) { return l ^ 0x1; }
+    inline uint32_t gateIndex (const literal l) { return l >> 1; }
+    inline bool isNegated (const literal l) { return (l & 0x1) != 0; }
+    inline bool isConstant (const literal l) { return gateIndex(l) == 0; }
+
+
+    class circuit {
+    protected :
+      enum gateType { INPUT, AND, XOR, XOR3, MAJORITY, ITE };
+
+      // Fanins that are not used are 0
+      struct gate {
+	gateType type;
+	literal fanin[3];
+
+	bool operator == (const gate &g) const {
+	  return type == g.type && fanin[0] == g.fanin[0] &&
+	    fanin[1] == g.fanin[1] && fanin[2] == g.fanin[2];
+	}
+      };
+
+      struct hasher {
+	size_t operator() (const gate &g) const {
+	  uint64_t h = (((uint64_t)g.fanin[0]) << 32 | g.fanin[1]) * 0x9e3779b97f4a7c15ULL;
+	  h ^= ((((uint64_t)g.fanin[2]) << 8) | g.type) * 0xbf58476d1ce4e5b9ULL;
+	  return (size_t)(h ^ (h >> 31));
+	}
+      };
+
+      std::vector<gate> gates;
+      std::vector<uint32_t> inputGates;         // In order of creation
+      std::vector<std::string> inputNames;
+      std::unordered_map<gate, uint32_t, hasher> structuralHash;
+
+      literal makeGate (const gateType type, const literal a, const literal b, const literal c);
+
+      // Calls emit on every clause needed.  Returns the number of
+      // variables and maps gates to them.
+      template <class emitter>
+      uint32_t generate (const std::vector<literal> &assertions,
+			 const std::vector<literal> &outputs,
+			 const bool polarityAware,
+			 std::vector<uint32_t> &variable,
+			 emitter &emit) const;
+
+    public :
+      circuit ();
+
+      literal input (const std::string &name = std::string());
+
+      literal andGate (const literal a, const literal b);
+      literal orGate (const literal a, const literal b) { return negate(andGate(negate(a), negate(b))); }
+      literal xorGate (const literal a, const literal b);
+      literal equalGate (const literal a, const literal b) { return negate(xorGate(a, b)); }
+      literal iteGate (const literal c, const literal t, const literal e);
+      literal xor3Gate (const literal a, const literal b, const literal c);
+      literal majorityGate (const literal a, const literal b, const literal c);
+
+      size_t numberOfInputs (void) const { return inputGates.size(); }
+      size_t numberOfGates (void) const { return gates.size() - inputGates.size() - 1; }
+
+      struct statistics {
+	uint32_t variables;
+	uint64_t clauses;
+	uint64_t literals;
+      };
+
+      // The size of the CNF that writeDIMACS would give
+      statistics size (const std::vector<literal> &assertions,
+		       const std::vector<literal> &outputs,
+		       const bool polarityAware = true) const;
+
+      // The assertions are given as unit clauses.  The outputs are not
+      // constrained but are encoded in both polarities so they can be
+      // used by clauses added later; their variables are given in
+      // comments, as are those of the inputs, which are always
+      // included.  Clauses are written as they are generated.
+      void writeDIMACS (std::ostream &out,
+			const std::vector<literal> &assertions,
+			const std::vector<literal> &outputs,
+			const bool polarityAware = true) const;
+    };
+
+
+    // The circuit that operations add to
+    circuit & currentCircuit (void);
+
+    class scope {
+    protected :
+      circuit *previous;
+
+    public :
+      scope (circuit &c);
+      ~scope ();
+    };
+
+
+
+    // Forward declarations
+    class roundingMode;
+    class proposition;
+    template <bool isSigned> class bitVector;
+
+    // Wrap up the types into one template parameter
+    class traits {
+    public :
+      typedef bitWidthType bwt;
+      typedef roundingMode rm;
+      typedef floatingPointTypeInfo fpt;
+      typedef proposition prop;
+      typedef bitVector< true> sbv;
+      typedef bitVector<false> ubv;
+
+      static roundingMode RNE (void);
+      static roundingMode RNA (void);
+      static roundingMode RTP (void);
+      static roundingMode RTN (void);
+      static roundingMode RTZ (void);
+      static roundingMode RTO (void);
+
+      // Literal invariants
+      inline static void precondition (const bool b) { assert(b); return; }
+      inline static void postcondition (const bool b) { assert(b); return; }
+      inline static void invariant (const bool b) { assert(b); return; }
+
+      // Symbolic invariants, only those that are known to fail are caught
+      static void precondition (const prop &p);
+      static void postcondition (const prop &p);
+      static void invariant (const prop &p);
+    };
+
+    // To simplify the property macros
+    typedef traits t;
+
+
+
+    class proposition {
+    protected :
+      literal lit;
+
+      friend ite<proposition, proposition>;   // For ITE
+
+    public :
+      proposition (bool v) : lit(v ? trueLiteral : falseLiteral) {}
+      proposition (const proposition &old) : lit(old.lit) {}
+
+      static proposition fromLiteral (const literal l) {
+	proposition p(false);
+	p.lit = l;
+	return p;
+      }
+      static proposition input (const std::string &name = std::string()) {
+	return fromLiteral(currentCircuit().input(name));
+      }
+
+      literal getLiteral (void) const { return lit; }
+      bool isTrue (void) const { return lit == trueLiteral; }
+      bool isFalse (void) const { return lit == falseLiteral; }
+
+      proposition & operator = (const proposition &op) {
+	this->lit = op.lit;
+	return *this;
+      }
+
+      proposition operator ! (void) const {
+	return fromLiteral(negate(lit));
+      }
+
+      proposition operator && (const proposition &op) const {
+	return fromLiteral(currentCircuit().andGate(lit, op.lit));
+      }
+
+      proposition operator || (const proposition &op) const {
+	return fromLiteral(currentCircuit().orGate(lit, op.lit));
+      }
+
+      proposition operator == (const proposition &op) const {
+	return fromLiteral(currentCircuit().equalGate(lit, op.lit));
+      }
+
+      proposition operator ^ (const proposition &op) const {
+	return fromLiteral(currentCircuit().xorGate(lit, op.lit));
+      }
+    };
+
+
+
+    // One literal per rounding mode, exactly one of which is true
+    class roundingMode {
+    public :
+      static const unsigned int numberOfModes = 6;   // RNE, RNA, RTP, RTN, RTZ, RTO
+
+    protected :
+      literal modes[numberOfModes];
+
+      friend ite<proposition, roundingMode>;   // For ITE
+
+    public :
+      roundingMode (const unsigned int mode);
+      roundingMode (const roundingMode &old);
+
+      roundingMode & operator = (const roundingMode &op);
+
+      // Decodes three new inputs, values above RTO are RNE
+      static roundingMode input (const std::string &name = std::string());
+
+      proposition valid (void) const;
+      proposition operator == (const roundingMode &op) const;
+
+      literal getLiteral (const unsigned int mode) const {
+	PRECONDITION(mode < numberOfModes);
+	return modes[mode];
+      }
+    };
+
+
+
+    // Operations on the bits of a vector, least significant first
+    typedef std::vector<literal> bits;
+
+    namespace operations {
+      bits constant (const bitWidthType w, const uint64_t v, const bool isSigned);
+      bits mux (const literal c, const bits &l, const bits &r);
+      bits bitwiseAnd (const bits &a, const bits &b);
+      bits bitwiseOr (const bits &a, const bits &b);
+      bits bitwiseNot (const bits &a);
+      bits add (const bits &a, const bits &b, const literal carryIn);
+      bits negate (const bits &a);
+      bits multiply (const bits &a, const bits &b);
+      void divide (const bits &a, const bits &b, const bool isSigned, bits &quotient, bits &remainder);
+      bits leftShift (const bits &a, const bits &amount);
+      bits rightShift (const bits &a, const bits &amount, const bool arithmetic);
+      literal equal (const bits &a, const bits &b);
+      literal lessThan (const bits &a, const bits &b, const bool isSigned, const bool orEqual);
+      literal allOnes (const bits &a);
+      literal allZeros (const bits &a);
+    }
+
+
+    template <bool isSigned>
+    class bitVector {
+    protected :
+      bits contents;
+
+      friend bitVector<!isSigned>;    // To allow conversion between the types
+      friend ite<proposition, bitVector<isSigned> >;   // For ITE
+
+      bitVector (const bits &b) : contents(b) {}
+
+    public :
+      bitVector (const bitWidthType w, const uint64_t v) : contents(operations::constant(w, v, isSigned)) {
+	PRECONDITION(w > 0);
+      }
+      bitVector (const proposition &p) : contents(1, p.getLiteral()) {}
+      bitVector (const bitVector<isSigned> &old) : contents(old.contents) {}
+
+      static bitVector<isSigned> input (const bitWidthType w, const std::string &name = std::string()) {
+	bits b(w);
+	for (bitWidthType i = 0; i < w; ++i) {
+	  b[i] = currentCircuit().input(name.empty() ? name : name + "[" + std::to_string(i) + "]");
+	}
+	return bitVector<isSigned>(b);
+      }
+
+      bitWidthType getWidth (void) const {
+	return contents.size();
+      }
+
+      const bits & getBits (void) const { return contents; }
+
+      bool isConstant (void) const {
+	for (bitWidthType i = 0; i < contents.size(); ++i) {
+	  if (!cnf::isConstant(contents[i])) return false;
+	}
+	return true;
+      }
+
+      // Only meaningful for constants, the low 64 bits
+      uint64_t constantValue (void) const {
+	PRECONDITION(this->isConstant());
+	uint64_t v = 0;
+	for (bitWidthType i = 0; i < contents.size() && i < 64; ++i) {
+	  v |= ((uint64_t)(contents[i] == trueLiteral)) << i;
+	}
+	return v;
+      }
+
+      bitVector<isSigned> & operator = (const bitVector<isSigned> &op) {
+	this->contents = op.contents;
+	return *this;
+      }
+
+
+      /*** Constant creation and test ***/
+
+      static bitVector<isSigned> one (const bitWidthType &w) { return bitVector<isSigned>(w,1); }
+      static bitVector<isSigned> zero (const bitWidthType &w)  { return bitVector<isSigned>(w,0); }
+      static bitVector<isSigned> allOnes (const bitWidthType &w) { return ~zero(w); }
+
+      inline proposition isAllOnes() const { return proposition::fromLiteral(operations::allOnes(contents)); }
+      inline proposition isAllZeros() const { return proposition::fromLiteral(operations::allZeros(contents)); }
+
+      static bitVector<isSigned> maxValue (const bitWidthType &w) {
+	if (isSigned) {
+	  return zero(1).append(allOnes(w-1));
+	} else {
+	  return allOnes(w);
+	}
+      }
+
+      static bitVector<isSigned> minValue (const bitWidthType &w) {
+	if (isSigned) {
+	  return one(1).append(zero(w-1));
+	} else {
+	  return zero(w);
+	}
+      }
+
+
+      /*** Operators ***/
+      inline bitVector<isSigned> operator << (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::leftShift(contents, op.contents));
+      }
+
+      inline bitVector<isSigned> operator >> (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::rightShift(contents, op.contents, isSigned));
+      }
+
+      inline bitVector<isSigned> operator | (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::bitwiseOr(contents, op.contents));
+      }
+
+      inline bitVector<isSigned> operator & (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::bitwiseAnd(contents, op.contents));
+      }
+
+      inline bitVector<isSigned> operator + (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::add(contents, op.contents, falseLiteral));
+      }
+
+      inline bitVector<isSigned> operator - (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::add(contents, operations::bitwiseNot(op.contents), trueLiteral));
+      }
+
+      inline bitVector<isSigned> operator * (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::multiply(contents, op.contents));
+      }
+
+      inline bitVector<isSigned> operator / (const bitVector<isSigned> &op) const {
+	bits quotient, remainder;
+	operations::divide(contents, op.contents, isSigned, quotient, remainder);
+	return bitVector<isSigned>(quotient);
+      }
+
+      inline bitVector<isSigned> operator % (const bitVector<isSigned> &op) const {
+	bits quotient, remainder;
+	operations::divide(contents, op.contents, isSigned, quotient, remainder);
+	return bitVector<isSigned>(remainder);
+      }
+
+      inline bitVector<isSigned> operator - (void) const {
+	return bitVector<isSigned>(operations::negate(contents));
+      }
+
+      inline bitVector<isSigned> operator ~ (void) const {
+	return bitVector<isSigned>(operations::bitwiseNot(contents));
+      }
+
+      inline bitVector<isSigned> increment () const {
+	return bitVector<isSigned>(operations::add(contents, operations::constant(getWidth(), 0, false), trueLiteral));
+      }
+
+      inline bitVector<isSigned> decrement () const {
+	return *this - bitVector<isSigned>::one(getWidth());
+      }
+
+      inline bitVector<isSigned> signExtendRightShift (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::rightShift(contents, op.contents, true));
+      }
+
+
+      /*** Modular opertaions ***/
+      // No overflow checking so these are the same as other operations
+      inline bitVector<isSigned> modularLeftShift (const bitVector<isSigned> &op) const {
+	return *this << op;
+      }
+
+      inline bitVector<isSigned> modularRightShift (const bitVector<isSigned> &op) const {
+	return *this >> op;
+      }
+
+      inline bitVector<isSigned> modularIncrement () const {
+	return this->increment();
+      }
+
+      inline bitVector<isSigned> modularDecrement () const {
+	return this->decrement();
+      }
+
+      inline bitVector<isSigned> modularAdd (const bitVector<isSigned> &op) const {
+	return *this + op;
+      }
+
+      inline bitVector<isSigned> modularNegate () const {
+	return -(*this);
+      }
+
+
+      /*** Comparisons ***/
+
+      inline proposition operator == (const bitVector<isSigned> &op) const {
+	return proposition::fromLiteral(operations::equal(contents, op.contents));
+      }
+
+      inline proposition operator <= (const bitVector<isSigned> &op) const {
+	return proposition::fromLiteral(operations::lessThan(contents, op.contents, isSigned, true));
+      }
+
+      inline proposition operator >= (const bitVector<isSigned> &op) const {
+	return op <= *this;
+      }
+
+      inline proposition operator < (const bitVector<isSigned> &op) const {
+	return proposition::fromLiteral(operations::lessThan(contents, op.contents, isSigned, false));
+      }
+
+      inline proposition operator > (const bitVector<isSigned> &op) const {
+	return op < *this;
+      }
+
+
+      /*** Type conversion ***/
+      // The bits are the same, only the interpretation changes
+      bitVector<true> toSigned (void) const {
+	return bitVector<true>(contents);
+      }
+      bitVector<false> toUnsigned (void) const {
+	return bitVector<false>(contents);
+      }
+
+
+      /*** Bit hacks ***/
+
+      inline bitVector<isSigned> extend (bitWidthType extension) const {
+	bits b(contents);
+	b.resize(contents.size() + extension, isSigned ? contents.back() : falseLiteral);
+	return bitVector<isSigned>(b);
+      }
+
+      inline bitVector<isSigned> contract (bitWidthType reduction) const {
+	PRECONDITION(this->getWidth() > reduction);
+	bits b(contents);
+	b.resize(contents.size() - reduction);
+	return bitVector<isSigned>(b);
+      }
+
+      inline bitVector<isSigned> resize (bitWidthType newSize) const {
+	bitWidthType width = this->getWidth();
+
+	if (newSize > width) {
+	  return this->extend(newSize - width);
+	} else if (newSize < width) {
+	  return this->contract(width - newSize);
+	} else {
+	  return *this;
+	}
+      }
+
+      inline bitVector<isSigned> matchWidth (const bitVector<isSigned> &op) const {
+	PRECONDITION(this->getWidth() <= op.getWidth());
+	return this->extend(op.getWidth() - this->getWidth());
+      }
+
+      // this is the high part of the result
+      bitVector<isSigned> append (const bitVector<isSigned> &op) const {
+	bits b(op.contents);
+	b.insert(b.end(), contents.begin(), contents.end());
+	return bitVector<isSigned>(b);
+      }
+
+      // Inclusive of end points, thus if the same, extracts just one bit
+      bitVector<isSigned> extract (bitWidthType upper, bitWidthType lower) const {
+	PRECONDITION(upper >= lower);
+	PRECONDITION(upper < this->getWidth());
+	return bitVector<isSigned>(bits(contents.begin() + lower, contents.begin() + upper + 1));
+      }
+    };
+
+
+    // The identity of a value in the current circuit, for memoisation
+    inline void appendTermIdentity (std::vector<uint64_t> &key, const proposition &p) {
+      key.push_back(p.getLiteral());
+    }
+
+    inline void appendTermIdentity (std::vector<uint64_t> &key, const roundingMode &m) {
+      for (unsigned int i = 0; i < roundingMode::numberOfModes; ++i) {
+	key.push_back(m.getLiteral(i));
+      }
+    }
+
+    template <bool isSigned>
+    inline void appendTermIdentity (std::vector<uint64_t> &key, const bitVector<isSigned> &b) {
+      key.push_back(b.getWidth());
+      key.insert(key.end(), b.getBits().begin(), b.getBits().end());
+    }
+
+  }
+
+
+  template <>
+  struct ite<cnf::proposition, cnf::proposition> {
+    static const cnf::proposition iteOp (const cnf::proposition &cond,
+					 const cnf::proposition &l,
+					 const cnf::proposition &r) {
+      return cnf::proposition::fromLiteral(cnf::currentCircuit().iteGate(cond.lit, l.lit, r.lit));
+    }
+  };
+
+  template <>
+  struct ite<cnf::proposition, cnf::roundingMode> {
+    static const cnf::roundingMode iteOp (const cnf::proposition &cond,
+					  const cnf::roundingMode &l,
+					  const cnf::roundingMode &r) {
+      cnf::roundingMode result(l);
+      for (unsigned int i = 0; i < cnf::roundingMode::numberOfModes; ++i) {
+	result.modes[i] = cnf::currentCircuit().iteGate(cond.getLiteral(), l.modes[i], r.modes[i]);
+      }
+      return result;
+    }
+  };
+
+#define CNFITEDFN(T) template <>					\
+    struct ite<cnf::proposition, T> {					\
+    static const T iteOp (const cnf::proposition &cond,		\
+			  const T &l,					\
+			  const T &r) {					\
+      assert(l.getWidth() == r.getWidth());				\
+      return T(cnf::operations::mux(cond.getLiteral(), l.contents, r.contents)); \
+    }									\
+  };
+
+  CNFITEDFN(cnf::traits::sbv);
+  CNFITEDFN(cnf::traits::ubv);
+
+#undef CNFITEDFN
+
+}
+
+#endif
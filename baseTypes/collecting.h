@@ -0,0 +1,216 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** collecting.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** Traits that are the same as another set of traits except that the
+** symbolic preconditions, postconditions and invariants are collected.
+** Postconditions and invariants hold for every input, preconditions
+** hold as long as the inputs are made by symfpu (i.e. by unpack), so
+** the caller can give them to the solver as redundant constraints,
+** which can make solving faster.  Which are collected can be chosen by
+** kind and by the file and line they are in.
+**
+** Properties are collected in the collector given by the innermost
+** collecting::scope; without one they are only passed on.
+**
+*/
+
+#include <stdint.h>
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Symfpu headers
+#include "symfpu/utils/properties.h"
+
+#ifndef SYMFPU_COLLECTING
+#define SYMFPU_COLLECTING
+
+namespace symfpu {
+  namespace collecting {
+
+    enum propertyKind {
+      PRECONDITION_PROPERTY,
+      POSTCONDITION_PROPERTY,
+      INVARIANT_PROPERTY,
+      numberOfPropertyKinds
+    };
+
+    inline const char * propertyKindName (const propertyKind k) {
+      static const char * names[] = { "precondition", "postcondition", "invariant" };
+      return names[k];
+    }
+
+
+    template <class inner>
+    class collector {
+    public :
+      typedef typename inner::prop prop;
+
+      struct lemma {
+	prop condition;
+	propertyKind kind;
+	properties::callSite site;
+
+	lemma (const prop &p, const propertyKind k, const properties::callSite &s) :
+	  condition(p), kind(k), site(s) {}
+      };
+
+    protected :
+      std::vector<lemma> lemmas;
+      bool kindEnabled[numberOfPropertyKinds];
+
+      // A line of 0 is all of the file.  File names are matched on
+      // their end, so "multiply.h" is enough.
+      typedef std::pair<std::string, unsigned int> siteKey;
+      std::map<siteKey, bool> siteEnabled;
+
+      static bool endsWith (const std::string &s, const std::string &suffix) {
+	return s.size() >= suffix.size() &&
+	  s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+      }
+
+    public :
+      collector () {
+	for (unsigned int i = 0; i < numberOfPropertyKinds; ++i) {
+	  kindEnabled[i] = true;
+	}
+      }
+
+      void enable (const propertyKind k) { kindEnabled[k] = true; }
+      void disable (const propertyKind k) { kindEnabled[k] = false; }
+
+      void enable (const std::string &file, const unsigned int line = 0) { siteEnabled[siteKey(file, line)] = true; }
+      void disable (const std::string &file, const unsigned int line = 0) { siteEnabled[siteKey(file, line)] = false; }
+
+      // A line setting is used before a file one, which is used before
+      // the setting for the kind
+      bool isEnabled (const propertyKind k, const properties::callSite &s) const {
+	if (!kindEnabled[k]) return false;
+
+	std::string file(s.file);
+	bool found = false;
+	bool result = true;
+	for (typename std::map<siteKey, bool>::const_iterator it = siteEnabled.begin(); it != siteEnabled.end(); ++it) {
+	  if (endsWith(file, it->first.first)) {
+	    if (it->first.second == s.line) {
+	      return it->second;
+	    } else if (it->first.second == 0 && !found) {
+	      found = true;
+	      result = it->second;
+	    }
+	  }
+	}
+	return result;
+      }
+
+      void record (const prop &p, const propertyKind k, const properties::callSite &s) {
+	if (this->isEnabled(k, s)) {
+	  lemmas.push_back(lemma(p, k, s));
+	}
+	return;
+      }
+
+      const std::vector<lemma> & getLemmas (void) const { return lemmas; }
+      size_t size (void) const { return lemmas.size(); }
+      void clear (void) { lemmas.clear(); }
+
+      // One tab separated line per call site : kind  file  line  count
+      void writeSummary (std::ostream &out) const {
+	typedef std::pair<std::pair<propertyKind, std::string>, unsigned int> summaryKey;
+	std::map<summaryKey, size_t> count;
+	for (typename std::vector<lemma>::const_iterator it = lemmas.begin(); it != lemmas.end(); ++it) {
+	  ++count[summaryKey(std::make_pair(it->kind, std::string(it->site.file)), it->site.line)];
+	}
+
+	for (typename std::map<summaryKey, size_t>::const_iterator it = count.begin(); it != count.end(); ++it) {
+	  out << propertyKindName(it->first.first.first) << '\t' << it->first.first.second << '\t'
+	      << it->first.second << '\t' << it->second << '\n';
+	}
+	return;
+      }
+    };
+
+
+    // The collector that properties are added to, if any
+    template <class inner>
+    collector<inner> *& currentCollector (void) {
+      static thread_local collector<inner> *current = NULL;
+      return current;
+    }
+
+    template <class inner>
+    class scope {
+    protected :
+      collector<inner> *previous;
+
+    public :
+      scope (collector<inner> &c) : previous(currentCollector<inner>()) {
+	currentCollector<inner>() = &c;
+      }
+      ~scope () {
+	currentCollector<inner>() = previous;
+      }
+    };
+
+
+    // Everything else, including the types, is from inner
+    template <class inner>
+    class traits : public inner {
+    protected :
+      static void collect (const typename inner::prop &p, const propertyKind k, const properties::callSite &s) {
+	collector<inner> *c = currentCollector<inner>();
+	if (c != NULL) {
+	  c->record(p, k, s);
+	}
+	return;
+      }
+
+    public :
+      typedef typename inner::prop prop;
+
+      using inner::precondition;
+      using inner::postcondition;
+      using inner::invariant;
+
+      static void precondition (const prop &p, const properties::callSite &s) {
+	inner::precondition(p);
+	collect(p, PRECONDITION_PROPERTY, s);
+      }
+      static void postcondition (const prop &p, const properties::callSite &s) {
+	inner::postcondition(p);
+	collect(p, POSTCONDITION_PROPERTY, s);
+      }
+      static void invariant (const prop &p, const properties::callSite &s) {
+	inner::invariant(p);
+	collect(p, INVARIANT_PROPERTY, s);
+      }
+    };
+
+  }
+}
+
+#endif
@@ -0,0 +1,243 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** cost.cpp
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** The ledger and the cost model for the counting back-end.
+**
+*/
+
+#include "symfpu/baseTypes/cost.h"
+
+namespace symfpu {
+  namespace cost {
+
+    const char * kindName (const kind k) {
+      switch (k) {
+      case LOGIC : return "logic";
+      case ADDER : return "adder";
+      case MULTIPLIER : return "multiplier";
+      case DIVIDER : return "divider";
+      case SHIFTER : return "shifter";
+      case COMPARATOR : return "comparator";
+      case EQUALITY : return "equality";
+      case ITE : return "ite";
+      case EXTRACT : return "extract";
+      case CONCAT : return "concat";
+      case EXTEND : return "extend";
+      default : assert(0); return "unknown";
+      }
+    }
+
+
+
+    /*** Ledger ***/
+
+    void ledger::record (const kind k, const bitWidthType w, const uint64_t gates, const uint64_t clauses) {
+      tally &entry = entries[key(k, w)];
+      ++entry.count;
+      entry.gates += gates;
+      entry.clauses += clauses;
+      return;
+    }
+
+    tally ledger::total (void) const {
+      tally result;
+      for (std::map<key, tally>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+	result += it->second;
+      }
+      return result;
+    }
+
+    tally ledger::total (const kind k) const {
+      tally result;
+      for (std::map<key, tally>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+	if (it->first.first == k) {
+	  result += it->second;
+	}
+      }
+      return result;
+    }
+
+    void ledger::writeReportHeader (std::ostream &out) {
+      out << "label\tkind\twidth\tcount\tgates\tclauses\n";
+      return;
+    }
+
+    void ledger::writeReport (std::ostream &out, const std::string &label) const {
+      for (std::map<key, tally>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+	out << label << '\t' << kindName(it->first.first) << '\t' << it->first.second << '\t'
+	    << it->second.count << '\t' << it->second.gates << '\t' << it->second.clauses << '\n';
+      }
+
+      tally t(this->total());
+      out << label << "\ttotal\t0\t" << t.count << '\t' << t.gates << '\t' << t.clauses << '\n';
+      return;
+    }
+
+
+    static thread_local ledger *current = NULL;
+
+    ledger & currentLedger (void) {
+      assert(current != NULL);
+      return *current;
+    }
+
+    scope::scope (ledger &l) : previous(current) {
+      current = &l;
+    }
+
+    scope::~scope () {
+      current = previous;
+    }
+
+
+
+    /*** Cost model ***/
+
+    // And gates in an and-inverter graph and clauses in a Tseitin
+    // encoding of the usual circuits
+    namespace estimate {
+
+      struct unit {
+	uint64_t gates;
+	uint64_t clauses;
+      };
+
+      static const unit andGate = { 1, 3 };
+      static const unit xorGate = { 3, 4 };
+      static const unit muxGate = { 3, 4 };
+      static const unit majorityGate = { 4, 6 };
+      static const unit halfAdder = { 4, 7 };
+      static const unit fullAdder = { 7, 14 };
+
+      static void record (const kind k, const bitWidthType w, const unit &u, const uint64_t n) {
+	currentLedger().record(k, w, u.gates * n, u.clauses * n);
+	return;
+      }
+
+      static void record (const kind k, const bitWidthType w,
+			  const unit &u, const uint64_t n,
+			  const unit &v, const uint64_t m) {
+	currentLedger().record(k, w, u.gates * n + v.gates * m, u.clauses * n + v.clauses * m);
+	return;
+      }
+
+      static uint64_t ceilingLog2 (const bitWidthType w) {
+	uint64_t l = 0;
+	while ((1ULL << l) < w) {
+	  ++l;
+	}
+	return l;
+      }
+
+
+      void logic (const bitWidthType w) {
+	record(LOGIC, w, andGate, w);
+      }
+
+      void exclusiveOr (const bitWidthType w) {
+	record(LOGIC, w, xorGate, w);
+      }
+
+      // With a constant operand the carry chain is half adders
+      void adder (const bitWidthType w, const bool constantOperand) {
+	record(ADDER, w, constantOperand ? halfAdder : fullAdder, w);
+      }
+
+      void incrementer (const bitWidthType w) {
+	record(ADDER, w, halfAdder, w);
+      }
+
+      // Only the partial products below the width are needed and
+      // multiplying by a constant needs, on average, half of the adds
+      void multiplier (const bitWidthType w, const bool constantOperand) {
+	uint64_t n = w;
+	if (constantOperand) {
+	  record(MULTIPLIER, w, fullAdder, n * (n - 1) / 4);
+	} else {
+	  record(MULTIPLIER, w, andGate, n * (n + 1) / 2, fullAdder, n * (n - 1) / 2);
+	}
+      }
+
+      // Restoring division, one subtract and select per quotient bit
+      void divider (const bitWidthType w, const bool) {
+	uint64_t n = w;
+	record(DIVIDER, w, fullAdder, n * (n + 1), muxGate, n * n);
+      }
+
+      // A barrel shifter, then masking for amounts of the width or more
+      void shifter (const bitWidthType w, const bool constantAmount) {
+	if (constantAmount) {
+	  wiring(SHIFTER, w);
+	} else {
+	  record(SHIFTER, w, muxGate, ceilingLog2(w) * w, andGate, w);
+	}
+      }
+
+      // The carry out of a subtraction, which is a chain of ands and
+      // ors when one side is constant
+      void comparator (const bitWidthType w, const bool constantOperand) {
+	record(COMPARATOR, w, constantOperand ? andGate : majorityGate, w);
+      }
+
+      void equality (const bitWidthType w, const bool constantOperand) {
+	if (constantOperand) {
+	  reduction(w);
+	} else {
+	  record(EQUALITY, w, xorGate, w, andGate, w - 1);
+	}
+      }
+
+      void reduction (const bitWidthType w) {
+	record(EQUALITY, w, andGate, w - 1);
+      }
+
+      // Selecting between constants only needs the condition and its
+      // negation, selecting with one constant is an and or an or
+      void multiplexer (const bitWidthType w, const unsigned int constantBranches) {
+	switch (constantBranches) {
+	case 0 : record(ITE, w, muxGate, w); break;
+	case 1 : record(ITE, w, andGate, w); break;
+	default : wiring(ITE, w); break;
+	}
+      }
+
+      void wiring (const kind k, const bitWidthType w) {
+	currentLedger().record(k, w, 0, 0);
+      }
+
+    }
+
+
+
+    /*** Traits ***/
+
+    roundingMode traits::RNE (void) { return roundingMode(true); }
+    roundingMode traits::RNA (void) { return roundingMode(true); }
+    roundingMode traits::RTP (void) { return roundingMode(true); }
+    roundingMode traits::RTN (void) { return roundingMode(true); }
+    roundingMode traits::RTZ (void) { return roundingMode(true); }
+    roundingMode traits::RTO (void) { return roundingMode(true); }
+
+  }
+}
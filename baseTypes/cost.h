@@ -0,0 +1,486 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** cost.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** A back-end that builds nothing.  Values only have a width and
+** whether they are constant; each operation is counted by kind and
+** width along with an estimate of the and gates and clauses a
+** bit-blasted encoding would need.  This gives the relative cost of
+** operations, or of different implementations of them, without
+** building or solving anything.
+**
+** Operations on constants are assumed to be folded and are not
+** counted.  Nor are negations, which are free in an and-inverter
+** graph, or shifts by a constant, which are only wiring.  As nothing
+** is built, nothing is shared; the estimates are an upper bound for a
+** hash-consed back-end and are best used to compare, not predict.
+**
+** Operations are counted in the ledger given by the innermost
+** cost::scope.
+**
+*/
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+
+// Symfpu headers
+#include "symfpu/utils/properties.h"
+#include "symfpu/core/ite.h"
+#include "symfpu/baseTypes/shared.h"
+
+#ifndef SYMFPU_COST
+#define SYMFPU_COST
+
+namespace symfpu {
+  namespace cost {
+
+    typedef symfpu::shared::bitWidthType bitWidthType;
+    typedef symfpu::shared::floatingPointTypeInfo floatingPointTypeInfo;
+
+    enum kind {
+      LOGIC,         // and, or, xor of propositions and vectors
+      ADDER,         // add, subtract, increment, decrement, negate
+      MULTIPLIER,
+      DIVIDER,       // division and remainder
+      SHIFTER,
+      COMPARATOR,    // ordering
+      EQUALITY,      // including all ones / all zeros tests
+      ITE,
+      EXTRACT,
+      CONCAT,
+      EXTEND,        // extend and contract
+      numberOfKinds
+    };
+
+    const char * kindName (const kind k);
+
+    struct tally {
+      uint64_t count;
+      uint64_t gates;
+      uint64_t clauses;
+
+      tally () : count(0), gates(0), clauses(0) {}
+
+      tally & operator += (const tally &op) {
+	count += op.count;
+	gates += op.gates;
+	clauses += op.clauses;
+	return *this;
+      }
+    };
+
+
+    class ledger {
+    protected :
+      typedef std::pair<kind, bitWidthType> key;
+      std::map<key, tally> entries;
+
+    public :
+      void record (const kind k, const bitWidthType w, const uint64_t gates, const uint64_t clauses);
+      void clear (void) { entries.clear(); }
+
+      tally total (void) const;
+      tally total (const kind k) const;
+
+      // One tab separated line per kind and width used, then the
+      // total, all starting with the label :
+      //   label  kind  width  count  gates  clauses
+      static void writeReportHeader (std::ostream &out);
+      void writeReport (std::ostream &out, const std::string &label) const;
+    };
+
+
+    // The ledger that operations are counted in
+    ledger & currentLedger (void);
+
+    class scope {
+    protected :
+      ledger *previous;
+
+    public :
+      scope (ledger &l);
+      ~scope ();
+    };
+
+
+    // The estimates for each operation.  An operand that is constant
+    // (but not all of them) often allows a smaller circuit.
+    namespace estimate {
+      void logic (const bitWidthType w);
+      void exclusiveOr (const bitWidthType w);
+      void adder (const bitWidthType w, const bool constantOperand);
+      void incrementer (const bitWidthType w);
+      void multiplier (const bitWidthType w, const bool constantOperand);
+      void divider (const bitWidthType w, const bool constantOperand);
+      void shifter (const bitWidthType w, const bool constantAmount);
+      void comparator (const bitWidthType w, const bool constantOperand);
+      void equality (const bitWidthType w, const bool constantOperand);
+      void reduction (const bitWidthType w);
+      void multiplexer (const bitWidthType w, const unsigned int constantBranches);
+      void wiring (const kind k, const bitWidthType w);
+    }
+
+
+
+    // Forward declarations
+    class roundingMode;
+    class proposition;
+    template <bool isSigned> class bitVector;
+
+    // Wrap up the types into one template parameter
+    class traits {
+    public :
+      typedef bitWidthType bwt;
+      typedef roundingMode rm;
+      typedef floatingPointTypeInfo fpt;
+      typedef proposition prop;
+      typedef bitVector< true> sbv;
+      typedef bitVector<false> ubv;
+
+      static roundingMode RNE (void);
+      static roundingMode RNA (void);
+      static roundingMode RTP (void);
+      static roundingMode RTN (void);
+      static roundingMode RTZ (void);
+      static roundingMode RTO (void);
+
+      // Literal invariants
+      inline static void precondition (const bool b) { assert(b); return; }
+      inline static void postcondition (const bool b) { assert(b); return; }
+      inline static void invariant (const bool b) { assert(b); return; }
+
+      // Symbolic invariants cost nothing and are not checked
+      inline static void precondition (const prop &) { return; }
+      inline static void postcondition (const prop &) { return; }
+      inline static void invariant (const prop &) { return; }
+    };
+
+    // To simplify the property macros
+    typedef traits t;
+
+
+
+    class proposition {
+    protected :
+      bool constant;
+
+      friend ite<proposition, proposition>;   // For ITE
+
+      static proposition variable (void) {
+	proposition p(false);
+	p.constant = false;
+	return p;
+      }
+
+      // With a constant operand these are a constant or the other
+      // operand, possibly negated
+      static proposition combine (const proposition &a, const proposition &b, void (*e)(const bitWidthType)) {
+	if (a.constant || b.constant) return result(a.constant && b.constant);
+	e(1);
+	return variable();
+      }
+
+    public :
+      proposition (bool) : constant(true) {}
+      proposition (const proposition &old) : constant(old.constant) {}
+
+      static proposition input (const std::string & = std::string()) { return variable(); }
+      static proposition result (const bool isConstant) { return isConstant ? proposition(false) : variable(); }
+
+      bool isConstant (void) const { return constant; }
+
+      proposition & operator = (const proposition &op) {
+	this->constant = op.constant;
+	return *this;
+      }
+
+      proposition operator ! (void) const { return *this; }
+
+      proposition operator && (const proposition &op) const { return combine(*this, op, estimate::logic); }
+      proposition operator || (const proposition &op) const { return combine(*this, op, estimate::logic); }
+      proposition operator == (const proposition &op) const { return combine(*this, op, estimate::exclusiveOr); }
+      proposition operator ^ (const proposition &op) const { return combine(*this, op, estimate::exclusiveOr); }
+    };
+
+
+
+    // Counted as a three bit vector
+    class roundingMode {
+    protected :
+      bool constant;
+
+      friend ite<proposition, roundingMode>;   // For ITE
+
+    public :
+      static const bitWidthType width = 3;
+
+      roundingMode (bool isConstant) : constant(isConstant) {}
+      roundingMode (const roundingMode &old) : constant(old.constant) {}
+
+      static roundingMode input (const std::string & = std::string()) { return roundingMode(false); }
+
+      bool isConstant (void) const { return constant; }
+
+      roundingMode & operator = (const roundingMode &op) {
+	this->constant = op.constant;
+	return *this;
+      }
+
+      proposition valid (void) const {
+	if (!constant) estimate::comparator(width, true);
+	return proposition::result(constant);
+      }
+
+      proposition operator == (const roundingMode &op) const {
+	if (constant && op.constant) return proposition(false);
+	estimate::equality(width, constant || op.constant);
+	return proposition::result(false);
+      }
+    };
+
+
+
+    template <bool isSigned>
+    class bitVector {
+    protected :
+      bitWidthType width;
+      bool constant;
+
+      friend bitVector<!isSigned>;    // To allow conversion between the types
+      friend ite<proposition, bitVector<isSigned> >;   // For ITE
+
+      bitVector (const bitWidthType w, const bool isConstant, const bool) : width(w), constant(isConstant) {}
+
+      // The result of an operation on this and op
+      bitVector<isSigned> binary (const bitVector<isSigned> &op, void (*e)(const bitWidthType, const bool)) const {
+	PRECONDITION(width == op.width);
+	bool isConstant = constant && op.constant;
+	if (!isConstant) e(width, constant || op.constant);
+	return bitVector<isSigned>(width, isConstant, true);
+      }
+
+      // Each bit with a constant operand is a constant or the other bit
+      bitVector<isSigned> bitwise (const bitVector<isSigned> &op) const {
+	PRECONDITION(width == op.width);
+	if (!constant && !op.constant) estimate::logic(width);
+	return bitVector<isSigned>(width, constant && op.constant, true);
+      }
+
+      bitVector<isSigned> unary (void (*e)(const bitWidthType)) const {
+	if (!constant) e(width);
+	return *this;
+      }
+
+      proposition compare (const bitVector<isSigned> &op, void (*e)(const bitWidthType, const bool)) const {
+	PRECONDITION(width == op.width);
+	bool isConstant = constant && op.constant;
+	if (!isConstant) e(width, constant || op.constant);
+	return proposition::result(isConstant);
+      }
+
+      bitVector<isSigned> shift (const bitVector<isSigned> &op) const {
+	PRECONDITION(width == op.width);
+	if (!constant) estimate::shifter(width, op.constant);
+	return bitVector<isSigned>(width, constant && op.constant, true);
+      }
+
+      bitVector<isSigned> wire (const kind k, const bitWidthType w) const {
+	if (!constant) estimate::wiring(k, w);
+	return bitVector<isSigned>(w, constant, true);
+      }
+
+    public :
+      bitVector (const bitWidthType w, const uint64_t) : width(w), constant(true) {
+	PRECONDITION(w > 0);
+      }
+      bitVector (const proposition &p) : width(1), constant(p.isConstant()) {}
+      bitVector (const bitVector<isSigned> &old) : width(old.width), constant(old.constant) {}
+
+      static bitVector<isSigned> input (const bitWidthType w, const std::string & = std::string()) {
+	return bitVector<isSigned>(w, false, true);
+      }
+
+      bitWidthType getWidth (void) const { return width; }
+      bool isConstant (void) const { return constant; }
+
+      bitVector<isSigned> & operator = (const bitVector<isSigned> &op) {
+	this->width = op.width;
+	this->constant = op.constant;
+	return *this;
+      }
+
+
+      /*** Constant creation and test ***/
+
+      static bitVector<isSigned> one (const bitWidthType &w) { return bitVector<isSigned>(w,1); }
+      static bitVector<isSigned> zero (const bitWidthType &w)  { return bitVector<isSigned>(w,0); }
+      static bitVector<isSigned> allOnes (const bitWidthType &w) { return bitVector<isSigned>(w,0); }
+
+      inline proposition isAllOnes() const {
+	if (!constant) estimate::reduction(width);
+	return proposition::result(constant);
+      }
+      inline proposition isAllZeros() const { return this->isAllOnes(); }
+
+      static bitVector<isSigned> maxValue (const bitWidthType &w) { return bitVector<isSigned>(w,0); }
+      static bitVector<isSigned> minValue (const bitWidthType &w) { return bitVector<isSigned>(w,0); }
+
+
+      /*** Operators ***/
+      inline bitVector<isSigned> operator << (const bitVector<isSigned> &op) const { return this->shift(op); }
+      inline bitVector<isSigned> operator >> (const bitVector<isSigned> &op) const { return this->shift(op); }
+
+      inline bitVector<isSigned> operator | (const bitVector<isSigned> &op) const { return this->bitwise(op); }
+      inline bitVector<isSigned> operator & (const bitVector<isSigned> &op) const { return this->bitwise(op); }
+      inline bitVector<isSigned> operator + (const bitVector<isSigned> &op) const { return this->binary(op, estimate::adder); }
+      inline bitVector<isSigned> operator - (const bitVector<isSigned> &op) const { return this->binary(op, estimate::adder); }
+      inline bitVector<isSigned> operator * (const bitVector<isSigned> &op) const { return this->binary(op, estimate::multiplier); }
+      inline bitVector<isSigned> operator / (const bitVector<isSigned> &op) const { return this->binary(op, estimate::divider); }
+      inline bitVector<isSigned> operator % (const bitVector<isSigned> &op) const { return this->binary(op, estimate::divider); }
+
+      inline bitVector<isSigned> operator - (void) const { return this->unary(estimate::incrementer); }
+      inline bitVector<isSigned> operator ~ (void) const { return *this; }
+
+      inline bitVector<isSigned> increment () const { return this->unary(estimate::incrementer); }
+      inline bitVector<isSigned> decrement () const { return this->unary(estimate::incrementer); }
+
+      inline bitVector<isSigned> signExtendRightShift (const bitVector<isSigned> &op) const { return this->shift(op); }
+
+
+      /*** Modular opertaions ***/
+      // No overflow checking so these are the same as other operations
+      inline bitVector<isSigned> modularLeftShift (const bitVector<isSigned> &op) const { return *this << op; }
+      inline bitVector<isSigned> modularRightShift (const bitVector<isSigned> &op) const { return *this >> op; }
+      inline bitVector<isSigned> modularIncrement () const { return this->increment(); }
+      inline bitVector<isSigned> modularDecrement () const { return this->decrement(); }
+      inline bitVector<isSigned> modularAdd (const bitVector<isSigned> &op) const { return *this + op; }
+      inline bitVector<isSigned> modularNegate () const { return -(*this); }
+
+
+      /*** Comparisons ***/
+
+      inline proposition operator == (const bitVector<isSigned> &op) const { return this->compare(op, estimate::equality); }
+      inline proposition operator <= (const bitVector<isSigned> &op) const { return this->compare(op, estimate::comparator); }
+      inline proposition operator >= (const bitVector<isSigned> &op) const { return this->compare(op, estimate::comparator); }
+      inline proposition operator < (const bitVector<isSigned> &op) const { return this->compare(op, estimate::comparator); }
+      inline proposition operator > (const bitVector<isSigned> &op) const { return this->compare(op, estimate::comparator); }
+
+
+      /*** Type conversion ***/
+      // The bits are the same, only the interpretation changes
+      bitVector<true> toSigned (void) const { return bitVector<true>(width, constant, true); }
+      bitVector<false> toUnsigned (void) const { return bitVector<false>(width, constant, true); }
+
+
+      /*** Bit hacks ***/
+
+      inline bitVector<isSigned> extend (bitWidthType extension) const {
+	return this->wire(EXTEND, width + extension);
+      }
+
+      inline bitVector<isSigned> contract (bitWidthType reduction) const {
+	PRECONDITION(width > reduction);
+	return this->wire(EXTEND, width - reduction);
+      }
+
+      inline bitVector<isSigned> resize (bitWidthType newSize) const {
+	if (newSize > width) {
+	  return this->extend(newSize - width);
+	} else if (newSize < width) {
+	  return this->contract(width - newSize);
+	} else {
+	  return *this;
+	}
+      }
+
+      inline bitVector<isSigned> matchWidth (const bitVector<isSigned> &op) const {
+	PRECONDITION(width <= op.width);
+	return this->extend(op.width - width);
+      }
+
+      // this is the high part of the result
+      bitVector<isSigned> append (const bitVector<isSigned> &op) const {
+	bool isConstant = constant && op.constant;
+	if (!isConstant) estimate::wiring(CONCAT, width + op.width);
+	return bitVector<isSigned>(width + op.width, isConstant, true);
+      }
+
+      // Inclusive of end points, thus if the same, extracts just one bit
+      bitVector<isSigned> extract (bitWidthType upper, bitWidthType lower) const {
+	PRECONDITION(upper >= lower);
+	PRECONDITION(upper < width);
+	return this->wire(EXTRACT, upper - lower + 1);
+      }
+    };
+
+  }
+
+
+  // An ITE with a constant condition is assumed to be folded
+  template <>
+  struct ite<cost::proposition, cost::proposition> {
+    static const cost::proposition iteOp (const cost::proposition &cond,
+					  const cost::proposition &l,
+					  const cost::proposition &r) {
+      if (cond.isConstant()) return (l.isConstant()) ? r : l;
+      cost::estimate::multiplexer(1, l.isConstant() + r.isConstant());
+      return cost::proposition::result(false);
+    }
+  };
+
+  template <>
+  struct ite<cost::proposition, cost::roundingMode> {
+    static const cost::roundingMode iteOp (const cost::proposition &cond,
+					   const cost::roundingMode &l,
+					   const cost::roundingMode &r) {
+      if (cond.isConstant()) return (l.isConstant()) ? r : l;
+      cost::estimate::multiplexer(cost::roundingMode::width, l.isConstant() + r.isConstant());
+      return cost::roundingMode(false);
+    }
+  };
+
+#define COSTITEDFN(T) template <>					\
+    struct ite<cost::proposition, T> {					\
+    static const T iteOp (const cost::proposition &cond,		\
+			  const T &l,					\
+			  const T &r) {					\
+      assert(l.getWidth() == r.getWidth());				\
+      if (cond.isConstant()) return (l.isConstant()) ? r : l;		\
+      cost::estimate::multiplexer(l.getWidth(), l.isConstant() + r.isConstant()); \
+      return T::input(l.getWidth());					\
+    }									\
+  };
+
+  COSTITEDFN(cost::traits::sbv);
+  COSTITEDFN(cost::traits::ubv);
+
+#undef COSTITEDFN
+
+}
+
+#endif
@@ -0,0 +1,33 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+** 
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+** 
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** costInstantiations.cpp
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** The one copy of the operations for the counting back-end.
+**
+*/
+
+#include "symfpu/baseTypes/cost.h"
+#include "symfpu/core/instantiate.h"
+
+SYMFPU_INSTANTIATE(template, symfpu::cost::traits)
+SYMFPU_INSTANTIATE_SIGNED_CONVERSION(template, symfpu::cost::traits)
@@ -23,12 +23,18 @@ namespace symfpu {
 
     #define BITS 32
 
+    // ieee_floatt uses 0 to 3 for the IEEE-754 1985 modes and the
+    // value after them is used for RNA.  It has no round-to-odd so it
+    // is given the next one.
+    static const int roundNearestAwayValue = 4;
+    static const int roundToOddValue = 5;
+
     roundingMode traits::RNE (void) {
       return roundingMode(solver->build_constant(0/*ieee_floatt::ROUND_TO_EVEN*/, BITS));
     }
     
     roundingMode traits::RNA (void) {
-      return roundingMode(solver->build_constant(4, BITS));
+      return roundingMode(solver->build_constant(roundNearestAwayValue, BITS));
     }
     
     roundingMode traits::RTP (void) {
@@ -43,5 +49,9 @@ namespace symfpu {
       return roundingMode(solver->build_constant(3/*ieee_floatt::ROUND_TO_ZERO*/, BITS));
     }
 
+    roundingMode traits::RTO (void) {
+      return roundingMode(solver->build_constant(roundToOddValue, BITS));
+    }
+
   }
 }
@@ -67,6 +67,7 @@ namespace symfpu {
       static roundingMode RTP (void);
       static roundingMode RTN (void);
       static roundingMode RTZ (void);
+      static roundingMode RTO (void);
 
       // Literal invariants
       inline static void precondition (const bool b) { assert(b); return; }
@@ -37,12 +37,18 @@ namespace symfpu {
 
     #define BITS 32
 
+    // ieee_floatt uses 0 to 3 for the IEEE-754 1985 modes and the
+    // value after them is used for RNA.  It has no round-to-odd so it
+    // is given the next one.
+    static const int roundNearestAwayValue = 4;
+    static const int roundToOddValue = 5;
+
     roundingMode traits::RNE (void) {
       return roundingMode(from_integer(0/*ieee_floatt::ROUND_TO_EVEN*/, signedbv_typet(BITS)));
     }
     
     roundingMode traits::RNA (void) {
-      return roundingMode(from_integer(4, signedbv_typet(BITS)));
+      return roundingMode(from_integer(roundNearestAwayValue, signedbv_typet(BITS)));
     }
     
     roundingMode traits::RTP (void) {
@@ -57,6 +63,10 @@ namespace symfpu {
       return roundingMode(from_integer(3/*ieee_floatt::ROUND_TO_ZERO*/, signedbv_typet(BITS)));
     }
 
+    roundingMode traits::RTO (void) {
+      return roundingMode(from_integer(roundToOddValue, signedbv_typet(BITS)));
+    }
+
 #ifdef THERE_BE_DRAGONS
     // The following code is evil and insane
     // It exists to add labels in code generated by boolbvt_graph.h
@@ -0,0 +1,386 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** knownBits.cpp
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** The transfer functions for the known bits back-end.
+**
+*/
+
+#include "symfpu/baseTypes/knownBits.h"
+
+namespace symfpu {
+  namespace knownBits {
+
+    /*** Traits ***/
+
+    roundingMode traits::RNE (void) { return roundingMode(0); }
+    roundingMode traits::RNA (void) { return roundingMode(1); }
+    roundingMode traits::RTP (void) { return roundingMode(2); }
+    roundingMode traits::RTN (void) { return roundingMode(3); }
+    roundingMode traits::RTZ (void) { return roundingMode(4); }
+    roundingMode traits::RTO (void) { return roundingMode(5); }
+
+    void traits::precondition (const prop &p) { assert(!p.isFalse()); return; }
+    void traits::postcondition (const prop &p) { assert(!p.isFalse()); return; }
+    void traits::invariant (const prop &p) { assert(!p.isFalse()); return; }
+
+
+
+    /*** Transfer functions ***/
+
+    namespace operations {
+
+      // Concrete values, least significant bit first
+      typedef std::vector<bool> word;
+
+      // The least and greatest values that match
+      static word lowest (const bits &a) {
+	word w(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  w[i] = (a[i] == ONE);
+	}
+	return w;
+      }
+
+      static word highest (const bits &a) {
+	word w(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  w[i] = (a[i] != ZERO);
+	}
+	return w;
+      }
+
+      static word unknownMask (const bits &a) {
+	word w(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  w[i] = (a[i] == UNKNOWN);
+	}
+	return w;
+      }
+
+      static bits fromWord (const word &w) {
+	bits b(w.size());
+	for (size_t i = 0; i < w.size(); ++i) {
+	  b[i] = w[i] ? ONE : ZERO;
+	}
+	return b;
+      }
+
+      static word addWords (const word &a, const word &b, bool carry) {
+	assert(a.size() == b.size());
+	word sum(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  sum[i] = a[i] ^ b[i] ^ carry;
+	  carry = (a[i] && b[i]) || (carry && (a[i] ^ b[i]));
+	}
+	return sum;
+      }
+
+      static word notWord (const word &a) {
+	word w(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  w[i] = !a[i];
+	}
+	return w;
+      }
+
+      static word subtractWords (const word &a, const word &b) {
+	return addWords(a, notWord(b), true);
+      }
+
+      static bool lessThanWords (const word &a, const word &b) {
+	assert(a.size() == b.size());
+	for (size_t i = a.size(); i > 0; --i) {
+	  if (a[i - 1] != b[i - 1]) {
+	    return b[i - 1];
+	  }
+	}
+	return false;
+      }
+
+      // Known where the value is known and the mask is not set
+      static bits fromValueAndMask (const word &value, const word &mask) {
+	bits b(value.size());
+	for (size_t i = 0; i < value.size(); ++i) {
+	  b[i] = mask[i] ? UNKNOWN : (value[i] ? ONE : ZERO);
+	}
+	return b;
+      }
+
+
+      bits constant (const bitWidthType w, const uint64_t v, const bool isSigned) {
+	bits b(w);
+	for (bitWidthType i = 0; i < w; ++i) {
+	  bitWidthType j = (i < 64) ? i : 63;
+	  bool bit = (i < 64 || isSigned) && ((v >> j) & 0x1);
+	  b[i] = bit ? ONE : ZERO;
+	}
+	return b;
+      }
+
+      bits join (const bits &l, const bits &r) {
+	assert(l.size() == r.size());
+	bits result(l.size());
+	for (size_t i = 0; i < l.size(); ++i) {
+	  result[i] = knownBits::join(l[i], r[i]);
+	}
+	return result;
+      }
+
+      bits bitwiseAnd (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+	bits result(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result[i] = (proposition::fromTrit(a[i]) && proposition::fromTrit(b[i])).getTrit();
+	}
+	return result;
+      }
+
+      bits bitwiseOr (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+	bits result(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result[i] = (proposition::fromTrit(a[i]) || proposition::fromTrit(b[i])).getTrit();
+	}
+	return result;
+      }
+
+      bits bitwiseNot (const bits &a) {
+	bits result(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  result[i] = (!proposition::fromTrit(a[i])).getTrit();
+	}
+	return result;
+      }
+
+      // A bit of the sum is known if it is the same in the least and
+      // greatest sums and does not depend on an unknown bit of either
+      bits add (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+
+	word low(addWords(lowest(a), lowest(b), false));
+	word high(addWords(highest(a), highest(b), false));
+
+	word mask(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  mask[i] = (low[i] != high[i]) || (a[i] == UNKNOWN) || (b[i] == UNKNOWN);
+	}
+
+	return fromValueAndMask(low, mask);
+      }
+
+      bits subtract (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+
+	word difference(subtractWords(lowest(a), lowest(b)));
+	word alpha(addWords(difference, unknownMask(a), false));
+	word beta(subtractWords(difference, unknownMask(b)));
+
+	word mask(a.size());
+	for (size_t i = 0; i < a.size(); ++i) {
+	  mask[i] = (alpha[i] != beta[i]) || (a[i] == UNKNOWN) || (b[i] == UNKNOWN);
+	}
+
+	return fromValueAndMask(difference, mask);
+      }
+
+      bits negate (const bits &a) {
+	return subtract(constant(a.size(), 0, false), a);
+      }
+
+      // Sum of the shifted partial products, where a partial product for
+      // an unknown bit is unknown wherever the other side is not zero
+      bits multiply (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+	size_t w = a.size();
+
+	bits result(constant(w, 0, false));
+	for (size_t i = 0; i < w; ++i) {
+	  if (a[i] == ZERO) continue;
+
+	  bits partial(w, ZERO);
+	  for (size_t j = i; j < w; ++j) {
+	    trit t = b[j - i];
+	    partial[j] = (a[i] == ONE || t == ZERO) ? t : UNKNOWN;
+	  }
+	  result = add(result, partial);
+	}
+	return result;
+      }
+
+      // Only constants are divided, with division by zero as in SMT-LIB
+      static void unsignedDivide (const word &a, const word &b, word &quotient, word &remainder) {
+	size_t w = a.size();
+
+	word divisor(b);
+	divisor.push_back(false);
+
+	word partial(w + 1, false);
+	quotient.assign(w, false);
+
+	for (size_t i = w; i > 0; --i) {
+	  partial.pop_back();
+	  partial.insert(partial.begin(), a[i - 1]);
+
+	  bool fits = !lessThanWords(partial, divisor);
+	  if (fits) {
+	    partial = subtractWords(partial, divisor);
+	  }
+	  quotient[i - 1] = fits;
+	}
+
+	partial.pop_back();
+	remainder = partial;
+	return;
+      }
+
+      void divide (const bits &a, const bits &b, const bool isSigned, bits &quotient, bits &remainder) {
+	assert(a.size() == b.size());
+	size_t w = a.size();
+
+	for (size_t i = 0; i < w; ++i) {
+	  if (a[i] == UNKNOWN || b[i] == UNKNOWN) {
+	    quotient.assign(w, UNKNOWN);
+	    remainder.assign(w, UNKNOWN);
+	    return;
+	  }
+	}
+
+	word x(lowest(a));
+	word y(lowest(b));
+	word zero(w, false);
+
+	bool xNegative = isSigned && x.back();
+	bool yNegative = isSigned && y.back();
+
+	word q, r;
+	unsignedDivide(xNegative ? subtractWords(zero, x) : x,
+		       yNegative ? subtractWords(zero, y) : y,
+		       q, r);
+
+	quotient = fromWord((xNegative != yNegative) ? subtractWords(zero, q) : q);
+	remainder = fromWord(xNegative ? subtractWords(zero, r) : r);
+	return;
+      }
+
+      // The join of the shifts by every amount that matches
+      static bits shift (const bits &a, const bits &amount, const bool left, const trit fill) {
+	assert(a.size() == amount.size());
+	size_t w = a.size();
+
+	bits result;
+	bool first = true;
+
+	for (size_t k = 0; k < w; ++k) {
+	  bool possible = true;
+	  for (size_t j = 0; j < amount.size() && possible; ++j) {
+	    bool bit = (j < 64) && ((k >> j) & 0x1);
+	    possible = (amount[j] == UNKNOWN) || ((amount[j] == ONE) == bit);
+	  }
+	  if (!possible) continue;
+
+	  bits shifted(w);
+	  for (size_t i = 0; i < w; ++i) {
+	    if (left) {
+	      shifted[i] = (i >= k) ? a[i - k] : ZERO;
+	    } else {
+	      shifted[i] = (i + k < w) ? a[i + k] : fill;
+	    }
+	  }
+
+	  result = first ? shifted : join(result, shifted);
+	  first = false;
+	}
+
+	// Shifting by the width or more shifts everything out
+	word widthWord(w, false);
+	for (size_t j = 0; j < w && j < 64; ++j) {
+	  widthWord[j] = (w >> j) & 0x1;
+	}
+	if (!lessThanWords(highest(amount), widthWord)) {
+	  bits all(w, left ? ZERO : fill);
+	  result = first ? all : join(result, all);
+	}
+
+	return result;
+      }
+
+      bits leftShift (const bits &a, const bits &amount) {
+	return shift(a, amount, true, ZERO);
+      }
+
+      bits rightShift (const bits &a, const bits &amount, const bool arithmetic) {
+	return shift(a, amount, false, arithmetic ? a.back() : ZERO);
+      }
+
+      trit equal (const bits &a, const bits &b) {
+	assert(a.size() == b.size());
+
+	trit result = ONE;
+	for (size_t i = 0; i < a.size(); ++i) {
+	  if (a[i] == UNKNOWN || b[i] == UNKNOWN) {
+	    result = UNKNOWN;
+	  } else if (a[i] != b[i]) {
+	    return ZERO;
+	  }
+	}
+	return result;
+      }
+
+      // Signed comparison is unsigned comparison with the top bits
+      // inverted, then it is known if the ranges do not overlap
+      trit lessThan (const bits &a, const bits &b, const bool isSigned, const bool orEqual) {
+	assert(a.size() == b.size());
+
+	bits x(a);
+	bits y(b);
+	if (isSigned) {
+	  x.back() = (!proposition::fromTrit(x.back())).getTrit();
+	  y.back() = (!proposition::fromTrit(y.back())).getTrit();
+	}
+
+	word xLow(lowest(x)), xHigh(highest(x));
+	word yLow(lowest(y)), yHigh(highest(y));
+
+	if (orEqual) {
+	  if (!lessThanWords(yLow, xHigh)) return ONE;    // xHigh <= yLow
+	  if (lessThanWords(yHigh, xLow)) return ZERO;
+	} else {
+	  if (lessThanWords(xHigh, yLow)) return ONE;
+	  if (!lessThanWords(xLow, yHigh)) return ZERO;   // xLow >= yHigh
+	}
+	return UNKNOWN;
+      }
+
+      trit allOnes (const bits &a) {
+	return equal(a, bits(a.size(), ONE));
+      }
+
+      trit allZeros (const bits &a) {
+	return equal(a, bits(a.size(), ZERO));
+      }
+
+    }
+
+  }
+}
@@ -0,0 +1,550 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** knownBits.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** An abstract back-end where each bit is known to be 0, known to be 1
+** or unknown (X), as are propositions.  Rounding modes are the set of
+** modes they may be.  Running an operation on partially known inputs
+** (for example a known sign, a bounded exponent or a constant rounding
+** mode) gives the bits of the result, and of anything computed on the
+** way, that are the same for all inputs that match; a symbolic
+** back-end does not need logic for these.
+**
+** Addition and subtraction use the transfer functions of tristate
+** numbers (Vishwanathan et al.) which are optimal, multiplication is
+** a sum of these, shifts by partially known amounts are the join of
+** the possible shifts and comparisons use the range of each side.
+** Division is only exact when both sides are constants.
+**
+*/
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// Symfpu headers
+#include "symfpu/utils/properties.h"
+#include "symfpu/core/ite.h"
+#include "symfpu/baseTypes/shared.h"
+
+#ifndef SYMFPU_KNOWN_BITS
+#define SYMFPU_KNOWN_BITS
+
+namespace symfpu {
+  namespace knownBits {
+
+    typedef symfpu::shared::bitWidthType bitWidthType;
+    typedef symfpu::shared::floatingPointTypeInfo floatingPointTypeInfo;
+
+    enum trit { ZERO = 0, ONE = 1, UNKNOWN = 2 };
+
+    // The least precise value that includes both
+    inline trit join (const trit a, const trit b) { return (a == b) ? a : UNKNOWN; }
+
+
+
+    // Forward declarations
+    class roundingMode;
+    class proposition;
+    template <bool isSigned> class bitVector;
+
+    // Wrap up the types into one template parameter
+    class traits {
+    public :
+      typedef bitWidthType bwt;
+      typedef roundingMode rm;
+      typedef floatingPointTypeInfo fpt;
+      typedef proposition prop;
+      typedef bitVector< true> sbv;
+      typedef bitVector<false> ubv;
+
+      static roundingMode RNE (void);
+      static roundingMode RNA (void);
+      static roundingMode RTP (void);
+      static roundingMode RTN (void);
+      static roundingMode RTZ (void);
+      static roundingMode RTO (void);
+
+      // Literal invariants
+      inline static void precondition (const bool b) { assert(b); return; }
+      inline static void postcondition (const bool b) { assert(b); return; }
+      inline static void invariant (const bool b) { assert(b); return; }
+
+      // Abstract invariants, only those that are known to fail are caught
+      static void precondition (const prop &p);
+      static void postcondition (const prop &p);
+      static void invariant (const prop &p);
+    };
+
+    // To simplify the property macros
+    typedef traits t;
+
+
+
+    class proposition {
+    protected :
+      trit value;
+
+      friend ite<proposition, proposition>;   // For ITE
+
+    public :
+      proposition (bool v) : value(v ? ONE : ZERO) {}
+      proposition (const proposition &old) : value(old.value) {}
+
+      static proposition fromTrit (const trit v) {
+	proposition p(false);
+	p.value = v;
+	return p;
+      }
+      static proposition unknown (void) {
+	return fromTrit(UNKNOWN);
+      }
+
+      trit getTrit (void) const { return value; }
+      bool isTrue (void) const { return value == ONE; }
+      bool isFalse (void) const { return value == ZERO; }
+      bool isKnown (void) const { return value != UNKNOWN; }
+
+      proposition & operator = (const proposition &op) {
+	this->value = op.value;
+	return *this;
+      }
+
+      proposition operator ! (void) const {
+	return fromTrit((value == UNKNOWN) ? UNKNOWN : ((value == ONE) ? ZERO : ONE));
+      }
+
+      proposition operator && (const proposition &op) const {
+	if (value == ZERO || op.value == ZERO) return proposition(false);
+	if (value == ONE && op.value == ONE) return proposition(true);
+	return unknown();
+      }
+
+      proposition operator || (const proposition &op) const {
+	return !((!*this) && (!op));
+      }
+
+      proposition operator == (const proposition &op) const {
+	if (value == UNKNOWN || op.value == UNKNOWN) return unknown();
+	return proposition(value == op.value);
+      }
+
+      proposition operator ^ (const proposition &op) const {
+	return !(*this == op);
+      }
+    };
+
+
+
+    // The set of modes it may be, in the order RNE, RNA, RTP, RTN, RTZ, RTO
+    class roundingMode {
+    protected :
+      uint8_t modes;
+
+      friend ite<proposition, roundingMode>;   // For ITE
+
+    public :
+      static const uint8_t anyMode = 0x3F;
+
+      roundingMode (const unsigned int mode) : modes(1U << mode) {
+	PRECONDITION(mode <= 5);
+      }
+      roundingMode (const roundingMode &old) : modes(old.modes) {}
+
+      static roundingMode fromSet (const uint8_t m) {
+	PRECONDITION(m != 0 && (m & ~anyMode) == 0);
+	roundingMode r(0);
+	r.modes = m;
+	return r;
+      }
+      static roundingMode unknown (void) {
+	return fromSet(anyMode);
+      }
+
+      uint8_t getSet (void) const { return modes; }
+
+      roundingMode & operator = (const roundingMode &op) {
+	this->modes = op.modes;
+	return *this;
+      }
+
+      proposition valid (void) const {
+	return proposition(true);
+      }
+
+      proposition operator == (const roundingMode &op) const {
+	if ((modes & op.modes) == 0) return proposition(false);
+	if (modes == op.modes && (modes & (modes - 1)) == 0) return proposition(true);
+	return proposition::unknown();
+      }
+    };
+
+
+
+    // Operations on the bits of a vector, least significant first
+    typedef std::vector<trit> bits;
+
+    namespace operations {
+      bits constant (const bitWidthType w, const uint64_t v, const bool isSigned);
+      bits join (const bits &l, const bits &r);
+      bits bitwiseAnd (const bits &a, const bits &b);
+      bits bitwiseOr (const bits &a, const bits &b);
+      bits bitwiseNot (const bits &a);
+      bits add (const bits &a, const bits &b);
+      bits subtract (const bits &a, const bits &b);
+      bits negate (const bits &a);
+      bits multiply (const bits &a, const bits &b);
+      void divide (const bits &a, const bits &b, const bool isSigned, bits &quotient, bits &remainder);
+      bits leftShift (const bits &a, const bits &amount);
+      bits rightShift (const bits &a, const bits &amount, const bool arithmetic);
+      trit equal (const bits &a, const bits &b);
+      trit lessThan (const bits &a, const bits &b, const bool isSigned, const bool orEqual);
+      trit allOnes (const bits &a);
+      trit allZeros (const bits &a);
+    }
+
+
+    template <bool isSigned>
+    class bitVector {
+    protected :
+      bits contents;
+
+      friend bitVector<!isSigned>;    // To allow conversion between the types
+      friend ite<proposition, bitVector<isSigned> >;   // For ITE
+
+      bitVector (const bits &b) : contents(b) {}
+
+    public :
+      bitVector (const bitWidthType w, const uint64_t v) : contents(operations::constant(w, v, isSigned)) {
+	PRECONDITION(w > 0);
+      }
+      bitVector (const proposition &p) : contents(1, p.getTrit()) {}
+      bitVector (const bitVector<isSigned> &old) : contents(old.contents) {}
+
+      static bitVector<isSigned> unknown (const bitWidthType w) {
+	PRECONDITION(w > 0);
+	return bitVector<isSigned>(bits(w, UNKNOWN));
+      }
+
+      // Most significant bit first, using 0, 1 and X
+      static bitVector<isSigned> fromString (const std::string &s) {
+	PRECONDITION(s.size() > 0);
+	bits b(s.size());
+	for (size_t i = 0; i < s.size(); ++i) {
+	  char c = s[s.size() - 1 - i];
+	  PRECONDITION(c == '0' || c == '1' || c == 'X');
+	  b[i] = (c == '0') ? ZERO : ((c == '1') ? ONE : UNKNOWN);
+	}
+	return bitVector<isSigned>(b);
+      }
+
+      std::string toString (void) const {
+	std::string s(contents.size(), 'X');
+	for (size_t i = 0; i < contents.size(); ++i) {
+	  s[contents.size() - 1 - i] = (contents[i] == ZERO) ? '0' : ((contents[i] == ONE) ? '1' : 'X');
+	}
+	return s;
+      }
+
+      bitWidthType getWidth (void) const {
+	return contents.size();
+      }
+
+      const bits & getBits (void) const { return contents; }
+
+      bitWidthType numberOfKnownBits (void) const {
+	bitWidthType count = 0;
+	for (bitWidthType i = 0; i < contents.size(); ++i) {
+	  count += (contents[i] != UNKNOWN);
+	}
+	return count;
+      }
+
+      bool isConstant (void) const {
+	return this->numberOfKnownBits() == this->getWidth();
+      }
+
+      // Only meaningful for constants, the low 64 bits
+      uint64_t constantValue (void) const {
+	PRECONDITION(this->isConstant());
+	uint64_t v = 0;
+	for (bitWidthType i = 0; i < contents.size() && i < 64; ++i) {
+	  v |= ((uint64_t)(contents[i] == ONE)) << i;
+	}
+	return v;
+      }
+
+      bitVector<isSigned> & operator = (const bitVector<isSigned> &op) {
+	this->contents = op.contents;
+	return *this;
+      }
+
+
+      /*** Constant creation and test ***/
+
+      static bitVector<isSigned> one (const bitWidthType &w) { return bitVector<isSigned>(w,1); }
+      static bitVector<isSigned> zero (const bitWidthType &w)  { return bitVector<isSigned>(w,0); }
+      static bitVector<isSigned> allOnes (const bitWidthType &w) { return ~zero(w); }
+
+      inline proposition isAllOnes() const { return proposition::fromTrit(operations::allOnes(contents)); }
+      inline proposition isAllZeros() const { return proposition::fromTrit(operations::allZeros(contents)); }
+
+      static bitVector<isSigned> maxValue (const bitWidthType &w) {
+	if (isSigned) {
+	  return zero(1).append(allOnes(w-1));
+	} else {
+	  return allOnes(w);
+	}
+      }
+
+      static bitVector<isSigned> minValue (const bitWidthType &w) {
+	if (isSigned) {
+	  return one(1).append(zero(w-1));
+	} else {
+	  return zero(w);
+	}
+      }
+
+
+      /*** Operators ***/
+      inline bitVector<isSigned> operator << (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::leftShift(contents, op.contents));
+      }
+
+      inline bitVector<isSigned> operator >> (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::rightShift(contents, op.contents, isSigned));
+      }
+
+      inline bitVector<isSigned> operator | (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::bitwiseOr(contents, op.contents));
+      }
+
+      inline bitVector<isSigned> operator & (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::bitwiseAnd(contents, op.contents));
+      }
+
+      inline bitVector<isSigned> operator + (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::add(contents, op.contents));
+      }
+
+      inline bitVector<isSigned> operator - (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::subtract(contents, op.contents));
+      }
+
+      inline bitVector<isSigned> operator * (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::multiply(contents, op.contents));
+      }
+
+      inline bitVector<isSigned> operator / (const bitVector<isSigned> &op) const {
+	bits quotient, remainder;
+	operations::divide(contents, op.contents, isSigned, quotient, remainder);
+	return bitVector<isSigned>(quotient);
+      }
+
+      inline bitVector<isSigned> operator % (const bitVector<isSigned> &op) const {
+	bits quotient, remainder;
+	operations::divide(contents, op.contents, isSigned, quotient, remainder);
+	return bitVector<isSigned>(remainder);
+      }
+
+      inline bitVector<isSigned> operator - (void) const {
+	return bitVector<isSigned>(operations::negate(contents));
+      }
+
+      inline bitVector<isSigned> operator ~ (void) const {
+	return bitVector<isSigned>(operations::bitwiseNot(contents));
+      }
+
+      inline bitVector<isSigned> increment () const {
+	return *this + bitVector<isSigned>::one(getWidth());
+      }
+
+      inline bitVector<isSigned> decrement () const {
+	return *this - bitVector<isSigned>::one(getWidth());
+      }
+
+      inline bitVector<isSigned> signExtendRightShift (const bitVector<isSigned> &op) const {
+	return bitVector<isSigned>(operations::rightShift(contents, op.contents, true));
+      }
+
+
+      /*** Modular opertaions ***/
+      // No overflow checking so these are the same as other operations
+      inline bitVector<isSigned> modularLeftShift (const bitVector<isSigned> &op) const {
+	return *this << op;
+      }
+
+      inline bitVector<isSigned> modularRightShift (const bitVector<isSigned> &op) const {
+	return *this >> op;
+      }
+
+      inline bitVector<isSigned> modularIncrement () const {
+	return this->increment();
+      }
+
+      inline bitVector<isSigned> modularDecrement () const {
+	return this->decrement();
+      }
+
+      inline bitVector<isSigned> modularAdd (const bitVector<isSigned> &op) const {
+	return *this + op;
+      }
+
+      inline bitVector<isSigned> modularNegate () const {
+	return -(*this);
+      }
+
+
+      /*** Comparisons ***/
+
+      inline proposition operator == (const bitVector<isSigned> &op) const {
+	return proposition::fromTrit(operations::equal(contents, op.contents));
+      }
+
+      inline proposition operator <= (const bitVector<isSigned> &op) const {
+	return proposition::fromTrit(operations::lessThan(contents, op.contents, isSigned, true));
+      }
+
+      inline proposition operator >= (const bitVector<isSigned> &op) const {
+	return op <= *this;
+      }
+
+      inline proposition operator < (const bitVector<isSigned> &op) const {
+	return proposition::fromTrit(operations::lessThan(contents, op.contents, isSigned, false));
+      }
+
+      inline proposition operator > (const bitVector<isSigned> &op) const {
+	return op < *this;
+      }
+
+
+      /*** Type conversion ***/
+      // The bits are the same, only the interpretation changes
+      bitVector<true> toSigned (void) const {
+	return bitVector<true>(contents);
+      }
+      bitVector<false> toUnsigned (void) const {
+	return bitVector<false>(contents);
+      }
+
+
+      /*** Bit hacks ***/
+
+      inline bitVector<isSigned> extend (bitWidthType extension) const {
+	bits b(contents);
+	b.resize(contents.size() + extension, isSigned ? contents.back() : ZERO);
+	return bitVector<isSigned>(b);
+      }
+
+      inline bitVector<isSigned> contract (bitWidthType reduction) const {
+	PRECONDITION(this->getWidth() > reduction);
+	bits b(contents);
+	b.resize(contents.size() - reduction);
+	return bitVector<isSigned>(b);
+      }
+
+      inline bitVector<isSigned> resize (bitWidthType newSize) const {
+	bitWidthType width = this->getWidth();
+
+	if (newSize > width) {
+	  return this->extend(newSize - width);
+	} else if (newSize < width) {
+	  return this->contract(width - newSize);
+	} else {
+	  return *this;
+	}
+      }
+
+      inline bitVector<isSigned> matchWidth (const bitVector<isSigned> &op) const {
+	PRECONDITION(this->getWidth() <= op.getWidth());
+	return this->extend(op.getWidth() - this->getWidth());
+      }
+
+      // this is the high part of the result
+      bitVector<isSigned> append (const bitVector<isSigned> &op) const {
+	bits b(op.contents);
+	b.insert(b.end(), contents.begin(), contents.end());
+	return bitVector<isSigned>(b);
+      }
+
+      // Inclusive of end points, thus if the same, extracts just one bit
+      bitVector<isSigned> extract (bitWidthType upper, bitWidthType lower) const {
+	PRECONDITION(upper >= lower);
+	PRECONDITION(upper < this->getWidth());
+	return bitVector<isSigned>(bits(contents.begin() + lower, contents.begin() + upper + 1));
+      }
+    };
+
+  }
+
+
+  template <>
+  struct ite<knownBits::proposition, knownBits::proposition> {
+    static const knownBits::proposition iteOp (const knownBits::proposition &cond,
+					       const knownBits::proposition &l,
+					       const knownBits::proposition &r) {
+      switch (cond.value) {
+      case knownBits::ONE : return l;
+      case knownBits::ZERO : return r;
+      default : return knownBits::proposition::fromTrit(knownBits::join(l.value, r.value));
+      }
+    }
+  };
+
+  template <>
+  struct ite<knownBits::proposition, knownBits::roundingMode> {
+    static const knownBits::roundingMode iteOp (const knownBits::proposition &cond,
+						const knownBits::roundingMode &l,
+						const knownBits::roundingMode &r) {
+      switch (cond.getTrit()) {
+      case knownBits::ONE : return l;
+      case knownBits::ZERO : return r;
+      default : return knownBits::roundingMode::fromSet(l.modes | r.modes);
+      }
+    }
+  };
+
+#define KNOWNBITSITEDFN(T) template <>					\
+    struct ite<knownBits::proposition, T> {				\
+    static const T iteOp (const knownBits::proposition &cond,		\
+			  const T &l,					\
+			  const T &r) {					\
+      assert(l.getWidth() == r.getWidth());				\
+      switch (cond.getTrit()) {						\
+      case knownBits::ONE : return l;					\
+      case knownBits::ZERO : return r;					\
+      default : return T(knownBits::operations::join(l.contents, r.contents)); \
+      }									\
+    }									\
+  };
+
+  KNOWNBITSITEDFN(knownBits::traits::sbv);
+  KNOWNBITSITEDFN(knownBits::traits::ubv);
+
+#undef KNOWNBITSITEDFN
+
+}
+
+#endif
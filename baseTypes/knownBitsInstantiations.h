@@ -0,0 +1,43 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+** 
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+** 
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** knownBitsInstantiations.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** The operations for the known bits back-end are compiled once into
+** symfpu.a (see knownBitsInstantiations.cpp).  Including this stops each
+** user instantiating them again.  Define SYMFPU_NO_EXTERN_TEMPLATES
+** to instantiate them locally instead.
+**
+*/
+
+#include "symfpu/baseTypes/knownBits.h"
+#include "symfpu/core/instantiate.h"
+
+#ifndef SYMFPU_KNOWN_BITS_INSTANTIATIONS
+#define SYMFPU_KNOWN_BITS_INSTANTIATIONS
+
+#ifndef SYMFPU_NO_EXTERN_TEMPLATES
+SYMFPU_INSTANTIATE(extern template, symfpu::knownBits::traits)
+SYMFPU_INSTANTIATE_SIGNED_CONVERSION(extern template, symfpu::knownBits::traits)
+#endif
+
+#endif
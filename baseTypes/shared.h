@@ -43,23 +43,40 @@ namespace symfpu {
     typedef bool executable_proposition;
 
     // In SMT-LIB style -- significand includes hidden bit
+    // Optionally, subnormal results can be flushed to zero (FTZ) and
+    // subnormal inputs read as zero (DAZ).  These are fixed when the
+    // format is made so the subnormal logic is not built at all.
     class floatingPointTypeInfo {
     private :
       bitWidthType exponentBits;
       bitWidthType significandBits;
+      bool flushSubnormalResults;
+      bool flushSubnormalInputs;
       
     public :
-      floatingPointTypeInfo (bitWidthType eb, bitWidthType sb) : exponentBits(eb), significandBits(sb) {
+      floatingPointTypeInfo (bitWidthType eb, bitWidthType sb) :
+        exponentBits(eb), significandBits(sb),
+	flushSubnormalResults(false), flushSubnormalInputs(false) {
 	assert(eb > 1);  // Not precondition as we don't have a traits class to use
 	assert(sb > 1);
       }
+
+      floatingPointTypeInfo (bitWidthType eb, bitWidthType sb, bool ftz, bool daz) :
+        exponentBits(eb), significandBits(sb),
+	flushSubnormalResults(ftz), flushSubnormalInputs(daz) {
+	assert(eb > 1);
+	assert(sb > 1);
+      }
       
       floatingPointTypeInfo (const floatingPointTypeInfo &old) : 
-      exponentBits(old.exponentBits), significandBits(old.significandBits) {}
+      exponentBits(old.exponentBits), significandBits(old.significandBits),
+	flushSubnormalResults(old.flushSubnormalResults), flushSubnormalInputs(old.flushSubnormalInputs) {}
       
       floatingPointTypeInfo & operator= (const floatingPointTypeInfo &old) {
 	this->exponentBits = old.exponentBits;
 	this->significandBits = old.significandBits;
+	this->flushSubnormalResults = old.flushSubnormalResults;
+	this->flushSubnormalInputs = old.flushSubnormalInputs;
 	
 	return *this;
       }
@@ -67,6 +84,9 @@ namespace symfpu {
       bitWidthType exponentWidth(void) const    { return this->exponentBits; }
       bitWidthType significandWidth(void) const { return this->significandBits; }
 
+      bool flushToZero(void) const      { return this->flushSubnormalResults; }
+      bool denormalsAreZero(void) const { return this->flushSubnormalInputs; }
+
       
       bitWidthType packedWidth(void) const            { return this->exponentBits + this->significandBits; }
       bitWidthType packedExponentWidth(void) const    { return this->exponentBits; }
@@ -37,11 +37,29 @@
 namespace symfpu {
   namespace simpleExecutable {
 
+    // a * b mod m for a, b < m < 2^63
+    static uint64_t multiplyModulo (uint64_t a, uint64_t b, uint64_t m) {
+#if defined(__SIZEOF_INT128__)
+      __extension__ typedef unsigned __int128 uint128;
+      return (uint64_t)(((uint128)a * b) % m);
+#else
+      uint64_t result = 0;
+      for (; b > 0; b >>= 1) {
+	if (b & 1) {
+	  result = (result + a) % m;
+	}
+	a = (a << 1) % m;
+      }
+      return result;
+#endif
+    }
+
 
     // This would all be much easier if C++ allowed partial specialisation of member templates...
 
     template <>
     bool bitVector<int64_t>::isRepresentable (const bitWidthType w, const int64_t v) {
+      if (w == bitVector<int64_t>::maxWidth()) return true;  // Shifting by the width is undefined
       uint64_t shiftSafe = *((uint64_t *)(&v));
       uint64_t top = (shiftSafe >> w);
       uint64_t signbit = shiftSafe & 0x8000000000000000;
@@ -51,6 +69,7 @@ namespace symfpu {
 
     template <>
     bool bitVector<uint64_t>::isRepresentable (const bitWidthType w, const uint64_t v) {
+      if (w == bitVector<uint64_t>::maxWidth()) return true;
       uint64_t top = (v >> w);
       return (top == 0);
     }
@@ -194,14 +213,16 @@ namespace symfpu {
 				 bitVector<uint64_t>::makeRepresentable(this->width, ~this->value + 1));
     }
 
+    // Wraps modulo 2^n so -2^{n-1} is its own negation
     template <>
     bitVector<int64_t> bitVector<int64_t>::modularNegate (void) const {
-      return bitVector<int64_t>(this->width, 
-				bitVector<int64_t>::makeRepresentable(this->width, -this->value));
+      uint64_t negated((~(*((uint64_t *)&this->value)) + 1) & (((1ULL << (this->width - 1)) << 1) - 1));
+      uint64_t signBit(1ULL << (this->width - 1));
+      uint64_t extended((negated ^ signBit) - signBit);
+      return bitVector<int64_t>(this->width, *((int64_t *)&extended));
     }
 
 
-    // Only instantiated for unsigned
     template <>
     bitVector<uint64_t> bitVector<uint64_t>::extract(bitWidthType upper, bitWidthType lower) const {
       PRECONDITION(this->width > upper);
@@ -213,6 +234,20 @@ namespace symfpu {
 				 bitVector<uint64_t>::makeRepresentable(newLength, (this->value >> lower)));
     }
 
+    // Used by the conversions to signed; the result is sign extended from the new top bit
+    template <>
+    bitVector<int64_t> bitVector<int64_t>::extract(bitWidthType upper, bitWidthType lower) const {
+      PRECONDITION(this->width > upper);
+      PRECONDITION(upper >= lower);
+      
+      bitWidthType newLength = (upper - lower) + 1;
+      uint64_t bits = ((*((uint64_t *)&this->value)) >> lower) & (((1ULL << (newLength - 1)) << 1) - 1);
+      uint64_t signBit = 1ULL << (newLength - 1);
+      uint64_t extended = (bits ^ signBit) - signBit;
+      
+      return bitVector<int64_t>(newLength, *((int64_t *)&extended));
+    }
+
     template <>
     bitVector<uint64_t> bitVector<uint64_t>::append(const bitVector<uint64_t> &op) const {
       PRECONDITION(this->width + op.width <= bitVector<uint64_t>::maxWidth());
@@ -224,7 +259,10 @@ namespace symfpu {
     
     template <>
     bitVector<typename modifySignedness<uint64_t>::signedVersion> bitVector<uint64_t>::toSigned (void) const {
-      return bitVector<int64_t>(this->width, *((int64_t *)&this->value));
+      // Sign extend so that the value matches the bits
+      uint64_t topBit(1ULL << (this->width - 1));
+      uint64_t extended((this->value & topBit) ? (this->value | ~bitVector<uint64_t>::nOnes(this->width)) : this->value);
+      return bitVector<int64_t>(this->width, *((int64_t *)&extended));
     }
 
     template <>
@@ -234,12 +272,80 @@ namespace symfpu {
     }
 
 
+    // RNA and RTO have no FE_* value so they are given ones that are
+    // not any of them (or combinations of their bits) and which
+    // fesetround will reject.
+    static const int roundNearestAwayValue = 23;     // Could be better...
+    static const int roundToOddValue = 29;           // No hardware equivalent
+
     roundingMode traits::RNE (void) { return roundingMode(FE_TONEAREST); }
-    roundingMode traits::RNA (void) { return roundingMode(23); }          // Could be better...
+    roundingMode traits::RNA (void) { return roundingMode(roundNearestAwayValue); }
     roundingMode traits::RTP (void) { return roundingMode(FE_UPWARD); }
     roundingMode traits::RTN (void) { return roundingMode(FE_DOWNWARD); }
     roundingMode traits::RTZ (void) { return roundingMode(FE_TOWARDZERO); }
+    roundingMode traits::RTO (void) { return roundingMode(roundToOddValue); }
+
+  }
+
+  template <>
+  simpleExecutable::traits::ubv remainderDivideSteps<simpleExecutable::traits> (const simpleExecutable::traits::ubv &x,
+										 const simpleExecutable::traits::ubv &y,
+										 const simpleExecutable::traits::sbv &difference,
+										 const simpleExecutable::traits::bwt &maxDifference) {
+    typedef simpleExecutable::traits t;
+    typedef t::ubv ubv;
+
+    PRECONDITION(x.getWidth() == y.getWidth());
+    PRECONDITION(y.extract(y.getWidth() - 2, y.getWidth() - 2).isAllOnes());  // As divideStep
+
+    int64_t d(difference.contents());
+    if (d <= 0) {
+      return x;
+    }
+    uint64_t steps((uint64_t)d < maxDifference ? (uint64_t)d : maxDifference);
+
+    // Each step is r := 2 * (r mod y) and as x < 2y the first step is
+    // 2 * (x mod y).  So the result is 2 * (x * 2^(steps - 1) mod y).
+    // y has a leading zero so all of the doubling below is safe.
+    uint64_t modulus(y.contents());
+    uint64_t base(x.contents() % modulus);
+    uint64_t power(1 % modulus);
+    uint64_t square(2 % modulus);
+    for (uint64_t e = steps - 1; e > 0; e >>= 1) {
+      if (e & 1) {
+	power = simpleExecutable::multiplyModulo(power, square, modulus);
+      }
+      square = simpleExecutable::multiplyModulo(square, square, modulus);
+    }
+
+    return ubv(x.getWidth(), simpleExecutable::multiplyModulo(base, power, modulus) << 1);
+  }
+
+  template <>
+  normaliseShiftResult<simpleExecutable::traits> normaliseShift<simpleExecutable::traits> (const simpleExecutable::traits::ubv input) {
+    typedef simpleExecutable::traits t;
+    typedef t::bwt bwt;
+    typedef t::prop prop;
+    typedef t::ubv ubv;
+
+    bwt width(input.getWidth());
+    bwt startingMask(previousPowerOfTwo(width));
+    INVARIANT(startingMask < width);
+
+    // The generic version has one bit of shift amount per stage
+    bwt shiftAmountWidth(bitsToRepresent(startingMask));
+
+    uint64_t value(input.contents());
+    prop zeroCase(value == 0);
+    bwt leadingZeros((zeroCase) ? 0 : __builtin_clzll(value) - (64 - width));
+
+    normaliseShiftResult<t> res(ubv(width, value << leadingZeros),
+				ubv(shiftAmountWidth, leadingZeros),
+				zeroCase);
+
+    POSTCONDITION(res.normalised.extract(width-1,width-1).isAllZeros() == res.isZero);
 
+    return res;
   }
 
   #if 0
@@ -72,6 +72,7 @@ namespace symfpu {
       static roundingMode RTP(void);
       static roundingMode RTN(void);
       static roundingMode RTZ(void);
+      static roundingMode RTO(void);
 
       // As prop == bool only one set of these is needed
       inline static void precondition(const bool b) { assert(b); return; }
@@ -407,6 +408,26 @@ namespace symfpu {
 }
 
 
+#include "symfpu/core/operations.h"
+
+namespace symfpu {
+
+  // Reduces x * 2^(difference - 1) modulo y directly rather than
+  // building one divide step for each possible exponent difference
+  template <>
+    simpleExecutable::traits::ubv remainderDivideSteps<simpleExecutable::traits> (const simpleExecutable::traits::ubv &x,
+										   const simpleExecutable::traits::ubv &y,
+										   const simpleExecutable::traits::sbv &difference,
+										   const simpleExecutable::traits::bwt &maxDifference);
+
+  // Counts the leading zeros in one instruction rather than a shift
+  // stage for each bit of the shift amount
+  template <>
+    normaliseShiftResult<simpleExecutable::traits> normaliseShift<simpleExecutable::traits> (const simpleExecutable::traits::ubv input);
+
+}
+
+
 // For testing only; bitwise implementation is way slower for software
 #if 0
 #include "../core/operations.h"
@@ -0,0 +1,44 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+** 
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+** 
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** simpleExecutableInstantiations.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** The operations for the simple executable back-end are compiled once
+** into symfpu.a (see simpleExecutableInstantiations.cpp).  Including
+** this stops each user instantiating them again.  Define
+** SYMFPU_NO_EXTERN_TEMPLATES to instantiate them locally instead,
+** for example to allow them to be inlined.
+**
+*/
+
+#include "symfpu/baseTypes/simpleExecutable.h"
+#include "symfpu/core/instantiate.h"
+
+#ifndef SYMFPU_SIMPLE_EXECUTABLE_INSTANTIATIONS
+#define SYMFPU_SIMPLE_EXECUTABLE_INSTANTIATIONS
+
+#ifndef SYMFPU_NO_EXTERN_TEMPLATES
+SYMFPU_INSTANTIATE(extern template, symfpu::simpleExecutable::traits)
+SYMFPU_INSTANTIATE_SIGNED_CONVERSION(extern template, symfpu::simpleExecutable::traits)
+#endif
+
+#endif
@@ -0,0 +1,580 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** simplifying.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** Traits that wrap any other traits and simplify before passing
+** operations on.  Each value keeps its concrete value if it is known
+** (for bit-vectors, up to 64 bits) so operations on constants are
+** folded, ITEs with a known condition or the same branches are
+** collapsed and the usual Boolean identities are applied.  Comparisons
+** of a constant rounding mode are decided without reaching the inner
+** back-end at all.
+**
+** Values that are not constant carry an identifier, shared by copies,
+** with the negation of a proposition having the identifier next to
+** it.  This catches ITE(c, x, x), x && !x, x == x and so on without
+** needing to look inside the inner back-end's values.
+**
+*/
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <type_traits>
+
+// Symfpu headers
+#include "symfpu/core/ite.h"
+
+#ifndef SYMFPU_SIMPLIFYING
+#define SYMFPU_SIMPLIFYING
+
+namespace symfpu {
+  namespace simplifying {
+
+    // Even, so that the negation of a proposition is id ^ 1
+    inline uint64_t freshIdentifier (void) {
+      static std::atomic<uint64_t> next(2);
+      return next.fetch_add(2);
+    }
+
+    static const uint64_t noIdentifier = 0;
+
+
+    template <class inner> class proposition;
+    template <class inner> class roundingMode;
+    template <class inner, bool isSigned> class bitVector;
+
+
+    // Round-to-odd is only provided if the inner traits have it
+    template <class inner>
+    class innerHasRoundToOdd {
+      template <class u> static char test (decltype(&u::RTO));
+      template <class u> static long test (...);
+    public :
+      static const bool value = (sizeof(test<inner>(NULL)) == sizeof(char));
+    };
+
+    template <class inner, bool supported = innerHasRoundToOdd<inner>::value>
+    class roundToOdd {};
+
+    template <class inner>
+    class roundToOdd<inner, true> {
+    public :
+      static roundingMode<inner> RTO (void) { return roundingMode<inner>(inner::RTO(), 5); }
+    };
+
+
+    // Wrap up the types into one template parameter
+    template <class inner>
+    class traits : public roundToOdd<inner> {
+    public :
+      typedef typename inner::bwt bwt;
+      typedef roundingMode<inner> rm;
+      typedef typename inner::fpt fpt;
+      typedef proposition<inner> prop;
+      typedef bitVector<inner, true> sbv;
+      typedef bitVector<inner, false> ubv;
+
+      static rm RNE (void) { return rm(inner::RNE(), 0); }
+      static rm RNA (void) { return rm(inner::RNA(), 1); }
+      static rm RTP (void) { return rm(inner::RTP(), 2); }
+      static rm RTN (void) { return rm(inner::RTN(), 3); }
+      static rm RTZ (void) { return rm(inner::RTZ(), 4); }
+
+      inline static void precondition (const bool b) { inner::precondition(b); return; }
+      inline static void postcondition (const bool b) { inner::postcondition(b); return; }
+      inline static void invariant (const bool b) { inner::invariant(b); return; }
+
+      // Known properties are checked here, others are passed on
+      static void precondition (const prop &p) {
+	if (p.isKnown()) { inner::precondition(p.isTrue()); } else { inner::precondition(p.getInner()); }
+	return;
+      }
+      static void postcondition (const prop &p) {
+	if (p.isKnown()) { inner::postcondition(p.isTrue()); } else { inner::postcondition(p.getInner()); }
+	return;
+      }
+      static void invariant (const prop &p) {
+	if (p.isKnown()) { inner::invariant(p.isTrue()); } else { inner::invariant(p.getInner()); }
+	return;
+      }
+    };
+
+
+
+    template <class inner>
+    class proposition {
+    protected :
+      typedef typename inner::prop innerProp;
+
+      innerProp value;
+      int8_t known;          // -1 if not known, otherwise 0 or 1
+      uint64_t identifier;
+
+      friend ite<proposition<inner>, proposition<inner> >;   // For ITE
+
+      proposition (const innerProp &v, const uint64_t id) : value(v), known(-1), identifier(id) {}
+
+    public :
+      proposition (bool b) : value(b), known(b), identifier(noIdentifier) {}
+      proposition (const proposition<inner> &old) : value(old.value), known(old.known), identifier(old.identifier) {}
+
+      // Not a constructor as the inner proposition may be bool
+      static proposition<inner> fromInner (const innerProp &v) {
+	return proposition<inner>(v, freshIdentifier());
+      }
+
+      const innerProp & getInner (void) const { return value; }
+      bool isKnown (void) const { return known != -1; }
+      bool isTrue (void) const { return known == 1; }
+      bool isFalse (void) const { return known == 0; }
+      uint64_t getIdentifier (void) const { return identifier; }
+
+      proposition<inner> & operator = (const proposition<inner> &op) {
+	this->value = op.value;
+	this->known = op.known;
+	this->identifier = op.identifier;
+	return *this;
+      }
+
+      proposition<inner> operator ! (void) const {
+	if (this->isKnown()) return proposition<inner>(!this->isTrue());
+	return proposition<inner>(!value, identifier ^ 0x1);
+      }
+
+      proposition<inner> operator && (const proposition<inner> &op) const {
+	if (this->isFalse() || op.isFalse()) return proposition<inner>(false);
+	if (this->isTrue()) return op;
+	if (op.isTrue()) return *this;
+	if (identifier == op.identifier) return *this;
+	if (identifier == (op.identifier ^ 0x1)) return proposition<inner>(false);
+	return proposition<inner>(value && op.value, freshIdentifier());
+      }
+
+      proposition<inner> operator || (const proposition<inner> &op) const {
+	if (this->isTrue() || op.isTrue()) return proposition<inner>(true);
+	if (this->isFalse()) return op;
+	if (op.isFalse()) return *this;
+	if (identifier == op.identifier) return *this;
+	if (identifier == (op.identifier ^ 0x1)) return proposition<inner>(true);
+	return proposition<inner>(value || op.value, freshIdentifier());
+      }
+
+      proposition<inner> operator == (const proposition<inner> &op) const {
+	if (this->isKnown() && op.isKnown()) return proposition<inner>(known == op.known);
+	if (this->isKnown()) return this->isTrue() ? op : !op;
+	if (op.isKnown()) return op.isTrue() ? *this : !*this;
+	if (identifier == op.identifier) return proposition<inner>(true);
+	if (identifier == (op.identifier ^ 0x1)) return proposition<inner>(false);
+	return proposition<inner>(value == op.value, freshIdentifier());
+      }
+
+      proposition<inner> operator ^ (const proposition<inner> &op) const {
+	return !(*this == op);
+      }
+    };
+
+
+
+    // Modes are numbered RNE, RNA, RTP, RTN, RTZ, RTO
+    template <class inner>
+    class roundingMode {
+    protected :
+      typedef typename inner::rm innerRM;
+
+      innerRM value;
+      int8_t mode;           // -1 if not known
+      uint64_t identifier;
+
+      friend ite<proposition<inner>, roundingMode<inner> >;   // For ITE
+
+    public :
+      roundingMode (const innerRM &v, const int8_t m) : value(v), mode(m), identifier(noIdentifier) {}
+      explicit roundingMode (const innerRM &v) : value(v), mode(-1), identifier(freshIdentifier()) {}
+      roundingMode (const roundingMode<inner> &old) : value(old.value), mode(old.mode), identifier(old.identifier) {}
+
+      const innerRM & getInner (void) const { return value; }
+      bool isKnown (void) const { return mode != -1; }
+
+      roundingMode<inner> & operator = (const roundingMode<inner> &op) {
+	this->value = op.value;
+	this->mode = op.mode;
+	this->identifier = op.identifier;
+	return *this;
+      }
+
+      proposition<inner> operator == (const roundingMode<inner> &op) const {
+	if (this->isKnown() && op.isKnown()) return proposition<inner>(mode == op.mode);
+	if (!this->isKnown() && identifier == op.identifier) return proposition<inner>(true);
+	return proposition<inner>::fromInner(value == op.value);
+      }
+    };
+
+
+
+    // The value of a constant is kept in the low bits of known, which
+    // are sign extended for signed vectors
+    template <class inner, bool isSigned>
+    class bitVector {
+    protected :
+      typedef typename inner::bwt bwt;
+      typedef typename inner::prop innerProp;
+      typedef typename std::conditional<isSigned, typename inner::sbv, typename inner::ubv>::type innerBV;
+      typedef bitVector<inner, isSigned> bv;
+
+      innerBV value;
+      bool isKnown;
+      uint64_t known;
+      uint64_t identifier;
+
+      friend bitVector<inner, !isSigned>;    // To allow conversion between the types
+      friend ite<proposition<inner>, bv>;   // For ITE
+
+      static const bwt maximumKnownWidth = 64;
+
+      static uint64_t mask (const bwt w) {
+	return (w >= 64) ? ~0ULL : ((1ULL << w) - 1);
+      }
+
+      // What the inner constructor expects
+      static uint64_t normalise (const bwt w, const uint64_t v) {
+	uint64_t m = v & mask(w);
+	if (isSigned && w < 64 && ((m >> (w - 1)) & 0x1)) {
+	  m |= ~mask(w);
+	}
+	return m;
+      }
+
+      static bv constant (const bwt w, const uint64_t v) {
+	return bv(w, normalise(w, v));
+      }
+
+      static bv fromInner (const innerBV &v) {
+	return bv(v);
+      }
+
+      static int64_t asSigned (const bwt w, const uint64_t v) {
+	return bitVector<inner, true>::normalise(w, v);
+      }
+
+      bool isKnownValue (const uint64_t v) const {
+	return isKnown && ((known & mask(this->getWidth())) == (v & mask(this->getWidth())));
+      }
+
+      bool sameAs (const bv &op) const {
+	return (isKnown && op.isKnown) ? (known == op.known) :
+	  (!isKnown && !op.isKnown && identifier == op.identifier);
+      }
+
+    public :
+      bitVector (const bwt w, const uint64_t v) :
+	value(w, v), isKnown(w <= maximumKnownWidth), known(normalise(w, v)),
+	identifier((w <= maximumKnownWidth) ? noIdentifier : freshIdentifier()) {}
+      bitVector (const proposition<inner> &p) :
+	value(p.getInner()), isKnown(p.isKnown()), known(p.isTrue()),
+	identifier(p.isKnown() ? noIdentifier : freshIdentifier()) {}
+      explicit bitVector (const innerBV &v) : value(v), isKnown(false), known(0), identifier(freshIdentifier()) {}
+      bitVector (const bv &old) : value(old.value), isKnown(old.isKnown), known(old.known), identifier(old.identifier) {}
+
+      const innerBV & getInner (void) const { return value; }
+      bool isConstant (void) const { return isKnown; }
+      uint64_t constantValue (void) const { assert(isKnown); return known & mask(this->getWidth()); }
+
+      bwt getWidth (void) const { return value.getWidth(); }
+
+      bv & operator = (const bv &op) {
+	this->value = op.value;
+	this->isKnown = op.isKnown;
+	this->known = op.known;
+	this->identifier = op.identifier;
+	return *this;
+      }
+
+
+      /*** Constant creation and test ***/
+
+      static bv one (const bwt &w) { return bv(w, 1); }
+      static bv zero (const bwt &w) { return bv(w, 0); }
+      static bv allOnes (const bwt &w) {
+	return (w <= maximumKnownWidth) ? constant(w, ~0ULL) : fromInner(innerBV::allOnes(w));
+      }
+
+      inline proposition<inner> isAllOnes() const {
+	if (isKnown) return proposition<inner>(this->isKnownValue(~0ULL));
+	return proposition<inner>::fromInner(value.isAllOnes());
+      }
+      inline proposition<inner> isAllZeros() const {
+	if (isKnown) return proposition<inner>(this->isKnownValue(0));
+	return proposition<inner>::fromInner(value.isAllZeros());
+      }
+
+      static bv maxValue (const bwt &w) {
+	if (w > maximumKnownWidth) return fromInner(innerBV::maxValue(w));
+	return constant(w, isSigned ? mask(w - 1) : mask(w));
+      }
+
+      static bv minValue (const bwt &w) {
+	if (w > maximumKnownWidth) return fromInner(innerBV::minValue(w));
+	return constant(w, isSigned ? (1ULL << (w - 1)) : 0);
+      }
+
+
+      /*** Operators ***/
+
+      // Fold if both are known, otherwise pass on
+#define SIMPLIFYINGBINARY(OP, FOLD)					\
+      inline bv operator OP (const bv &op) const {			\
+	if (isKnown && op.isKnown) {					\
+	  bwt w(this->getWidth());					\
+	  uint64_t a = known & mask(w);					\
+	  uint64_t b = op.known & mask(w);				\
+	  (void)a; (void)b;						\
+	  FOLD;								\
+	}								\
+	return fromInner(value OP op.value);				\
+      }
+
+      // Shifts and divisions are only folded where the result does
+      // not depend on how the inner back-end handles edge cases
+      SIMPLIFYINGBINARY(<<, if (b < w) return constant(w, a << b))
+      SIMPLIFYINGBINARY(>>, if (b < w) return constant(w, isSigned ? (uint64_t)(asSigned(w, a) >> b) : a >> b))
+      SIMPLIFYINGBINARY(|, return constant(w, a | b))
+      SIMPLIFYINGBINARY(&, return constant(w, a & b))
+      SIMPLIFYINGBINARY(+, return constant(w, a + b))
+      SIMPLIFYINGBINARY(-, return constant(w, a - b))
+      SIMPLIFYINGBINARY(*, return constant(w, a * b))
+      SIMPLIFYINGBINARY(/, if (b != 0 && !isSigned) return constant(w, a / b))
+      SIMPLIFYINGBINARY(%, if (b != 0 && !isSigned) return constant(w, a % b))
+
+#undef SIMPLIFYINGBINARY
+
+      inline bv operator - (void) const {
+	if (isKnown) return constant(this->getWidth(), -known);
+	return fromInner(-value);
+      }
+
+      inline bv operator ~ (void) const {
+	if (isKnown) return constant(this->getWidth(), ~known);
+	return fromInner(~value);
+      }
+
+      inline bv increment () const {
+	if (isKnown) return constant(this->getWidth(), known + 1);
+	return fromInner(value.increment());
+      }
+
+      inline bv decrement () const {
+	if (isKnown) return constant(this->getWidth(), known - 1);
+	return fromInner(value.decrement());
+      }
+
+      inline bv signExtendRightShift (const bv &op) const {
+	if (op.isKnownValue(0)) return *this;
+	if (isKnown && op.isKnown && (!isSigned || asSigned(this->getWidth(), op.known) >= 0)) {
+	  bwt w(this->getWidth());
+	  uint64_t b = op.known & mask(w);
+	  return constant(w, (uint64_t)(asSigned(w, known) >> ((b < w) ? b : w - 1)));
+	}
+	return fromInner(value.signExtendRightShift(op.value));
+      }
+
+
+      /*** Modular opertaions ***/
+      inline bv modularLeftShift (const bv &op) const {
+	if (op.isKnownValue(0)) return *this;
+	if (isKnown && op.isKnown) {
+	  bwt w(this->getWidth());
+	  uint64_t b = op.known & mask(w);
+	  return (b < w) ? constant(w, known << b) : zero(w);
+	}
+	return fromInner(value.modularLeftShift(op.value));
+      }
+
+      inline bv modularRightShift (const bv &op) const {
+	if (op.isKnownValue(0)) return *this;
+	if (isKnown && op.isKnown && (op.known & mask(this->getWidth())) < this->getWidth()) return *this >> op;
+	return fromInner(value.modularRightShift(op.value));
+      }
+
+      inline bv modularIncrement () const {
+	if (isKnown) return this->increment();
+	return fromInner(value.modularIncrement());
+      }
+
+      inline bv modularDecrement () const {
+	if (isKnown) return this->decrement();
+	return fromInner(value.modularDecrement());
+      }
+
+      inline bv modularAdd (const bv &op) const {
+	if (op.isKnownValue(0)) return *this;
+	if (this->isKnownValue(0)) return op;
+	if (isKnown && op.isKnown) return *this + op;
+	return fromInner(value.modularAdd(op.value));
+      }
+
+      inline bv modularNegate () const {
+	if (isKnown) return -(*this);
+	return fromInner(value.modularNegate());
+      }
+
+
+      /*** Comparisons ***/
+
+#define SIMPLIFYINGCOMPARE(OP, REFLEXIVE)				\
+      inline proposition<inner> operator OP (const bv &op) const {	\
+	if (isKnown && op.isKnown) {					\
+	  bwt w(this->getWidth());					\
+	  return isSigned ?						\
+	    proposition<inner>(asSigned(w, known) OP asSigned(w, op.known)) : \
+	    proposition<inner>((known & mask(w)) OP (op.known & mask(w))); \
+	}								\
+	if (this->sameAs(op)) return proposition<inner>(REFLEXIVE);	\
+	return proposition<inner>::fromInner(value OP op.value);	\
+      }
+
+      SIMPLIFYINGCOMPARE(==, true)
+      SIMPLIFYINGCOMPARE(<=, true)
+      SIMPLIFYINGCOMPARE(>=, true)
+      SIMPLIFYINGCOMPARE(<, false)
+      SIMPLIFYINGCOMPARE(>, false)
+
+#undef SIMPLIFYINGCOMPARE
+
+
+      /*** Type conversion ***/
+      // The bits are the same so what is known is kept
+      bitVector<inner, true> toSigned (void) const {
+	bitVector<inner, true> result(value.toSigned());
+	result.isKnown = isKnown;
+	result.known = isKnown ? bitVector<inner, true>::normalise(this->getWidth(), known) : 0;
+	result.identifier = identifier;
+	return result;
+      }
+      bitVector<inner, false> toUnsigned (void) const {
+	bitVector<inner, false> result(value.toUnsigned());
+	result.isKnown = isKnown;
+	result.known = isKnown ? bitVector<inner, false>::normalise(this->getWidth(), known) : 0;
+	result.identifier = identifier;
+	return result;
+      }
+
+
+      /*** Bit hacks ***/
+
+      inline bv extend (bwt extension) const {
+	if (extension == 0) return *this;
+	if (isKnown && this->getWidth() + extension <= maximumKnownWidth) {
+	  // known is already sign extended if needed
+	  return constant(this->getWidth() + extension, known);
+	}
+	return fromInner(value.extend(extension));
+      }
+
+      inline bv contract (bwt reduction) const {
+	if (reduction == 0) return *this;
+	if (isKnown) return constant(this->getWidth() - reduction, known);
+	return fromInner(value.contract(reduction));
+      }
+
+      inline bv resize (bwt newSize) const {
+	bwt width = this->getWidth();
+
+	if (newSize > width) {
+	  return this->extend(newSize - width);
+	} else if (newSize < width) {
+	  return this->contract(width - newSize);
+	} else {
+	  return *this;
+	}
+      }
+
+      inline bv matchWidth (const bv &op) const {
+	assert(this->getWidth() <= op.getWidth());
+	return this->extend(op.getWidth() - this->getWidth());
+      }
+
+      // this is the high part of the result
+      bv append (const bv &op) const {
+	bwt width = this->getWidth() + op.getWidth();
+	if (isKnown && op.isKnown && width <= maximumKnownWidth) {
+	  return constant(width, (known << op.getWidth()) | (op.known & mask(op.getWidth())));
+	}
+	return fromInner(value.append(op.value));
+      }
+
+      // Inclusive of end points, thus if the same, extracts just one bit
+      bv extract (bwt upper, bwt lower) const {
+	if (lower == 0 && upper + 1 == this->getWidth()) return *this;
+	if (isKnown) return constant(upper - lower + 1, known >> lower);
+	return fromInner(value.extract(upper, lower));
+      }
+    };
+
+  }
+
+
+  template <class inner>
+  struct ite<simplifying::proposition<inner>, simplifying::proposition<inner> > {
+    static const simplifying::proposition<inner> iteOp (const simplifying::proposition<inner> &cond,
+							const simplifying::proposition<inner> &l,
+							const simplifying::proposition<inner> &r) {
+      if (cond.isKnown()) return cond.isTrue() ? l : r;
+      if (l.isKnown() && r.isKnown()) {
+	if (l.known == r.known) return l;
+	return l.isTrue() ? cond : !cond;
+      }
+      if (!l.isKnown() && !r.isKnown() && l.identifier == r.identifier) return l;
+      return simplifying::proposition<inner>(ITE(cond.value, l.value, r.value),
+					     simplifying::freshIdentifier());
+    }
+  };
+
+  template <class inner>
+  struct ite<simplifying::proposition<inner>, simplifying::roundingMode<inner> > {
+    static const simplifying::roundingMode<inner> iteOp (const simplifying::proposition<inner> &cond,
+							 const simplifying::roundingMode<inner> &l,
+							 const simplifying::roundingMode<inner> &r) {
+      if (cond.isKnown()) return cond.isTrue() ? l : r;
+      if (l.isKnown() ? (l.mode == r.mode) : (!r.isKnown() && l.identifier == r.identifier)) return l;
+      return simplifying::roundingMode<inner>(ITE(cond.getInner(), l.value, r.value));
+    }
+  };
+
+  template <class inner, bool isSigned>
+  struct ite<simplifying::proposition<inner>, simplifying::bitVector<inner, isSigned> > {
+    typedef simplifying::bitVector<inner, isSigned> bv;
+
+    static const bv iteOp (const simplifying::proposition<inner> &cond,
+			   const bv &l,
+			   const bv &r) {
+      if (cond.isKnown()) return cond.isTrue() ? l : r;
+      if (l.sameAs(r)) return l;
+      return bv::fromInner(ITE(cond.getInner(), l.value, r.value));
+    }
+  };
+
+}
+
+#endif
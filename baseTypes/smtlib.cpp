@@ -0,0 +1,649 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** smtlib.cpp
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** The term table, folding and printing for the SMT-LIB back-end.
+**
+*/
+
+#include "symfpu/baseTypes/smtlib.h"
+
+#include <algorithm>
+
+namespace symfpu {
+  namespace smtlib {
+
+    /*** Nodes ***/
+
+    bool dag::node::operator == (const node &n) const {
+      return op == n.op && width == n.width &&
+	arguments[0] == n.arguments[0] &&
+	arguments[1] == n.arguments[1] &&
+	arguments[2] == n.arguments[2] &&
+	value == n.value && parameter == n.parameter;
+    }
+
+    size_t dag::hasher::operator() (const node &n) const {
+      uint64_t h = (((uint64_t)n.op) << 56) ^ (((uint64_t)n.width) << 32) ^ n.parameter;
+      for (int i = 0; i < 3; ++i) {
+	h = (h ^ n.arguments[i]) * 0x9e3779b97f4a7c15ULL;
+	h ^= h >> 29;
+      }
+      h = (h ^ n.value) * 0xbf58476d1ce4e5b9ULL;
+      h ^= h >> 32;
+      return (size_t)h;
+    }
+
+    static const char * operationName (const operation op) {
+      switch (op) {
+      case NOT : return "not";
+      case AND : return "and";
+      case OR : return "or";
+      case XOR : return "xor";
+      case EQUAL : return "=";
+      case ITE : return "ite";
+      case BVNOT : return "bvnot";
+      case BVNEG : return "bvneg";
+      case BVAND : return "bvand";
+      case BVOR : return "bvor";
+      case BVADD : return "bvadd";
+      case BVSUB : return "bvsub";
+      case BVMUL : return "bvmul";
+      case BVUDIV : return "bvudiv";
+      case BVUREM : return "bvurem";
+      case BVSDIV : return "bvsdiv";
+      case BVSREM : return "bvsrem";
+      case BVSHL : return "bvshl";
+      case BVLSHR : return "bvlshr";
+      case BVASHR : return "bvashr";
+      case BVULT : return "bvult";
+      case BVULE : return "bvule";
+      case BVSLT : return "bvslt";
+      case BVSLE : return "bvsle";
+      case CONCAT : return "concat";
+      case EXTRACT : return "extract";
+      case ZERO_EXTEND : return "zero_extend";
+      case SIGN_EXTEND : return "sign_extend";
+      default : assert(0); return "";
+      }
+    }
+
+    static bool isCommutative (const operation op) {
+      return op == AND || op == OR || op == XOR || op == EQUAL ||
+	op == BVAND || op == BVOR || op == BVADD || op == BVMUL;
+    }
+
+
+
+    /*** The table ***/
+
+    dag::dag () {
+      nodes.reserve(1024);
+    }
+
+    term dag::make (const node &n) {
+      std::unordered_map<node, term, hasher>::const_iterator it(structuralHash.find(n));
+      if (it != structuralHash.end()) {
+	return it->second;
+      }
+
+      term index = nodes.size();
+      assert(index < noTerm);
+
+      nodes.push_back(n);
+      structuralHash.insert(std::make_pair(n, index));
+
+      return index;
+    }
+
+    term dag::constant (const bitWidthType width, const uint64_t low, const bool fill) {
+      node n;
+      n.op = CONSTANT;
+      n.width = width;
+      n.arguments[0] = n.arguments[1] = n.arguments[2] = noTerm;
+
+      if (width == 0) {
+	n.value = low & 0x1;
+	n.parameter = 0;
+      } else if (width < 64) {
+	n.value = low & ((1ULL << width) - 1);
+	n.parameter = 0;
+      } else if (width == 64) {
+	n.value = low;
+	n.parameter = 0;
+      } else {
+	n.value = low;
+	n.parameter = fill;
+      }
+
+      return make(n);
+    }
+
+    term dag::variable (const bitWidthType width, const std::string &name) {
+      node n;
+      n.op = VARIABLE;
+      n.width = width;
+      n.arguments[0] = n.arguments[1] = n.arguments[2] = noTerm;
+      n.value = 0;
+      n.parameter = variableNames.size();
+
+      variableNames.push_back(name.empty() ? "symfpu_input" + std::to_string(variables.size()) : name);
+      term v = make(n);
+      variables.push_back(v);
+
+      return v;
+    }
+
+    bool dag::bit (const term t, const bitWidthType i) const {
+      const node &n = nodes[t];
+      assert(n.op == CONSTANT);
+      return (i < 64) ? ((n.value >> i) & 0x1) : (n.parameter != 0);
+    }
+
+    bool dag::isConstantValue (const term t, const uint64_t low, const bool fill) const {
+      const node &n = nodes[t];
+      if (n.op != CONSTANT) return false;
+
+      bitWidthType w = n.width;
+      if (w > 64) {
+	return n.value == low && (n.parameter != 0) == fill;
+      } else {
+	uint64_t mask = (w == 64) ? ~0ULL : ((1ULL << w) - 1);
+	return n.value == (low & mask);
+      }
+    }
+
+    // Constants with more than 64 bits are kept when the higher bits
+    // are all the same, otherwise noTerm
+    term dag::constantFromBits (const bitWidthType width, const node &n) {
+      uint64_t low = 0;
+      bool fill = false;
+
+      #define RESULTBIT(I) ((n.op == CONCAT) ?				\
+			    (((I) < nodes[n.arguments[1]].width) ?	\
+			     bit(n.arguments[1], (I)) :			\
+			     bit(n.arguments[0], (I) - nodes[n.arguments[1]].width)) : \
+			    (n.op == EXTRACT) ?				\
+			    bit(n.arguments[0], (I) + n.value) :		\
+			    ((I) < nodes[n.arguments[0]].width) ?		\
+			    bit(n.arguments[0], (I)) :			\
+			    ((n.op == SIGN_EXTEND) && bit(n.arguments[0], nodes[n.arguments[0]].width - 1)))
+
+      for (bitWidthType i = 0; i < width && i < 64; ++i) {
+	low |= ((uint64_t)RESULTBIT(i)) << i;
+      }
+
+      if (width > 64) {
+	fill = RESULTBIT(64);
+	for (bitWidthType i = 65; i < width; ++i) {
+	  if (RESULTBIT(i) != fill) {
+	    return noTerm;
+	  }
+	}
+      }
+
+      #undef RESULTBIT
+
+      return constant(width, low, fill);
+    }
+
+    static inline int64_t signExtend (const uint64_t v, const bitWidthType w) {
+      return (w == 64) ? (int64_t)v : (((int64_t)(v << (64 - w))) >> (64 - w));
+    }
+
+    // Returns noTerm if n can not be simplified
+    term dag::fold (const node &n) {
+      const term a = n.arguments[0];
+      const term b = n.arguments[1];
+      const term c = n.arguments[2];
+
+      bool aConstant = (a != noTerm) && isConstant(a);
+      bool bConstant = (b != noTerm) && isConstant(b);
+      bitWidthType w = (a != noTerm) ? nodes[a].width : 0;
+
+      switch (n.op) {
+
+	/*** Bool ***/
+      case NOT :
+	if (aConstant) return boolean(!nodes[a].value);
+	if (nodes[a].op == NOT) return nodes[a].arguments[0];
+	return noTerm;
+
+      case AND :
+      case OR : {
+	bool isAnd = (n.op == AND);
+	if (aConstant) return (nodes[a].value == isAnd) ? b : a;
+	if (bConstant) return (nodes[b].value == isAnd) ? a : b;
+	if (a == b) return a;
+	if ((nodes[a].op == NOT && nodes[a].arguments[0] == b) ||
+	    (nodes[b].op == NOT && nodes[b].arguments[0] == a)) {
+	  return boolean(!isAnd);
+	}
+	return noTerm;
+      }
+
+      case XOR :
+	if (aConstant) return nodes[a].value ? apply(NOT, b) : b;
+	if (bConstant) return nodes[b].value ? apply(NOT, a) : a;
+	if (a == b) return boolean(false);
+	return noTerm;
+
+      case EQUAL :
+	if (a == b) return boolean(true);
+	if (aConstant && bConstant) return boolean(false);   // As they are hash-consed
+	if (w == 0 && aConstant) return nodes[a].value ? b : apply(NOT, b);
+	if (w == 0 && bConstant) return nodes[b].value ? a : apply(NOT, a);
+	return noTerm;
+
+      case ITE :
+	if (aConstant) return nodes[a].value ? b : c;
+	if (b == c) return b;
+	if (nodes[b].width == 0 && bConstant && isConstant(c)) {
+	  return nodes[b].value ? a : apply(NOT, a);    // As b != c
+	}
+	if (nodes[a].op == NOT) return apply(ITE, nodes[a].arguments[0], c, b);
+	return noTerm;
+
+
+	/*** Structure ***/
+      case CONCAT :
+      case EXTRACT :
+      case ZERO_EXTEND :
+      case SIGN_EXTEND :
+	if (aConstant && (n.op != CONCAT || bConstant)) {
+	  return constantFromBits(n.width, n);
+	}
+	if (n.op == EXTRACT && n.value == 0 && n.parameter == w - 1) return a;
+	if (n.op == EXTRACT && nodes[a].op == EXTRACT) {
+	  return extract(nodes[a].arguments[0],
+			 n.parameter + nodes[a].value,
+			 n.value + nodes[a].value);
+	}
+	if ((n.op == ZERO_EXTEND || n.op == SIGN_EXTEND) && n.parameter == 0) return a;
+	return noTerm;
+
+
+	/*** Bitwise, at any width ***/
+      case BVNOT :
+	if (aConstant) return constant(w, ~nodes[a].value, !nodes[a].parameter);
+	if (nodes[a].op == BVNOT) return nodes[a].arguments[0];
+	return noTerm;
+
+      case BVAND :
+      case BVOR : {
+	bool isAnd = (n.op == BVAND);
+	if (aConstant && bConstant) {
+	  return isAnd ?
+	    constant(w, nodes[a].value & nodes[b].value, nodes[a].parameter && nodes[b].parameter) :
+	    constant(w, nodes[a].value | nodes[b].value, nodes[a].parameter || nodes[b].parameter);
+	}
+	for (int i = 0; i < 2; ++i) {
+	  term x = (i == 0) ? a : b;
+	  term y = (i == 0) ? b : a;
+	  if (isConstantValue(x, 0, false)) return isAnd ? x : y;
+	  if (isConstantValue(x, ~0ULL, true)) return isAnd ? y : x;
+	}
+	if (a == b) return a;
+	return noTerm;
+      }
+
+      default :
+	break;
+      }
+
+
+      /*** Arithmetic ***/
+      if (bConstant && isConstantValue(b, 0, false)) {
+	switch (n.op) {
+	case BVADD :
+	case BVSUB :
+	case BVSHL :
+	case BVLSHR :
+	case BVASHR :
+	  return a;
+	default :
+	  break;
+	}
+      }
+      if (aConstant && isConstantValue(a, 0, false) && n.op == BVADD) {
+	return b;
+      }
+
+      if (!aConstant || (b != noTerm && !bConstant) || w > 64) {
+	return noTerm;
+      }
+
+      uint64_t mask = (w == 64) ? ~0ULL : ((1ULL << w) - 1);
+      uint64_t va = nodes[a].value;
+      uint64_t vb = (b != noTerm) ? nodes[b].value : 0;
+      int64_t sa = signExtend(va, w);
+      int64_t sb = signExtend(vb, w);
+      uint64_t ua = (sa < 0) ? -(uint64_t)sa : (uint64_t)sa;
+      uint64_t ub = (sb < 0) ? -(uint64_t)sb : (uint64_t)sb;
+
+      switch (n.op) {
+      case BVNEG : return constant(w, -va, false);
+      case BVADD : return constant(w, va + vb, false);
+      case BVSUB : return constant(w, va - vb, false);
+      case BVMUL : return constant(w, va * vb, false);
+      case BVUDIV : return constant(w, (vb == 0) ? mask : va / vb, false);
+      case BVUREM : return constant(w, (vb == 0) ? va : va % vb, false);
+      case BVSDIV :
+	if (vb == 0) return constant(w, (sa < 0) ? 1 : mask, false);
+	return constant(w, ((sa < 0) != (sb < 0)) ? -(ua / ub) : (ua / ub), false);
+      case BVSREM :
+	if (vb == 0) return constant(w, va, false);
+	return constant(w, (sa < 0) ? -(ua % ub) : (ua % ub), false);
+      case BVSHL : return constant(w, (vb >= w) ? 0 : va << vb, false);
+      case BVLSHR : return constant(w, (vb >= w) ? 0 : va >> vb, false);
+      case BVASHR : return constant(w, (uint64_t)((vb >= w) ? ((sa < 0) ? -1 : 0) : (sa >> vb)), false);
+      case BVULT : return boolean(va < vb);
+      case BVULE : return boolean(va <= vb);
+      case BVSLT : return boolean(sa < sb);
+      case BVSLE : return boolean(sa <= sb);
+      default :
+	assert(0);
+	return noTerm;
+      }
+    }
+
+    term dag::apply (const operation op, const term a) {
+      return apply(op, a, noTerm, noTerm);
+    }
+
+    term dag::apply (const operation op, const term a, const term b) {
+      return apply(op, a, b, noTerm);
+    }
+
+    term dag::apply (const operation op, const term a, const term b, const term c) {
+      node n;
+      n.op = op;
+      n.arguments[0] = a;
+      n.arguments[1] = b;
+      n.arguments[2] = c;
+      n.value = 0;
+      n.parameter = 0;
+
+      if (isCommutative(op) && a > b) {
+	std::swap(n.arguments[0], n.arguments[1]);
+      }
+
+      switch (op) {
+      case NOT :
+      case AND :
+      case OR :
+      case XOR :
+	assert(nodes[a].width == 0);
+	n.width = 0;
+	break;
+
+      case EQUAL :
+      case BVULT :
+      case BVULE :
+      case BVSLT :
+      case BVSLE :
+	assert(nodes[a].width == nodes[b].width);
+	n.width = 0;
+	break;
+
+      case ITE :
+	assert(nodes[a].width == 0);
+	assert(nodes[b].width == nodes[c].width);
+	n.width = nodes[b].width;
+	break;
+
+      case CONCAT :
+	n.width = nodes[a].width + nodes[b].width;
+	break;
+
+      default :
+	assert(nodes[a].width > 0);
+	assert(b == noTerm || nodes[a].width == nodes[b].width);
+	n.width = nodes[a].width;
+	break;
+      }
+
+      term folded = fold(n);
+      return (folded != noTerm) ? folded : make(n);
+    }
+
+    term dag::extract (const term a, const bitWidthType upper, const bitWidthType lower) {
+      assert(lower <= upper && upper < nodes[a].width);
+
+      node n;
+      n.op = EXTRACT;
+      n.width = upper - lower + 1;
+      n.arguments[0] = a;
+      n.arguments[1] = n.arguments[2] = noTerm;
+      n.value = lower;
+      n.parameter = upper;
+
+      term folded = fold(n);
+      return (folded != noTerm) ? folded : make(n);
+    }
+
+    term dag::extend (const operation op, const term a, const bitWidthType amount) {
+      assert(op == ZERO_EXTEND || op == SIGN_EXTEND);
+
+      node n;
+      n.op = op;
+      n.width = nodes[a].width + amount;
+      n.arguments[0] = a;
+      n.arguments[1] = n.arguments[2] = noTerm;
+      n.value = 0;
+      n.parameter = amount;
+
+      term folded = fold(n);
+      return (folded != noTerm) ? folded : make(n);
+    }
+
+
+
+    /*** Printing ***/
+
+    static void writeSymbol (std::ostream &out, const std::string &s) {
+      bool simple = !s.empty() && !(s[0] >= '0' && s[0] <= '9');
+      for (size_t i = 0; i < s.size() && simple; ++i) {
+	char c = s[i];
+	simple = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+	  (std::string("~!@$%^&*_-+=<>.?/").find(c) != std::string::npos);
+      }
+
+      if (simple) {
+	out << s;
+      } else {
+	out << "|" << s << "|";
+      }
+    }
+
+    static void writeSort (std::ostream &out, const bitWidthType width) {
+      if (width == 0) {
+	out << "Bool";
+      } else {
+	out << "(_ BitVec " << width << ")";
+      }
+    }
+
+    void dag::writeTerm (std::ostream &out, const term t,
+			 const std::vector<bool> &inlined) const {
+      const node &n = nodes[t];
+
+      if (n.op == CONSTANT) {
+	if (n.width == 0) {
+	  out << (n.value ? "true" : "false");
+	} else {
+	  out << "#b";
+	  for (bitWidthType i = n.width; i > 0; --i) {
+	    out << (bit(t, i - 1) ? '1' : '0');
+	  }
+	}
+
+      } else if (n.op == VARIABLE) {
+	writeSymbol(out, variableNames[n.parameter]);
+
+      } else if (!inlined[t]) {
+	out << "symfpu_" << t;
+
+      } else {
+	out << "(";
+	if (n.op == EXTRACT) {
+	  out << "(_ extract " << n.parameter << " " << n.value << ")";
+	} else if (n.op == ZERO_EXTEND || n.op == SIGN_EXTEND) {
+	  out << "(_ " << operationName(n.op) << " " << n.parameter << ")";
+	} else {
+	  out << operationName(n.op);
+	}
+
+	for (int i = 0; i < 3 && n.arguments[i] != noTerm; ++i) {
+	  out << " ";
+	  writeTerm(out, n.arguments[i], inlined);
+	}
+	out << ")";
+      }
+
+      return;
+    }
+
+    void dag::writeSMTLIB (std::ostream &out,
+			   const std::vector<term> &outputs,
+			   const std::vector<std::string> &outputNames) const {
+      assert(outputNames.empty() || outputNames.size() == outputs.size());
+
+      // Arguments are always made before the terms that use them so
+      // going down the indices reaches every term after its users
+      std::vector<uint32_t> uses(nodes.size(), 0);
+      for (size_t i = 0; i < outputs.size(); ++i) {
+	++uses[outputs[i]];
+      }
+      for (size_t i = nodes.size(); i > 0; --i) {
+	const node &n = nodes[i - 1];
+	if (uses[i - 1] > 0 && n.op != CONSTANT && n.op != VARIABLE) {
+	  for (int j = 0; j < 3 && n.arguments[j] != noTerm; ++j) {
+	    ++uses[n.arguments[j]];
+	  }
+	}
+      }
+
+      // Terms used once are written in place, unless this makes the
+      // nesting too deep for parsers that recurse
+      static const uint32_t maximumDepth = 32;
+      std::vector<bool> inlined(nodes.size(), false);
+      std::vector<uint32_t> depth(nodes.size(), 0);
+
+      for (size_t i = 0; i < nodes.size(); ++i) {
+	const node &n = nodes[i];
+	if (uses[i] == 0 || n.op == CONSTANT || n.op == VARIABLE) continue;
+
+	uint32_t d = 0;
+	for (int j = 0; j < 3 && n.arguments[j] != noTerm; ++j) {
+	  if (inlined[n.arguments[j]]) {
+	    d = std::max(d, depth[n.arguments[j]]);
+	  }
+	}
+	depth[i] = d + 1;
+	inlined[i] = (uses[i] == 1) && (depth[i] < maximumDepth);
+      }
+
+
+      out << "(set-logic QF_BV)\n";
+
+      for (size_t i = 0; i < variables.size(); ++i) {
+	out << "(declare-fun ";
+	writeSymbol(out, variableNames[nodes[variables[i]].parameter]);
+	out << " () ";
+	writeSort(out, nodes[variables[i]].width);
+	out << ")\n";
+      }
+
+      for (size_t i = 0; i < nodes.size(); ++i) {
+	const node &n = nodes[i];
+	if (uses[i] == 0 || inlined[i] || n.op == CONSTANT || n.op == VARIABLE) continue;
+
+	out << "(define-fun symfpu_" << i << " () ";
+	writeSort(out, n.width);
+	out << " ";
+
+	// Write the definition rather than the name
+	std::vector<bool>::reference self(inlined[i]);
+	self = true;
+	writeTerm(out, i, inlined);
+	self = false;
+
+	out << ")\n";
+      }
+
+      for (size_t i = 0; i < outputs.size(); ++i) {
+	out << "(define-fun ";
+	writeSymbol(out, (outputNames.empty() || outputNames[i].empty()) ?
+		    "symfpu_output" + std::to_string(i) : outputNames[i]);
+	out << " () ";
+	writeSort(out, nodes[outputs[i]].width);
+	out << " ";
+	writeTerm(out, outputs[i], inlined);
+	out << ")\n";
+      }
+
+      return;
+    }
+
+
+
+    /*** The current table ***/
+
+    static thread_local dag *current = NULL;
+
+    dag & currentDAG (void) {
+      assert(current != NULL);
+      return *current;
+    }
+
+    scope::scope (dag &d) : previous(current) {
+      current = &d;
+    }
+
+    scope::~scope () {
+      current = previous;
+    }
+
+
+
+    /*** Traits ***/
+
+    roundingMode traits::RNE (void) { return roundingMode(0); }
+    roundingMode traits::RNA (void) { return roundingMode(1); }
+    roundingMode traits::RTP (void) { return roundingMode(2); }
+    roundingMode traits::RTN (void) { return roundingMode(3); }
+    roundingMode traits::RTZ (void) { return roundingMode(4); }
+    roundingMode traits::RTO (void) { return roundingMode(5); }
+
+    static bool isFalse (const proposition &p) {
+      dag &d = currentDAG();
+      return d.isConstant(p.getTerm()) && d.constantValue(p.getTerm()) == 0;
+    }
+
+    void traits::precondition (const prop &p) { assert(!isFalse(p)); return; }
+    void traits::postcondition (const prop &p) { assert(!isFalse(p)); return; }
+    void traits::invariant (const prop &p) { assert(!isFalse(p)); return; }
+
+  }
+}
@@ -0,0 +1,579 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** smtlib.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** A word-level back-end that builds SMT-LIB QF_BV terms without
+** needing a solver.  Terms are held in one hash-consed table and
+** referred to by 32-bit indices.  Operations on constants are folded
+** (fully up to 64 bits, bitwise and structurally above that) and a few
+** identities are applied as terms are made.
+**
+** The terms for a set of outputs can be written as an SMT-LIB2 script
+** where each shared subterm is given once by a define-fun.  QF_BV has
+** no rounding mode sort so these are 3-bit vectors, see
+** roundingMode::valid().
+**
+** Operations add to the table given by the innermost smtlib::scope.
+**
+*/
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Symfpu headers
+#include "symfpu/utils/properties.h"
+#include "symfpu/core/ite.h"
+#include "symfpu/baseTypes/shared.h"
+
+#ifndef SYMFPU_SMTLIB
+#define SYMFPU_SMTLIB
+
+namespace symfpu {
+  namespace smtlib {
+
+    typedef symfpu::shared::bitWidthType bitWidthType;
+    typedef symfpu::shared::floatingPointTypeInfo floatingPointTypeInfo;
+
+    // An index into the table
+    typedef uint32_t term;
+
+    enum operation {
+      CONSTANT, VARIABLE,
+
+      // Bool
+      NOT, AND, OR, XOR, EQUAL, ITE,
+
+      // Bit-vector
+      BVNOT, BVNEG, BVAND, BVOR,
+      BVADD, BVSUB, BVMUL, BVUDIV, BVUREM, BVSDIV, BVSREM,
+      BVSHL, BVLSHR, BVASHR,
+      BVULT, BVULE, BVSLT, BVSLE,
+      CONCAT, EXTRACT, ZERO_EXTEND, SIGN_EXTEND
+    };
+
+
+    class dag {
+    protected :
+      // Width 0 is Bool.  Constants keep the low 64 bits in value and
+      // the value of all higher bits in parameter, extract keeps the
+      // lower index in value and the upper in parameter, extensions
+      // keep the amount in parameter and variables keep the index of
+      // their name.
+      struct node {
+	operation op;
+	bitWidthType width;
+	term arguments[3];
+	uint64_t value;
+	uint32_t parameter;
+
+	bool operator == (const node &n) const;
+      };
+
+      struct hasher {
+	size_t operator() (const node &n) const;
+      };
+
+      static const term noTerm = 0xFFFFFFFF;
+
+      std::vector<node> nodes;
+      std::vector<std::string> variableNames;
+      std::vector<term> variables;
+      std::unordered_map<node, term, hasher> structuralHash;
+
+      term make (const node &n);
+      term fold (const node &n);
+      term constantFromBits (const bitWidthType width, const node &n);
+      bool bit (const term t, const bitWidthType i) const;
+      bool isConstantValue (const term t, const uint64_t low, const bool fill) const;
+
+      void writeTerm (std::ostream &out, const term t,
+		      const std::vector<bool> &inlined) const;
+
+    public :
+      dag ();
+
+      bitWidthType width (const term t) const { return nodes[t].width; }
+      bool isConstant (const term t) const { return nodes[t].op == CONSTANT; }
+      uint64_t constantValue (const term t) const {
+	assert(isConstant(t));
+	return nodes[t].value;
+      }
+
+      term constant (const bitWidthType width, const uint64_t low, const bool fill);
+      term boolean (const bool b) { return constant(0, b, false); }
+      term variable (const bitWidthType width, const std::string &name = std::string());
+
+      term apply (const operation op, const term a);
+      term apply (const operation op, const term a, const term b);
+      term apply (const operation op, const term a, const term b, const term c);
+      term extract (const term a, const bitWidthType upper, const bitWidthType lower);
+      term extend (const operation op, const term a, const bitWidthType amount);
+
+      size_t numberOfTerms (void) const { return nodes.size(); }
+      size_t numberOfVariables (void) const { return variables.size(); }
+
+      // Declares all of the variables, so the interface does not depend
+      // on the outputs, then defines the outputs.  Terms are written
+      // in place if they are only used once and otherwise given once,
+      // by a define-fun, before their first use.  The output is written
+      // as it is generated.
+      void writeSMTLIB (std::ostream &out,
+			const std::vector<term> &outputs,
+			const std::vector<std::string> &outputNames) const;
+    };
+
+
+    // The table that operations add to
+    dag & currentDAG (void);
+
+    class scope {
+    protected :
+      dag *previous;
+
+    public :
+      scope (dag &d);
+      ~scope ();
+    };
+
+
+
+    // Forward declarations
+    class roundingMode;
+    class proposition;
+    template <bool isSigned> class bitVector;
+
+    // Wrap up the types into one template parameter
+    class traits {
+    public :
+      typedef bitWidthType bwt;
+      typedef roundingMode rm;
+      typedef floatingPointTypeInfo fpt;
+      typedef proposition prop;
+      typedef bitVector< true> sbv;
+      typedef bitVector<false> ubv;
+
+      static roundingMode RNE (void);
+      static roundingMode RNA (void);
+      static roundingMode RTP (void);
+      static roundingMode RTN (void);
+      static roundingMode RTZ (void);
+      static roundingMode RTO (void);
+
+      // Literal invariants
+      inline static void precondition (const bool b) { assert(b); return; }
+      inline static void postcondition (const bool b) { assert(b); return; }
+      inline static void invariant (const bool b) { assert(b); return; }
+
+      // Symbolic invariants, only those that are known to fail are caught
+      static void precondition (const prop &p);
+      static void postcondition (const prop &p);
+      static void invariant (const prop &p);
+    };
+
+    // To simplify the property macros
+    typedef traits t;
+
+
+
+    class proposition {
+    protected :
+      term node;
+
+      friend ite<proposition, proposition>;   // For ITE
+
+    public :
+      proposition (bool v) : node(currentDAG().boolean(v)) {}
+      proposition (const proposition &old) : node(old.node) {}
+
+      static proposition fromTerm (const term t) {
+	proposition p(false);
+	p.node = t;
+	return p;
+      }
+      static proposition input (const std::string &name = std::string()) {
+	return fromTerm(currentDAG().variable(0, name));
+      }
+
+      term getTerm (void) const { return node; }
+
+      proposition & operator = (const proposition &op) {
+	this->node = op.node;
+	return *this;
+      }
+
+      proposition operator ! (void) const {
+	return fromTerm(currentDAG().apply(NOT, node));
+      }
+
+      proposition operator && (const proposition &op) const {
+	return fromTerm(currentDAG().apply(AND, node, op.node));
+      }
+
+      proposition operator || (const proposition &op) const {
+	return fromTerm(currentDAG().apply(OR, node, op.node));
+      }
+
+      proposition operator == (const proposition &op) const {
+	return fromTerm(currentDAG().apply(EQUAL, node, op.node));
+      }
+
+      proposition operator ^ (const proposition &op) const {
+	return fromTerm(currentDAG().apply(XOR, node, op.node));
+      }
+    };
+
+
+
+    // A 3-bit vector, in the order RNE, RNA, RTP, RTN, RTZ, RTO
+    class roundingMode {
+    protected :
+      term node;
+
+      friend ite<proposition, roundingMode>;   // For ITE
+
+    public :
+      static const bitWidthType width = 3;
+
+      roundingMode (const unsigned int mode) : node(currentDAG().constant(width, mode, false)) {
+	PRECONDITION(mode <= 5);
+      }
+      roundingMode (const roundingMode &old) : node(old.node) {}
+
+      static roundingMode fromTerm (const term t) {
+	roundingMode r(0);
+	r.node = t;
+	return r;
+      }
+      static roundingMode input (const std::string &name = std::string()) {
+	return fromTerm(currentDAG().variable(width, name));
+      }
+
+      term getTerm (void) const { return node; }
+
+      roundingMode & operator = (const roundingMode &op) {
+	this->node = op.node;
+	return *this;
+      }
+
+      // The other encodings match none of the modes so inputs should be
+      // constrained by this
+      proposition valid (void) const {
+	return proposition::fromTerm(currentDAG().apply(BVULE, node, currentDAG().constant(width, 5, false)));
+      }
+
+      proposition operator == (const roundingMode &op) const {
+	return proposition::fromTerm(currentDAG().apply(EQUAL, node, op.node));
+      }
+    };
+
+
+
+    template <bool isSigned>
+    class bitVector {
+    protected :
+      term node;
+
+      friend bitVector<!isSigned>;    // To allow conversion between the types
+      friend ite<proposition, bitVector<isSigned> >;   // For ITE
+
+      static bitVector<isSigned> fromTerm (const term t) {
+	bitVector<isSigned> b(1, 0);
+	b.node = t;
+	return b;
+      }
+
+      inline bitVector<isSigned> apply (const operation op, const bitVector<isSigned> &o) const {
+	PRECONDITION(this->getWidth() == o.getWidth());
+	return fromTerm(currentDAG().apply(op, node, o.node));
+      }
+
+      inline proposition compare (const operation op, const bitVector<isSigned> &o) const {
+	PRECONDITION(this->getWidth() == o.getWidth());
+	return proposition::fromTerm(currentDAG().apply(op, node, o.node));
+      }
+
+    public :
+      bitVector (const bitWidthType w, const uint64_t v) :
+        node(currentDAG().constant(w, v, isSigned && ((v >> 63) & 0x1))) {
+	PRECONDITION(w > 0);
+      }
+      bitVector (const proposition &p) :
+	node(currentDAG().apply(ITE, p.getTerm(),
+				currentDAG().constant(1, 1, false),
+				currentDAG().constant(1, 0, false))) {}
+      bitVector (const bitVector<isSigned> &old) : node(old.node) {}
+
+      static bitVector<isSigned> input (const bitWidthType w, const std::string &name = std::string()) {
+	PRECONDITION(w > 0);
+	return fromTerm(currentDAG().variable(w, name));
+      }
+
+      bitWidthType getWidth (void) const {
+	return currentDAG().width(node);
+      }
+
+      term getTerm (void) const { return node; }
+
+      bool isConstant (void) const {
+	return currentDAG().isConstant(node);
+      }
+
+      // The low 64 bits
+      uint64_t constantValue (void) const {
+	PRECONDITION(this->isConstant());
+	return currentDAG().constantValue(node);
+      }
+
+      bitVector<isSigned> & operator = (const bitVector<isSigned> &op) {
+	this->node = op.node;
+	return *this;
+      }
+
+
+      /*** Constant creation and test ***/
+
+      static bitVector<isSigned> one (const bitWidthType &w) { return bitVector<isSigned>(w,1); }
+      static bitVector<isSigned> zero (const bitWidthType &w)  { return bitVector<isSigned>(w,0); }
+      static bitVector<isSigned> allOnes (const bitWidthType &w) { return ~zero(w); }
+
+      inline proposition isAllOnes() const { return (*this == allOnes(this->getWidth())); }
+      inline proposition isAllZeros() const { return (*this == zero(this->getWidth())); }
+
+      static bitVector<isSigned> maxValue (const bitWidthType &w) {
+	if (isSigned) {
+	  return bitVector<isSigned>(1, 0).append(allOnes(w-1));
+	} else {
+	  return allOnes(w);
+	}
+      }
+
+      static bitVector<isSigned> minValue (const bitWidthType &w) {
+	if (isSigned) {
+	  return bitVector<isSigned>(1, 1).append(zero(w-1));
+	} else {
+	  return zero(w);
+	}
+      }
+
+
+      /*** Operators ***/
+      inline bitVector<isSigned> operator << (const bitVector<isSigned> &op) const {
+	return apply(BVSHL, op);
+      }
+
+      inline bitVector<isSigned> operator >> (const bitVector<isSigned> &op) const {
+	return apply(isSigned ? BVASHR : BVLSHR, op);
+      }
+
+      inline bitVector<isSigned> operator | (const bitVector<isSigned> &op) const {
+	return apply(BVOR, op);
+      }
+
+      inline bitVector<isSigned> operator & (const bitVector<isSigned> &op) const {
+	return apply(BVAND, op);
+      }
+
+      inline bitVector<isSigned> operator + (const bitVector<isSigned> &op) const {
+	return apply(BVADD, op);
+      }
+
+      inline bitVector<isSigned> operator - (const bitVector<isSigned> &op) const {
+	return apply(BVSUB, op);
+      }
+
+      inline bitVector<isSigned> operator * (const bitVector<isSigned> &op) const {
+	return apply(BVMUL, op);
+      }
+
+      inline bitVector<isSigned> operator / (const bitVector<isSigned> &op) const {
+	return apply(isSigned ? BVSDIV : BVUDIV, op);
+      }
+
+      inline bitVector<isSigned> operator % (const bitVector<isSigned> &op) const {
+	return apply(isSigned ? BVSREM : BVUREM, op);
+      }
+
+      inline bitVector<isSigned> operator - (void) const {
+	return fromTerm(currentDAG().apply(BVNEG, node));
+      }
+
+      inline bitVector<isSigned> operator ~ (void) const {
+	return fromTerm(currentDAG().apply(BVNOT, node));
+      }
+
+      inline bitVector<isSigned> increment () const {
+	return *this + one(this->getWidth());
+      }
+
+      inline bitVector<isSigned> decrement () const {
+	return *this - one(this->getWidth());
+      }
+
+      inline bitVector<isSigned> signExtendRightShift (const bitVector<isSigned> &op) const {
+	return apply(BVASHR, op);
+      }
+
+
+      /*** Modular opertaions ***/
+      // No overflow checking so these are the same as other operations
+      inline bitVector<isSigned> modularLeftShift (const bitVector<isSigned> &op) const {
+	return *this << op;
+      }
+
+      inline bitVector<isSigned> modularRightShift (const bitVector<isSigned> &op) const {
+	return *this >> op;
+      }
+
+      inline bitVector<isSigned> modularIncrement () const {
+	return this->increment();
+      }
+
+      inline bitVector<isSigned> modularDecrement () const {
+	return this->decrement();
+      }
+
+      inline bitVector<isSigned> modularAdd (const bitVector<isSigned> &op) const {
+	return *this + op;
+      }
+
+      inline bitVector<isSigned> modularNegate () const {
+	return -(*this);
+      }
+
+
+      /*** Comparisons ***/
+
+      inline proposition operator == (const bitVector<isSigned> &op) const {
+	return compare(EQUAL, op);
+      }
+
+      inline proposition operator <= (const bitVector<isSigned> &op) const {
+	return compare(isSigned ? BVSLE : BVULE, op);
+      }
+
+      inline proposition operator >= (const bitVector<isSigned> &op) const {
+	return op <= *this;
+      }
+
+      inline proposition operator < (const bitVector<isSigned> &op) const {
+	return compare(isSigned ? BVSLT : BVULT, op);
+      }
+
+      inline proposition operator > (const bitVector<isSigned> &op) const {
+	return op < *this;
+      }
+
+
+      /*** Type conversion ***/
+      // The term is the same, only the interpretation changes
+      bitVector<true> toSigned (void) const {
+	return bitVector<true>::fromTerm(node);
+      }
+      bitVector<false> toUnsigned (void) const {
+	return bitVector<false>::fromTerm(node);
+      }
+
+
+      /*** Bit hacks ***/
+
+      inline bitVector<isSigned> extend (bitWidthType extension) const {
+	return fromTerm(currentDAG().extend(isSigned ? SIGN_EXTEND : ZERO_EXTEND, node, extension));
+      }
+
+      inline bitVector<isSigned> contract (bitWidthType reduction) const {
+	PRECONDITION(this->getWidth() > reduction);
+	return this->extract(this->getWidth() - 1 - reduction, 0);
+      }
+
+      inline bitVector<isSigned> resize (bitWidthType newSize) const {
+	bitWidthType width = this->getWidth();
+
+	if (newSize > width) {
+	  return this->extend(newSize - width);
+	} else if (newSize < width) {
+	  return this->contract(width - newSize);
+	} else {
+	  return *this;
+	}
+      }
+
+      inline bitVector<isSigned> matchWidth (const bitVector<isSigned> &op) const {
+	PRECONDITION(this->getWidth() <= op.getWidth());
+	return this->extend(op.getWidth() - this->getWidth());
+      }
+
+      // this is the high part of the result
+      bitVector<isSigned> append (const bitVector<isSigned> &op) const {
+	return fromTerm(currentDAG().apply(CONCAT, node, op.node));
+      }
+
+      // Inclusive of end points, thus if the same, extracts just one bit
+      bitVector<isSigned> extract (bitWidthType upper, bitWidthType lower) const {
+	PRECONDITION(upper >= lower);
+	PRECONDITION(upper < this->getWidth());
+	return fromTerm(currentDAG().extract(node, upper, lower));
+      }
+    };
+
+
+    // The identity of a value in the current DAG, for memoisation
+    inline void appendTermIdentity (std::vector<uint64_t> &key, const proposition &p) {
+      key.push_back(p.getTerm());
+    }
+
+    inline void appendTermIdentity (std::vector<uint64_t> &key, const roundingMode &m) {
+      key.push_back(m.getTerm());
+    }
+
+    template <bool isSigned>
+    inline void appendTermIdentity (std::vector<uint64_t> &key, const bitVector<isSigned> &b) {
+      key.push_back(b.getTerm());
+    }
+
+  }
+
+
+#define SMTLIBITEDFN(T) template <>					\
+    struct ite<smtlib::proposition, T> {				\
+    static const T iteOp (const smtlib::proposition &cond,		\
+			  const T &l,					\
+			  const T &r) {					\
+      return T::fromTerm(smtlib::currentDAG().apply(smtlib::ITE, cond.getTerm(), l.node, r.node)); \
+    }									\
+  };
+
+  SMTLIBITEDFN(smtlib::traits::prop);
+  SMTLIBITEDFN(smtlib::traits::rm);
+  SMTLIBITEDFN(smtlib::traits::sbv);
+  SMTLIBITEDFN(smtlib::traits::ubv);
+
+#undef SMTLIBITEDFN
+
+}
+
+#endif
@@ -0,0 +1,311 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** accumulator.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** Exact sums and dot products (a Kulisch accumulator).  The accumulator
+** is a two's complement fixed-point number wide enough to hold any
+** finite value (or product of two values) of the format exactly, plus
+** carry bits for a fixed number of terms.  Adding a term is an
+** alignment shift and an addition; there is only one rounding, when
+** the result is read.
+**
+** Zero results have the sign IEEE-754 addition would give, so
+** the sum of -0 and -0 is -0 and exact cancellation gives +0 (-0 for
+** RTN).
+**
+*/
+
+
+#include <vector>
+
+#include "symfpu/core/unpackedFloat.h"
+#include "symfpu/core/ite.h"
+#include "symfpu/core/operations.h"
+#include "symfpu/core/rounder.h"
+
+#ifndef SYMFPU_ACCUMULATOR
+#define SYMFPU_ACCUMULATOR
+
+namespace symfpu {
+
+ template <class t>
+ class exactAccumulator {
+ public :
+   typedef typename t::bwt bwt;
+   typedef typename t::prop prop;
+   typedef typename t::sbv sbv;
+   typedef typename t::fpt fpt;
+
+   const prop nan;
+   const prop inf;               // If so, all of the infinities have infSign
+   const prop infSign;
+   const prop allPositiveZero;   // Of the terms added so far
+   const prop allNegativeZero;
+   const sbv sum;                // The value is sum * 2^-fractionBits
+   const bwt fractionBits;
+   const size_t terms;
+   const size_t capacity;
+
+   exactAccumulator (const prop &n, const prop &i, const prop &is,
+		     const prop &apz, const prop &anz,
+		     const sbv &s, const bwt f, const size_t te, const size_t c) :
+     nan(n), inf(i), infSign(is), allPositiveZero(apz), allNegativeZero(anz),
+     sum(s), fractionBits(f), terms(te), capacity(c) {}
+
+   exactAccumulator (const exactAccumulator<t> &old) :
+     nan(old.nan), inf(old.inf), infSign(old.infSign),
+     allPositiveZero(old.allPositiveZero), allNegativeZero(old.allNegativeZero),
+     sum(old.sum), fractionBits(old.fractionBits), terms(old.terms), capacity(old.capacity) {}
+
+
+   // The layout; products need twice the range of single values.
+   // These are concrete so the executable back-ends can use them too.
+   static bwt fractionBitsFor (const fpt &format, const bool products) {
+     bwt significandWidth(unpackedFloat<t>::significandWidth(format));
+     bwt maxNormalExponent((bwt(1) << (format.exponentWidth() - 1)) - 1);
+     bwt negatedMinSubnormalExponent(maxNormalExponent + (significandWidth - 2));
+     bwt single((significandWidth - 1) + negatedMinSubnormalExponent);  // Of the smallest least significant bit
+     return products ? 2 * single : single;
+   }
+
+   static bwt widthFor (const fpt &format, const bool products, const size_t capacity) {
+     bwt significandWidth(unpackedFloat<t>::significandWidth(format));
+     bwt range(unpackedFloat<t>::maximumExponentDifference(format));
+     bwt single(significandWidth + range);
+     return (products ? 2 * single : single) + bitsToRepresent<bwt>(capacity) + 1; // + carries and sign
+   }
+
+
+   // An empty accumulator for up to capacity terms
+   static exactAccumulator<t> makeEmpty (const fpt &format, const bool products, const size_t capacity) {
+     PRECONDITION(capacity > 0);
+     return exactAccumulator<t>(prop(false), prop(false), prop(false), prop(true), prop(true),
+				sbv::zero(widthFor(format, products, capacity)),
+				fractionBitsFor(format, products), 0, capacity);
+   }
+ };
+
+
+ // Adds ITE(negative, -1, 1) * magnitude * 2^(exponent - fractionBits)
+ // where the term has already been classified.
+ template <class t>
+   exactAccumulator<t> accumulateTerm (const exactAccumulator<t> &acc,
+				       const typename t::prop &nan,
+				       const typename t::prop &inf,
+				       const typename t::prop &zero,
+				       const typename t::prop &negative,
+				       const typename t::ubv &magnitude,
+				       const typename t::sbv &position) {
+   typedef typename t::bwt bwt;
+   typedef typename t::prop prop;
+   typedef typename t::ubv ubv;
+   typedef typename t::sbv sbv;
+
+   PRECONDITION(acc.terms < acc.capacity);
+
+   bwt sumWidth(acc.sum.getWidth());
+   PRECONDITION(magnitude.getWidth() < sumWidth);
+
+   // The layout means position is in [0, sumWidth - magnitude width)
+   // for all finite, non-zero terms.
+   bwt positionWidth(position.getWidth());
+   ubv shift(ITE(zero || inf || nan,
+		 ubv::zero(positionWidth),
+		 position.toUnsigned()));
+   ubv aligned(magnitude.matchWidth(acc.sum.toUnsigned()) << shift.matchWidth(acc.sum.toUnsigned()));
+
+   sbv term(aligned.toSigned());
+   sbv signedTerm(ITE(zero || inf || nan,
+		      sbv::zero(sumWidth),
+		      ITE(negative, term.modularNegate(), term)));
+
+   prop resultNaN(acc.nan || nan || (acc.inf && inf && (acc.infSign ^ negative)));
+
+   return exactAccumulator<t>(resultNaN,
+			      acc.inf || inf,
+			      ITE(acc.inf, acc.infSign, negative),
+			      acc.allPositiveZero && zero && !negative,
+			      acc.allNegativeZero && zero && negative,
+			      acc.sum + signedTerm,   // Can not overflow as there are carry bits
+			      acc.fractionBits, acc.terms + 1, acc.capacity);
+ }
+
+
+ // The width needed to compute exponent + offset, for the positions
+ template <class t>
+   typename t::bwt accumulatorPositionWidth (const typename t::bwt exponentWidth,
+					     const exactAccumulator<t> &acc) {
+   typedef typename t::bwt bwt;
+
+   bwt sumBits(bitsToRepresent<bwt>(acc.sum.getWidth()) + 1);  // +1 as it is signed
+   return ((exponentWidth > sumBits) ? exponentWidth : sumBits) + 1;
+ }
+
+ template <class t>
+   exactAccumulator<t> accumulate (const typename t::fpt &format,
+				   const exactAccumulator<t> &acc,
+				   const unpackedFloat<t> &uf) {
+   typedef typename t::bwt bwt;
+   typedef typename t::sbv sbv;
+
+   PRECONDITION(uf.valid(format));
+   PRECONDITION(acc.fractionBits >= exactAccumulator<t>::fractionBitsFor(format, false));
+
+   // The least significant bit of the significand is 2^(exponent - (significandWidth - 1))
+   bwt significandWidth(unpackedFloat<t>::significandWidth(format));
+   bwt positionWidth(accumulatorPositionWidth<t>(uf.getExponent().getWidth(), acc));
+   sbv position(uf.getExponent().matchWidth(sbv::zero(positionWidth)) +
+		sbv(positionWidth, acc.fractionBits - (significandWidth - 1)));
+
+   return accumulateTerm<t>(acc, uf.getNaN(), uf.getInf(), uf.getZero(), uf.getSign(),
+			    uf.getSignificand(), position);
+ }
+
+ template <class t>
+   exactAccumulator<t> accumulateProduct (const typename t::fpt &format,
+					  const exactAccumulator<t> &acc,
+					  const unpackedFloat<t> &left,
+					  const unpackedFloat<t> &right) {
+   typedef typename t::bwt bwt;
+   typedef typename t::prop prop;
+   typedef typename t::ubv ubv;
+   typedef typename t::sbv sbv;
+
+   PRECONDITION(left.valid(format));
+   PRECONDITION(right.valid(format));
+   PRECONDITION(acc.fractionBits >= exactAccumulator<t>::fractionBitsFor(format, true));
+
+   prop nan(left.getNaN() || right.getNaN() ||
+	    (left.getInf() && right.getZero()) ||
+	    (left.getZero() && right.getInf()));
+   prop inf(left.getInf() || right.getInf());
+   prop zero(left.getZero() || right.getZero());
+
+   ubv product(expandingMultiply<t, ubv>(left.getSignificand(), right.getSignificand()));
+
+   bwt significandWidth(unpackedFloat<t>::significandWidth(format));
+   bwt positionWidth(accumulatorPositionWidth<t>(left.getExponent().getWidth() + 1, acc));
+   sbv position(expandingAdd<t>(left.getExponent(), right.getExponent()).matchWidth(sbv::zero(positionWidth)) +
+		sbv(positionWidth, acc.fractionBits - 2 * (significandWidth - 1)));
+
+   return accumulateTerm<t>(acc, nan, inf, zero, left.getSign() ^ right.getSign(),
+			    product, position);
+ }
+
+
+ // The only rounding
+ template <class t>
+   unpackedFloat<t> roundAccumulator (const typename t::fpt &format,
+				      const typename t::rm &roundingMode,
+				      const exactAccumulator<t> &acc) {
+   typedef typename t::bwt bwt;
+   typedef typename t::prop prop;
+   typedef typename t::ubv ubv;
+   typedef typename t::sbv sbv;
+
+   bwt sumWidth(acc.sum.getWidth());
+   bwt magnitudeWidth(sumWidth - 1);
+
+   prop exactZero(acc.sum.isAllZeros());
+   prop negative(acc.sum < sbv::zero(sumWidth));
+   ubv magnitude(abs<t,sbv>(acc.sum).toUnsigned().extract(magnitudeWidth - 1, 0));  // Safe as there are carry bits
+
+   // The leading bit of magnitude is 2^(magnitudeWidth - 1 - fractionBits)
+   // and normalising can take the exponent down to -fractionBits.
+   // Keeping the exponent as narrow as possible keeps the rounder small.
+   bwt top(magnitudeWidth - 1);
+   bwt furthest((acc.fractionBits > top - acc.fractionBits) ? acc.fractionBits : top - acc.fractionBits);
+   bwt rangeWidth(bitsToRepresent<bwt>(furthest) + 1);   // +1 as it is signed
+   bwt shiftWidth(bitsToRepresent<bwt>(magnitudeWidth) + 1); // normaliseUp needs it to be wider than the shift
+   bwt targetExponentWidth(unpackedFloat<t>::exponentWidth(format));
+   bwt exponentWidth((rangeWidth > shiftWidth) ? rangeWidth : shiftWidth);
+   exponentWidth = (exponentWidth > targetExponentWidth) ? exponentWidth : targetExponentWidth;
+
+   unpackedFloat<t> initial(negative,
+			    sbv(exponentWidth, top) - sbv(exponentWidth, acc.fractionBits),
+			    magnitude);
+   unpackedFloat<t> normalised(initial.normaliseUp(format));   // Zero is handled below
+
+   unpackedFloat<t> rounded(rounder(format, roundingMode, normalised));
+
+   prop zeroSign(ITE(roundingMode == t::RTN(),
+		     !acc.allPositiveZero,
+		     acc.allNegativeZero && prop(acc.terms > 0)));
+
+   unpackedFloat<t> result(ITE(acc.nan,
+			       unpackedFloat<t>::makeNaN(format),
+			       ITE(acc.inf,
+				   unpackedFloat<t>::makeInf(format, acc.infSign),
+				   ITE(exactZero,
+				       unpackedFloat<t>::makeZero(format, zeroSign),
+				       rounded))));
+
+   POSTCONDITION(result.valid(format));
+
+   return result;
+ }
+
+
+ template <class t>
+   unpackedFloat<t> exactSum (const typename t::fpt &format,
+			      const typename t::rm &roundingMode,
+			      const std::vector<unpackedFloat<t> > &values) {
+   PRECONDITION(values.size() > 0);
+
+   exactAccumulator<t> *acc = new exactAccumulator<t>(exactAccumulator<t>::makeEmpty(format, false, values.size()));
+   for (size_t i = 0; i < values.size(); ++i) {
+     exactAccumulator<t> *tmp = acc;
+     acc = new exactAccumulator<t>(accumulate<t>(format, *acc, values[i]));
+     delete tmp;
+   }
+
+   unpackedFloat<t> result(roundAccumulator<t>(format, roundingMode, *acc));
+   delete acc;
+
+   return result;
+ }
+
+ template <class t>
+   unpackedFloat<t> exactDotProduct (const typename t::fpt &format,
+				     const typename t::rm &roundingMode,
+				     const std::vector<unpackedFloat<t> > &left,
+				     const std::vector<unpackedFloat<t> > &right) {
+   PRECONDITION(left.size() > 0);
+   PRECONDITION(left.size() == right.size());
+
+   exactAccumulator<t> *acc = new exactAccumulator<t>(exactAccumulator<t>::makeEmpty(format, true, left.size()));
+   for (size_t i = 0; i < left.size(); ++i) {
+     exactAccumulator<t> *tmp = acc;
+     acc = new exactAccumulator<t>(accumulateProduct<t>(format, *acc, left[i], right[i]));
+     delete tmp;
+   }
+
+   unpackedFloat<t> result(roundAccumulator<t>(format, roundingMode, *acc));
+   delete acc;
+
+   return result;
+ }
+
+}
+
+#endif
@@ -52,6 +52,7 @@
 #include "symfpu/core/rounder.h"
 #include "symfpu/core/sign.h"
 #include "symfpu/core/operations.h"
+#include "symfpu/core/convert.h"
 
 
 #ifndef SYMFPU_ADD
@@ -110,11 +111,11 @@ template <class t>
   // an ITE with the default values "on top", thus doing the special cases
   // first (inner) rather than last (outer) allows them to be compacted better
   return ITE(idRight || returnRight,
-	     ITE(isAdd,
-		 right,
-		 negate(format, right)),
+	     flushSubnormal<t>(format, ITE(isAdd,
+					   right,
+					   negate(format, right))),
 	     ITE(idLeft || returnLeft,
-		 leftID,
+		 flushSubnormal<t>(format, leftID),
 		 ITE(generatesNaN,
 		     unpackedFloat<t>::makeNaN(format),
 		     ITE(generatesInf,
@@ -272,14 +273,42 @@ template <class t>
  floatWithCustomRounderInfo(const floatWithCustomRounderInfo<t> &old) : uf(old.uf), known(old.known) {}
  };
 
+ // What arithmeticAdd drops from the aligned sum, which is enough for
+ // augmentedAdd to find the rounding error without a wider addition.
+ // The magnitude of the sum, in units of the last bit of sum, is
+ //   sum + shiftedOut / 2^w + (something less than 1 if stickyBit) / 2^w
+ // where w is the width of sum.
  template <class t>
-   floatWithCustomRounderInfo<t> arithmeticAdd (const typename t::fpt &format,
-						const typename t::rm &roundingMode,
-						const unpackedFloat<t> &left,
-						const unpackedFloat<t> &right,
-						const typename t::prop &isAdd,
-						const typename t::prop &knownInCorrectOrder,
-						const exponentCompareInfo<t> &ec) {
+ struct addResidual {
+   typedef typename t::ubv ubv;
+
+   ubv sum;
+   ubv shiftedOut;
+   ubv stickyBit;
+
+ addResidual(const ubv &s, const ubv &so, const ubv &sb) : sum(s), shiftedOut(so), stickyBit(sb) {}
+ addResidual(const addResidual<t> &old) : sum(old.sum), shiftedOut(old.shiftedOut), stickyBit(old.stickyBit) {}
+ };
+
+ template <class t>
+ struct floatWithAddResidual {
+   floatWithCustomRounderInfo<t> result;
+   addResidual<t> residual;
+
+ floatWithAddResidual(const floatWithCustomRounderInfo<t> &r, const addResidual<t> &res) : result(r), residual(res) {}
+ floatWithAddResidual(const floatWithAddResidual<t> &old) : result(old.result), residual(old.residual) {}
+ };
+
+ // The residual is only built if computeResidual is set
+ template <class t>
+   floatWithAddResidual<t> arithmeticAddWithResidual (const typename t::fpt &format,
+						      const typename t::rm &roundingMode,
+						      const unpackedFloat<t> &left,
+						      const unpackedFloat<t> &right,
+						      const typename t::prop &isAdd,
+						      const typename t::prop &knownInCorrectOrder,
+						      const exponentCompareInfo<t> &ec,
+						      const bool computeResidual) {
    
    typedef typename t::bwt bwt;
    typedef typename t::fpt fpt;
@@ -436,8 +465,42 @@ template <class t>
    // See 'all subnormals generated by addition are exact'
    // and the extended exponent.
    POSTCONDITION(additionResult.valid(extendedFormat));
-   
-   return floatWithCustomRounderInfo<t>(additionResult, customRounderInfo<t>(noOverflow, noUnderflow, exact, subnormalExact, noSignificandOverflow));   
+
+   floatWithCustomRounderInfo<t> result(additionResult, customRounderInfo<t>(noOverflow, noUnderflow, exact, subnormalExact, noSignificandOverflow));
+
+   if (!computeResidual) {
+     return floatWithAddResidual<t>(result, addResidual<t>(sum, sum, sum));  // Not used
+   }
+
+
+   // The bits of the smaller significand below the sum, moved up to
+   // the top.  If the shift is more than the width of the sum the
+   // window is moved down and the rest go in the sticky bit.
+   // Negating before the shift means these are the low bits of the
+   // two's complement and so are added to the sum.
+   bwt negatedSmallerWidth(negatedSmaller.getWidth());
+   ubv windowWidth(negatedSmallerWidth, negatedSmallerWidth);
+   prop withinWindow(shiftAmount <= windowWidth);
+
+   ubv shiftedUp(negatedSmaller.modularLeftShift(windowWidth.modularAdd(shiftAmount.modularNegate())));
+   stickyRightShiftResult<t> shiftedDown(stickyRightShift<t>(negatedSmaller, shiftAmount.modularAdd(windowWidth.modularNegate())));
+
+   addResidual<t> residual(sum,
+			   ITE(withinWindow, shiftedUp, shiftedDown.signExtendedResult),
+			   ITE(withinWindow, ubv::zero(negatedSmallerWidth), shiftedDown.stickyBit));
+
+   return floatWithAddResidual<t>(result, residual);
+ }
+
+ template <class t>
+   floatWithCustomRounderInfo<t> arithmeticAdd (const typename t::fpt &format,
+						const typename t::rm &roundingMode,
+						const unpackedFloat<t> &left,
+						const unpackedFloat<t> &right,
+						const typename t::prop &isAdd,
+						const typename t::prop &knownInCorrectOrder,
+						const exponentCompareInfo<t> &ec) {
+   return arithmeticAddWithResidual(format, roundingMode, left, right, isAdd, knownInCorrectOrder, ec, false).result;
  }
  
  template <class t>
@@ -617,6 +680,26 @@ template <class t>
    return result;
  }
 
+// arithmeticAdd needs the unpacked exponent of its extended format to
+// be one bit wider than that of format.  This does not hold when the
+// significand is wide compared to the exponent, which formats made by
+// widening the significand can be, so the exponent is widened until it does.
+template <class t>
+  typename t::fpt arithmeticAddFormat (const typename t::fpt &format) {
+  typedef typename t::bwt bwt;
+  typedef typename t::fpt fpt;
+
+  bwt exponentWidth(format.exponentWidth());
+  bwt significandWidth(format.significandWidth());
+
+  while (unpackedFloat<t>::exponentWidth(fpt(exponentWidth + 1, significandWidth + 2)) !=
+	 unpackedFloat<t>::exponentWidth(fpt(exponentWidth, significandWidth)) + 1) {
+    ++exponentWidth;
+  }
+
+  return fpt(exponentWidth, significandWidth);
+ }
+
 template <class t>
    unpackedFloat<t> add (const typename t::fpt &format,
 			 const typename t::rm &roundingMode,
@@ -649,6 +732,66 @@ template <class t>
    return result;
  }
 
+ // Reads sourceFormat and rounds once into targetFormat.  The sum is
+ // computed with the guard and sticky bits of the wider of the two.
+ // Adding zero still needs the other argument rounding, so it is
+ // chosen as the input to the same rounder.
+ template <class t>
+   unpackedFloat<t> add (const typename t::fpt &sourceFormat,
+			 const typename t::fpt &targetFormat,
+			 const typename t::rm &roundingMode,
+			 const unpackedFloat<t> &left,
+			 const unpackedFloat<t> &right,
+			 const typename t::prop &isAdd) {
+
+   typedef typename t::prop prop;
+   typedef typename t::fpt fpt;
+
+   PRECONDITION(left.valid(sourceFormat));
+   PRECONDITION(right.valid(sourceFormat));
+
+   fpt workingFormat(arithmeticAddFormat<t>(commonFormat<t>(sourceFormat, targetFormat)));
+
+   // Strict extensions so the rounding mode does not matter
+   unpackedFloat<t> extendedLeft(convertFloatToFloat(sourceFormat, workingFormat, t::RTZ(), left));
+   unpackedFloat<t> extendedRight(convertFloatToFloat(sourceFormat, workingFormat, t::RTZ(), right));
+
+   prop knownInCorrectOrder(false);
+
+   exponentCompareInfo<t> ec(addExponentCompare<t>(extendedLeft.getExponent().getWidth() + 1, extendedLeft.getSignificand().getWidth(),
+						   extendedLeft.getExponent(), extendedRight.getExponent(), knownInCorrectOrder));
+
+   floatWithCustomRounderInfo<t> additionResult(arithmeticAdd(workingFormat, roundingMode, extendedLeft, extendedRight, isAdd, knownInCorrectOrder, ec));
+
+   // Same widths as additionResult
+   unpackedFloat<t> leftOnly(extendedLeft.extend(1, 2));
+   unpackedFloat<t> rightOnly(ITE(isAdd, extendedRight, negate(workingFormat, extendedRight)).extend(1, 2));
+
+   // The flags from arithmeticAdd are about the working format's range so can not be used
+   unpackedFloat<t> roundedAdditionResult(rounder(targetFormat, roundingMode,
+						  ITE(right.getZero(),
+						      leftOnly,
+						      ITE(left.getZero(),
+							  rightOnly,
+							  additionResult.uf))));
+
+   prop leftIsNumber(!left.getNaN() && !left.getInf() && !left.getZero());
+   prop rightIsNumber(!right.getNaN() && !right.getInf() && !right.getZero());
+   prop identity((leftIsNumber && right.getZero()) || (left.getZero() && rightIsNumber));
+
+   // Otherwise the special cases only use the flags of left and right
+   unpackedFloat<t> result(ITE(identity,
+			       roundedAdditionResult,
+			       addAdditionSpecialCases(targetFormat, roundingMode,
+						       unpackedFloat<t>::makeSpecialsOnly(targetFormat, left),
+						       unpackedFloat<t>::makeSpecialsOnly(targetFormat, right),
+						       roundedAdditionResult, isAdd)));
+
+   POSTCONDITION(result.valid(targetFormat));
+
+   return result;
+ }
+
  template <class t>
    unpackedFloat<t> addWithBypass (const typename t::fpt &format,
 				   const typename t::rm &roundingMode,
@@ -693,9 +836,13 @@ template <class t>
 		       left.getSign(),
 		       prop(!isAdd ^ right.getSign())));
 
-   prop significandEven(true);  // This is an optimisation that assumes only RNE uses this bit
-                                // This needs to be changed to implement things like roundToOdd
-                                // or for the diffIsGreaterThanPrecision case.
+   // The parity of the truncated result, which is the larger argument
+   // when adding and one less than it when subtracting.  The larger is
+   // normal as the exponents are so far apart.
+   prop maxSignificandEven(ITE((knownInCorrectOrder || ec.leftIsMax),
+			       left.getSignificand(),
+			       right.getSignificand()).extract(0,0).isAllZeros());
+   prop significandEven(ITE(effectiveAdd, maxSignificandEven, !maxSignificandEven));
    prop farRoundUp(roundingDecision<t>(roundingMode, resultSign, significandEven, !effectiveAdd, prop(true), prop(false)));
 
    // Returns left or right unchanged if adding and rounded down or subtracting and rounded up
@@ -712,6 +859,160 @@ template <class t>
  }
 
 
+// As add but rounds stochastically (see stochasticRoundingDecision).
+// roundingMode is still used for the sign of exact zeros and to decide
+// overflow and underflow.
+template <class t>
+   unpackedFloat<t> stochasticAdd (const typename t::fpt &format,
+				   const typename t::rm &roundingMode,
+				   const unpackedFloat<t> &left,
+				   const unpackedFloat<t> &right,
+				   const typename t::prop &isAdd,
+				   const typename t::ubv &randomBits) {
+
+   typedef typename t::bwt bwt;
+   typedef typename t::fpt fpt;
+   typedef typename t::prop prop;
+
+   PRECONDITION(left.valid(format));
+   PRECONDITION(right.valid(format));
+
+   // arithmeticAdd only keeps the guard and sticky bits so, to have
+   // discarded bits to compare with the random ones, work in a format
+   // with that many more significand bits.  As all of the flags for the
+   // rounder are about the value of the sum, they are still correct.
+   bwt extraBits(randomBits.getWidth());
+   fpt workingFormat(format.exponentWidth(), format.significandWidth() + extraBits);
+   bwt exponentExtension(unpackedFloat<t>::exponentWidth(workingFormat) - unpackedFloat<t>::exponentWidth(format));
+
+   unpackedFloat<t> extendedLeft(left.extend(exponentExtension, extraBits));
+   unpackedFloat<t> extendedRight(right.extend(exponentExtension, extraBits));
+
+   prop knownInCorrectOrder(false);
+
+   exponentCompareInfo<t> ec(addExponentCompare<t>(extendedLeft.getExponent().getWidth() + 1, extendedLeft.getSignificand().getWidth(),
+						   extendedLeft.getExponent(), extendedRight.getExponent(), knownInCorrectOrder));
+
+   floatWithCustomRounderInfo<t> additionResult(arithmeticAdd(workingFormat, roundingMode, extendedLeft, extendedRight, isAdd, knownInCorrectOrder, ec));
+
+   unpackedFloat<t> roundedAdditionResult(customRounder(format, roundingMode, additionResult.uf, additionResult.known, &randomBits));
+
+   unpackedFloat<t> result(addAdditionSpecialCases(format, roundingMode, left, right, roundedAdditionResult, isAdd));
+
+   POSTCONDITION(result.valid(format));
+
+   return result;
+ }
+
+
+ // The rounded sum and its rounding error.  With one of the nearest
+ // rounding modes the error is exact, so with RNE this is TwoSum.
+ // (IEEE-754 2019's augmentedAddition rounds ties toward zero, which is
+ // not one of the traits' rounding modes.)  With the directed modes it
+ // is the error rounded in the same mode.  If the sum overflows or is
+ // NaN the error is the same as the sum.
+ template <class t>
+   augmentedResult<t> augmentedAdd (const typename t::fpt &format,
+				    const typename t::rm &roundingMode,
+				    const unpackedFloat<t> &left,
+				    const unpackedFloat<t> &right,
+				    const typename t::prop &isAdd) {
+
+   typedef typename t::bwt bwt;
+   typedef typename t::prop prop;
+   typedef typename t::ubv ubv;
+   typedef typename t::sbv sbv;
+
+   PRECONDITION(left.valid(format));
+   PRECONDITION(right.valid(format));
+
+   prop knownInCorrectOrder(false);
+
+   exponentCompareInfo<t> ec(addExponentCompare<t>(left.getExponent().getWidth() + 1, left.getSignificand().getWidth(),
+						   left.getExponent(), right.getExponent(), knownInCorrectOrder));
+
+   floatWithAddResidual<t> additionResult(arithmeticAddWithResidual(format, roundingMode, left, right, isAdd, knownInCorrectOrder, ec, true));
+
+   unpackedFloat<t> roundedAdditionResult(customRounder(format, roundingMode, additionResult.result.uf, additionResult.result.known));
+
+   unpackedFloat<t> result(addAdditionSpecialCases(format, roundingMode, left, right, roundedAdditionResult, isAdd));
+
+
+   // The sum is at most a few units of its last bit from the rounded
+   // result, so the difference only needs the bottom few bits of each.
+   // The rounded significand is moved up to the scale of the sum by the
+   // change in exponent: 1 if the sum cancelled one bit, 2 normally and
+   // 3 or 4 if it carried.  More cancellation than that is exact.
+   bwt significandWidth(unpackedFloat<t>::significandWidth(format));
+   bwt differenceWidth(5);
+
+   sbv maxExponent(ec.maxExponent);
+   bwt exponentWidth(maxExponent.getWidth());
+   sbv scale(roundedAdditionResult.getExponent().matchWidth(maxExponent) - maxExponent + sbv(exponentWidth, 2));
+   prop cancelled(scale < sbv::one(exponentWidth));
+
+   ubv scaleAmount(scale.toUnsigned().extract(2,0).extend(differenceWidth - 3));
+   ubv roundedLowBits(roundedAdditionResult.getSignificand().resize(differenceWidth).modularLeftShift(scaleAmount));
+   ubv difference(additionResult.residual.sum.extract(differenceWidth - 1, 0).modularAdd(roundedLowBits.modularNegate()));
+
+   // (sum - rounded) * 2^w + shiftedOut, which is signed
+   ubv error(difference.append(additionResult.residual.shiftedOut));
+   bwt errorWidth(error.getWidth());
+   prop negative(error.extract(errorWidth - 1, errorWidth - 1).isAllOnes());
+   prop sticky(!additionResult.residual.stickyBit.isAllZeros());
+
+   // Bits below error make a negative one slightly smaller in magnitude
+   ubv magnitude(ITE(negative,
+		     ITE(sticky, ~error, error.modularNegate()),
+		     error));
+   ubv magnitudeWithSticky(magnitude.append(ITE(sticky, ubv::one(1), ubv::zero(1))));
+
+   // The last bit of the sum is worth 2^(maxExponent - significandWidth - 1)
+   bwt magnitudeWidth(magnitudeWithSticky.getWidth());
+   bwt normaliseWidth(exponentWidth + bitsToRepresent(magnitudeWidth));  // Room to normalise below the subnormals
+   sbv topExponent(maxExponent.matchWidth(sbv::zero(normaliseWidth)) + sbv(normaliseWidth, 3) - sbv(normaliseWidth, significandWidth));
+   unpackedFloat<t> unnormalised(roundedAdditionResult.getSign() ^ negative, topExponent, magnitudeWithSticky);
+   prop noError(magnitudeWithSticky.isAllZeros());
+
+   unpackedFloat<t> roundedError(errorRounder(format, roundingMode,
+					      ITE(noError,
+						  unpackedFloat<t>(unnormalised.getSign(), topExponent, ubv::one(magnitudeWidth)),
+						  unnormalised).normaliseUp(format)));
+
+
+   // Far apart, the error is the smaller operand if rounding has left
+   // the larger unchanged.  This is exact for all rounding modes.
+   sbv exponentDifference(ec.absoluteExponentDifference);
+   prop farApart(exponentDifference >= sbv(exponentDifference.getWidth(), significandWidth + 3));
+   unpackedFloat<t> larger(ITE(ec.leftIsMax, left, right));
+   unpackedFloat<t> smaller(ITE(ec.leftIsMax, ITE(isAdd, right, negate(format, right)), left));
+   prop largerUnchanged(result.getExponent() == larger.getExponent() &&
+			result.getSignificand() == larger.getSignificand());
+
+   // With the directed rounding modes overflow can give the largest
+   // finite number rather than infinity
+   sbv unroundedExponent(additionResult.result.uf.getExponent());
+   prop overflow(unroundedExponent > unpackedFloat<t>::maxNormalExponent(format).matchWidth(unroundedExponent));
+
+   prop exactInputs(left.getNaN() || left.getInf() || left.getZero() ||
+		    right.getNaN() || right.getInf() || right.getZero() ||
+		    additionResult.result.uf.getZero());
+
+   unpackedFloat<t> errorResult(ITE(result.getNaN() || result.getInf() || overflow,
+				    result,
+				    ITE(exactInputs || cancelled || noError,
+					unpackedFloat<t>::makeZero(format, result.getSign()),
+					ITE(farApart && largerUnchanged,
+					    smaller,
+					    roundedError))));
+
+   POSTCONDITION(result.valid(format));
+   POSTCONDITION(errorResult.valid(format));
+
+   return augmentedResult<t>(result, errorResult);
+ }
+
+
  // True if and only if adding these would result in a catastrophic cancellation
  // I.E. if the addition cancells out cancelAmount or more MSBs leaving only LSBs
  template <class t>
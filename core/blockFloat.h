@@ -0,0 +1,308 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** blockFloat.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** Block floating-point : a block of signed fixed-point elements that
+** share one exponent (as in the MXINT microscaling formats).  Element
+** i has the value
+**
+**   elements[i] * 2^(scale - (elementWidth - 2))
+**
+** so the leading bit of the largest magnitude is just below the sign
+** bit.  The scale has the same range as the unpacked exponent of the
+** floating-point format the block was encoded from.  Elements are
+** symmetric, -(2^(elementWidth - 1) - 1) to 2^(elementWidth - 1) - 1,
+** and saturate when rounding overflows.  Blocks containing NaN or
+** infinity are NaN.
+**
+*/
+
+
+#include <vector>
+
+#include "symfpu/core/unpackedFloat.h"
+#include "symfpu/core/ite.h"
+#include "symfpu/core/rounder.h"
+#include "symfpu/core/convert.h"
+
+#ifndef SYMFPU_BLOCKFLOAT
+#define SYMFPU_BLOCKFLOAT
+
+namespace symfpu {
+
+ template <class t>
+ class blockFloat {
+ public :
+   typedef typename t::prop prop;
+   typedef typename t::sbv sbv;
+
+   const prop nan;
+   const sbv scale;
+   const std::vector<sbv> elements;
+
+   blockFloat (const prop &n, const sbv &s, const std::vector<sbv> &e) :
+     nan(n), scale(s), elements(e) {}
+
+   blockFloat (const blockFloat<t> &old) :
+     nan(old.nan), scale(old.scale), elements(old.elements) {}
+ };
+
+
+ // The shared exponent is found once for the block and then each
+ // significand only needs to be aligned to it and rounded.
+ template <class t>
+   blockFloat<t> blockEncode (const typename t::fpt &format,
+			      const typename t::rm &roundingMode,
+			      const std::vector<unpackedFloat<t> > &values,
+			      const typename t::bwt &elementWidth) {
+   typedef typename t::bwt bwt;
+   typedef typename t::prop prop;
+   typedef typename t::ubv ubv;
+   typedef typename t::sbv sbv;
+
+   PRECONDITION(values.size() > 0);
+   PRECONDITION(elementWidth >= 3);  // fixedPositionRound needs at least two magnitude bits
+
+
+   // Find the shared exponent
+   sbv *maxExponent = new sbv(unpackedFloat<t>::minSubnormalExponent(format));
+   prop *special = new prop(false);
+
+   for (size_t i = 0; i < values.size(); ++i) {
+     PRECONDITION(values[i].valid(format));
+
+     sbv *tmp = maxExponent;
+     maxExponent = new sbv(ITE(!values[i].getZero() && (*maxExponent < values[i].getExponent()),
+			       values[i].getExponent(),
+			       *maxExponent));
+     delete tmp;
+
+     prop *ptmp = special;
+     special = new prop(*special || values[i].getNaN() || values[i].getInf());
+     delete ptmp;
+   }
+
+   sbv scale(*maxExponent);
+   prop nan(*special);
+   delete maxExponent;
+   delete special;
+
+
+   // Align and round each element
+   bwt magnitudeWidth(elementWidth - 1);
+   bwt significandWidth(unpackedFloat<t>::significandWidth(format));
+   bwt workingWidth(((significandWidth > magnitudeWidth) ? significandWidth : magnitudeWidth) + 2); // + guard and sticky
+
+   bwt maxShift(workingWidth);  // Everything is in the sticky bit
+   bwt maxShiftBits(bitsToRepresent(maxShift) + 1); // +1 as it is signed
+   bwt exponentWidth(scale.getWidth() + 1);
+   bwt workingExponentWidth((exponentWidth >= maxShiftBits) ? exponentWidth : maxShiftBits);
+   sbv maxShiftAmount(workingExponentWidth, maxShift);
+
+   std::vector<sbv> elements;
+   for (size_t i = 0; i < values.size(); ++i) {
+     const unpackedFloat<t> &v = values[i];
+
+     // Extended so that the sign extending shift brings in zeros
+     ubv working(v.getSignificand().extend(1).append(ubv::zero(workingWidth - significandWidth)));
+
+     sbv shift(collar<t>(expandingSubtract<t>(scale, v.getExponent()).matchWidth(maxShiftAmount),
+			 sbv::zero(workingExponentWidth),
+			 maxShiftAmount));
+     ubv shiftAmount(shift.resize(maxShiftBits).toUnsigned().matchWidth(working)); // Safe due to collar
+
+     stickyRightShiftResult<t> shifted(stickyRightShift<t>(working, shiftAmount));
+     ubv aligned((shifted.signExtendedResult | shifted.stickyBit).extract(workingWidth - 1, 0));
+
+     significandRounderResult<t> rounded(fixedPositionRound<t>(roundingMode, v.getSign(), aligned,
+							       magnitudeWidth, prop(false), prop(false)));
+
+     ubv magnitude(ITE(v.getZero(),
+		       ubv::zero(magnitudeWidth),
+		       ITE(rounded.incrementExponent,
+			   ubv::allOnes(magnitudeWidth),   // Saturate
+			   rounded.significand)));
+
+     sbv element(magnitude.extend(1).toSigned());
+     elements.push_back(ITE(v.getSign(), element.modularNegate(), element));
+   }
+
+   return blockFloat<t>(nan, scale, elements);
+ }
+
+
+ // The working format for decode and dot product needs more exponent
+ // range than format and enough significand bits for the value.
+ template <class t>
+   unpackedFloat<t> blockRound (const typename t::fpt &format,
+				const typename t::rm &roundingMode,
+				const typename t::prop &nan,
+				const typename t::prop &sign,
+				const typename t::sbv &exponent,
+				const typename t::ubv &magnitude,
+				const typename t::bwt &extraExponentBits) {
+   typedef typename t::bwt bwt;
+   typedef typename t::ubv ubv;
+   typedef typename t::fpt fpt;
+
+   bwt magnitudeWidth(magnitude.getWidth());
+   bwt targetSignificandWidth(unpackedFloat<t>::significandWidth(format));
+   bwt workingSignificandWidth(((magnitudeWidth > targetSignificandWidth) ? magnitudeWidth : targetSignificandWidth) + 2);
+
+   fpt workingFormat(format.exponentWidth() + extraExponentBits, workingSignificandWidth);
+   bwt workingExponentWidth(unpackedFloat<t>::exponentWidth(workingFormat));
+   PRECONDITION(exponent.getWidth() <= workingExponentWidth);
+
+   unpackedFloat<t> initial(sign,
+			    exponent.matchWidth(unpackedFloat<t>::minNormalExponent(workingFormat)),
+			    magnitude.append(ubv::zero(workingSignificandWidth - magnitudeWidth)));
+   unpackedFloat<t> normalised(initial.normaliseUpDetectZero(workingFormat));
+
+   unpackedFloat<t> result(ITE(nan,
+			       unpackedFloat<t>::makeNaN(format),
+			       convertFloatToFloat(workingFormat, format, roundingMode, normalised)));
+
+   POSTCONDITION(result.valid(format));
+
+   return result;
+ }
+
+ template <class t>
+   unpackedFloat<t> blockDecode (const typename t::fpt &format,
+				 const typename t::rm &roundingMode,
+				 const blockFloat<t> &block,
+				 const size_t index) {
+   typedef typename t::bwt bwt;
+   typedef typename t::prop prop;
+   typedef typename t::ubv ubv;
+   typedef typename t::sbv sbv;
+
+   PRECONDITION(index < block.elements.size());
+
+   const sbv &element(block.elements[index]);
+   bwt elementWidth(element.getWidth());
+
+   prop negative(element < sbv::zero(elementWidth));
+   ubv magnitude(abs<t,sbv>(element).toUnsigned().extract(elementWidth - 2, 0));  // Safe as elements are symmetric
+
+   // The leading bit of the magnitude is 2^scale
+   return blockRound<t>(format, roundingMode, block.nan, negative,
+			block.scale.extend(1), magnitude, 1);
+ }
+
+ // Sum of the products of the elements with a single rounding
+ template <class t>
+   unpackedFloat<t> blockDotProduct (const typename t::fpt &format,
+				     const typename t::rm &roundingMode,
+				     const blockFloat<t> &left,
+				     const blockFloat<t> &right) {
+   typedef typename t::bwt bwt;
+   typedef typename t::prop prop;
+   typedef typename t::ubv ubv;
+   typedef typename t::sbv sbv;
+
+   size_t count(left.elements.size());
+   PRECONDITION(count > 0);
+   PRECONDITION(count == right.elements.size());
+
+   bwt elementWidth(left.elements[0].getWidth());
+   PRECONDITION(elementWidth == right.elements[0].getWidth());
+
+   // Exact, each product fits in 2 * elementWidth - 1 bits
+   bwt sumWidth(2 * elementWidth + bitsToRepresent<bwt>(count));
+
+   sbv *sum = new sbv(sbv::zero(sumWidth));
+   for (size_t i = 0; i < count; ++i) {
+     sbv product(left.elements[i].matchWidth(*sum) * right.elements[i].matchWidth(*sum));
+
+     sbv *tmp = sum;
+     sum = new sbv(*sum + product);
+     delete tmp;
+   }
+   sbv total(*sum);
+   delete sum;
+
+   prop isZero(total.isAllZeros());
+   prop negative(ITE(isZero, prop(roundingMode == t::RTN()), total < sbv::zero(sumWidth)));
+   ubv magnitude(abs<t,sbv>(total).toUnsigned().extract(sumWidth - 2, 0));
+
+   // Each product is scaled by 2^(leftScale + rightScale - 2 * (elementWidth - 2))
+   // and the leading bit of magnitude is 2^(sumWidth - 2) of those.
+   bwt exponentWidth(left.scale.getWidth() + 2);
+   bwt offsetWidth(bitsToRepresent<bwt>(sumWidth) + 1);
+   bwt workingExponentWidth((exponentWidth > offsetWidth) ? exponentWidth : offsetWidth);
+   sbv scaleSum(expandingAdd<t>(left.scale, right.scale).matchWidth(sbv::zero(workingExponentWidth)));
+   sbv offset(sbv(workingExponentWidth, sumWidth - 2) - sbv(workingExponentWidth, 2 * (elementWidth - 2)));
+   sbv exponent(scaleSum + offset);
+
+   return blockRound<t>(format, roundingMode, left.nan || right.nan, negative,
+			exponent, magnitude, workingExponentWidth - left.scale.getWidth() + 1);
+ }
+
+
+ // Packed as the NaN flag, then the scale, then the elements in order
+ template <class t>
+   typename t::ubv blockPack (const blockFloat<t> &block) {
+   typedef typename t::ubv ubv;
+
+   ubv *packed = new ubv(ubv(block.nan).append(block.scale.toUnsigned()));
+   for (size_t i = 0; i < block.elements.size(); ++i) {
+     ubv *tmp = packed;
+     packed = new ubv(packed->append(block.elements[i].toUnsigned()));
+     delete tmp;
+   }
+
+   ubv result(*packed);
+   delete packed;
+
+   return result;
+ }
+
+ template <class t>
+   blockFloat<t> blockUnpack (const typename t::fpt &format,
+			      const typename t::ubv &packed,
+			      const size_t count,
+			      const typename t::bwt &elementWidth) {
+   typedef typename t::bwt bwt;
+   typedef typename t::prop prop;
+   typedef typename t::sbv sbv;
+
+   bwt scaleWidth(unpackedFloat<t>::exponentWidth(format));
+   bwt packedWidth(packed.getWidth());
+   PRECONDITION(packedWidth == 1 + scaleWidth + count * elementWidth);
+
+   prop nan(packed.extract(packedWidth - 1, packedWidth - 1).isAllOnes());
+   sbv scale(packed.extract(packedWidth - 2, packedWidth - 1 - scaleWidth).toSigned());
+
+   std::vector<sbv> elements;
+   for (size_t i = 0; i < count; ++i) {
+     bwt top(packedWidth - 2 - scaleWidth - i * elementWidth);
+     elements.push_back(packed.extract(top, top - (elementWidth - 1)).toSigned());
+   }
+
+   return blockFloat<t>(nan, scale, elements);
+ }
+
+}
+
+#endif
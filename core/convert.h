@@ -34,6 +34,17 @@
 
 namespace symfpu {
 
+// The smallest format that holds every value of both a and b, so that
+// operations reading one format and rounding into another can work in
+// it without losing anything.
+template <class t>
+typename t::fpt commonFormat (const typename t::fpt &a, const typename t::fpt &b) {
+  typedef typename t::fpt fpt;
+
+  return fpt((a.exponentWidth() > b.exponentWidth()) ? a.exponentWidth() : b.exponentWidth(),
+	     (a.significandWidth() > b.significandWidth()) ? a.significandWidth() : b.significandWidth());
+}
+
 template <class t>
 unpackedFloat<t> convertFloatToFloat (const typename t::fpt &sourceFormat,
 				      const typename t::fpt &targetFormat,
@@ -106,36 +117,49 @@ unpackedFloat<t> roundToIntegral (const typename t::fpt &format,
   prop isSpecial(input.getNaN() || input.getInf() || input.getZero());
   prop isID(isIntegral || isSpecial);
   probabilityAnnotation<t>(isID, LIKELY);
-  // TODO : fast path the cases that don't round up
+
+  ubv significand(input.getSignificand());
+  bwt significandWidth(significand.getWidth());
+
+
+  // Magnitudes below one round to zero or one, which only depends on
+  // the bit worth a half and whether there is anything below it
+  prop isFraction(exponent < sbv::zero(exponentWidth));
+  prop fractionGuard(exponent == sbv::one(exponentWidth).modularNegate());
+  prop fractionSticky(!fractionGuard ||
+		      !significand.extract(significandWidth - 2, 0).isAllZeros());
+  prop fractionRoundUp(roundingDecision<t>(roundingMode, input.getSign(), prop(true),
+					   fractionGuard, fractionSticky, !isFraction));
+
+  unpackedFloat<t> fractionResult(ITE(fractionRoundUp,
+				      unpackedFloat<t>(input.getSign(), sbv::zero(exponentWidth),
+						       unpackedFloat<t>::leadingOne(significandWidth)),
+				      unpackedFloat<t>::makeZero(format, input.getSign())));
 
   
-  // Otherwise, compute rounding location
+  // Otherwise, compute rounding location, which is within the
+  // significand so the leading one is never lost
   sbv initialRoundingPoint(expandingSubtract<t>(packedSigWidth,exponent));  // Expansion only needed in obscure formats
   sbv roundingPoint(collar<t>(initialRoundingPoint,
 			      sbv::zero(exponentWidth + 1),
-			      unpackedSigWidth.extend(1).increment()));
+			      packedSigWidth.extend(1)));
 
   // Round
-  ubv significand(input.getSignificand());
   significandRounderResult<t> roundedResult(variablePositionRound<t>(roundingMode, input.getSign(), significand,
 								     roundingPoint.toUnsigned().matchWidth(significand),
-								     prop(false), // TODO : Could actually be exponent >= 0
-								     isID));      // The fast-path case so just deactives some code
+								     prop(true),
+								     isID || isFraction)); // The fast-path cases so just deactives some code
 
   // Reconstruct
-  // Note this is not in a valid form if significand is all zeros
-  // The max is necessary to catch cases when we round up to one from very small numbers
-  // The rounder ensures these are zero if they don't round up
   unpackedFloat<t> reconstructed(input.getSign(),
-				 max<t>(conditionalIncrement<t>(roundedResult.incrementExponent, exponent),
-					sbv::zero(exponentWidth)),
+				 conditionalIncrement<t>(roundedResult.incrementExponent, exponent),
 				 roundedResult.significand);
 					    
   
   unpackedFloat<t> result(ITE(isID,
 			      input,
-			      ITE(roundedResult.significand.isAllZeros(),
-				  unpackedFloat<t>::makeZero(format, input.getSign()),
+			      ITE(isFraction,
+				  fractionResult,
 				  reconstructed)));
 
   POSTCONDITION(result.valid(format));
@@ -182,6 +206,108 @@ unpackedFloat<t> roundToIntegral (const typename t::fpt &format,
 }
 
 
+// Whether every input with the given number of significant bits, the
+// largest having its top bit at topBit (before the decimal point is
+// placed), is a normal number in the target format.  If so conversion
+// does not need to round.
+template <class t>
+  bool integerConversionIsExact (const typename t::fpt &targetFormat,
+				 const typename t::bwt &significantBits,
+				 const typename t::bwt &topBit,
+				 const typename t::bwt &decimalPointPosition) {
+  typedef typename t::bwt bwt;
+
+  bwt bias((((bwt)1) << (targetFormat.exponentWidth() - 1)) - 1);
+
+  return (significantBits <= unpackedFloat<t>::significandWidth(targetFormat)) &&
+    (bitsToRepresent<bwt>(topBit + 1) < unpackedFloat<t>::exponentWidth(targetFormat)) &&  // Shift amount fits
+    (topBit <= bias + decimalPointPosition) &&     // Largest is not above maxNormal
+    (decimalPointPosition < bias);                 // Smallest is not below minNormal
+ }
+
+// The exponent is found directly from the leading zero count of the
+// magnitude, whose top bit has the value 2^(topBit - decimalPointPosition).
+// Only valid when integerConversionIsExact.
+template <class t>
+  unpackedFloat<t> convertMagnitudeExactly (const typename t::fpt &targetFormat,
+					    const typename t::prop &sign,
+					    const typename t::ubv &magnitude,
+					    const typename t::bwt &topBit,
+					    const typename t::bwt &decimalPointPosition) {
+  typedef typename t::bwt bwt;
+  typedef typename t::ubv ubv;
+  typedef typename t::sbv sbv;
+
+  bwt magnitudeWidth(magnitude.getWidth());
+  bwt targetSignificandWidth(unpackedFloat<t>::significandWidth(targetFormat));
+  bwt targetExponentWidth(unpackedFloat<t>::exponentWidth(targetFormat));
+
+  normaliseShiftResult<t> normal(normaliseShift<t>(magnitude));
+
+  sbv exponent(sbv(targetExponentWidth, topBit) - sbv(targetExponentWidth, decimalPointPosition) -
+	       normal.shiftAmount.matchWidth(ubv::zero(targetExponentWidth)).toSigned());
+
+  // Any bits below the target significand are zero as the conversion is exact
+  ubv significand((magnitudeWidth < targetSignificandWidth) ?
+		  normal.normalised.append(ubv::zero(targetSignificandWidth - magnitudeWidth)) :
+		  normal.normalised.extract(magnitudeWidth - 1, magnitudeWidth - targetSignificandWidth));
+
+  unpackedFloat<t> result(ITE(normal.isZero,
+			      unpackedFloat<t>::makeZero(targetFormat, sign),
+			      unpackedFloat<t>(sign, exponent, significand)));
+
+  POSTCONDITION(result.valid(targetFormat));
+
+  return result;
+ }
+
+
+// Otherwise the magnitude is normalised and rounded directly, padding
+// it to the width the rounder needs.
+template <class t>
+  unpackedFloat<t> convertMagnitudeRounding (const typename t::fpt &targetFormat,
+					     const typename t::rm &roundingMode,
+					     const typename t::prop &sign,
+					     const typename t::ubv &magnitude,
+					     const typename t::bwt &topBit,
+					     const typename t::bwt &decimalPointPosition) {
+  typedef typename t::bwt bwt;
+  typedef typename t::ubv ubv;
+  typedef typename t::sbv sbv;
+
+  bwt magnitudeWidth(magnitude.getWidth());
+  bwt roundingSignificandWidth(unpackedFloat<t>::significandWidth(targetFormat) + 2);
+  bwt targetExponentWidth(unpackedFloat<t>::exponentWidth(targetFormat));
+
+  // Exponents are between -(decimalPointPosition + magnitudeWidth) and magnitudeWidth
+  bwt neededExponentWidth(bitsToRepresent<bwt>(decimalPointPosition + magnitudeWidth) + 1);
+  bwt exponentWidth((neededExponentWidth > targetExponentWidth) ? neededExponentWidth : targetExponentWidth);
+
+  normaliseShiftResult<t> normal(normaliseShift<t>(magnitude));
+
+  sbv exponent(sbv(exponentWidth, topBit) - sbv(exponentWidth, decimalPointPosition) -
+	       normal.shiftAmount.matchWidth(ubv::zero(exponentWidth)).toSigned());
+
+  ubv significand((magnitudeWidth < roundingSignificandWidth) ?
+		  normal.normalised.append(ubv::zero(roundingSignificandWidth - magnitudeWidth)) :
+		  normal.normalised);
+
+  // Zero is given a dummy value so that the rounder sees a normal number
+  unpackedFloat<t> normalised(ITE(normal.isZero,
+				  unpackedFloat<t>(sign, sbv::zero(exponentWidth),
+						   unpackedFloat<t>::leadingOne(significand.getWidth())),
+				  unpackedFloat<t>(sign, exponent, significand)));
+
+  unpackedFloat<t> result(ITE(normal.isZero,
+			      unpackedFloat<t>::makeZero(targetFormat, sign),
+			      rounder(targetFormat, roundingMode, normalised)));
+
+  POSTCONDITION(result.valid(targetFormat));
+
+  return result;
+ }
+
+
 template <class t>
   unpackedFloat<t> convertUBVToFloat (const typename t::fpt &targetFormat,
 				      const typename t::rm &roundingMode,
@@ -190,26 +316,17 @@ template <class t>
   
   typedef typename t::bwt bwt;
   typedef typename t::prop prop;
-  typedef typename t::sbv sbv;
-  typedef typename t::fpt fpt;
 
   bwt inputWidth(input.getWidth());
 
   PRECONDITION(decimalPointPosition <= inputWidth);
-  
-  // Devise an appropriate format 
-  bwt initialExponentWidth(bitsToRepresent<bwt>(inputWidth) + 1); // +1 as unsigned -> signed
-  fpt initialFormat(initialExponentWidth, inputWidth);
-  bwt actualExponentWidth(unpackedFloat<t>::exponentWidth(initialFormat));
 
-  // Build
-  unpackedFloat<t> initial(prop(false), sbv(actualExponentWidth, (inputWidth - 1) - decimalPointPosition), input);  // inputWidth - 1 as we want one bit above the decimal point
-  
-  // Normalise
-  unpackedFloat<t> normalised(initial.normaliseUpDetectZero(initialFormat));
-
-  // Round (the conversion will catch the cases where no rounding is needed)
-  return convertFloatToFloat(initialFormat, targetFormat, roundingMode, normalised);
+  // Format sizes are literal so it is safe to branch on them
+  if (integerConversionIsExact<t>(targetFormat, inputWidth, inputWidth - 1, decimalPointPosition)) {
+    return convertMagnitudeExactly<t>(targetFormat, prop(false), input, inputWidth - 1, decimalPointPosition);
+  } else {
+    return convertMagnitudeRounding<t>(targetFormat, roundingMode, prop(false), input, inputWidth - 1, decimalPointPosition);
+  }
  }
 
  
@@ -220,29 +337,24 @@ template <class t>
 				      const typename t::bwt &decimalPointPosition = 0) {
   typedef typename t::bwt bwt;
   typedef typename t::prop prop;
+  typedef typename t::ubv ubv;
   typedef typename t::sbv sbv;
-  typedef typename t::fpt fpt;
 
   bwt inputWidth(input.getWidth());
 
   PRECONDITION(decimalPointPosition <= inputWidth);
-  
-  // Devise an appropriate format 
-  bwt initialExponentWidth(bitsToRepresent<bwt>(inputWidth) + 1); // +1 as unsigned -> signed
-  fpt initialFormat(initialExponentWidth, inputWidth + 1);        // +1 as signed -> unsigned
-  bwt actualExponentWidth(unpackedFloat<t>::exponentWidth(initialFormat));
 
   // Work out the sign
   prop negative(input < sbv::zero(inputWidth));
+  ubv magnitude((abs<t,sbv>(input.extend(1))).toUnsigned());
 
-  // Build
-  unpackedFloat<t> initial(negative, sbv(actualExponentWidth, inputWidth - decimalPointPosition), (abs<t,sbv>(input.extend(1))).toUnsigned());
-  
-  // Normalise
-  unpackedFloat<t> normalised(initial.normaliseUpDetectZero(initialFormat));
-
-  // Round (the conversion will catch the cases where no rounding is needed)
-  return convertFloatToFloat(initialFormat, targetFormat, roundingMode, normalised);
+  // The magnitude has at most inputWidth - 1 significant bits apart
+  // from the most negative number, which is a power of two
+  if (integerConversionIsExact<t>(targetFormat, inputWidth - 1, inputWidth - 1, decimalPointPosition)) {
+    return convertMagnitudeExactly<t>(targetFormat, negative, magnitude, inputWidth, decimalPointPosition);
+  } else {
+    return convertMagnitudeRounding<t>(targetFormat, roundingMode, negative, magnitude, inputWidth, decimalPointPosition);
+  }
  }
 
 
@@ -250,7 +362,7 @@ template <class t>
  // Note that the results will be junk if it is not in bounds, etc.
  // convertFloatToUBV and convertFloatToSBV handle all of that logic.
  template <class t>
-   significandRounderResult<t> convertFloatToBV (const typename t::fpt &format,
+   significandRounderResult<t> convertFloatToBV (const typename t::fpt &/*format*/,
 						 const typename t::rm &roundingMode,
 						 const unpackedFloat<t> &input,
 						 const typename t::bwt &targetWidth,
@@ -319,11 +431,13 @@ template <class t>
    return rounded;
  }
 
- // A more compact version for round to zero
+ // A more compact version for round to zero, truncation needs neither
+ // guard and sticky bits nor an increment so the significand is
+ // shifted directly into place.
  // Only handles normal, subnormal and zero cases, overflow of targetWidth will give junk.
  // Inf, NaN, and overflow must be handled by the caller.
  template <class t>
-   significandRounderResult<t> convertFloatToBVRTZ (const typename t::fpt &format,
+   significandRounderResult<t> convertFloatToBVRTZ (const typename t::fpt &/*format*/,
 						    const unpackedFloat<t> &input,
 						    const typename t::bwt &targetWidth,
 						    const typename t::bwt &decimalPointPosition) {
@@ -345,19 +459,25 @@ template <class t>
 
 
    // Handle zero and fractional cases
-   sbv exponent(input.getExponent());
+   bwt inputExponentWidth(input.getExponent().getWidth());
+   bwt decimalPointBits(bitsToRepresent(decimalPointPosition) + 1);
+   bwt workingExponentWidth((inputExponentWidth >= decimalPointBits) ?
+			    inputExponentWidth : decimalPointBits);
+
+   sbv exponent(expandingAdd<t>(input.getExponent().matchWidth(sbv::zero(workingExponentWidth)),
+				sbv(workingExponentWidth, decimalPointPosition)));  // Scaled by 2^decimalPointPosition
    bwt exponentWidth(exponent.getWidth());
 
-   prop fraction(input.getExponent() < sbv::zero(exponentWidth));
+   prop fraction(exponent < sbv::zero(exponentWidth));
    ubv zerodSignificand(significantSignificand &
 			ITE(input.getZero() || fraction, ubv::zero(ssWidth), ubv::allOnes(ssWidth)));
 
    ubv expandedSignificand(zerodSignificand.extend(targetWidth - 1)); // Start with the significand in the LSB of output
 
 
-   // Prepare exponent
-   bwt maxShift(targetWidth - 1); // - 1 as we are already at LSB
-   bwt maxShiftBits(bitsToRepresent(maxShift)); // Don't care about it being signed
+   // Prepare exponent, only the bits needed for shifts up to
+   // targetWidth - 1 are used as anything larger is overflow
+   bwt maxShiftBits(bitsToRepresent(targetWidth)); // Don't care about it being signed
 
    ubv convertedExponent(exponent.toUnsigned());
    bwt topExtractedBit(((maxShiftBits >  (exponentWidth - 1)) ? exponentWidth : maxShiftBits) - 1);
@@ -399,7 +519,7 @@ template <class t>
    // Invalid cases
    prop specialValue(input.getInf() || input.getNaN());
 
-   bwt maxExponentValue(targetWidth);
+   bwt maxExponentValue(targetWidth - decimalPointPosition);  // Scaled by 2^decimalPointPosition
    bwt maxExponentBits(bitsToRepresent(maxExponentValue) + 1);
 
    bwt exponentWidth(input.getExponent().getWidth());
@@ -411,28 +531,46 @@ template <class t>
 
    prop tooLarge(exponent >= maxExponent);
 
-   prop tooNegative(input.getSign() &&
-		    !input.getZero() &&  // Zero is handled elsewhere
-		    sbv::zero(workingExponentWidth) <= exponent);  // Can't round to 0
+
+   // Negative numbers are only defined if they round to zero.  This
+   // only depends on the bit worth a half (the guard bit) and those
+   // below it (sticky), so the main conversion is only of magnitudes.
+   bwt decimalPointBits(bitsToRepresent(decimalPointPosition) + 1);
+   bwt scaledExponentWidth((workingExponentWidth >= decimalPointBits) ?
+			   workingExponentWidth : decimalPointBits);
+   sbv scaledExponent(expandingAdd<t>(exponent.matchWidth(sbv::zero(scaledExponentWidth)),
+				      sbv(scaledExponentWidth, decimalPointPosition)));
+   sbv minusOne(sbv::one(scaledExponentWidth + 1).modularNegate());
+
+   ubv significand(input.getSignificand());
+   bwt significandWidth(significand.getWidth());
+   prop guardBit(scaledExponent == minusOne);
+   prop stickyBit((scaledExponent < minusOne) ||
+		  !significand.extract(significandWidth - 2, 0).isAllZeros());
+
+   prop negative(input.getSign() && !input.getZero());  // Zero is handled elsewhere
+   prop tooNegative(negative &&
+		    ((sbv::zero(scaledExponentWidth + 1) <= scaledExponent) ||  // Can't round to 0
+		     roundingDecision<t>(roundingMode, prop(true), prop(true),
+					 guardBit, stickyBit, prop(false))));
    
    prop earlyUndefinedResult(specialValue || tooLarge || tooNegative);
    probabilityAnnotation<t>(earlyUndefinedResult, LIKELY); // Convertable values are rare
 
 
    // Fixed position round
-   significandRounderResult<t> rounded(convertFloatToBV(format, roundingMode, input,
+   significandRounderResult<t> rounded(convertFloatToBV(format, roundingMode, unpackedFloat<t>(input, prop(false)),
 							targetWidth, decimalPointPosition));
 
-   // TODO : fast path negative by converting exp==0 into guard and exp < 0 into sticky
-   
    // Put the result together
    prop undefinedResult(earlyUndefinedResult ||
-			rounded.incrementExponent ||    // Overflow
-			(input.getSign() && !rounded.significand.isAllZeros()));  // Negative case
+			rounded.incrementExponent);    // Overflow
    
    ubv result(ITE(undefinedResult,
 		  undefValue,
-		  rounded.significand));
+		  ITE(negative,
+		      ubv::zero(targetWidth),
+		      rounded.significand)));
 
    return result;
  }
@@ -459,7 +597,7 @@ template <class t>
    // Invalid cases
    prop specialValue(input.getInf() || input.getNaN());
 
-   bwt maxExponentValue(targetWidth);
+   bwt maxExponentValue(targetWidth - decimalPointPosition);  // Scaled by 2^decimalPointPosition
    bwt maxExponentBits(bitsToRepresent(maxExponentValue) + 1);
 
    bwt exponentWidth(input.getExponent().getWidth());
@@ -490,13 +628,154 @@ template <class t>
 			 !(input.getSign() && rounded.significand.extract(roundSigWidth - 2, 0).isAllZeros()))); // -2^{n-1} is the only safe "overflow" case
 
    
+   // Modular so that -2^{n-1} and the undefined cases are safe
+   sbv magnitude(rounded.significand.toSigned());
+   sbv result(ITE(undefinedResult,
+		  undefValue,
+		  ITE(input.getSign(), magnitude.modularNegate(), magnitude)));
+
+   return result;
+ }
+
+
+ // Truncating versions, as used for C casts.  These are the same as
+ // convertFloatToUBV / convertFloatToSBV with RTZ but do not need a
+ // rounder.
+ template <class t>
+   typename t::ubv convertFloatToUBVRTZ (const typename t::fpt &format,
+					 const unpackedFloat<t> &input,
+					 const typename t::bwt &targetWidth,
+					 const typename t::ubv &undefValue,
+					 const typename t::bwt &decimalPointPosition = 0) {
+
+   typedef typename t::bwt bwt;
+   typedef typename t::prop prop;
+   typedef typename t::ubv ubv;
+   typedef typename t::sbv sbv;
+
+
+   PRECONDITION(decimalPointPosition < targetWidth);
+
+
+   // Invalid cases
+   prop specialValue(input.getInf() || input.getNaN());
+
+   bwt maxExponentValue(targetWidth - decimalPointPosition);  // Scaled by 2^decimalPointPosition
+   bwt maxExponentBits(bitsToRepresent(maxExponentValue) + 1);
+
+   bwt exponentWidth(input.getExponent().getWidth());
+   bwt workingExponentWidth((exponentWidth >= maxExponentBits) ?
+			    exponentWidth : maxExponentBits);
+
+   sbv maxExponent(workingExponentWidth, maxExponentValue);
+   sbv exponent(input.getExponent().matchWidth(maxExponent));
+
+   prop tooLarge(exponent >= maxExponent);
+
+   
+   // Truncate
+   significandRounderResult<t> truncated(convertFloatToBVRTZ(format, input,
+							     targetWidth, decimalPointPosition));
+
+   // Negative numbers are only defined if they truncate to zero
+   prop undefinedResult(specialValue || tooLarge ||
+			(input.getSign() && !truncated.significand.isAllZeros()));
+   probabilityAnnotation<t>(undefinedResult, LIKELY); // Convertable values are rare
+
+   ubv result(ITE(undefinedResult,
+		  undefValue,
+		  truncated.significand));
+
+   return result;
+ }
+
+ template <class t>
+   typename t::sbv convertFloatToSBVRTZ (const typename t::fpt &format,
+					 const unpackedFloat<t> &input,
+					 const typename t::bwt &targetWidth,
+					 const typename t::sbv &undefValue,
+					 const typename t::bwt &decimalPointPosition = 0) {
+
+   typedef typename t::bwt bwt;
+   typedef typename t::prop prop;
+   typedef typename t::sbv sbv;
+
+
+   PRECONDITION(decimalPointPosition < targetWidth);
+
+
+   // Invalid cases
+   prop specialValue(input.getInf() || input.getNaN());
+
+   bwt maxExponentValue(targetWidth - decimalPointPosition);  // Scaled by 2^decimalPointPosition
+   bwt maxExponentBits(bitsToRepresent(maxExponentValue) + 1);
+
+   bwt exponentWidth(input.getExponent().getWidth());
+   bwt workingExponentWidth((exponentWidth >= maxExponentBits) ?
+			    exponentWidth : maxExponentBits);
+
+   sbv maxExponent(workingExponentWidth, maxExponentValue);
+   sbv exponent(input.getExponent().matchWidth(maxExponent));
+
+   prop tooLarge(exponent >= maxExponent);
+
+
+   // Truncate, which can not carry so the only overflow is the top bit
+   significandRounderResult<t> truncated(convertFloatToBVRTZ(format, input,
+							     targetWidth, decimalPointPosition));
+
+   bwt truncatedWidth(truncated.significand.getWidth());
+   prop undefinedResult(specialValue || tooLarge ||
+			(truncated.significand.extract(truncatedWidth - 1,
+						       truncatedWidth - 1).isAllOnes() &&
+			 !(input.getSign() && truncated.significand.extract(truncatedWidth - 2, 0).isAllZeros()))); // -2^{n-1} is the only safe "overflow" case
+   probabilityAnnotation<t>(undefinedResult, LIKELY); // Convertable values are rare
+
+   // Modular so that -2^{n-1} and the undefined cases are safe
+   sbv magnitude(truncated.significand.toSigned());
    sbv result(ITE(undefinedResult,
 		  undefValue,
-		  conditionalNegate<t,sbv,prop>(input.getSign(), rounded.significand.toSigned())));
+		  ITE(input.getSign(), magnitude.modularNegate(), magnitude)));
 
    return result;
  }
 
+
+ // Saturating versions, as used for quantisation.  Out of range values
+ // go to the nearest representable value and NaN goes to zero.
+ template <class t>
+   typename t::ubv convertFloatToUBVSaturating (const typename t::fpt &format,
+						const typename t::rm &roundingMode,
+						const unpackedFloat<t> &input,
+						const typename t::bwt &targetWidth,
+						const typename t::bwt &decimalPointPosition = 0) {
+   typedef typename t::ubv ubv;
+
+   // Negative values that do not round to zero saturate to zero
+   ubv saturated(ITE(input.getNaN() || input.getSign(),
+		     ubv::zero(targetWidth),
+		     ubv::allOnes(targetWidth)));
+
+   return convertFloatToUBV(format, roundingMode, input, targetWidth, saturated, decimalPointPosition);
+ }
+
+ template <class t>
+   typename t::sbv convertFloatToSBVSaturating (const typename t::fpt &format,
+						const typename t::rm &roundingMode,
+						const unpackedFloat<t> &input,
+						const typename t::bwt &targetWidth,
+						const typename t::bwt &decimalPointPosition = 0) {
+   typedef typename t::sbv sbv;
+
+   sbv saturated(ITE(input.getNaN(),
+		     sbv::zero(targetWidth),
+		     ITE(input.getSign(),
+			 sbv::minValue(targetWidth),
+			 sbv::maxValue(targetWidth))));
+
+   return convertFloatToSBV(format, roundingMode, input, targetWidth, saturated, decimalPointPosition);
+ }
+
 }
 
 #endif
@@ -30,6 +30,7 @@
 #include "symfpu/core/ite.h"
 #include "symfpu/core/rounder.h"
 #include "symfpu/core/operations.h"
+#include "symfpu/core/convert.h"
 
 #ifndef SYMFPU_DIVIDE
 #define SYMFPU_DIVIDE
@@ -165,6 +166,38 @@ template <class t>
  }
 
 
+// Reads sourceFormat and rounds once into targetFormat.  The quotient
+// is computed to the precision of the wider of the two.
+template <class t>
+  unpackedFloat<t> divide (const typename t::fpt &sourceFormat,
+			   const typename t::fpt &targetFormat,
+			   const typename t::rm &roundingMode,
+			   const unpackedFloat<t> &left,
+			   const unpackedFloat<t> &right) {
+  typedef typename t::fpt fpt;
+
+  PRECONDITION(left.valid(sourceFormat));
+  PRECONDITION(right.valid(sourceFormat));
+
+  fpt workingFormat(commonFormat<t>(sourceFormat, targetFormat));
+
+  // Strict extensions so the rounding mode does not matter
+  unpackedFloat<t> extendedLeft(convertFloatToFloat(sourceFormat, workingFormat, t::RTZ(), left));
+  unpackedFloat<t> extendedRight(convertFloatToFloat(sourceFormat, workingFormat, t::RTZ(), right));
+
+  unpackedFloat<t> divideResult(arithmeticDivide(workingFormat, extendedLeft, extendedRight));
+
+  unpackedFloat<t> roundedDivideResult(rounder(targetFormat, roundingMode, divideResult));
+
+  // The special cases only use the flags of left and right
+  unpackedFloat<t> result(addDivideSpecialCases(targetFormat, left, right, roundedDivideResult.getSign(), roundedDivideResult));
+
+  POSTCONDITION(result.valid(targetFormat));
+
+  return result;
+ }
+
+
 }
 
 #endif
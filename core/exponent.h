@@ -0,0 +1,240 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** exponent.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** Operations that mostly act on the exponent : scaleB, logB, nextUp and
+** nextDown.  As the unpacked format keeps subnormals normalised, these
+** do not need the multiplier or adder.
+**
+*/
+
+#include "symfpu/core/unpackedFloat.h"
+#include "symfpu/core/ite.h"
+#include "symfpu/core/operations.h"
+#include "symfpu/core/rounder.h"
+#include "symfpu/core/sign.h"
+
+#ifndef SYMFPU_EXPONENT
+#define SYMFPU_EXPONENT
+
+namespace symfpu {
+
+// uf * 2^scale, where scale can be any width.  Within the normal range
+// this is exact and just the sum of the exponents, the rounder is only
+// needed for subnormal results, underflow and overflow.
+template <class t>
+  unpackedFloat<t> scaleB (const typename t::fpt &format,
+			   const typename t::rm &roundingMode,
+			   const unpackedFloat<t> &uf,
+			   const typename t::sbv &scale) {
+
+  typedef typename t::bwt bwt;
+  typedef typename t::prop prop;
+  typedef typename t::ubv ubv;
+  typedef typename t::sbv sbv;
+
+  PRECONDITION(uf.valid(format));
+
+  // Scaling by more than the width of the exponent range always over
+  // or underflows so wide scales can be brought into range.
+  bwt exponentWidth(uf.getExponent().getWidth());
+  bwt scaleWidth(exponentWidth + 2);
+  bwt limit(unpackedFloat<t>::maximumExponentDifference(format) + 2);
+
+  sbv workingScale((scale.getWidth() > scaleWidth) ?
+		   collar<t>(scale,
+			     sbv(scale.getWidth(), limit).modularNegate(),
+			     sbv(scale.getWidth(), limit)).resize(scaleWidth) :
+		   scale.matchWidth(sbv::zero(scaleWidth)));
+
+  sbv exponent(uf.getExponent().extend(3) + workingScale.extend(1));  // Can not overflow
+
+
+  // Normal results
+  prop inNormalRange((unpackedFloat<t>::minNormalExponent(format).matchWidth(exponent) <= exponent) &&
+		     (exponent <= unpackedFloat<t>::maxNormalExponent(format).matchWidth(exponent)));
+  probabilityAnnotation<t>(inNormalRange, LIKELY);
+
+  sbv normalExponent(collar<t>(exponent,
+			       unpackedFloat<t>::minNormalExponent(format).matchWidth(exponent),
+			       unpackedFloat<t>::maxNormalExponent(format).matchWidth(exponent)));
+  unpackedFloat<t> normal(uf.getSign(),
+			  normalExponent.contract(3),  // Safe due to collar, only used when inNormalRange
+			  uf.getSignificand());
+
+
+  // Otherwise round, with exponents below the subnormals or above
+  // the normals collared to values that still under or overflow
+  bwt targetExponentWidth(exponentWidth + 1);
+  sbv lowest(unpackedFloat<t>::minSubnormalExponent(format).extend(1) - sbv(targetExponentWidth, 2));
+  sbv highest(unpackedFloat<t>::maxNormalExponent(format).extend(1).increment());
+  sbv roundingExponent(collar<t>(exponent,
+				 lowest.matchWidth(exponent),
+				 highest.matchWidth(exponent)).resize(targetExponentWidth));
+
+  unpackedFloat<t> rounded(rounder(format, roundingMode,
+				   unpackedFloat<t>(uf.getSign(), roundingExponent,
+						    uf.getSignificand().append(ubv::zero(2)))));
+
+
+  unpackedFloat<t> result(ITE(uf.getNaN() || uf.getInf() || uf.getZero(),
+			      uf,
+			      ITE(inNormalRange, normal, rounded)));
+
+  POSTCONDITION(result.valid(format));
+
+  return result;
+ }
+
+
+// The exponent of uf as a signed integer, which is exact for
+// subnormals as they are normalised.  As with conversion to bit-vectors
+// the result for zero, infinity and NaN is given by undefValue.
+template <class t>
+  typename t::sbv logB (const typename t::fpt &format,
+			const unpackedFloat<t> &uf,
+			const typename t::sbv &undefValue) {
+
+  typedef typename t::sbv sbv;
+
+  PRECONDITION(uf.valid(format));
+  PRECONDITION(undefValue.getWidth() == uf.getExponent().getWidth());
+
+  sbv result(ITE(uf.getNaN() || uf.getInf() || uf.getZero(),
+		 undefValue,
+		 uf.getExponent()));
+
+  return result;
+ }
+
+
+// The least value greater than uf.  A unit in the last place is added
+// to or taken from the significand, where for subnormals the last
+// place is moved up by the subnormal amount.  The exponent only
+// changes when the significand carries or loses its leading bit.
+template <class t>
+  unpackedFloat<t> nextUp (const typename t::fpt &format,
+			   const unpackedFloat<t> &uf) {
+
+  typedef typename t::bwt bwt;
+  typedef typename t::prop prop;
+  typedef typename t::ubv ubv;
+  typedef typename t::sbv sbv;
+
+  PRECONDITION(uf.valid(format));
+
+  bwt significandWidth(unpackedFloat<t>::significandWidth(format));
+  bwt workingWidth(significandWidth + 2);
+
+  // One bit for the carry and one below for the smaller last place
+  // of the next binade down
+  ubv working(uf.getSignificand().extend(1).append(ubv::zero(1)));
+
+  ubv subnormalAmount(uf.getSubnormalAmount(format).toUnsigned().matchWidth(working));
+  ubv lastPlace(ubv::one(workingWidth) << subnormalAmount.increment());
+  ubv halfLastPlace(ubv::one(workingWidth) << subnormalAmount);
+
+  sbv exponent(uf.getExponent().extend(1));  // So that the steps can not overflow
+
+
+  // Away from zero
+  ubv increased(working + lastPlace);
+  prop carry(increased.extract(workingWidth - 1, workingWidth - 1).isAllOnes());
+
+  sbv increasedExponent(conditionalIncrement<t>(carry, exponent));
+  ubv increasedSignificand(ITE(carry,
+			       increased.extract(workingWidth - 1, 2),
+			       increased.extract(workingWidth - 2, 1)));
+  prop overflow(increasedExponent > unpackedFloat<t>::maxNormalExponent(format).matchWidth(increasedExponent));
+
+
+  // Towards zero, the last place is smaller in the next binade down
+  // unless that is subnormal
+  prop powerOfTwo(uf.getSignificand() == unpackedFloat<t>::leadingOne(significandWidth));
+  prop smallerStep(powerOfTwo &&
+		   (uf.getExponent() > unpackedFloat<t>::minNormalExponent(format)));
+  ubv decreased(working - ITE(smallerStep, halfLastPlace, lastPlace));
+  prop borrow(decreased.extract(workingWidth - 2, workingWidth - 2).isAllZeros());
+
+  sbv decreasedExponent(conditionalDecrement<t>(borrow, exponent));
+  ubv decreasedSignificand(ITE(borrow,
+			       decreased.extract(workingWidth - 3, 0),
+			       decreased.extract(workingWidth - 2, 1)));
+  prop underflow(decreased.isAllZeros());
+
+
+  // Put it back together
+  prop awayFromZero(!uf.getSign());
+  unpackedFloat<t> finite(ITE(awayFromZero,
+			      ITE(overflow,
+				  unpackedFloat<t>::makeInf(format, prop(false)),
+				  unpackedFloat<t>(uf.getSign(),
+						   collar<t>(increasedExponent,
+							     exponent,
+							     unpackedFloat<t>::maxNormalExponent(format).matchWidth(exponent)).contract(1),
+						   increasedSignificand)),
+			      ITE(underflow,
+				  unpackedFloat<t>::makeZero(format, prop(true)),
+				  unpackedFloat<t>(uf.getSign(),
+						   collar<t>(decreasedExponent,
+							     unpackedFloat<t>::minSubnormalExponent(format).matchWidth(exponent),
+							     exponent).contract(1),
+						   decreasedSignificand))));
+
+  unpackedFloat<t> max(prop(true),
+		       unpackedFloat<t>::maxNormalExponent(format),
+		       ubv::allOnes(significandWidth));
+  unpackedFloat<t> min(prop(false),
+		       unpackedFloat<t>::minSubnormalExponent(format),
+		       unpackedFloat<t>::leadingOne(significandWidth));
+
+  unpackedFloat<t> result(ITE(uf.getNaN(),
+			      uf,
+			      ITE(uf.getInf(),
+				  ITE(uf.getSign(), max, uf),
+				  ITE(uf.getZero(),
+				      min,
+				      finite))));
+
+  POSTCONDITION(result.valid(format));
+
+  return result;
+ }
+
+
+// The greatest value less than uf
+template <class t>
+  unpackedFloat<t> nextDown (const typename t::fpt &format,
+			     const unpackedFloat<t> &uf) {
+  PRECONDITION(uf.valid(format));
+
+  unpackedFloat<t> result(negate(format, nextUp(format, negate(format, uf))));
+
+  POSTCONDITION(result.valid(format));
+
+  return result;
+ }
+
+}
+
+#endif
@@ -130,6 +130,87 @@ namespace symfpu {
    return result;
  }
 
+
+ // Reads sourceFormat and rounds once into targetFormat.  As with fma
+ // there is a second rounder for when only one of the product and the
+ // addend is zero, which here also rounds the addend to targetFormat.
+ template <class t>
+   unpackedFloat<t> fma (const typename t::fpt &sourceFormat,
+			 const typename t::fpt &targetFormat,
+			 const typename t::rm &roundingMode,
+			 const unpackedFloat<t> &leftMultiply,
+			 const unpackedFloat<t> &rightMultiply,
+			 const unpackedFloat<t> &addArgument) {
+
+   typedef typename t::prop prop;
+   typedef typename t::fpt fpt;
+
+   PRECONDITION(leftMultiply.valid(sourceFormat));
+   PRECONDITION(rightMultiply.valid(sourceFormat));
+   PRECONDITION(addArgument.valid(sourceFormat));
+
+   fpt workingFormat(commonFormat<t>(sourceFormat, targetFormat));
+
+   // Strict extensions so the rounding mode does not matter
+   unpackedFloat<t> workingLeft(convertFloatToFloat(sourceFormat, workingFormat, t::RTZ(), leftMultiply));
+   unpackedFloat<t> workingRight(convertFloatToFloat(sourceFormat, workingFormat, t::RTZ(), rightMultiply));
+   unpackedFloat<t> workingAdd(convertFloatToFloat(sourceFormat, workingFormat, t::RTZ(), addArgument));
+
+   /* First multiply */
+   unpackedFloat<t> arithmeticMultiplyResult(arithmeticMultiply(workingFormat, workingLeft, workingRight));
+
+   fpt extendedFormat(workingFormat.exponentWidth() + 1, workingFormat.significandWidth() * 2);
+   INVARIANT(arithmeticMultiplyResult.valid(extendedFormat));
+
+   /* Then add */
+   unpackedFloat<t> extendedAddArgument(convertFloatToFloat(workingFormat, extendedFormat, t::RTZ(), workingAdd));
+
+   prop knownInCorrectOrder(false);
+   exponentCompareInfo<t> ec(addExponentCompare<t>(arithmeticMultiplyResult.getExponent().getWidth() + 1,
+						   arithmeticMultiplyResult.getSignificand().getWidth(),
+						   arithmeticMultiplyResult.getExponent(),
+						   extendedAddArgument.getExponent(),
+						   knownInCorrectOrder));
+
+   unpackedFloat<t> additionResult(arithmeticAdd(extendedFormat, roundingMode, arithmeticMultiplyResult, extendedAddArgument, prop(true), knownInCorrectOrder, ec).uf);
+
+   /* Then round */
+   unpackedFloat<t> roundedResult(rounder(targetFormat, roundingMode, additionResult));
+
+   prop productIsZero(leftMultiply.getZero() || rightMultiply.getZero());
+   unpackedFloat<t> roundedMultiplyOrAddResult(rounder(targetFormat, roundingMode,
+							ITE(productIsZero,
+							    extendedAddArgument,
+							    arithmeticMultiplyResult)));
+
+   /* Finally, the special cases, which otherwise only use the flags */
+   unpackedFloat<t> fullMultiplyResult(addMultiplySpecialCases(targetFormat, leftMultiply, rightMultiply,
+							       roundedMultiplyOrAddResult.getSign(), roundedMultiplyOrAddResult));
+
+   unpackedFloat<t> dummyZero(unpackedFloat<t>::makeZero(targetFormat, prop(false)));
+   unpackedFloat<t> dummyValue(dummyZero.getSign(), dummyZero.getExponent(), dummyZero.getSignificand());
+
+   unpackedFloat<t> multiplyResultWithSpecialCases(addMultiplySpecialCases(targetFormat, leftMultiply, rightMultiply, arithmeticMultiplyResult.getSign(), dummyValue));
+
+   prop productIsFinite(!leftMultiply.getNaN() && !leftMultiply.getInf() &&
+			!rightMultiply.getNaN() && !rightMultiply.getInf());
+   prop addIsNumber(!addArgument.getNaN() && !addArgument.getInf() && !addArgument.getZero());
+
+   unpackedFloat<t> result(ITE(productIsZero && productIsFinite && addIsNumber,
+			       roundedMultiplyOrAddResult,
+			       addAdditionSpecialCasesWithID(targetFormat,
+							     roundingMode,
+							     multiplyResultWithSpecialCases,
+							     fullMultiplyResult, // for the identity case
+							     unpackedFloat<t>::makeSpecialsOnly(targetFormat, addArgument),
+							     roundedResult,
+							     prop(true))));
+
+   POSTCONDITION(result.valid(targetFormat));
+
+   return result;
+ }
+
 /*
  * BUGS : 
  * 1. sign of zero different for exact 0 and underflow
@@ -0,0 +1,120 @@
+/*
+** Copyright (C) 2018 Martin Brain
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+** 
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+** 
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+** instantiate.h
+**
+** Martin Brain
+** martin.brain@cs.ox.ac.uk
+** 18/10/26
+**
+** Explicit instantiation of the user-facing operations for a given
+** set of traits.  One translation unit should use
+**
+**   SYMFPU_INSTANTIATE(template, T)
+**
+** to compile them once and any others can then use
+**
+**   SYMFPU_INSTANTIATE(extern template, T)
+**
+** (at namespace scope, after including this file) to link against
+** those rather than instantiating their own copy.
+** SYMFPU_INSTANTIATE_SIGNED_CONVERSION is used in the same way.
+**
+*/
+
+
+#include "symfpu/core/unpackedFloat.h"
+#include "symfpu/core/packing.h"
+#include "symfpu/core/sign.h"
+#include "symfpu/core/classify.h"
+#include "symfpu/core/compare.h"
+#include "symfpu/core/multiply.h"
+#include "symfpu/core/add.h"
+#include "symfpu/core/divide.h"
+#include "symfpu/core/sqrt.h"
+#include "symfpu/core/fma.h"
+#include "symfpu/core/remainder.h"
+#include "symfpu/core/exponent.h"
+#include "symfpu/core/convert.h"
+
+#ifndef SYMFPU_INSTANTIATE_H
+#define SYMFPU_INSTANTIATE_H
+
+#define SYMFPU_INSTANTIATE_UNARY_PROP(KIND, T, F)			\
+  KIND T::prop symfpu::F<T> (const T::fpt &, const symfpu::unpackedFloat<T> &);
+
+#define SYMFPU_INSTANTIATE_BINARY_PROP(KIND, T, F)			\
+  KIND T::prop symfpu::F<T> (const T::fpt &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &);
+
+#define SYMFPU_INSTANTIATE(KIND, T)					\
+  KIND symfpu::unpackedFloat<T> symfpu::unpack<T> (const T::fpt, const T::ubv &); \
+  KIND T::ubv symfpu::pack<T> (const T::fpt &, const symfpu::unpackedFloat<T> &); \
+									\
+  KIND symfpu::unpackedFloat<T> symfpu::negate<T> (const T::fpt &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::absolute<T> (const T::fpt &, const symfpu::unpackedFloat<T> &); \
+									\
+  SYMFPU_INSTANTIATE_UNARY_PROP(KIND, T, isNormal)			\
+  SYMFPU_INSTANTIATE_UNARY_PROP(KIND, T, isSubnormal)			\
+  SYMFPU_INSTANTIATE_UNARY_PROP(KIND, T, isZero)			\
+  SYMFPU_INSTANTIATE_UNARY_PROP(KIND, T, isInfinite)			\
+  SYMFPU_INSTANTIATE_UNARY_PROP(KIND, T, isNaN)				\
+  SYMFPU_INSTANTIATE_UNARY_PROP(KIND, T, isPositive)			\
+  SYMFPU_INSTANTIATE_UNARY_PROP(KIND, T, isNegative)			\
+									\
+  SYMFPU_INSTANTIATE_BINARY_PROP(KIND, T, smtlibEqual)			\
+  SYMFPU_INSTANTIATE_BINARY_PROP(KIND, T, ieee754Equal)			\
+  SYMFPU_INSTANTIATE_BINARY_PROP(KIND, T, lessThan)			\
+  SYMFPU_INSTANTIATE_BINARY_PROP(KIND, T, lessThanOrEqual)		\
+  KIND symfpu::unpackedFloat<T> symfpu::max<T> (const T::fpt &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &, const T::prop &); \
+  KIND symfpu::unpackedFloat<T> symfpu::min<T> (const T::fpt &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &, const T::prop &); \
+									\
+  KIND symfpu::unpackedFloat<T> symfpu::add<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &, const T::prop &); \
+  KIND symfpu::unpackedFloat<T> symfpu::multiply<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::stochasticAdd<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &, const T::prop &, const T::ubv &); \
+  KIND symfpu::unpackedFloat<T> symfpu::stochasticMultiply<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &, const T::ubv &); \
+  KIND symfpu::augmentedResult<T> symfpu::augmentedAdd<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &, const T::prop &); \
+  KIND symfpu::augmentedResult<T> symfpu::augmentedMultiply<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::divide<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::sqrt<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::fma<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::add<T> (const T::fpt &, const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &, const T::prop &); \
+  KIND symfpu::unpackedFloat<T> symfpu::multiply<T> (const T::fpt &, const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::divide<T> (const T::fpt &, const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::sqrt<T> (const T::fpt &, const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::fma<T> (const T::fpt &, const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::remainder<T> (const T::fpt &, const symfpu::unpackedFloat<T> &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::scaleB<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const T::sbv &); \
+  KIND T::sbv symfpu::logB<T> (const T::fpt &, const symfpu::unpackedFloat<T> &, const T::sbv &); \
+  KIND symfpu::unpackedFloat<T> symfpu::nextUp<T> (const T::fpt &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::nextDown<T> (const T::fpt &, const symfpu::unpackedFloat<T> &); \
+									\
+  KIND symfpu::unpackedFloat<T> symfpu::roundToIntegral<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::convertFloatToFloat<T> (const T::fpt &, const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &); \
+  KIND symfpu::unpackedFloat<T> symfpu::convertUBVToFloat<T> (const T::fpt &, const T::rm &, const T::ubv &, const T::bwt &); \
+  KIND T::ubv symfpu::convertFloatToUBV<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const T::bwt &, const T::ubv &, const T::bwt &); \
+  KIND T::ubv symfpu::convertFloatToUBVSaturating<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const T::bwt &, const T::bwt &); \
+  KIND T::ubv symfpu::convertFloatToUBVRTZ<T> (const T::fpt &, const symfpu::unpackedFloat<T> &, const T::bwt &, const T::ubv &, const T::bwt &);
+
+// Needs extract on signed bit-vectors, which not all back-ends provide
+#define SYMFPU_INSTANTIATE_SIGNED_CONVERSION(KIND, T)			\
+  KIND symfpu::unpackedFloat<T> symfpu::convertSBVToFloat<T> (const T::fpt &, const T::rm &, const T::sbv &, const T::bwt &); \
+  KIND T::sbv symfpu::convertFloatToSBV<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const T::bwt &, const T::sbv &, const T::bwt &); \
+  KIND T::sbv symfpu::convertFloatToSBVSaturating<T> (const T::fpt &, const T::rm &, const symfpu::unpackedFloat<T> &, const T::bwt &, const T::bwt &); \
+  KIND T::sbv symfpu::convertFloatToSBVRTZ<T> (const T::fpt &, const symfpu::unpackedFloat<T> &, const T::bwt &, const T::sbv &, const T::bwt &);
+
+#endif
@@ -30,6 +30,7 @@
 #include "symfpu/core/ite.h"
 #include "symfpu/core/rounder.h"
 #include "symfpu/core/operations.h"
+#include "symfpu/core/convert.h"
 
 #ifndef SYMFPU_MULTIPLY
 #define SYMFPU_MULTIPLY
@@ -150,6 +151,95 @@ template <class t>
  }
 
 
+// Reads sourceFormat and rounds once into targetFormat, rather than
+// converting before or after.  The product is exact so it is only the
+// exponent and significand widths that change.
+template <class t>
+  unpackedFloat<t> multiply (const typename t::fpt &sourceFormat,
+			     const typename t::fpt &targetFormat,
+			     const typename t::rm &roundingMode,
+			     const unpackedFloat<t> &left,
+			     const unpackedFloat<t> &right) {
+  typedef typename t::fpt fpt;
+
+  PRECONDITION(left.valid(sourceFormat));
+  PRECONDITION(right.valid(sourceFormat));
+
+  fpt workingFormat(commonFormat<t>(sourceFormat, targetFormat));
+
+  // Strict extensions so the rounding mode does not matter
+  unpackedFloat<t> extendedLeft(convertFloatToFloat(sourceFormat, workingFormat, t::RTZ(), left));
+  unpackedFloat<t> extendedRight(convertFloatToFloat(sourceFormat, workingFormat, t::RTZ(), right));
+
+  unpackedFloat<t> multiplyResult(arithmeticMultiply(workingFormat, extendedLeft, extendedRight));
+
+  unpackedFloat<t> roundedMultiplyResult(rounder(targetFormat, roundingMode, multiplyResult));
+
+  // The special cases only use the flags of left and right
+  unpackedFloat<t> result(addMultiplySpecialCases(targetFormat, left, right, roundedMultiplyResult.getSign(), roundedMultiplyResult));
+
+  POSTCONDITION(result.valid(targetFormat));
+
+  return result;
+ }
+
+
+// As multiply but rounds stochastically (see stochasticRoundingDecision).
+// roundingMode is still used to decide overflow and underflow.
+template <class t>
+  unpackedFloat<t> stochasticMultiply (const typename t::fpt &format,
+				       const typename t::rm &roundingMode,
+				       const unpackedFloat<t> &left,
+				       const unpackedFloat<t> &right,
+				       const typename t::ubv &randomBits) {
+
+  PRECONDITION(left.valid(format));
+  PRECONDITION(right.valid(format));
+
+  unpackedFloat<t> multiplyResult(arithmeticMultiply(format, left, right));
+
+  unpackedFloat<t> roundedMultiplyResult(stochasticRounder(format, roundingMode, multiplyResult, randomBits));
+
+  unpackedFloat<t> result(addMultiplySpecialCases(format, left, right, roundedMultiplyResult.getSign(), roundedMultiplyResult));
+
+  POSTCONDITION(result.valid(format));
+
+  return result;
+ }
+
+
+// The rounded product and its rounding error.  With one of the nearest
+// rounding modes the error is exact unless it is below the subnormal
+// range, so with RNE this is TwoProduct.  If the product overflows or
+// is NaN the error is the same as the product.
+template <class t>
+  augmentedResult<t> augmentedMultiply (const typename t::fpt &format,
+					const typename t::rm &roundingMode,
+					const unpackedFloat<t> &left,
+					const unpackedFloat<t> &right) {
+
+  PRECONDITION(left.valid(format));
+  PRECONDITION(right.valid(format));
+
+  unpackedFloat<t> multiplyResult(arithmeticMultiply(format, left, right));  // Exact
+
+  unpackedFloat<t> roundedMultiplyResult(rounder(format, roundingMode, multiplyResult));
+
+  unpackedFloat<t> result(addMultiplySpecialCases(format, left, right, roundedMultiplyResult.getSign(), roundedMultiplyResult));
+
+  unpackedFloat<t> error(ITE(result.getNaN() || result.getInf(),
+			     result,
+			     ITE(left.getZero() || right.getZero(),
+				 unpackedFloat<t>::makeZero(format, result.getSign()),
+				 roundingError(format, roundingMode, multiplyResult, roundedMultiplyResult))));
+
+  POSTCONDITION(result.valid(format));
+  POSTCONDITION(error.valid(format));
+
+  return augmentedResult<t>(result, error);
+ }
+
+
 }
 
 #endif
@@ -31,6 +31,7 @@
 */
 
 #include <cassert>
+#include <cstddef>
 #include <map>
 
 #include "../utils/common.h"
@@ -580,6 +581,44 @@ namespace symfpu {
 
     return resultWithRemainderBit<t>(step << ubv::one(xWidth), canSubtract);
   }
+
+  // The divide steps of remainder.  x and y are aligned significands
+  // and the result is what is left after dividing x * 2^difference by
+  // y to all but the last bit of the integer quotient, shifted as
+  // divideStep does.  If difference <= 0 this is just x.
+  // One step is built for each possible difference.
+  template <class t>
+  typename t::ubv remainderDivideSteps (const typename t::ubv &x, const typename t::ubv &y,
+					const typename t::sbv &difference,
+					const typename t::bwt &maxDifference) {
+    typedef typename t::bwt bwt;
+    typedef typename t::ubv ubv;
+    typedef typename t::sbv sbv;
+    typedef typename t::prop prop;
+
+    bwt dWidth(difference.getWidth());
+
+    ubv first(divideStep<t>(x,y).result);
+    ubv *running = new ubv(first); // To avoid running out of stack space loop with a pointer
+
+    for (bwt i = maxDifference - 1; i > 0; i--) {
+      prop needPrevious(difference > sbv(dWidth, i));
+      probabilityAnnotation<t>(needPrevious, (i > (maxDifference / 2)) ? VERYUNLIKELY : UNLIKELY);
+
+      ubv r(ITE(needPrevious, *running, x));
+      delete running;  // We assume the value / reference has been transfered to ITE
+      running = new ubv(divideStep<t>(r, y).result);
+    }
+
+    prop needPrevious(difference > sbv::zero(dWidth));
+    probabilityAnnotation<t>(needPrevious, UNLIKELY);
+
+    ubv result(ITE(needPrevious, *running, x));
+    delete running;
+
+    return result;
+  }
+
 }
 
 #endif
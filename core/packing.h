@@ -88,6 +88,21 @@ namespace symfpu {
     INVARIANT(isZero || isSubnormal || isNormal || isInf || isNaN);
 
     probabilityAnnotation<t,prop>(isSubnormal, UNLIKELY);
+
+    // Denormals-are-zero drops the normalisation altogether
+    if (denormalsAreZero<t>(format)) {
+      unpackedFloat<t> uf(ITE(isNaN,
+			      unpackedFloat<t>::makeNaN(format),
+			      ITE(isInf,
+				  unpackedFloat<t>::makeInf(format, sign),
+				  ITE(isZero || isSubnormal,
+				      unpackedFloat<t>::makeZero(format, sign),
+				      ufNormal))));
+
+      POSTCONDITION(uf.valid(format));
+
+      return uf;
+    }
     
     // Splice together
     unpackedFloat<t> uf(ITE(isNaN,
@@ -136,18 +136,8 @@ template <class t>
   ubv rsig(right.getSignificand().extend(1));
 
   
-  ubv first(divideStep<t>(lsig,rsig).result);
-  ubv *running = new ubv(first); // To avoid running out of stack space loop with a pointer
-
   bwt maxDifference = unpackedFloat<t>::maximumExponentDifference(format);
-  for (bwt i = maxDifference - 1; i > 0; i--) {
-    prop needPrevious(exponentDifference > sbv(edWidth, i));
-    probabilityAnnotation<t>(needPrevious, (i > (maxDifference / 2)) ? VERYUNLIKELY : UNLIKELY);
-    
-    ubv r(ITE(needPrevious, *running, lsig));
-    delete running;  // We assume the value / reference has been transfered to ITE
-    running = new ubv(divideStep<t>(r, rsig).result);
-  }
+  ubv r0(remainderDivideSteps<t>(lsig, rsig, exponentDifference, maxDifference));
 
   // The zero exponent difference case is a little different
   // as we need the result bit for the even flag
@@ -155,10 +145,6 @@ template <class t>
   prop lsbRoundActive(exponentDifference > -sbv::one(edWidth));  // i.e. >= 0
   
   prop needPrevious(exponentDifference > sbv::zero(edWidth));
-  probabilityAnnotation<t>(needPrevious, UNLIKELY);
-    
-  ubv r0(ITE(needPrevious, *running, lsig));
-  delete running;
   resultWithRemainderBit<t> dsr(divideStep<t>(r0, rsig));
 
   prop integerEven(!lsbRoundActive || !dsr.remainderBit);  // Note negation of guardBit
@@ -57,10 +57,15 @@
  *   open question.
  *
  * - add a 'non-deterministic rounding' mode for underapproximation.
+ *   (stochastic rounding with caller supplied random bits is done,
+ *    see stochasticRoundingDecision)
  *
- * - add 'round-to-odd' and 'round-away-from-zero' mode
+ * - add 'round-away-from-zero' mode
+ *   (round-to-odd is done for back-ends that provide RTO(),
+ *    see isRoundToOdd)
  *
  * - add 'flush subnormals to zero' option
+ *   (done as a property of the format, see flushToZeroRounder)
  *
  * - Rather than increment and re-align, take all but the top bit of the
  *   significand, concatinate on to the exponent and then increment.
@@ -103,6 +108,39 @@
 
 namespace symfpu {
 
+  // Round-to-odd truncates and then sets the last bit if anything was
+  // discarded.  Computing in a format at least two bits wider with
+  // round-to-odd and then rounding to the target is a single rounding.
+  // As not all back-ends can represent it, it is optional and traits
+  // that support it provide an RTO() alongside the other modes.
+  template <class t>
+  class hasRoundToOdd {
+    template <class u> static char test (decltype(&u::RTO));
+    template <class u> static long test (...);
+  public :
+    static const bool value = (sizeof(test<t>(NULL)) == sizeof(char));
+  };
+
+  template <class t, bool supported = hasRoundToOdd<t>::value>
+  struct roundToOddMode {
+    static typename t::prop test (const typename t::rm &) {
+      return typename t::prop(false);
+    }
+  };
+
+  template <class t>
+  struct roundToOddMode<t, true> {
+    static typename t::prop test (const typename t::rm &roundingMode) {
+      return roundingMode == t::RTO();
+    }
+  };
+
+  template <class t>
+    typename t::prop isRoundToOdd (const typename t::rm &roundingMode) {
+    return roundToOddMode<t>::test(roundingMode);
+  }
+
+
   // The final reconstruction of the rounded result
   // Handles the overflow and underflow conditions
   template <class t>
@@ -118,14 +156,14 @@ namespace symfpu {
 
     /*** Underflow and overflow ***/
     
-    // On overflow either return inf or max
+    // On overflow either return inf or max (which is odd)
     prop returnInf(roundingMode == t::RNE() || 
 		   roundingMode == t::RNA() ||
 		   (roundingMode == t::RTP() && !roundedResult.getSign()) ||
 		   (roundingMode == t::RTN() &&  roundedResult.getSign()));
     probabilityAnnotation<t>(returnInf, LIKELY);  // Inf is more likely than max in most application scenarios
     
-    // On underflow either return 0 or minimum subnormal
+    // On underflow either return 0 or minimum subnormal (which is odd)
     prop returnZero(roundingMode == t::RNE() || 
 		    roundingMode == t::RNA() ||
 		    roundingMode == t::RTZ() ||
@@ -167,8 +205,39 @@ namespace symfpu {
     prop roundUpRTP(roundingMode == t::RTP() && !sign && (guardBit || stickyBit));
     prop roundUpRTN(roundingMode == t::RTN() &&  sign && (guardBit || stickyBit));
     prop roundUpRTZ(roundingMode == t::RTZ() && prop(false));
+    // Only rounds up from even so can not carry
+    prop roundUpRTO(isRoundToOdd<t>(roundingMode) && significandEven && (guardBit || stickyBit));
     prop roundUp(!knownRoundDown &&
-		 (roundUpRNE || roundUpRNA || roundUpRTP || roundUpRTN || roundUpRTZ));
+		 (roundUpRNE || roundUpRNA || roundUpRTP || roundUpRTN || roundUpRTZ || roundUpRTO));
+
+    return roundUp;
+  }
+
+
+  // Stochastic rounding; round up (away from zero) with probability
+  // proportional to the part of an ULP that is discarded.
+  // discardedBits are the bits that are removed by rounding, most
+  // significant first, and randomBits should be uniformly distributed.
+  // Only as many discarded bits as there are random bits are used,
+  // so with n random bits the probability is accurate to 2^-n.
+  // The sign has no effect as the rounding is of the magnitude.
+  template <class t>
+    typename t::prop stochasticRoundingDecision (const typename t::ubv &discardedBits,
+						 const typename t::ubv &randomBits,
+						 const typename t::prop &knownRoundDown) {
+    typedef typename t::bwt bwt;
+    typedef typename t::prop prop;
+    typedef typename t::ubv ubv;
+
+    bwt discardedWidth(discardedBits.getWidth());
+    bwt randomWidth(randomBits.getWidth());
+
+    ubv aligned((discardedWidth >= randomWidth) ?
+		discardedBits.extract(discardedWidth - 1, discardedWidth - randomWidth) :
+		discardedBits.append(ubv::zero(randomWidth - discardedWidth)));
+
+    // discarded + random overflows, i.e. discarded > 2^n - 1 - random
+    prop roundUp(!knownRoundDown && (aligned > ~randomBits));
 
     return roundUp;
   }
@@ -190,13 +259,15 @@ namespace symfpu {
   // Handles rounding the significand to a fixed width
   // If knownRoundDown is true should simplify to just extract
   // Not quite the same as either rounder so can't quite be refactored
+  // If randomBits is given the rounding is stochastic and roundingMode is not used
   template <class t>
   significandRounderResult<t> fixedPositionRound(const typename t::rm &roundingMode,
 						 const typename t::prop &sign,
 						 const typename t::ubv &significand,
 						 const typename t::bwt &targetWidth,
 						 const typename t::prop &knownLeadingOne,
-						 const typename t::prop &knownRoundDown) {
+						 const typename t::prop &knownRoundDown,
+						 const typename t::ubv *randomBits = NULL) {
     typedef typename t::bwt bwt;
     typedef typename t::prop prop;
     typedef typename t::ubv ubv;
@@ -216,8 +287,11 @@ namespace symfpu {
     prop stickyBit(!significand.extract(guardBitPosition - 1,0).isAllZeros());
 
     // Rounding decision
-    prop roundUp(roundingDecision<t>(roundingMode, sign, significandEven,
-				     guardBit, stickyBit, knownRoundDown));
+    prop roundUp((randomBits == NULL) ?
+		 roundingDecision<t>(roundingMode, sign, significandEven,
+				     guardBit, stickyBit, knownRoundDown) :
+		 stochasticRoundingDecision<t>(significand.extract(guardBitPosition, 0),
+					       *randomBits, knownRoundDown));
 
     // Conditional increment
     ubv roundedSignificand(conditionalIncrement<t>(roundUp, extractedSignificand));
@@ -311,17 +385,129 @@ namespace symfpu {
       subnormalExact(sE), noSignificandOverflow(nSO) {}
   };
   
+// The bits that customRounder removes, most significant first.
+// In the normal case these are the guard and sticky bits, for
+// subnormals the masked out part of the significand comes before them.
+template <class t>
+  typename t::ubv customRounderDiscardedBits (const typename t::ubv &sig,
+					      const typename t::ubv &extractedSignificand,
+					      const typename t::prop &normalRounding,
+					      const typename t::ubv &subnormalMask,
+					      const typename t::ubv &subnormalShift) {
+  typedef typename t::bwt bwt;
+  typedef typename t::ubv ubv;
+
+  bwt sigWidth(sig.getWidth());
+  bwt extractedWidth(extractedSignificand.getWidth());   // Target significand width + 1
+  bwt guardBitPosition(sigWidth - extractedWidth);
+
+  ubv removedSignificand(extractedSignificand &
+			 ITE(normalRounding, ubv::zero(extractedWidth), subnormalMask));
+  ubv allBits(removedSignificand.append(sig.extract(guardBitPosition, 0)));
+
+  // Move the first removed bit to the top
+  ubv shift(ITE(normalRounding,
+		ubv(extractedWidth, extractedWidth),
+		ubv(extractedWidth, extractedWidth).modularAdd(subnormalShift.modularNegate())));
+  return allBits.modularLeftShift(shift.matchWidth(allBits));
+ }
+
+// For formats that flush subnormal results to zero.  Only rounding at
+// a fixed position is needed and anything with an exponent below the
+// normal range after rounding becomes zero, whatever the rounding mode.
+template <class t>
+  unpackedFloat<t> flushToZeroRounder (const typename t::fpt &format,
+				       const typename t::rm &roundingMode,
+				       const unpackedFloat<t> &uf,
+				       const customRounderInfo<t> &known,
+				       const typename t::ubv *randomBits = NULL) {
+
+  typedef typename t::bwt bwt;
+  typedef typename t::prop prop;
+  typedef typename t::ubv ubv;
+  typedef typename t::sbv sbv;
+
+  // Same preconditions as customRounder
+  ubv psig(uf.getSignificand());
+  bwt sigWidth(psig.getWidth());
+  ubv sig(psig | unpackedFloat<t>::leadingOne(sigWidth));
+
+  bwt targetSignificandWidth(unpackedFloat<t>::significandWidth(format));
+  PRECONDITION(sigWidth >= targetSignificandWidth + 2);
+
+  sbv exp(uf.getExponent());
+  bwt expWidth(exp.getWidth());
+  bwt targetExponentWidth(unpackedFloat<t>::exponentWidth(format));
+  PRECONDITION(expWidth >= targetExponentWidth);
+
+
+  /*** Round the significand ***/
+  significandRounderResult<t> rounded(fixedPositionRound<t>(roundingMode, uf.getSign(), sig,
+							    targetSignificandWidth, prop(true),
+							    known.exact, randomBits));
+  prop incrementExponent(!known.noSignificandOverflow && rounded.incrementExponent);
+  sbv correctedExponent(conditionalIncrement<t>(incrementExponent, exp.extend(1)));
+
+
+  /*** Flush and overflow ***/
+  sbv maxNormal(unpackedFloat<t>::maxNormalExponent(format).matchWidth(correctedExponent));
+  sbv minNormal(unpackedFloat<t>::minNormalExponent(format).matchWidth(correctedExponent));
+
+  prop overflow(!known.noOverflow && (correctedExponent > maxNormal));
+  prop flush(correctedExponent < minNormal);
+  probabilityAnnotation<t>(overflow, UNLIKELY);
+  probabilityAnnotation<t>(flush, UNLIKELY);
+
+  sbv correctedExponentInRange(collar<t>(correctedExponent, minNormal, maxNormal));
+  bwt currentExponentWidth(correctedExponentInRange.getWidth());
+  sbv roundedExponent(correctedExponentInRange.contract(currentExponentWidth - targetExponentWidth));
+
+  unpackedFloat<t> roundedResult(uf.getSign(), roundedExponent, rounded.significand);
+  unpackedFloat<t> result(rounderSpecialCases<t>(format, roundingMode, roundedResult,
+						 overflow, prop(false), uf.getZero() || flush));
+
+  POSTCONDITION(result.valid(format));
+
+  return result;
+ }
+
+// Results that are returned without going through a rounder (such as
+// x + 0) need flushing in the same way.  Only builds logic if the
+// format flushes.
+template <class t>
+  unpackedFloat<t> flushSubnormal (const typename t::fpt &format,
+				   const unpackedFloat<t> &uf) {
+  typedef typename t::prop prop;
+
+  if (!flushToZero<t>(format)) {
+    return uf;
+  }
+
+  prop flush(!uf.getNaN() && !uf.getInf() && !uf.getZero() &&
+	     uf.inSubnormalRange(format, prop(true)));
+  probabilityAnnotation<t>(flush, UNLIKELY);
+
+  return ITE(flush,
+	     unpackedFloat<t>::makeZero(format, uf.getSign()),
+	     uf);
+ }
+
 template <class t>
   unpackedFloat<t> customRounder (const typename t::fpt &format,
 				  const typename t::rm &roundingMode,
 				  const unpackedFloat<t> &uf,
-				  const customRounderInfo<t> &known) {
+				  const customRounderInfo<t> &known,
+				  const typename t::ubv *randomBits = NULL) {
 
   typedef typename t::bwt bwt;
   typedef typename t::prop prop;
   typedef typename t::ubv ubv;
   typedef typename t::sbv sbv;
 
+  if (flushToZero<t>(format)) {
+    return flushToZeroRounder(format, roundingMode, uf, known, randomBits);
+  }
+
   //PRECONDITION(uf.valid(format));
   // Not a precondition because
   //  1. Exponent and significand may be extended.
@@ -425,9 +611,15 @@ template <class t>
   prop significandEven(ITE(normalRounding,
 			   extractedSignificand.extract(0,0).isAllZeros(),
 			   ((extractedSignificand & subnormalIncrementAmount).isAllZeros())));
-  prop roundUp(roundingDecision<t>(roundingMode, uf.getSign(), significandEven,
+  prop knownRoundDown(known.exact || (known.subnormalExact && !normalRoundingRange));
+  prop roundUp((randomBits == NULL) ?
+	       roundingDecision<t>(roundingMode, uf.getSign(), significandEven,
 				   choosenGuardBit, choosenStickyBit,
-				   known.exact || (known.subnormalExact && !normalRoundingRange)));
+				   knownRoundDown) :
+	       stochasticRoundingDecision<t>(customRounderDiscardedBits<t>(sig, extractedSignificand,
+									   normalRounding, subnormalMask,
+									   subnormalShiftPrepared),
+					     *randomBits, knownRoundDown));
 
 
   // Perform the increment as needed
@@ -674,6 +866,20 @@ unpackedFloat<t> originalRounder (const typename t::fpt &format,
  }
 
 
+// Rounds up with probability proportional to the discarded part of an
+// ULP, see stochasticRoundingDecision.  roundingMode is only used to
+// decide the result on overflow and underflow.
+template <class t>
+  unpackedFloat<t> stochasticRounder (const typename t::fpt &format,
+				      const typename t::rm &roundingMode,
+				      const unpackedFloat<t> &uf,
+				      const typename t::ubv &randomBits) {
+  typedef typename t::prop prop;
+  customRounderInfo<t> cri(prop(false), prop(false), prop(false), prop(false), prop(false));
+
+  return customRounder(format, roundingMode, uf, cri, &randomBits);
+ }
+
 template <class t>
   unpackedFloat<t> rounder (const typename t::fpt &format,
 			    const typename t::rm &roundingMode,
@@ -682,6 +888,9 @@ template <class t>
   customRounderInfo<t> cri(prop(false), prop(false), prop(false), prop(false), prop(false));  // Default is to know nothing
 
   #ifdef USE_ORIGINAL_ROUNDER
+  if (flushToZero<t>(format)) {
+    return flushToZeroRounder(format, roundingMode, uf, cri);
+  }
   return originalRounder(format, roundingMode, uf);  // Allow old versions to be compared
   #else
   return customRounder(format, roundingMode, uf, cri);
@@ -689,6 +898,103 @@ template <class t>
  }
 
 
+// A rounded result together with the difference between it and the
+// exact value, as returned by the augmented operations.
+template <class t>
+struct augmentedResult {
+  unpackedFloat<t> value;
+  unpackedFloat<t> error;
+
+  augmentedResult(const unpackedFloat<t> &v, const unpackedFloat<t> &e) : value(v), error(e) {}
+  augmentedResult(const augmentedResult<t> &old) : value(old.value), error(old.error) {}
+};
+
+// Rounds a normalised error.  The error is no larger than the value it
+// comes from so only the bottom of the exponent range needs keeping and
+// the rounder can be given one bit more than format's unpacked exponent.
+template <class t>
+  unpackedFloat<t> errorRounder (const typename t::fpt &format,
+				 const typename t::rm &roundingMode,
+				 const unpackedFloat<t> &normalised) {
+  typedef typename t::bwt bwt;
+  typedef typename t::sbv sbv;
+
+  bwt targetExponentWidth(unpackedFloat<t>::exponentWidth(format) + 1);
+  sbv lowest(unpackedFloat<t>::minSubnormalExponent(format).extend(1) - sbv(targetExponentWidth, 2));
+  sbv highest(unpackedFloat<t>::maxNormalExponent(format).extend(1));
+  sbv clampedExponent(collar<t>(normalised.getExponent(),
+				lowest.matchWidth(normalised.getExponent()),
+				highest.matchWidth(normalised.getExponent())).resize(targetExponentWidth));
+
+  return rounder(format, roundingMode,
+		 unpackedFloat<t>(normalised.getSign(), clampedExponent, normalised.getSignificand()));
+ }
+
+// exact - rounded, where rounded is the rounding of exact to format and
+// exact is non-zero and finite.  Both have their leading bit at the
+// exponent or rounded has carried up to the next one, so the
+// difference can be found by aligning the significands rather than a
+// full subtraction.  The difference is then rounded to format, which
+// is exact for nearest rounding unless the result underflows.
+template <class t>
+  unpackedFloat<t> roundingError (const typename t::fpt &format,
+				  const typename t::rm &roundingMode,
+				  const unpackedFloat<t> &exact,
+				  const unpackedFloat<t> &rounded) {
+  typedef typename t::bwt bwt;
+  typedef typename t::prop prop;
+  typedef typename t::ubv ubv;
+  typedef typename t::sbv sbv;
+
+  PRECONDITION(rounded.valid(format));
+
+  bwt exactWidth(exact.getSignificand().getWidth());
+  bwt targetWidth(unpackedFloat<t>::significandWidth(format));
+  PRECONDITION(exactWidth >= targetWidth);
+
+  // Two extra bits, for the carry up and the sign of the difference
+  bwt workingWidth(exactWidth + 2);
+  ubv exactSignificand(exact.getSignificand().extend(2));
+
+  prop carried(!(rounded.getExponent().matchWidth(exact.getExponent()) == exact.getExponent()));
+  ubv alignedRounded(rounded.getSignificand().extend(2).append(ubv::zero(exactWidth - targetWidth)));
+  ubv roundedSignificand(ITE(rounded.getZero(),
+			     ubv::zero(workingWidth),
+			     conditionalLeftShiftOne<t>(carried, alignedRounded)));
+
+  ubv difference(exactSignificand.modularAdd(roundedSignificand.modularNegate()));
+  prop negative(difference.extract(workingWidth - 1, workingWidth - 1).isAllOnes());
+  ubv magnitude(ITE(negative, difference.modularNegate(), difference));
+
+  // The top bit of magnitude is worth 2^(exponent + 2)
+  bwt exponentWidth(exact.getExponent().getWidth() + 2);
+  sbv exponent(exact.getExponent().extend(2) + sbv(exponentWidth, 2));
+  unpackedFloat<t> unnormalised(exact.getSign() ^ negative, exponent, magnitude);
+
+  // Directed rounding can take a value far below the subnormals up to
+  // the smallest one.  The error is then just less than -rounded, so
+  // it is given as -rounded with the sticky bit set.
+  prop farAbove(!rounded.getZero() &&
+		(rounded.getExponent().matchWidth(exponent) > exact.getExponent().extend(2) + sbv::one(exponentWidth)));
+  unpackedFloat<t> justBelow(!rounded.getSign(),
+			     rounded.getExponent().matchWidth(exponent),
+			     rounded.getSignificand().append(ubv::zero(workingWidth - targetWidth)).modularAdd(ubv::allOnes(workingWidth)));
+
+  unpackedFloat<t> normalised(ITE(farAbove, justBelow, unnormalised).normaliseUp(format));
+
+  unpackedFloat<t> error(errorRounder(format, roundingMode, normalised));
+
+  // Above the range of format the error is not meaningful
+  prop overflow(exact.getExponent() > unpackedFloat<t>::maxNormalExponent(format).matchWidth(exact.getExponent()));
+
+  return ITE(overflow,
+	     rounded,
+	     ITE(!farAbove && magnitude.isAllZeros(),
+		 unpackedFloat<t>::makeZero(format, rounded.getSign()),
+		 error));
+ }
+
+
 }
 
 #endif
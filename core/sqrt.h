@@ -30,6 +30,7 @@
 #include "symfpu/core/ite.h"
 #include "symfpu/core/rounder.h"
 #include "symfpu/core/operations.h"
+#include "symfpu/core/convert.h"
 
 #ifndef SYMFPU_SQRT
 #define SYMFPU_SQRT
@@ -152,6 +153,35 @@ template <class t>
  }
 
 
+// Reads sourceFormat and rounds once into targetFormat.  Narrowing can
+// over or underflow so, unlike sqrt, the full rounder is used.
+template <class t>
+  unpackedFloat<t> sqrt (const typename t::fpt &sourceFormat,
+			 const typename t::fpt &targetFormat,
+			 const typename t::rm &roundingMode,
+			 const unpackedFloat<t> &uf) {
+  typedef typename t::fpt fpt;
+
+  PRECONDITION(uf.valid(sourceFormat));
+
+  fpt workingFormat(commonFormat<t>(sourceFormat, targetFormat));
+
+  // Strict extension so the rounding mode does not matter
+  unpackedFloat<t> extended(convertFloatToFloat(sourceFormat, workingFormat, t::RTZ(), uf));
+
+  unpackedFloat<t> sqrtResult(arithmeticSqrt(workingFormat, extended));
+
+  unpackedFloat<t> roundedSqrtResult(rounder(targetFormat, roundingMode, sqrtResult));
+
+  // The special cases only use the flags of uf
+  unpackedFloat<t> result(addSqrtSpecialCases(targetFormat, uf, roundedSqrtResult.getSign(), roundedSqrtResult));
+
+  POSTCONDITION(result.valid(targetFormat));
+
+  return result;
+ }
+
+
 }
 
 #endif
@@ -49,6 +49,41 @@
 
 namespace symfpu {
 
+  // Flush-to-zero and denormals-are-zero are optional properties of a
+  // format.  Back-ends whose fpt does not have them never flush.
+  template <class fpt>
+  class hasSubnormalFlushing {
+    template <class u> static char test (decltype(&u::flushToZero));
+    template <class u> static long test (...);
+  public :
+    static const bool value = (sizeof(test<fpt>(NULL)) == sizeof(char));
+  };
+
+  template <class fpt, bool supported = hasSubnormalFlushing<fpt>::value>
+  struct subnormalFlushing {
+    static bool flushToZero (const fpt &) { return false; }
+    static bool denormalsAreZero (const fpt &) { return false; }
+  };
+
+  template <class fpt>
+  struct subnormalFlushing<fpt, true> {
+    static bool flushToZero (const fpt &format) { return format.flushToZero(); }
+    static bool denormalsAreZero (const fpt &format) { return format.denormalsAreZero(); }
+  };
+
+  // Results that would be subnormal are rounded to zero
+  template <class t>
+    bool flushToZero (const typename t::fpt &format) {
+    return subnormalFlushing<typename t::fpt>::flushToZero(format);
+  }
+
+  // Subnormal inputs are read as zero
+  template <class t>
+    bool denormalsAreZero (const typename t::fpt &format) {
+    return subnormalFlushing<typename t::fpt>::denormalsAreZero(format);
+  }
+
+
   template<class t>
     class unpackedFloat {
   public :
@@ -152,6 +187,13 @@ namespace symfpu {
       return unpackedFloat<t>(FPCLASS_NAN, false, defaultExponent(fmt), defaultSignificand(fmt));
     }
 
+    // The flags and sign of uf with the default exponent and significand
+    // of fmt.  Only the same as uf if it is NaN, infinite or zero, but
+    // enough for the special case functions to use uf in fmt.
+    static unpackedFloat<t> makeSpecialsOnly(const fpt &fmt, const unpackedFloat<t> &uf) {
+      return unpackedFloat<t>(uf.nan, uf.inf, uf.zero, uf.sign, defaultExponent(fmt), defaultSignificand(fmt));
+    }
+
     inline const prop & getNaN(void) const { return this->nan; }
     inline const prop & getInf(void) const { return this->inf; }
     inline const prop & getZero(void) const { return this->zero; }
@@ -33,6 +33,10 @@
 **    floating-point computation.  Depending on the back-end these may
 **    be concrete or symbolic and thus handled in different ways.
 **
+** Back-ends that want to know where an algorithm assertion is can
+** also provide precondition(const prop &, const callSite &) and so
+** on, which are then used instead.
+**
 */
 
 #ifndef SYMFPU_PROPERTIES
@@ -40,16 +44,59 @@
 
 #define IMPLIES(X,Y) (!(X) || (Y))
 
+namespace symfpu {
+  namespace properties {
+
+    struct callSite {
+      const char *file;
+      unsigned int line;
+
+      callSite (const char *f, unsigned int l) : file(f), line(l) {}
+    };
+
+    // Use the call site if the back-end takes it.  The int / long
+    // argument makes the version with the call site preferred when
+    // both are viable.  Implementation assertions are bool and never
+    // need the call site.
+#define SYMFPU_PROPERTY_DISPATCH(NAME)					\
+    template <class t, class P>						\
+    inline auto NAME##WithSite (const P &p, const callSite &s, int) -> decltype(t::NAME(p, s)) { \
+      return t::NAME(p, s);						\
+    }									\
+    template <class t, class P>						\
+    inline void NAME##WithSite (const P &p, const callSite &, long) {	\
+      t::NAME(p);							\
+    }									\
+    template <class t>							\
+    inline void NAME (const bool b, const callSite &) {			\
+      t::NAME(b);							\
+    }									\
+    template <class t, class P>						\
+    inline void NAME (const P &p, const callSite &s) {			\
+      NAME##WithSite<t>(p, s, 0);					\
+    }
+
+    SYMFPU_PROPERTY_DISPATCH(precondition)
+    SYMFPU_PROPERTY_DISPATCH(postcondition)
+    SYMFPU_PROPERTY_DISPATCH(invariant)
+
+#undef SYMFPU_PROPERTY_DISPATCH
+
+  }
+}
+
+#define SYMFPU_CALL_SITE ::symfpu::properties::callSite(__FILE__, __LINE__)
+
 #ifndef PRECONDITION
-#define PRECONDITION(X) t::precondition(X)
+#define PRECONDITION(X) ::symfpu::properties::precondition<t>((X), SYMFPU_CALL_SITE)
 #endif
 
 #ifndef POSTCONDITION
-#define POSTCONDITION(X) t::postcondition(X)
+#define POSTCONDITION(X) ::symfpu::properties::postcondition<t>((X), SYMFPU_CALL_SITE)
 #endif
 
 #ifndef INVARIANT
-#define INVARIANT(X) t::invariant(X)
+#define INVARIANT(X) ::symfpu::properties::invariant<t>((X), SYMFPU_CALL_SITE)
 #endif
 
 #endif